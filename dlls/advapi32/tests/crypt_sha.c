@@ -66,7 +66,54 @@ static void test_sha_ctx(void)
    ok(!memcmp(result, result_correct, sizeof(result)), "incorrect result\n");
 }
 
+static void test_sha_chunks(void)
+{
+   void (WINAPI *pA_SHAInit)(PSHA_CTX);
+   void (WINAPI *pA_SHAUpdate)(PSHA_CTX, const unsigned char *, UINT);
+   void (WINAPI *pA_SHAFinal)(PSHA_CTX, PULONG);
+   /* odd sizes around the block size, so that blocks are hashed both from the
+    * context buffer and several at a time straight from the input */
+   static const UINT chunks[] = { 1, 3, 63, 64, 65, 127, 129, 200, 348 };
+   static const unsigned char result_correct[20] = {
+      0xff, 0xd1, 0x49, 0xad, 0xde, 0x1f, 0x5a, 0x54, 0xf6, 0x86,
+      0x7c, 0xaa, 0xb2, 0x47, 0x06, 0xfe, 0x40, 0x6f, 0xf4, 0x1f };
+   unsigned char buffer[1000];
+   HMODULE hmod;
+   SHA_CTX ctx;
+   ULONG result[5];
+   UINT i, pos;
+
+   hmod = GetModuleHandleA("advapi32.dll");
+   pA_SHAInit = (void *)GetProcAddress(hmod, "A_SHAInit");
+   pA_SHAUpdate = (void *)GetProcAddress(hmod, "A_SHAUpdate");
+   pA_SHAFinal = (void *)GetProcAddress(hmod, "A_SHAFinal");
+
+   if (!pA_SHAInit || !pA_SHAUpdate || !pA_SHAFinal)
+   {
+      win_skip("A_SHAInit and/or A_SHAUpdate and/or A_SHAFinal are not available\n");
+      return;
+   }
+
+   for (i = 0; i < sizeof(buffer); i++)
+      buffer[i] = i * 13 + 5;
+
+   RtlZeroMemory(&ctx, sizeof(ctx));
+   pA_SHAInit(&ctx);
+   pA_SHAUpdate(&ctx, buffer, sizeof(buffer));
+   pA_SHAFinal(&ctx, result);
+   ok(!memcmp(result, result_correct, sizeof(result)), "incorrect result\n");
+
+   RtlZeroMemory(&ctx, sizeof(ctx));
+   pA_SHAInit(&ctx);
+   for (i = pos = 0; i < ARRAY_SIZE(chunks); pos += chunks[i++])
+      pA_SHAUpdate(&ctx, buffer + pos, chunks[i]);
+   ok(pos == sizeof(buffer), "got %u\n", pos);
+   pA_SHAFinal(&ctx, result);
+   ok(!memcmp(result, result_correct, sizeof(result)), "incorrect result\n");
+}
+
 START_TEST(crypt_sha)
 {
     test_sha_ctx();
+    test_sha_chunks();
 }
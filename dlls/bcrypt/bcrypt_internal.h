@@ -40,6 +40,8 @@ typedef struct
 void sha256_init(SHA256_CTX *ctx) DECLSPEC_HIDDEN;
 void sha256_update(SHA256_CTX *ctx, const UCHAR *buffer, ULONG len) DECLSPEC_HIDDEN;
 void sha256_finalize(SHA256_CTX *ctx, UCHAR *buffer) DECLSPEC_HIDDEN;
+BOOL sha256_multi_supported(void) DECLSPEC_HIDDEN;
+void sha256_multi(const UCHAR **data, const ULONG *len, UCHAR **output, unsigned int count) DECLSPEC_HIDDEN;
 
 typedef struct
 {
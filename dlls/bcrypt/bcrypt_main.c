@@ -32,6 +32,7 @@
 
 #include "wine/debug.h"
 #include "wine/heap.h"
+#include "wine/list.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(bcrypt);
 
@@ -907,26 +908,166 @@ NTSTATUS WINAPI BCryptFinishHash( BCRYPT_HASH_HANDLE handle, UCHAR *output, ULON
     return hash_finalize( hash, output, size );
 }
 
+/* Up to one thread per CPU hashes one-shot SHA-256 requests at the same time,
+ * each one leading a batch made of its own request and whatever is queued.
+ * Requests only queue up when all CPUs are already busy hashing, and the
+ * next leader hashes them together with the multi-buffer code. Nothing waits
+ * for a batch to fill up, and a request is hashed without taking the lock
+ * when no other one is pending. */
+#define HASH_BATCH_MAX_LEN      16384
+#define HASH_BATCH_MAX_COUNT    32
+
+struct hash_request
+{
+    struct list  entry;
+    const UCHAR *input;
+    ULONG        len;
+    UCHAR       *output;
+    BOOL         taken;
+    BOOL         done;
+};
+
+static SRWLOCK hash_batch_lock = SRWLOCK_INIT;
+static CONDITION_VARIABLE hash_batch_cv = CONDITION_VARIABLE_INIT;
+static struct list hash_batch_queue = LIST_INIT( hash_batch_queue );
+static unsigned int hash_batch_leaders;
+static LONG hash_batch_pending;
+
+static unsigned int hash_batch_max_leaders( void )
+{
+    static unsigned int max_leaders;
+    SYSTEM_INFO info;
+
+    if (!max_leaders)
+    {
+        GetSystemInfo( &info );
+        max_leaders = info.dwNumberOfProcessors;
+    }
+    return max_leaders;
+}
+
+static void hash_batch_run( struct hash_request **batch, unsigned int count )
+{
+    const UCHAR *data[HASH_BATCH_MAX_COUNT];
+    UCHAR *output[HASH_BATCH_MAX_COUNT];
+    ULONG len[HASH_BATCH_MAX_COUNT];
+    SHA256_CTX ctx;
+    unsigned int i;
+
+    if (count == 1)
+    {
+        sha256_init( &ctx );
+        sha256_update( &ctx, batch[0]->input, batch[0]->len );
+        sha256_finalize( &ctx, batch[0]->output );
+        return;
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        data[i]   = batch[i]->input;
+        len[i]    = batch[i]->len;
+        output[i] = batch[i]->output;
+    }
+    sha256_multi( data, len, output, count );
+}
+
+static void sha256_batched( const UCHAR *input, ULONG len, UCHAR *output )
+{
+    struct hash_request req, *batch[HASH_BATCH_MAX_COUNT], *cur, *next;
+    unsigned int max_leaders = hash_batch_max_leaders(), count, i;
+    SHA256_CTX ctx;
+
+    if (InterlockedIncrement( &hash_batch_pending ) == 1)
+    {
+        sha256_init( &ctx );
+        sha256_update( &ctx, input, len );
+        sha256_finalize( &ctx, output );
+        InterlockedDecrement( &hash_batch_pending );
+        return;
+    }
+
+    req.input  = input;
+    req.len    = len;
+    req.output = output;
+    req.taken  = FALSE;
+    req.done   = FALSE;
+
+    AcquireSRWLockExclusive( &hash_batch_lock );
+
+    if (hash_batch_leaders >= max_leaders)
+    {
+        /* wait until a leader has hashed our request or a CPU is free again */
+        list_add_tail( &hash_batch_queue, &req.entry );
+        for (;;)
+        {
+            if (req.done)
+            {
+                ReleaseSRWLockExclusive( &hash_batch_lock );
+                InterlockedDecrement( &hash_batch_pending );
+                return;
+            }
+            if (!req.taken && hash_batch_leaders < max_leaders)
+            {
+                list_remove( &req.entry );
+                break;
+            }
+            SleepConditionVariableSRW( &hash_batch_cv, &hash_batch_lock, INFINITE, 0 );
+        }
+    }
+
+    hash_batch_leaders++;
+    batch[0] = &req;
+    count = 1;
+    LIST_FOR_EACH_ENTRY_SAFE( cur, next, &hash_batch_queue, struct hash_request, entry )
+    {
+        list_remove( &cur->entry );
+        cur->taken = TRUE;
+        batch[count++] = cur;
+        if (count == HASH_BATCH_MAX_COUNT) break;
+    }
+    ReleaseSRWLockExclusive( &hash_batch_lock );
+
+    hash_batch_run( batch, count );
+
+    AcquireSRWLockExclusive( &hash_batch_lock );
+    for (i = 1; i < count; i++) batch[i]->done = TRUE;
+    hash_batch_leaders--;
+    if (count > 1 || !list_empty( &hash_batch_queue )) WakeAllConditionVariable( &hash_batch_cv );
+    ReleaseSRWLockExclusive( &hash_batch_lock );
+    InterlockedDecrement( &hash_batch_pending );
+}
+
 NTSTATUS WINAPI BCryptHash( BCRYPT_ALG_HANDLE algorithm, UCHAR *secret, ULONG secret_len,
                             UCHAR *input, ULONG input_len, UCHAR *output, ULONG output_len )
 {
     struct algorithm *alg = algorithm;
-    struct hash *hash;
+    struct hash hash;
     NTSTATUS status;
 
     TRACE( "%p, %p, %u, %p, %u, %p, %u\n", algorithm, secret, secret_len, input, input_len, output, output_len );
 
     if (!alg || alg->hdr.magic != MAGIC_ALG) return STATUS_INVALID_HANDLE;
 
-    if ((status = hash_create( alg, secret, secret_len, 0, &hash ))) return status;
-    if ((status = hash_update( &hash->inner, hash->alg_id, input, input_len )))
+    if (alg->id == ALG_ID_SHA256 && !(alg->flags & BCRYPT_ALG_HANDLE_HMAC_FLAG) &&
+        output_len == builtin_algorithms[ALG_ID_SHA256].hash_length &&
+        input_len <= HASH_BATCH_MAX_LEN && sha256_multi_supported())
     {
-        hash_destroy( hash );
-        return status;
+        sha256_batched( input, input_len, output );
+        return STATUS_SUCCESS;
     }
-    status = hash_finalize( hash, output, output_len );
-    hash_destroy( hash );
-    return status;
+
+    /* the hash object doesn't outlive this call, so keep it on the stack
+     * and use the caller's secret instead of a copy */
+    memset( &hash, 0, sizeof(hash) );
+    hash.hdr.magic  = MAGIC_HASH;
+    hash.alg_id     = alg->id;
+    hash.secret     = secret;
+    hash.secret_len = secret_len;
+    if (alg->flags & BCRYPT_ALG_HANDLE_HMAC_FLAG) hash.flags = HASH_FLAG_HMAC;
+
+    if ((status = hash_prepare( &hash ))) return status;
+    if ((status = hash_update( &hash.inner, hash.alg_id, input, input_len ))) return status;
+    return hash_finalize( &hash, output, output_len );
 }
 
 static NTSTATUS key_asymmetric_create( struct key **ret_key, struct algorithm *alg, ULONG bitlen,
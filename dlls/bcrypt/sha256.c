@@ -22,6 +22,10 @@
 
 #include "bcrypt_internal.h"
 
+#if defined(__i386__) || defined(__x86_64__)
+#include <intrin.h>
+#endif
+
 static DWORD ror(DWORD n, int k) { return (n >> k) | (n << (32-k)); }
 #define Ch(x,y,z)  (z ^ (x & (y ^ z)))
 #define Maj(x,y,z) ((x & y) | (z & (x | y)))
@@ -91,6 +95,110 @@ static void processblock(SHA256_CTX *ctx, const UCHAR *buffer)
     ctx->h[7] += h;
 }
 
+#if defined(__i386__) || defined(__x86_64__)
+
+static BOOL have_sha_ni(void)
+{
+    static int supported = -1;
+    int regs[4];
+
+    if (supported == -1)
+    {
+        supported = 0;
+        __cpuid(regs, 0);
+        if (regs[0] >= 7)
+        {
+            __cpuid(regs, 1);
+            /* SSSE3 and SSE4.1 */
+            if ((regs[2] & (1 << 9)) && (regs[2] & (1 << 19)))
+            {
+                __cpuidex(regs, 7, 0);
+                supported = !!(regs[1] & (1 << 29));
+            }
+        }
+    }
+    return supported;
+}
+
+/* ROUNDS4 runs four rounds on the message words in "cur", SCHEDULE derives
+ * the words of the next group and SCHEDULE1 does the first half of the
+ * message schedule for the group three ahead. */
+#define ROUNDS4(k, cur) \
+    msg = _mm_add_epi32(cur, _mm_loadu_si128((const __m128i *)(K + k))); \
+    state1 = _mm_sha256rnds2_epu32(state1, state0, msg); \
+    state0 = _mm_sha256rnds2_epu32(state0, state1, _mm_shuffle_epi32(msg, 0x0e))
+#define SCHEDULE(next, cur, prev) \
+    next = _mm_sha256msg2_epu32(_mm_add_epi32(next, _mm_alignr_epi8(cur, prev, 4)), cur)
+#define SCHEDULE1(prev, cur) \
+    prev = _mm_sha256msg1_epu32(prev, cur)
+
+static void __attribute__((target("sha,ssse3,sse4.1"))) processblocks_sha_ni(SHA256_CTX *ctx, const UCHAR *buffer, ULONG count)
+{
+    const __m128i mask = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+    __m128i state0, state1, abef, cdgh, msg, m0, m1, m2, m3, tmp;
+
+    /* The instructions want the state as ABEF and CDGH. */
+    tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)&ctx->h[0]), 0xb1);
+    state1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)&ctx->h[4]), 0x1b);
+    state0 = _mm_alignr_epi8(tmp, state1, 8);
+    state1 = _mm_blend_epi16(state1, tmp, 0xf0);
+
+    for (; count; count--, buffer += 64)
+    {
+        abef = state0;
+        cdgh = state1;
+
+        m0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)buffer), mask);
+        m1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(buffer + 16)), mask);
+        m2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(buffer + 32)), mask);
+        m3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(buffer + 48)), mask);
+
+        ROUNDS4( 0, m0);
+        ROUNDS4( 4, m1); SCHEDULE1(m0, m1);
+        ROUNDS4( 8, m2); SCHEDULE1(m1, m2);
+        ROUNDS4(12, m3); SCHEDULE(m0, m3, m2); SCHEDULE1(m2, m3);
+        ROUNDS4(16, m0); SCHEDULE(m1, m0, m3); SCHEDULE1(m3, m0);
+        ROUNDS4(20, m1); SCHEDULE(m2, m1, m0); SCHEDULE1(m0, m1);
+        ROUNDS4(24, m2); SCHEDULE(m3, m2, m1); SCHEDULE1(m1, m2);
+        ROUNDS4(28, m3); SCHEDULE(m0, m3, m2); SCHEDULE1(m2, m3);
+        ROUNDS4(32, m0); SCHEDULE(m1, m0, m3); SCHEDULE1(m3, m0);
+        ROUNDS4(36, m1); SCHEDULE(m2, m1, m0); SCHEDULE1(m0, m1);
+        ROUNDS4(40, m2); SCHEDULE(m3, m2, m1); SCHEDULE1(m1, m2);
+        ROUNDS4(44, m3); SCHEDULE(m0, m3, m2); SCHEDULE1(m2, m3);
+        ROUNDS4(48, m0); SCHEDULE(m1, m0, m3); SCHEDULE1(m3, m0);
+        ROUNDS4(52, m1); SCHEDULE(m2, m1, m0);
+        ROUNDS4(56, m2); SCHEDULE(m3, m2, m1);
+        ROUNDS4(60, m3);
+
+        state0 = _mm_add_epi32(state0, abef);
+        state1 = _mm_add_epi32(state1, cdgh);
+    }
+
+    tmp = _mm_shuffle_epi32(state0, 0x1b);
+    state1 = _mm_shuffle_epi32(state1, 0xb1);
+    _mm_storeu_si128((__m128i *)&ctx->h[0], _mm_blend_epi16(tmp, state1, 0xf0));
+    _mm_storeu_si128((__m128i *)&ctx->h[4], _mm_alignr_epi8(state1, tmp, 8));
+}
+
+#undef ROUNDS4
+#undef SCHEDULE
+#undef SCHEDULE1
+
+#endif
+
+static void processblocks(SHA256_CTX *ctx, const UCHAR *buffer, ULONG count)
+{
+#if defined(__i386__) || defined(__x86_64__)
+    if (have_sha_ni())
+    {
+        processblocks_sha_ni(ctx, buffer, count);
+        return;
+    }
+#endif
+    for (; count; count--, buffer += 64)
+        processblock(ctx, buffer);
+}
+
 static void pad(SHA256_CTX *ctx)
 {
     ULONG64 r = ctx->len % 64;
@@ -101,7 +209,7 @@ static void pad(SHA256_CTX *ctx)
     {
         memset(ctx->buf + r, 0, 64 - r);
         r = 0;
-        processblock(ctx, ctx->buf);
+        processblocks(ctx, ctx->buf, 1);
     }
 
     memset(ctx->buf + r, 0, 56 - r);
@@ -115,7 +223,7 @@ static void pad(SHA256_CTX *ctx)
     ctx->buf[62] = ctx->len >> 8;
     ctx->buf[63] = ctx->len;
 
-    processblock(ctx, ctx->buf);
+    processblocks(ctx, ctx->buf, 1);
 }
 
 void sha256_init(SHA256_CTX *ctx)
@@ -147,11 +255,11 @@ void sha256_update(SHA256_CTX *ctx, const UCHAR *buffer, ULONG len)
         memcpy(ctx->buf + r, p, 64 - r);
         len -= 64 - r;
         p += 64 - r;
-        processblock(ctx, ctx->buf);
+        processblocks(ctx, ctx->buf, 1);
     }
-    for (; len >= 64; len -= 64, p += 64)
-        processblock(ctx, p);
-    memcpy(ctx->buf, p, len);
+    processblocks(ctx, p, len / 64);
+    p += len & ~63;
+    memcpy(ctx->buf, p, len & 63);
 }
 
 void sha256_finalize(SHA256_CTX *ctx, UCHAR *buffer)
@@ -167,3 +275,259 @@ void sha256_finalize(SHA256_CTX *ctx, UCHAR *buffer)
         buffer[4*i+3] = ctx->h[i];
     }
 }
+
+#ifdef __GNUC__
+
+/* Multi-buffer SHA-256: independent messages are hashed together, one per
+ * vector lane, so that a batch of small messages costs about as much as the
+ * longest of them. A lane that finishes its message picks up the next one. */
+
+#define SHA256_LANES 8
+
+typedef DWORD sha256_vec __attribute__((vector_size(SHA256_LANES * sizeof(DWORD))));
+
+#define VROR(x,k)  (((x) >> (k)) | ((x) << (32-(k))))
+#define VS0(x)     (VROR(x,2) ^ VROR(x,13) ^ VROR(x,22))
+#define VS1(x)     (VROR(x,6) ^ VROR(x,11) ^ VROR(x,25))
+#define VR0(x)     (VROR(x,7) ^ VROR(x,18) ^ (x>>3))
+#define VR1(x)     (VROR(x,17) ^ VROR(x,19) ^ (x>>10))
+
+static const DWORD H0[8] =
+{
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+static const UCHAR zero_block[64];
+
+struct sha256_lane
+{
+    const UCHAR *data;      /* full blocks still to hash straight from the message */
+    ULONG        blocks;
+    UCHAR        tail[128]; /* padded last one or two blocks */
+    ULONG        tail_pos;
+    ULONG        tail_blocks;
+    unsigned int index;     /* message hashed by this lane, ~0u if idle */
+};
+
+static void lane_start(struct sha256_lane *lane, const UCHAR *data, ULONG len, unsigned int index)
+{
+    ULONG rest = len % 64;
+    ULONG64 bits = (ULONG64)len * 8;
+    int i;
+
+    lane->data = data;
+    lane->blocks = len / 64;
+    lane->index = index;
+    lane->tail_pos = 0;
+    lane->tail_blocks = rest < 56 ? 1 : 2;
+    memset(lane->tail, 0, sizeof(lane->tail));
+    memcpy(lane->tail, data + len - rest, rest);
+    lane->tail[rest] = 0x80;
+    for (i = 0; i < 8; i++)
+        lane->tail[lane->tail_blocks * 64 - 1 - i] = bits >> (8 * i);
+}
+
+static const UCHAR *lane_next_block(struct sha256_lane *lane)
+{
+    const UCHAR *block;
+
+    if (lane->index == ~0u) return zero_block;
+    if (lane->blocks)
+    {
+        block = lane->data;
+        lane->data += 64;
+        lane->blocks--;
+        return block;
+    }
+    return lane->tail + 64 * lane->tail_pos++;
+}
+
+static inline __attribute__((always_inline)) void processblock_multi(sha256_vec *state, const UCHAR **blocks)
+{
+    sha256_vec W[64], t1, t2, a, b, c, d, e, f, g, h;
+    unsigned int i, lane;
+
+    for (i = 0; i < 16; i++)
+    {
+        for (lane = 0; lane < SHA256_LANES; lane++)
+        {
+            const UCHAR *p = blocks[lane] + 4 * i;
+            W[i][lane] = (DWORD)p[0] << 24 | (DWORD)p[1] << 16 | (DWORD)p[2] << 8 | p[3];
+        }
+    }
+
+    for (; i < 64; i++)
+        W[i] = VR1(W[i-2]) + W[i-7] + VR0(W[i-15]) + W[i-16];
+
+    a = state[0];
+    b = state[1];
+    c = state[2];
+    d = state[3];
+    e = state[4];
+    f = state[5];
+    g = state[6];
+    h = state[7];
+
+    for (i = 0; i < 64; i++)
+    {
+        t1 = h + VS1(e) + Ch(e,f,g) + K[i] + W[i];
+        t2 = VS0(a) + Maj(a,b,c);
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+    state[5] += f;
+    state[6] += g;
+    state[7] += h;
+}
+
+static inline __attribute__((always_inline)) void sha256_multi_run(const UCHAR **data, const ULONG *len,
+                                                                   UCHAR **output, unsigned int count)
+{
+    struct sha256_lane lanes[SHA256_LANES];
+    const UCHAR *blocks[SHA256_LANES];
+    sha256_vec state[8];
+    unsigned int next = 0, active = 0, lane, i;
+
+    for (lane = 0; lane < SHA256_LANES; lane++)
+    {
+        lanes[lane].index = ~0u;
+        if (next == count) continue;
+        lane_start(&lanes[lane], data[next], len[next], next);
+        for (i = 0; i < 8; i++) state[i][lane] = H0[i];
+        next++;
+        active++;
+    }
+
+    while (active)
+    {
+        for (lane = 0; lane < SHA256_LANES; lane++)
+            blocks[lane] = lane_next_block(&lanes[lane]);
+
+        processblock_multi(state, blocks);
+
+        for (lane = 0; lane < SHA256_LANES; lane++)
+        {
+            struct sha256_lane *cur = &lanes[lane];
+
+            if (cur->index == ~0u || cur->blocks || cur->tail_pos < cur->tail_blocks) continue;
+
+            for (i = 0; i < 8; i++)
+            {
+                DWORD word = state[i][lane];
+                output[cur->index][4*i]   = word >> 24;
+                output[cur->index][4*i+1] = word >> 16;
+                output[cur->index][4*i+2] = word >> 8;
+                output[cur->index][4*i+3] = word;
+            }
+
+            if (next < count)
+            {
+                lane_start(cur, data[next], len[next], next);
+                for (i = 0; i < 8; i++) state[i][lane] = H0[i];
+                next++;
+            }
+            else
+            {
+                cur->index = ~0u;
+                active--;
+            }
+        }
+    }
+}
+
+static void sha256_multi_generic(const UCHAR **data, const ULONG *len, UCHAR **output, unsigned int count)
+{
+    sha256_multi_run(data, len, output, count);
+}
+
+#if defined(__i386__) || defined(__x86_64__)
+
+static void __attribute__((target("avx2"))) sha256_multi_avx2(const UCHAR **data, const ULONG *len,
+                                                                UCHAR **output, unsigned int count)
+{
+    sha256_multi_run(data, len, output, count);
+}
+
+static BOOL have_avx2(void)
+{
+    static int supported = -1;
+    unsigned int xcr0_lo, xcr0_hi;
+    int regs[4];
+
+    if (supported == -1)
+    {
+        supported = 0;
+        __cpuid(regs, 0);
+        if (regs[0] >= 7)
+        {
+            __cpuid(regs, 1);
+            /* OSXSAVE and AVX, then check that the OS saves the YMM state */
+            if ((regs[2] & (1 << 27)) && (regs[2] & (1 << 28)))
+            {
+                __asm__ ("xgetbv" : "=a" (xcr0_lo), "=d" (xcr0_hi) : "c" (0));
+                __cpuidex(regs, 7, 0);
+                supported = (xcr0_lo & 6) == 6 && (regs[1] & (1 << 5));
+            }
+        }
+    }
+    return supported;
+}
+
+#endif
+
+/* Hashing several messages with sha256_multi() only beats hashing them one
+ * after the other with AVX2, and not when SHA-NI is available. */
+BOOL sha256_multi_supported(void)
+{
+#if defined(__i386__) || defined(__x86_64__)
+    return have_avx2() && !have_sha_ni();
+#else
+    return FALSE;
+#endif
+}
+
+void sha256_multi(const UCHAR **data, const ULONG *len, UCHAR **output, unsigned int count)
+{
+#if defined(__i386__) || defined(__x86_64__)
+    if (have_avx2())
+    {
+        sha256_multi_avx2(data, len, output, count);
+        return;
+    }
+#endif
+    sha256_multi_generic(data, len, output, count);
+}
+
+#else  /* __GNUC__ */
+
+BOOL sha256_multi_supported(void)
+{
+    return FALSE;
+}
+
+void sha256_multi(const UCHAR **data, const ULONG *len, UCHAR **output, unsigned int count)
+{
+    SHA256_CTX ctx;
+    unsigned int i;
+
+    for (i = 0; i < count; i++)
+    {
+        sha256_init(&ctx);
+        sha256_update(&ctx, data[i], len[i]);
+        sha256_finalize(&ctx, output[i]);
+    }
+}
+
+#endif  /* __GNUC__ */
@@ -22,6 +22,7 @@
 #include <ntstatus.h>
 #define WIN32_NO_STATUS
 #include <windows.h>
+#include <wincrypt.h>
 #include <bcrypt.h>
 #include <ncrypt.h>
 
@@ -416,6 +417,73 @@ static void test_hashes(void)
         test_hash(tests+i);
 }
 
+static void test_hash_chunks(void)
+{
+    /* odd sizes around the block size, so that blocks are hashed both from the
+     * internal buffer and several at a time straight from the input */
+    static const ULONG chunks[] = { 1, 3, 63, 64, 65, 127, 129, 200, 348 };
+    static const struct
+    {
+        const WCHAR *alg;
+        ULONG hash_size;
+        const char *expected;
+    }
+    tests[] =
+    {
+        { L"SHA1", 20, "ffd149adde1f5a54f6867caab24706fe406ff41f" },
+        { L"SHA256", 32, "7994e00959d889b2edd138584884b26ecd04053d86779cb88d89202dea18e599" },
+    };
+    BCRYPT_ALG_HANDLE alg;
+    BCRYPT_HASH_HANDLE hash;
+    UCHAR data[1000], digest[32];
+    char str[65];
+    ULONG i, j, pos;
+    NTSTATUS ret;
+
+    for (i = 0; i < sizeof(data); i++)
+        data[i] = i * 13 + 5;
+
+    for (i = 0; i < ARRAY_SIZE(tests); i++)
+    {
+        ret = pBCryptOpenAlgorithmProvider(&alg, tests[i].alg, MS_PRIMITIVE_PROVIDER, 0);
+        ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+
+        ret = pBCryptCreateHash(alg, &hash, NULL, 0, NULL, 0, 0);
+        ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+        ret = pBCryptHashData(hash, data, sizeof(data), 0);
+        ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+        ret = pBCryptFinishHash(hash, digest, tests[i].hash_size, 0);
+        ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+        format_hash(digest, tests[i].hash_size, str);
+        ok(!strcmp(str, tests[i].expected), "%s: got %s\n", wine_dbgstr_w(tests[i].alg), str);
+        pBCryptDestroyHash(hash);
+
+        ret = pBCryptCreateHash(alg, &hash, NULL, 0, NULL, 0, 0);
+        ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+        for (j = pos = 0; j < ARRAY_SIZE(chunks); pos += chunks[j++])
+        {
+            ret = pBCryptHashData(hash, data + pos, chunks[j], 0);
+            ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+        }
+        ok(pos == sizeof(data), "got %u\n", pos);
+        ret = pBCryptFinishHash(hash, digest, tests[i].hash_size, 0);
+        ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+        format_hash(digest, tests[i].hash_size, str);
+        ok(!strcmp(str, tests[i].expected), "%s: got %s\n", wine_dbgstr_w(tests[i].alg), str);
+        pBCryptDestroyHash(hash);
+
+        if (pBCryptHash)
+        {
+            ret = pBCryptHash(alg, NULL, 0, data, sizeof(data), digest, tests[i].hash_size);
+            ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+            format_hash(digest, tests[i].hash_size, str);
+            ok(!strcmp(str, tests[i].expected), "%s: got %s\n", wine_dbgstr_w(tests[i].alg), str);
+        }
+
+        pBCryptCloseAlgorithmProvider(alg, 0);
+    }
+}
+
 static void test_BcryptHash(void)
 {
     static const char expected[] =
@@ -465,6 +533,78 @@ static void test_BcryptHash(void)
     ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
 }
 
+struct hash_thread_params
+{
+    BCRYPT_ALG_HANDLE alg;
+    UCHAR data[300];
+    UCHAR expected[300][32];
+    LONG failures;
+};
+
+static DWORD WINAPI hash_thread(void *arg)
+{
+    struct hash_thread_params *params = arg;
+    UCHAR digest[32];
+    ULONG i, len;
+    NTSTATUS ret;
+
+    for (i = 0; i < 2000; i++)
+    {
+        len = (i * 7 + GetCurrentThreadId()) % ARRAY_SIZE(params->data);
+        ret = pBCryptHash(params->alg, NULL, 0, params->data, len, digest, sizeof(digest));
+        if (ret || memcmp(digest, params->expected[len], sizeof(digest)))
+            InterlockedIncrement(&params->failures);
+    }
+    return 0;
+}
+
+static void test_BcryptHash_threads(void)
+{
+    struct hash_thread_params *params;
+    BCRYPT_HASH_HANDLE hash;
+    HANDLE threads[MAXIMUM_WAIT_OBJECTS];
+    SYSTEM_INFO info;
+    NTSTATUS ret;
+    ULONG i, count;
+
+    if (!pBCryptHash) /* < Win10 */
+    {
+        win_skip("BCryptHash is not available\n");
+        return;
+    }
+
+    params = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*params));
+    ret = pBCryptOpenAlgorithmProvider(&params->alg, BCRYPT_SHA256_ALGORITHM, MS_PRIMITIVE_PROVIDER, 0);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+
+    for (i = 0; i < ARRAY_SIZE(params->data); i++)
+        params->data[i] = i * 13;
+    for (i = 0; i < ARRAY_SIZE(params->data); i++)
+    {
+        ret = pBCryptCreateHash(params->alg, &hash, NULL, 0, NULL, 0, 0);
+        ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+        ret = pBCryptHashData(hash, params->data, i, 0);
+        ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+        ret = pBCryptFinishHash(hash, params->expected[i], 32, 0);
+        ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+        pBCryptDestroyHash(hash);
+    }
+
+    /* concurrent one-shot hashes may be computed together when there are
+     * more hashing threads than CPUs */
+    GetSystemInfo(&info);
+    count = min(info.dwNumberOfProcessors * 2 + 2, ARRAY_SIZE(threads));
+    for (i = 0; i < count; i++)
+        threads[i] = CreateThread(NULL, 0, hash_thread, params, 0, NULL);
+    WaitForMultipleObjects(count, threads, TRUE, INFINITE);
+    for (i = 0; i < count; i++)
+        CloseHandle(threads[i]);
+    ok(!params->failures, "got %u wrong hashes\n", params->failures);
+
+    pBCryptCloseAlgorithmProvider(params->alg, 0);
+    HeapFree(GetProcessHeap(), 0, params);
+}
+
 /* test vectors from RFC 6070 */
 static UCHAR password[] = "password";
 static UCHAR salt[] = "salt";
@@ -2741,6 +2881,274 @@ static void test_SecretAgreement(void)
     ok(status == STATUS_SUCCESS, "got %08x\n", status);
 }
 
+#define BENCHMARK_SIZE (1 << 20)
+#define BENCHMARK_COUNT 64
+
+static double benchmark_mbps(LARGE_INTEGER start, LARGE_INTEGER end, LARGE_INTEGER freq)
+{
+    return (double)BENCHMARK_COUNT * BENCHMARK_SIZE / (1 << 20) * freq.QuadPart / (end.QuadPart - start.QuadPart);
+}
+
+static void benchmark_hash(const WCHAR *alg_id, const char *expected, UCHAR *data)
+{
+    BCRYPT_ALG_HANDLE alg;
+    BCRYPT_HASH_HANDLE hash;
+    LARGE_INTEGER start, end, freq;
+    UCHAR digest[64], *object;
+    char str[129];
+    ULONG len, size, i;
+    NTSTATUS ret;
+
+    ret = pBCryptOpenAlgorithmProvider(&alg, alg_id, NULL, 0);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+    ret = pBCryptGetProperty(alg, BCRYPT_OBJECT_LENGTH, (UCHAR *)&len, sizeof(len), &size, 0);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+    object = HeapAlloc(GetProcessHeap(), 0, len);
+    ret = pBCryptGetProperty(alg, BCRYPT_HASH_LENGTH, (UCHAR *)&size, sizeof(size), &i, 0);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+
+    ret = pBCryptCreateHash(alg, &hash, object, len, NULL, 0, 0);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&start);
+    for (i = 0; i < BENCHMARK_COUNT; i++)
+        pBCryptHashData(hash, data, BENCHMARK_SIZE, 0);
+    ret = pBCryptFinishHash(hash, digest, size, 0);
+    QueryPerformanceCounter(&end);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+    format_hash(digest, size, str);
+    ok(!strcmp(str, expected), "%s: got %s\n", wine_dbgstr_w(alg_id), str);
+
+    trace("%s: %.1f MB/s\n", wine_dbgstr_w(alg_id), benchmark_mbps(start, end, freq));
+
+    pBCryptDestroyHash(hash);
+    pBCryptCloseAlgorithmProvider(alg, 0);
+    HeapFree(GetProcessHeap(), 0, object);
+}
+
+static void benchmark_aes(const WCHAR *mode, ULONG key_size, UCHAR *data)
+{
+    BCRYPT_AUTHENTICATED_CIPHER_MODE_INFO auth_info;
+    LARGE_INTEGER start, end, freq;
+    BCRYPT_ALG_HANDLE alg;
+    BCRYPT_KEY_HANDLE key;
+    UCHAR secret[32], iv[16], nonce[12], tag[16];
+    ULONG size, i;
+    NTSTATUS ret;
+
+    memset(secret, 0x42, sizeof(secret));
+    memset(iv, 0, sizeof(iv));
+    memset(nonce, 0, sizeof(nonce));
+
+    ret = pBCryptOpenAlgorithmProvider(&alg, BCRYPT_AES_ALGORITHM, NULL, 0);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+    ret = pBCryptSetProperty(alg, BCRYPT_CHAINING_MODE, (UCHAR *)mode, (lstrlenW(mode) + 1) * sizeof(WCHAR), 0);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+    ret = pBCryptGenerateSymmetricKey(alg, &key, NULL, 0, secret, key_size / 8, 0);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+
+    memset(&auth_info, 0, sizeof(auth_info));
+    auth_info.cbSize = sizeof(auth_info);
+    auth_info.dwInfoVersion = 1;
+    auth_info.pbNonce = nonce;
+    auth_info.cbNonce = sizeof(nonce);
+    auth_info.pbTag = tag;
+    auth_info.cbTag = sizeof(tag);
+
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&start);
+    for (i = 0; i < BENCHMARK_COUNT; i++)
+    {
+        if (!lstrcmpW(mode, BCRYPT_CHAIN_MODE_GCM))
+            ret = pBCryptEncrypt(key, data, BENCHMARK_SIZE, &auth_info, NULL, 0, data, BENCHMARK_SIZE, &size, 0);
+        else
+            ret = pBCryptEncrypt(key, data, BENCHMARK_SIZE, NULL, iv, sizeof(iv), data, BENCHMARK_SIZE, &size, 0);
+        if (ret) break;
+    }
+    QueryPerformanceCounter(&end);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+
+    trace("AES-%u %s: %.1f MB/s\n", key_size, wine_dbgstr_w(mode), benchmark_mbps(start, end, freq));
+
+    pBCryptDestroyKey(key);
+    pBCryptCloseAlgorithmProvider(alg, 0);
+}
+
+static void benchmark_capi(ALG_ID alg_id, const char *name, const char *expected, UCHAR *data)
+{
+    static const BYTE secret[32];
+    struct
+    {
+        BLOBHEADER hdr;
+        DWORD len;
+        BYTE key[32];
+    } blob;
+    LARGE_INTEGER start, end, freq;
+    HCRYPTPROV prov;
+    HCRYPTHASH hash;
+    HCRYPTKEY key;
+    BYTE digest[32];
+    char str[65];
+    DWORD size, i;
+    BOOL ret;
+
+    ret = CryptAcquireContextA(&prov, NULL, MS_ENH_RSA_AES_PROV_A, PROV_RSA_AES, CRYPT_VERIFYCONTEXT);
+    if (!ret)
+    {
+        skip("no AES provider\n");
+        return;
+    }
+
+    QueryPerformanceFrequency(&freq);
+    if (GET_ALG_CLASS(alg_id) == ALG_CLASS_HASH)
+    {
+        ret = CryptCreateHash(prov, alg_id, 0, 0, &hash);
+        ok(ret, "CryptCreateHash failed %u\n", GetLastError());
+        QueryPerformanceCounter(&start);
+        for (i = 0; i < BENCHMARK_COUNT; i++)
+            CryptHashData(hash, data, BENCHMARK_SIZE, 0);
+        size = sizeof(digest);
+        ret = CryptGetHashParam(hash, HP_HASHVAL, digest, &size, 0);
+        QueryPerformanceCounter(&end);
+        ok(ret, "CryptGetHashParam failed %u\n", GetLastError());
+        format_hash(digest, size, str);
+        ok(!strcmp(str, expected), "%s: got %s\n", name, str);
+        CryptDestroyHash(hash);
+    }
+    else
+    {
+        blob.hdr.bType = PLAINTEXTKEYBLOB;
+        blob.hdr.bVersion = CUR_BLOB_VERSION;
+        blob.hdr.reserved = 0;
+        blob.hdr.aiKeyAlg = alg_id;
+        blob.len = alg_id == CALG_AES_128 ? 16 : 32;
+        memcpy(blob.key, secret, sizeof(secret));
+        ret = CryptImportKey(prov, (BYTE *)&blob, sizeof(blob), 0, 0, &key);
+        ok(ret, "CryptImportKey failed %u\n", GetLastError());
+        QueryPerformanceCounter(&start);
+        for (i = 0; i < BENCHMARK_COUNT; i++)
+        {
+            size = BENCHMARK_SIZE;
+            CryptEncrypt(key, 0, FALSE, 0, data, &size, BENCHMARK_SIZE);
+        }
+        QueryPerformanceCounter(&end);
+        CryptDestroyKey(key);
+    }
+
+    trace("CryptoAPI %s: %.1f MB/s\n", name, benchmark_mbps(start, end, freq));
+    CryptReleaseContext(prov, 0);
+}
+
+struct small_hash_params
+{
+    BCRYPT_ALG_HANDLE alg;
+    const UCHAR *data;
+    ULONG size;
+    ULONG count;
+    UCHAR expected[64][32];
+    LONG failures;
+};
+
+static DWORD WINAPI small_hash_thread(void *arg)
+{
+    struct small_hash_params *params = arg;
+    UCHAR digest[32];
+    NTSTATUS ret;
+    ULONG i;
+
+    for (i = 0; i < params->count; i++)
+    {
+        ret = pBCryptHash(params->alg, NULL, 0, (UCHAR *)params->data + (i % 64), params->size, digest, sizeof(digest));
+        if (ret || memcmp(digest, params->expected[i % 64], sizeof(digest)))
+            InterlockedIncrement(&params->failures);
+    }
+    return 0;
+}
+
+static void benchmark_small_hashes(ULONG size, ULONG threads, UCHAR *data)
+{
+    struct small_hash_params params;
+    LARGE_INTEGER start, end, freq;
+    HANDLE handles[16];
+    NTSTATUS ret;
+    ULONG i;
+
+    ret = pBCryptOpenAlgorithmProvider(&params.alg, BCRYPT_SHA256_ALGORITHM, NULL, 0);
+    ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+    params.data = data;
+    params.size = size;
+    params.count = 200000;
+    params.failures = 0;
+    for (i = 0; i < ARRAY_SIZE(params.expected); i++)
+    {
+        ret = pBCryptHash(params.alg, NULL, 0, data + i, size, params.expected[i], sizeof(params.expected[i]));
+        ok(ret == STATUS_SUCCESS, "got %08x\n", ret);
+    }
+
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&start);
+    for (i = 0; i < threads; i++)
+        handles[i] = CreateThread(NULL, 0, small_hash_thread, &params, 0, NULL);
+    WaitForMultipleObjects(threads, handles, TRUE, INFINITE);
+    QueryPerformanceCounter(&end);
+    for (i = 0; i < threads; i++)
+        CloseHandle(handles[i]);
+    ok(!params.failures, "got %u wrong hashes\n", params.failures);
+
+    trace("BCryptHash SHA256 %u bytes, %u threads: %.0f hashes/s\n", size, threads,
+          (double)params.count * threads * freq.QuadPart / (end.QuadPart - start.QuadPart));
+
+    pBCryptCloseAlgorithmProvider(params.alg, 0);
+}
+
+static void test_benchmark(void)
+{
+    static const char md5[] = "c0ce177f391e0a0f8b11840fd238dc5c";
+    static const char sha1[] = "df3299449f2ff473b7ed2971d24702334f4dcb3a";
+    static const char sha256[] = "1f75a31a378af1072d837f57d2cb32b1df7b1d11fed9f3d18f4072bf90a1aa03";
+    static const char sha384[] =
+        "fa5f9e81b213b54d3202604de6506b35bb1fd579b7ffee68033b58070db39b8f"
+        "2c4076c86d1694e323f776853ee6fd72";
+    static const char sha512[] =
+        "5f82b40aaa6d3bedd6e5f1ef12589a9f06e4b444aa0ddfcab0fa6d2b6aafe2aa"
+        "51c7ef62540680df09eff2f955622cfde4e5f18b1d855e9062fe610a792b859b";
+    UCHAR *data;
+    ULONG i;
+
+    data = HeapAlloc(GetProcessHeap(), 0, BENCHMARK_SIZE);
+    for (i = 0; i < BENCHMARK_SIZE; i++)
+        data[i] = i * 0x9e3779b1 >> 24;
+
+    benchmark_hash(BCRYPT_MD5_ALGORITHM, md5, data);
+    benchmark_hash(BCRYPT_SHA1_ALGORITHM, sha1, data);
+    benchmark_hash(BCRYPT_SHA256_ALGORITHM, sha256, data);
+    benchmark_hash(BCRYPT_SHA384_ALGORITHM, sha384, data);
+    benchmark_hash(BCRYPT_SHA512_ALGORITHM, sha512, data);
+
+    benchmark_capi(CALG_SHA1, "SHA1", sha1, data);
+    benchmark_capi(CALG_SHA_256, "SHA256", sha256, data);
+
+    /* the ciphers encrypt the data in place */
+    benchmark_aes(BCRYPT_CHAIN_MODE_CBC, 128, data);
+    benchmark_aes(BCRYPT_CHAIN_MODE_CBC, 256, data);
+    benchmark_aes(BCRYPT_CHAIN_MODE_GCM, 128, data);
+    benchmark_aes(BCRYPT_CHAIN_MODE_GCM, 256, data);
+
+    benchmark_capi(CALG_AES_128, "AES-128 CBC", NULL, data);
+    benchmark_capi(CALG_AES_256, "AES-256 CBC", NULL, data);
+
+    if (pBCryptHash)
+    {
+        benchmark_small_hashes(64, 1, data);
+        benchmark_small_hashes(64, 8, data);
+        benchmark_small_hashes(1024, 1, data);
+        benchmark_small_hashes(1024, 8, data);
+    }
+
+    HeapFree(GetProcessHeap(), 0, data);
+}
+
 START_TEST(bcrypt)
 {
     HMODULE module;
@@ -2788,7 +3196,9 @@ START_TEST(bcrypt)
     test_BCryptGenRandom();
     test_BCryptGetFipsAlgorithmMode();
     test_hashes();
+    test_hash_chunks();
     test_BcryptHash();
+    test_BcryptHash_threads();
     test_BcryptDeriveKeyPBKDF2();
     test_rng();
     test_3des();
@@ -2809,5 +3219,8 @@ START_TEST(bcrypt)
     test_DSA();
     test_SecretAgreement();
 
+    if (winetest_interactive)
+        test_benchmark();
+
     FreeLibrary(module);
 }
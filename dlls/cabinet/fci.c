@@ -138,6 +138,24 @@ struct data_block
     cab_UWORD   uncompressed;
 };
 
+#define MAX_BATCH_BLOCKS 16
+
+struct FCI_Int;
+
+/* full data blocks waiting to be compressed in parallel */
+struct compress_batch
+{
+    LONG             next;      /* next block to be picked by a worker */
+    LONG             pending;   /* workers that are still running */
+    HANDLE           event;     /* signaled when the last worker is done */
+    unsigned int     size;      /* number of blocks that fit in the batch */
+    unsigned int     count;     /* number of blocks currently queued */
+    unsigned char   *data_in;   /* size * CAB_BLOCKMAX uncompressed bytes */
+    unsigned char   *data_out;  /* size * 2 * CAB_BLOCKMAX compressed bytes */
+    cab_UWORD        compressed[MAX_BATCH_BLOCKS];
+    cab_UWORD      (*compress)(struct FCI_Int *, const unsigned char *, cab_UWORD, unsigned char *);
+};
+
 typedef struct FCI_Int
 {
   unsigned int       magic;
@@ -184,7 +202,9 @@ typedef struct FCI_Int
   cab_ULONG          pending_data_size;   /* size of data not yet assigned to a folder */
   cab_ULONG          folders_data_size;   /* total size of data contained in the current folders */
   TCOMP              compression;
-  cab_UWORD        (*compress)(struct FCI_Int *);
+  cab_UWORD        (*compress)(struct FCI_Int *, const unsigned char *, cab_UWORD, unsigned char *);
+  struct compress_batch *batch;
+  BOOL               no_batch;            /* parallel compression is not available */
 } FCI_Int;
 
 #define FCI_INT_MAGIC 0xfcfcfc05
@@ -305,14 +325,13 @@ static void free_file( FCI_Int *fci, struct file *file )
     fci->free( file );
 }
 
-/* create a new data block for the data in fci->data_in */
-static BOOL add_data_block( FCI_Int *fci, PFNFCISTATUS status_callback )
+/* store an already compressed data block in the temp file */
+static BOOL write_data_block( FCI_Int *fci, const unsigned char *data, cab_UWORD uncompressed,
+                              cab_UWORD compressed )
 {
     int err;
     struct data_block *block;
 
-    if (!fci->cdata_in) return TRUE;
-
     if (fci->data.handle == -1 && !create_temp_file( fci, &fci->data )) return FALSE;
 
     if (!(block = fci->alloc( sizeof(*block) )))
@@ -320,24 +339,35 @@ static BOOL add_data_block( FCI_Int *fci, PFNFCISTATUS status_callback )
         set_error( fci, FCIERR_ALLOC_FAIL, ERROR_NOT_ENOUGH_MEMORY );
         return FALSE;
     }
-    block->uncompressed = fci->cdata_in;
-    block->compressed   = fci->compress( fci );
+    block->uncompressed = uncompressed;
+    block->compressed   = compressed;
 
-    if (fci->write( fci->data.handle, fci->data_out,
-                    block->compressed, &err, fci->pv ) != block->compressed)
+    if (fci->write( fci->data.handle, (void *)data, compressed, &err, fci->pv ) != compressed)
     {
         set_error( fci, FCIERR_TEMP_FILE, err );
         fci->free( block );
         return FALSE;
     }
 
-    fci->cdata_in = 0;
-    fci->pending_data_size += sizeof(CFDATA) + fci->ccab.cbReserveCFData + block->compressed;
-    fci->cCompressedBytesInFolder += block->compressed;
+    fci->pending_data_size += sizeof(CFDATA) + fci->ccab.cbReserveCFData + compressed;
+    fci->cCompressedBytesInFolder += compressed;
     fci->cDataBlocks++;
     list_add_tail( &fci->blocks_list, &block->entry );
+    return TRUE;
+}
+
+/* create a new data block for the data in fci->data_in */
+static BOOL add_data_block( FCI_Int *fci, PFNFCISTATUS status_callback )
+{
+    cab_UWORD uncompressed = fci->cdata_in, compressed;
+
+    if (!uncompressed) return TRUE;
+
+    if (!(compressed = fci->compress( fci, fci->data_in, uncompressed, fci->data_out ))) return FALSE;
+    if (!write_data_block( fci, fci->data_out, uncompressed, compressed )) return FALSE;
+    fci->cdata_in = 0;
 
-    if (status_callback( statusFile, block->compressed, block->uncompressed, fci->pv ) == -1)
+    if (status_callback( statusFile, compressed, uncompressed, fci->pv ) == -1)
     {
         set_error( fci, FCIERR_USER_ABORT, 0 );
         return FALSE;
@@ -345,6 +375,119 @@ static BOOL add_data_block( FCI_Int *fci, PFNFCISTATUS status_callback )
     return TRUE;
 }
 
+static void compress_batch_blocks( struct compress_batch *batch )
+{
+    LONG i;
+
+    while ((i = InterlockedIncrement( &batch->next ) - 1) < (LONG)batch->count)
+        batch->compressed[i] = batch->compress( NULL, batch->data_in + i * CAB_BLOCKMAX, CAB_BLOCKMAX,
+                                                batch->data_out + i * 2 * CAB_BLOCKMAX );
+}
+
+static void CALLBACK compress_batch_callback( TP_CALLBACK_INSTANCE *instance, void *context )
+{
+    struct compress_batch *batch = context;
+    HANDLE event = batch->event;
+
+    compress_batch_blocks( batch );
+    if (!InterlockedDecrement( &batch->pending )) SetEvent( event );
+}
+
+/* allocate the batch used to compress full MSZIP blocks in parallel */
+static struct compress_batch *get_compress_batch( FCI_Int *fci )
+{
+    struct compress_batch *batch;
+    SYSTEM_INFO info;
+    unsigned int size;
+
+    if (fci->batch) return fci->batch;
+    if (fci->no_batch) return NULL;
+    fci->no_batch = TRUE;
+
+    GetSystemInfo( &info );
+    if ((size = min( info.dwNumberOfProcessors, MAX_BATCH_BLOCKS )) < 2) return NULL;
+
+    /* this is only an optimization, fall back to compressing one block at a time on failure */
+    if (!(batch = fci->alloc( sizeof(*batch) + size * 3 * CAB_BLOCKMAX ))) return NULL;
+    if (!(batch->event = CreateEventW( NULL, FALSE, FALSE, NULL )))
+    {
+        fci->free( batch );
+        return NULL;
+    }
+    batch->size     = size;
+    batch->count    = 0;
+    batch->data_in  = (unsigned char *)(batch + 1);
+    batch->data_out = batch->data_in + size * CAB_BLOCKMAX;
+    fci->no_batch = FALSE;
+    return fci->batch = batch;
+}
+
+static void free_compress_batch( FCI_Int *fci )
+{
+    if (!fci->batch) return;
+    CloseHandle( fci->batch->event );
+    fci->free( fci->batch );
+    fci->batch = NULL;
+}
+
+/* compress all the queued blocks and store them in order, exactly like add_data_block would */
+static BOOL flush_compress_batch( FCI_Int *fci, PFNFCISTATUS status_callback )
+{
+    struct compress_batch *batch = fci->batch;
+    unsigned int i, count;
+
+    if (!batch || !(count = batch->count)) return TRUE;
+
+    batch->compress = fci->compress;
+    batch->next     = 0;
+    batch->pending  = 1;
+    for (i = 1; i < count; i++)
+    {
+        InterlockedIncrement( &batch->pending );
+        if (!TrySubmitThreadpoolCallback( compress_batch_callback, batch, NULL ))
+        {
+            InterlockedDecrement( &batch->pending );
+            break;
+        }
+    }
+    compress_batch_blocks( batch );
+    if (InterlockedDecrement( &batch->pending )) WaitForSingleObject( batch->event, INFINITE );
+    batch->count = 0;
+
+    for (i = 0; i < count; i++)
+    {
+        if (!batch->compressed[i])
+        {
+            set_error( fci, FCIERR_ALLOC_FAIL, ERROR_NOT_ENOUGH_MEMORY );
+            return FALSE;
+        }
+        if (!write_data_block( fci, batch->data_out + i * 2 * CAB_BLOCKMAX, CAB_BLOCKMAX,
+                               batch->compressed[i] ))
+            return FALSE;
+        if (status_callback( statusFile, batch->compressed[i], CAB_BLOCKMAX, fci->pv ) == -1)
+        {
+            set_error( fci, FCIERR_USER_ABORT, 0 );
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+/* queue the full block in fci->data_in for parallel compression if possible */
+static BOOL queue_data_block( FCI_Int *fci, PFNFCISTATUS status_callback )
+{
+    struct compress_batch *batch = NULL;
+
+    if (fci->compression == tcompTYPE_MSZIP) batch = get_compress_batch( fci );
+    if (!batch) return add_data_block( fci, status_callback );
+
+    memcpy( batch->data_in + batch->count * CAB_BLOCKMAX, fci->data_in, CAB_BLOCKMAX );
+    batch->count++;
+    fci->cdata_in = 0;
+    if (batch->count < batch->size) return TRUE;
+    return flush_compress_batch( fci, status_callback );
+}
+
 /* add compressed blocks for all the data that can be read from the file */
 static BOOL add_file_data( FCI_Int *fci, char *sourcefile, char *filename, BOOL execute,
                            PFNFCIGETOPENINFO get_open_info, PFNFCISTATUS status_callback )
@@ -372,15 +515,17 @@ static BOOL add_file_data( FCI_Int *fci, char *sourcefile, char *filename, BOOL
 
         if (len == -1)
         {
+            flush_compress_batch( fci, status_callback );
             set_error( fci, FCIERR_READ_SRC, err );
             return FALSE;
         }
         file->size += len;
         fci->cdata_in += len;
-        if (fci->cdata_in == CAB_BLOCKMAX && !add_data_block( fci, status_callback )) return FALSE;
+        if (fci->cdata_in == CAB_BLOCKMAX && !queue_data_block( fci, status_callback )) return FALSE;
     }
     fci->close( handle, &err, fci->pv );
-    return TRUE;
+    /* the following blocks must not be written before the queued ones */
+    return flush_compress_batch( fci, status_callback );
 }
 
 static void free_data_block( FCI_Int *fci, struct data_block *block )
@@ -899,25 +1044,30 @@ static BOOL add_files_to_folder( FCI_Int *fci, struct folder *folder, cab_ULONG
     return TRUE;
 }
 
-static cab_UWORD compress_NONE( FCI_Int *fci )
+/* the compression functions are called with a NULL fci from the worker threads */
+static cab_UWORD compress_NONE( FCI_Int *fci, const unsigned char *in, cab_UWORD len, unsigned char *out )
 {
-    memcpy( fci->data_out, fci->data_in, fci->cdata_in );
-    return fci->cdata_in;
+    memcpy( out, in, len );
+    return len;
 }
 
+/* the application allocator isn't necessarily thread safe, use the process heap in the workers */
 static void *zalloc( void *opaque, unsigned int items, unsigned int size )
 {
     FCI_Int *fci = opaque;
+    if (!fci) return HeapAlloc( GetProcessHeap(), 0, items * size );
     return fci->alloc( items * size );
 }
 
 static void zfree( void *opaque, void *ptr )
 {
     FCI_Int *fci = opaque;
-    fci->free( ptr );
+    if (!fci) HeapFree( GetProcessHeap(), 0, ptr );
+    else fci->free( ptr );
 }
 
-static cab_UWORD compress_MSZIP( FCI_Int *fci )
+/* each block is a complete deflate stream, so blocks can be compressed independently */
+static cab_UWORD compress_MSZIP( FCI_Int *fci, const unsigned char *in, cab_UWORD len, unsigned char *out )
 {
     z_stream stream;
 
@@ -926,16 +1076,16 @@ static cab_UWORD compress_MSZIP( FCI_Int *fci )
     stream.opaque = fci;
     if (deflateInit2( &stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY ) != Z_OK)
     {
-        set_error( fci, FCIERR_ALLOC_FAIL, ERROR_NOT_ENOUGH_MEMORY );
+        if (fci) set_error( fci, FCIERR_ALLOC_FAIL, ERROR_NOT_ENOUGH_MEMORY );
         return 0;
     }
-    stream.next_in   = fci->data_in;
-    stream.avail_in  = fci->cdata_in;
-    stream.next_out  = fci->data_out + 2;
-    stream.avail_out = sizeof(fci->data_out) - 2;
+    stream.next_in   = (unsigned char *)in;
+    stream.avail_in  = len;
+    stream.next_out  = out + 2;
+    stream.avail_out = 2 * CAB_BLOCKMAX - 2;
     /* insert the signature */
-    fci->data_out[0] = 'C';
-    fci->data_out[1] = 'K';
+    out[0] = 'C';
+    out[1] = 'K';
     deflate( &stream, Z_FINISH );
     deflateEnd( &stream );
     return stream.total_out + 2;
@@ -1723,6 +1873,7 @@ BOOL __cdecl FCIDestroy(HFCI hfci)
     }
 
     close_temp_file( p_fci_internal, &p_fci_internal->data );
+    free_compress_batch( p_fci_internal );
 
     /* hfci can now be removed */
     p_fci_internal->free(hfci);
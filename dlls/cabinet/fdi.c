@@ -154,6 +154,9 @@ typedef struct fdi_cds_fwd {
   cab_ULONG q_position_base[42];
   cab_ULONG lzx_position_base[51];
   cab_UBYTE extra_bits[51];
+  /* MSZIP fixed Huffman tables, built on first use */
+  struct Ziphuft *fixed_tl, *fixed_td;
+  cab_LONG fixed_bl, fixed_bd;
   USHORT  setID;                   /* Cabinet set ID */
   USHORT  iCabinet;                /* Cabinet number in set (0 based) */
   struct fdi_cds_fwd *decomp_cab;
@@ -874,6 +877,20 @@ static void fdi_Ziphuft_free(FDI_Int *fdi, struct Ziphuft *t)
   } 
 }
 
+/*********************************************************
+ * fdi_copy_match (internal)
+ *
+ * Copy a match within the window. Matches closer than their length repeat
+ * their own output and have to be copied a byte at a time.
+ */
+static inline void fdi_copy_match(cab_UBYTE *dest, const cab_UBYTE *src, int len)
+{
+  if (src < dest && dest - src < len)
+    while (len-- > 0) *dest++ = *src++;
+  else if (len > 0)
+    memmove(dest, src, len);
+}
+
 /*********************************************************
  * fdi_Ziphuft_build (internal)
  */
@@ -1124,10 +1141,9 @@ static cab_LONG fdi_Zipinflate_codes(const struct Ziphuft *tl, const struct Ziph
         e = ZIPWSIZE - max(d, w);
         e = min(e, n);
         n -= e;
-        do
-        {
-          CAB(outbuf)[w++] = CAB(outbuf)[d++];
-        } while (--e);
+        fdi_copy_match(CAB(outbuf) + w, CAB(outbuf) + d, e);
+        w += e;
+        d += e;
       } while (n);
     }
   }
@@ -1170,13 +1186,19 @@ static cab_LONG fdi_Zipinflate_stored(fdi_decomp_state *decomp_state)
     return 1;                   /* error in compressed data */
   ZIPDUMPBITS(16)
 
-  /* read and output the compressed data */
-  while(n--)
+  if (w + n > ZIPWSIZE || ZIP(inpos) + n > CAB(inbuf) + CAB_INPUTMAX)
+    return 1;
+
+  /* output the bytes left in the bit buffer, then copy the rest directly */
+  while(n && k)
   {
-    ZIPNEEDBITS(8)
     CAB(outbuf)[w++] = (cab_UBYTE)b;
     ZIPDUMPBITS(8)
+    n--;
   }
+  memcpy(CAB(outbuf) + w, ZIP(inpos), n);
+  ZIP(inpos) += n;
+  w += n;
 
   /* restore the globals from the locals */
   ZIP(window_posn) = w;              /* restore global window pointer */
@@ -1196,6 +1218,10 @@ static cab_LONG fdi_Zipinflate_fixed(fdi_decomp_state *decomp_state)
   cab_LONG i;                /* temporary variable */
   cab_ULONG *l;
 
+  /* the tables never change, keep them for the next fixed blocks */
+  if (CAB(fixed_tl))
+    return fdi_Zipinflate_codes(CAB(fixed_tl), CAB(fixed_td), CAB(fixed_bl), CAB(fixed_bd), decomp_state);
+
   l = ZIP(ll);
 
   /* literal table */
@@ -1221,12 +1247,13 @@ static cab_LONG fdi_Zipinflate_fixed(fdi_decomp_state *decomp_state)
     return i;
   }
 
-  /* decompress until an end-of-block code */
-  i = fdi_Zipinflate_codes(fixed_tl, fixed_td, fixed_bl, fixed_bd, decomp_state);
+  CAB(fixed_tl) = fixed_tl;
+  CAB(fixed_td) = fixed_td;
+  CAB(fixed_bl) = fixed_bl;
+  CAB(fixed_bd) = fixed_bd;
 
-  fdi_Ziphuft_free(CAB(fdi), fixed_td);
-  fdi_Ziphuft_free(CAB(fdi), fixed_tl);
-  return i;
+  /* decompress until an end-of-block code */
+  return fdi_Zipinflate_codes(fixed_tl, fixed_td, fixed_bl, fixed_bd, decomp_state);
 }
 
 /**************************************************************
@@ -1537,7 +1564,7 @@ static int QTMfdi_decomp(int inlen, int outlen, fdi_decomp_state *decomp_state)
       window_posn += match_length;
 
       /* copy match data - no worries about destination wraps */
-      while (match_length-- > 0) *rundest++ = *runsrc++;
+      fdi_copy_match(rundest, runsrc, match_length);
     }
   } /* while (togo > 0) */
 
@@ -1775,7 +1802,7 @@ static int LZXfdi_decomp(int inlen, int outlen, fdi_decomp_state *decomp_state)
             window_posn += match_length;
 
             /* copy match data - no worries about destination wraps */
-            while (match_length-- > 0) *rundest++ = *runsrc++;
+            fdi_copy_match(rundest, runsrc, match_length);
           }
         }
         break;
@@ -1864,7 +1891,7 @@ static int LZXfdi_decomp(int inlen, int outlen, fdi_decomp_state *decomp_state)
             window_posn += match_length;
 
             /* copy match data - no worries about destination wraps */
-            while (match_length-- > 0) *rundest++ = *runsrc++;
+            fdi_copy_match(rundest, runsrc, match_length);
           }
         }
         break;
@@ -2239,6 +2266,8 @@ static void free_decompression_mem(FDI_Int *fdi, fdi_decomp_state *decomp_state)
       CAB(firstfol) = CAB(firstfol)->next;
       fdi->free(fol);
     }
+    if (CAB(fixed_tl)) fdi_Ziphuft_free(fdi, CAB(fixed_tl));
+    if (CAB(fixed_td)) fdi_Ziphuft_free(fdi, CAB(fixed_td));
     while (CAB(firstfile)) {
       struct fdi_file *file = CAB(firstfile);
       if (file->filename) fdi->free(file->filename);
@@ -942,10 +942,206 @@ static void test_FDICopy(void)
 }
 
 
+static ULONGLONG bench_written;
+
+static UINT CDECL fdi_bench_write(INT_PTR hf, void *pv, UINT cb)
+{
+    bench_written += cb;
+    return cb;
+}
+
+static INT_PTR CDECL fdi_bench_notify(FDINOTIFICATIONTYPE fdint, FDINOTIFICATION *info)
+{
+    switch (fdint)
+    {
+    case fdintCOPY_FILE:
+        return 0xbe0c; /* never opened, the write callback discards the data */
+    case fdintCLOSE_FILE_INFO:
+        return TRUE;
+    default:
+        return 0;
+    }
+}
+
+static DWORD create_bench_file(const char *name, unsigned int seed, DWORD size)
+{
+    static const char *words[] = {"cabinet", "folder", "extract", "inflate", "window", "block", "stream", "huffman"};
+    char buffer[4096];
+    DWORD written, done = 0, len;
+    HANDLE file;
+
+    file = CreateFileA(name, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, 0, NULL);
+    ok(file != INVALID_HANDLE_VALUE, "Failure to open file %s\n", name);
+
+    while (done < size)
+    {
+        for (len = 0; len < sizeof(buffer) - 32;)
+        {
+            seed = seed * 1103515245 + 12345;
+            len += sprintf(buffer + len, "%s%u ", words[(seed >> 16) % ARRAY_SIZE(words)], (seed >> 8) & 0xff);
+        }
+        WriteFile(file, buffer, len, &written, NULL);
+        done += len;
+    }
+
+    CloseHandle(file);
+    return done;
+}
+
+static void test_extract_benchmark(void)
+{
+    static const unsigned int folder_count = 8;
+    static const DWORD file_size = 16 * 1024 * 1024;
+    char name[MAX_PATH], path[MAX_PATH], cab[] = "bench.cab";
+    ULONGLONG total = 0;
+    CCAB cabParams;
+    unsigned int i;
+    DWORD start;
+    HFCI hfci;
+    HFDI hfdi;
+    ERF erf;
+    BOOL ret;
+
+    GetCurrentDirectoryA(MAX_PATH, CURR_DIR);
+
+    set_cab_parameters(&cabParams);
+    lstrcpyA(cabParams.szCab, cab);
+
+    hfci = FCICreate(&erf, file_placed, mem_alloc, mem_free, fci_open,
+                     fci_read, fci_write, fci_close, fci_seek, fci_delete,
+                     get_temp_file, &cabParams, NULL);
+    ok(hfci != NULL, "Failed to create an FCI context\n");
+
+    start = GetTickCount();
+    for (i = 0; i < folder_count; i++)
+    {
+        sprintf(name, "bench%u.txt", i);
+        total += create_bench_file(name, i, file_size);
+        add_file(hfci, name);
+        ret = FCIFlushFolder(hfci, get_next_cabinet, progress);
+        ok(ret, "Failed to flush the folder\n");
+    }
+    ret = FCIFlushCabinet(hfci, FALSE, get_next_cabinet, progress);
+    ok(ret, "Failed to flush the cabinet\n");
+    FCIDestroy(hfci);
+    trace("compressed %u MB in %u ms\n", (unsigned int)(total >> 20), GetTickCount() - start);
+
+    hfdi = FDICreate(fdi_alloc, fdi_free, fdi_open, fdi_read,
+                     fdi_bench_write, fdi_close, fdi_seek,
+                     cpuUNKNOWN, &erf);
+    ok(hfdi != NULL, "FDICreate error %d\n", erf.erfOper);
+
+    lstrcpyA(path, CURR_DIR);
+    lstrcatA(path, "\\");
+    bench_written = 0;
+    start = GetTickCount();
+    ret = FDICopy(hfdi, cab, path, 0, fdi_bench_notify, NULL, NULL);
+    ok(ret, "FDICopy error %d\n", erf.erfOper);
+    ok(bench_written == total, "extracted %s bytes, expected %s\n",
+       wine_dbgstr_longlong(bench_written), wine_dbgstr_longlong(total));
+    trace("extracted %u folders, %u MB in %u ms\n", folder_count, (unsigned int)(total >> 20),
+          GetTickCount() - start);
+    FDIDestroy(hfdi);
+
+    for (i = 0; i < folder_count; i++)
+    {
+        sprintf(name, "bench%u.txt", i);
+        DeleteFileA(name);
+    }
+    DeleteFileA(cab);
+}
+
+static BOOL compare_files(const char *name1, const char *name2)
+{
+    static char buffer1[65536], buffer2[65536];
+    DWORD read1, read2;
+    HANDLE file1, file2;
+    BOOL same = TRUE;
+
+    file1 = CreateFileA(name1, GENERIC_READ, 0, NULL, OPEN_EXISTING, 0, NULL);
+    file2 = CreateFileA(name2, GENERIC_READ, 0, NULL, OPEN_EXISTING, 0, NULL);
+    ok(file1 != INVALID_HANDLE_VALUE && file2 != INVALID_HANDLE_VALUE, "Failed to open the cabinets\n");
+
+    while (same)
+    {
+        ReadFile(file1, buffer1, sizeof(buffer1), &read1, NULL);
+        ReadFile(file2, buffer2, sizeof(buffer2), &read2, NULL);
+        same = read1 == read2 && !memcmp(buffer1, buffer2, read1);
+        if (!read1) break;
+    }
+
+    CloseHandle(file1);
+    CloseHandle(file2);
+    return same;
+}
+
+static void test_compress_benchmark(void)
+{
+    static const unsigned int file_count = 4;
+    static const DWORD file_size = 32 * 1024 * 1024;
+    static const char *cabs[] = {"bench1.cab", "bench2.cab"};
+    char name[MAX_PATH];
+    ULONGLONG total = 0;
+    CCAB cabParams;
+    unsigned int i, j;
+    DWORD start;
+    HFCI hfci;
+    ERF erf;
+    BOOL ret;
+
+    GetCurrentDirectoryA(MAX_PATH, CURR_DIR);
+
+    for (i = 0; i < file_count; i++)
+    {
+        sprintf(name, "bench%u.txt", i);
+        total += create_bench_file(name, i, file_size);
+    }
+
+    for (j = 0; j < ARRAY_SIZE(cabs); j++)
+    {
+        set_cab_parameters(&cabParams);
+        lstrcpyA(cabParams.szCab, cabs[j]);
+
+        hfci = FCICreate(&erf, file_placed, mem_alloc, mem_free, fci_open,
+                         fci_read, fci_write, fci_close, fci_seek, fci_delete,
+                         get_temp_file, &cabParams, NULL);
+        ok(hfci != NULL, "Failed to create an FCI context\n");
+
+        start = GetTickCount();
+        for (i = 0; i < file_count; i++)
+        {
+            sprintf(name, "bench%u.txt", i);
+            add_file(hfci, name);
+        }
+        ret = FCIFlushCabinet(hfci, FALSE, get_next_cabinet, progress);
+        ok(ret, "Failed to flush the cabinet\n");
+        FCIDestroy(hfci);
+        trace("%s: compressed %u MB in %u ms\n", cabs[j], (unsigned int)(total >> 20),
+              GetTickCount() - start);
+    }
+
+    /* the blocks may be compressed in parallel, but the output must not depend on it */
+    ok(compare_files(cabs[0], cabs[1]), "The cabinets differ\n");
+
+    for (i = 0; i < file_count; i++)
+    {
+        sprintf(name, "bench%u.txt", i);
+        DeleteFileA(name);
+    }
+    for (j = 0; j < ARRAY_SIZE(cabs); j++)
+        DeleteFileA(cabs[j]);
+}
+
 START_TEST(fdi)
 {
     test_FDICreate();
     test_FDIDestroy();
     test_FDIIsCabinet();
     test_FDICopy();
+
+    if (winetest_interactive)
+    {
+        test_compress_benchmark();
+        test_extract_benchmark();
+    }
 }
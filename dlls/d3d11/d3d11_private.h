@@ -540,15 +540,28 @@ struct d3d_device_context_state
     ID3D11Device2 *device;
 };
 
-/* ID3D11DeviceContext - immediate context */
-struct d3d11_immediate_context
+/* ID3D11DeviceContext - immediate and deferred contexts */
+struct d3d11_device_context
 {
     ID3D11DeviceContext1 ID3D11DeviceContext1_iface;
     ID3D11Multithread ID3D11Multithread_iface;
     LONG refcount;
 
+    D3D11_DEVICE_CONTEXT_TYPE type;
     struct wined3d_device_context *wined3d_context;
+    struct d3d_device *device;
+
+    struct wined3d_private_store private_store;
+};
 
+/* ID3D11CommandList */
+struct d3d11_command_list
+{
+    ID3D11CommandList ID3D11CommandList_iface;
+    LONG refcount;
+
+    ID3D11Device2 *device;
+    struct wined3d_command_list *wined3d_list;
     struct wined3d_private_store private_store;
 };
 
@@ -566,7 +579,7 @@ struct d3d_device
     BOOL d3d11_only;
 
     struct d3d_device_context_state *state;
-    struct d3d11_immediate_context immediate_context;
+    struct d3d11_device_context immediate_context;
 
     struct wined3d_device_parent device_parent;
     struct wined3d_device *wined3d_device;
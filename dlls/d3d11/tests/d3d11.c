@@ -2278,7 +2278,7 @@ static void test_create_deferred_context(void)
 
     expected_refcount = get_refcount(device) + 1;
     hr = ID3D11Device_CreateDeferredContext(device, 0, &context);
-    todo_wine ok(hr == S_OK, "Failed to create deferred context, hr %#x.\n", hr);
+    ok(hr == S_OK, "Failed to create deferred context, hr %#x.\n", hr);
     if (FAILED(hr))
         goto done;
     refcount = get_refcount(device);
@@ -32141,7 +32141,7 @@ static void test_deferred_context_state(void)
     ID3D11DeviceContext_PSSetConstantBuffers(immediate, 0, 1, &green_buffer);
 
     hr = ID3D11Device_CreateDeferredContext(device, 0, &deferred);
-    todo_wine ok(hr == S_OK, "Failed to create deferred context, hr %#x.\n", hr);
+    ok(hr == S_OK, "Failed to create deferred context, hr %#x.\n", hr);
     if (hr != S_OK)
     {
         ID3D11Buffer_Release(blue_buffer);
@@ -32219,7 +32219,7 @@ static void test_deferred_context_swap_state(void)
     ID3D11DeviceContext1_PSSetConstantBuffers(immediate, 0, 1, &green_buffer);
 
     hr = ID3D11Device1_CreateDeferredContext1(device, 0, &deferred);
-    todo_wine ok(hr == S_OK, "Failed to create deferred context, hr %#x.\n", hr);
+    ok(hr == S_OK, "Failed to create deferred context, hr %#x.\n", hr);
     if (hr != S_OK)
         goto out;
 
@@ -32274,7 +32274,7 @@ static void test_deferred_context_rendering(void)
     ID3D11DeviceContext_ClearRenderTargetView(immediate, test_context.backbuffer_rtv, white);
 
     hr = ID3D11Device_CreateDeferredContext(device, 0, &deferred);
-    todo_wine ok(hr == S_OK, "Failed to create deferred context, hr %#x.\n", hr);
+    ok(hr == S_OK, "Failed to create deferred context, hr %#x.\n", hr);
     if (hr != S_OK)
     {
         release_test_context(&test_context);
@@ -32351,6 +32351,553 @@ static void test_deferred_context_rendering(void)
     release_test_context(&test_context);
 }
 
+struct deferred_record_thread
+{
+    ID3D11Device *device;
+    ID3D11RenderTargetView *rtv;
+    ID3D11CommandList *list;
+};
+
+static DWORD WINAPI deferred_record_thread_proc(void *arg)
+{
+    static const float green[] = {0.0f, 1.0f, 0.0f, 1.0f};
+    struct deferred_record_thread *thread = arg;
+    ID3D11DeviceContext *deferred;
+    ID3D11BlendState *blend_state;
+    D3D11_BLEND_DESC blend_desc;
+    unsigned int i;
+    HRESULT hr;
+
+    hr = ID3D11Device_CreateDeferredContext(thread->device, 0, &deferred);
+    ok(hr == S_OK, "Failed to create deferred context, hr %#x.\n", hr);
+
+    memset(&blend_desc, 0, sizeof(blend_desc));
+    blend_desc.RenderTarget[0].RenderTargetWriteMask = D3D11_COLOR_WRITE_ENABLE_ALL;
+    for (i = 0; i < 1000; ++i)
+    {
+        /* The deferred context holds the last reference to the blend state
+         * once it is replaced, so this releases objects while recording. */
+        blend_desc.AlphaToCoverageEnable = i & 1;
+        hr = ID3D11Device_CreateBlendState(thread->device, &blend_desc, &blend_state);
+        ok(hr == S_OK, "Failed to create blend state, hr %#x.\n", hr);
+        ID3D11DeviceContext_OMSetBlendState(deferred, blend_state, NULL, D3D11_DEFAULT_SAMPLE_MASK);
+        ID3D11BlendState_Release(blend_state);
+        ID3D11DeviceContext_ClearRenderTargetView(deferred, thread->rtv, green);
+    }
+    ID3D11DeviceContext_OMSetBlendState(deferred, NULL, NULL, D3D11_DEFAULT_SAMPLE_MASK);
+
+    hr = ID3D11DeviceContext_FinishCommandList(deferred, FALSE, &thread->list);
+    ok(hr == S_OK, "Failed to create command list, hr %#x.\n", hr);
+    ID3D11DeviceContext_Release(deferred);
+
+    return 0;
+}
+
+static void test_deferred_context_map(void)
+{
+    static const float white[] = {1.0f, 1.0f, 1.0f, 1.0f};
+    struct deferred_record_thread threads[2];
+    ID3D11DeviceContext *immediate, *deferred;
+    struct d3d11_test_context test_context;
+    D3D11_TEXTURE2D_DESC texture_desc;
+    D3D11_MAPPED_SUBRESOURCE map_desc;
+    D3D11_BUFFER_DESC buffer_desc;
+    struct resource_readback rb;
+    ID3D11CommandList *list;
+    HANDLE handles[2];
+    ID3D11Texture2D *texture;
+    ID3D11Buffer *buffer;
+    ID3D11Device *device;
+    unsigned int i, x, y;
+    DWORD color, *data;
+    HRESULT hr;
+
+    if (!init_test_context(&test_context, NULL))
+        return;
+
+    device = test_context.device;
+    immediate = test_context.immediate_context;
+
+    hr = ID3D11Device_CreateDeferredContext(device, 0, &deferred);
+    ok(hr == S_OK, "Failed to create deferred context, hr %#x.\n", hr);
+    if (hr != S_OK)
+    {
+        release_test_context(&test_context);
+        return;
+    }
+
+    texture_desc.Width = 16;
+    texture_desc.Height = 16;
+    texture_desc.MipLevels = 1;
+    texture_desc.ArraySize = 1;
+    texture_desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    texture_desc.SampleDesc.Count = 1;
+    texture_desc.SampleDesc.Quality = 0;
+    texture_desc.Usage = D3D11_USAGE_DYNAMIC;
+    texture_desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+    texture_desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    texture_desc.MiscFlags = 0;
+    hr = ID3D11Device_CreateTexture2D(device, &texture_desc, NULL, &texture);
+    ok(hr == S_OK, "Failed to create texture, hr %#x.\n", hr);
+
+    hr = ID3D11DeviceContext_Map(deferred, (ID3D11Resource *)texture, 0, D3D11_MAP_WRITE_DISCARD, 0, &map_desc);
+    ok(hr == S_OK, "Failed to map texture, hr %#x.\n", hr);
+    ok(map_desc.RowPitch >= texture_desc.Width * 4, "Got unexpected row pitch %u.\n", map_desc.RowPitch);
+    for (y = 0; y < texture_desc.Height; ++y)
+    {
+        data = (DWORD *)((BYTE *)map_desc.pData + y * map_desc.RowPitch);
+        for (x = 0; x < texture_desc.Width; ++x)
+            data[x] = y < texture_desc.Height / 2 ? 0xff00ff00 : 0xffff0000;
+    }
+    ID3D11DeviceContext_Unmap(deferred, (ID3D11Resource *)texture, 0);
+
+    hr = ID3D11DeviceContext_FinishCommandList(deferred, FALSE, &list);
+    ok(hr == S_OK, "Failed to create command list, hr %#x.\n", hr);
+    ID3D11DeviceContext_ExecuteCommandList(immediate, list, FALSE);
+    ID3D11CommandList_Release(list);
+
+    get_texture_readback(texture, 0, &rb);
+    color = get_readback_color(&rb, 3, 2, 0);
+    ok(color == 0xff00ff00, "Got unexpected color 0x%08x.\n", color);
+    color = get_readback_color(&rb, 12, 13, 0);
+    ok(color == 0xffff0000, "Got unexpected color 0x%08x.\n", color);
+    release_resource_readback(&rb);
+    ID3D11Texture2D_Release(texture);
+
+    buffer_desc.ByteWidth = 1024;
+    buffer_desc.Usage = D3D11_USAGE_DYNAMIC;
+    buffer_desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+    buffer_desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    buffer_desc.MiscFlags = 0;
+    buffer_desc.StructureByteStride = 0;
+    hr = ID3D11Device_CreateBuffer(device, &buffer_desc, NULL, &buffer);
+    ok(hr == S_OK, "Failed to create buffer, hr %#x.\n", hr);
+
+    hr = ID3D11DeviceContext_Map(deferred, (ID3D11Resource *)buffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &map_desc);
+    ok(hr == S_OK, "Failed to map buffer, hr %#x.\n", hr);
+    data = map_desc.pData;
+    for (i = 0; i < buffer_desc.ByteWidth / 8; ++i)
+        data[i] = i;
+    ID3D11DeviceContext_Unmap(deferred, (ID3D11Resource *)buffer, 0);
+
+    hr = ID3D11DeviceContext_Map(deferred, (ID3D11Resource *)buffer, 0, D3D11_MAP_WRITE_NO_OVERWRITE, 0, &map_desc);
+    ok(hr == S_OK, "Failed to map buffer, hr %#x.\n", hr);
+    data = map_desc.pData;
+    for (i = buffer_desc.ByteWidth / 8; i < buffer_desc.ByteWidth / 4; ++i)
+        data[i] = ~i;
+    ID3D11DeviceContext_Unmap(deferred, (ID3D11Resource *)buffer, 0);
+
+    hr = ID3D11DeviceContext_FinishCommandList(deferred, FALSE, &list);
+    ok(hr == S_OK, "Failed to create command list, hr %#x.\n", hr);
+    ID3D11DeviceContext_ExecuteCommandList(immediate, list, FALSE);
+    ID3D11CommandList_Release(list);
+
+    get_buffer_readback(buffer, &rb);
+    for (i = 0; i < buffer_desc.ByteWidth / 4; ++i)
+    {
+        DWORD expected = i < buffer_desc.ByteWidth / 8 ? i : ~i;
+
+        color = get_readback_u32(&rb, i, 0, 0);
+        ok(color == expected, "Got unexpected value 0x%08x at %u.\n", color, i);
+    }
+    release_resource_readback(&rb);
+    ID3D11Buffer_Release(buffer);
+    ID3D11DeviceContext_Release(deferred);
+
+    /* Record on two deferred contexts at once, while the immediate context
+     * is in use as well. */
+    for (i = 0; i < ARRAY_SIZE(threads); ++i)
+    {
+        threads[i].device = device;
+        threads[i].rtv = test_context.backbuffer_rtv;
+        threads[i].list = NULL;
+        handles[i] = CreateThread(NULL, 0, deferred_record_thread_proc, &threads[i], 0, NULL);
+        ok(!!handles[i], "Failed to create thread, error %u.\n", GetLastError());
+    }
+    for (i = 0; i < 100; ++i)
+        ID3D11DeviceContext_ClearRenderTargetView(immediate, test_context.backbuffer_rtv, white);
+    WaitForMultipleObjects(ARRAY_SIZE(handles), handles, TRUE, INFINITE);
+    for (i = 0; i < ARRAY_SIZE(threads); ++i)
+    {
+        CloseHandle(handles[i]);
+        ID3D11DeviceContext_ClearRenderTargetView(immediate, test_context.backbuffer_rtv, white);
+        ok(!!threads[i].list, "Failed to record command list %u.\n", i);
+        if (!threads[i].list)
+            continue;
+        ID3D11DeviceContext_ExecuteCommandList(immediate, threads[i].list, FALSE);
+        ID3D11CommandList_Release(threads[i].list);
+        color = get_texture_color(test_context.backbuffer, 320, 240);
+        ok(color == 0xff00ff00, "Got unexpected color 0x%08x.\n", color);
+    }
+
+    release_test_context(&test_context);
+}
+
+static int compare_frame_time(const void *a, const void *b)
+{
+    double t1 = *(const double *)a, t2 = *(const double *)b;
+
+    return t1 < t2 ? -1 : t1 > t2 ? 1 : 0;
+}
+
+static void shader_cache_child(void)
+{
+    static const struct vec4 green = {0.0f, 1.0f, 0.0f, 1.0f};
+    struct d3d11_test_context test_context;
+
+    if (!init_test_context(&test_context, NULL))
+        return;
+
+    draw_color_quad(&test_context, &green);
+    check_texture_color(test_context.backbuffer, 0xff00ff00, 1);
+
+    release_test_context(&test_context);
+}
+
+static void run_shader_cache_child(void)
+{
+    STARTUPINFOA si = {sizeof(si)};
+    PROCESS_INFORMATION pi;
+    char cmdline[MAX_PATH * 2];
+    char **argv;
+    BOOL ret;
+
+    winetest_get_mainargs(&argv);
+    sprintf(cmdline, "\"%s\" d3d11 shader_cache", argv[0]);
+    ret = CreateProcessA(NULL, cmdline, NULL, NULL, FALSE, 0, NULL, NULL, &si, &pi);
+    ok(ret, "Failed to create process, error %u.\n", GetLastError());
+    if (!ret)
+        return;
+    wait_child_process(pi.hProcess);
+    CloseHandle(pi.hThread);
+    CloseHandle(pi.hProcess);
+}
+
+static BYTE *read_cache_file(const char *path, DWORD *size)
+{
+    HANDLE file;
+    DWORD read;
+    BYTE *data;
+
+    file = CreateFileA(path, GENERIC_READ, 0, NULL, OPEN_EXISTING, 0, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return NULL;
+    *size = GetFileSize(file, NULL);
+    data = heap_alloc(*size);
+    ReadFile(file, data, *size, &read, NULL);
+    CloseHandle(file);
+    return data;
+}
+
+static void write_cache_file(const char *path, const BYTE *data, DWORD size, const BYTE *extra, DWORD extra_size)
+{
+    DWORD written;
+    HANDLE file;
+
+    file = CreateFileA(path, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, 0, NULL);
+    ok(file != INVALID_HANDLE_VALUE, "Failed to create %s, error %u.\n", path, GetLastError());
+    WriteFile(file, data, size, &written, NULL);
+    if (extra_size)
+        WriteFile(file, extra, extra_size, &written, NULL);
+    CloseHandle(file);
+}
+
+/* Wine specific: wined3d stores translated shaders in the directory given by
+ * the ShaderCachePath setting, and reads them back in later processes. */
+static void test_shader_cache(void)
+{
+    static const BYTE marker[8] = {'m', 'a', 'r', 'k', 'e', 'r', 0, 0};
+    char temp[MAX_PATH], dir[MAX_PATH], path[MAX_PATH], app[MAX_PATH], key_name[MAX_PATH];
+    BYTE *original, *data, *stale;
+    DWORD original_size, size;
+    WIN32_FIND_DATAA find;
+    HANDLE find_handle;
+    const char *name;
+    HKEY key;
+    LONG ret;
+
+    if (strcmp(winetest_platform, "wine"))
+    {
+        skip("The shader cache is specific to Wine.\n");
+        return;
+    }
+
+    GetTempPathA(ARRAY_SIZE(temp), temp);
+    GetTempFileNameA(temp, "wsc", 0, dir);
+    DeleteFileA(dir);
+    ok(CreateDirectoryA(dir, NULL), "Failed to create %s, error %u.\n", dir, GetLastError());
+
+    GetModuleFileNameA(NULL, app, ARRAY_SIZE(app));
+    name = strrchr(app, '\\') ? strrchr(app, '\\') + 1 : app;
+    sprintf(key_name, "Software\\Wine\\AppDefaults\\%s\\Direct3D", name);
+    ret = RegCreateKeyExA(HKEY_CURRENT_USER, key_name, 0, NULL, 0, KEY_ALL_ACCESS, NULL, &key, NULL);
+    ok(!ret, "Failed to create key, error %d.\n", ret);
+    ret = RegSetValueExA(key, "ShaderCachePath", 0, REG_SZ, (BYTE *)dir, strlen(dir) + 1);
+    ok(!ret, "Failed to set value, error %d.\n", ret);
+
+    run_shader_cache_child();
+
+    sprintf(path, "%s\\*.cache", dir);
+    if ((find_handle = FindFirstFileA(path, &find)) == INVALID_HANDLE_VALUE)
+    {
+        skip("No shader cache file was written.\n");
+        goto done;
+    }
+    FindClose(find_handle);
+    sprintf(path, "%s\\%s", dir, find.cFileName);
+
+    original = read_cache_file(path, &original_size);
+    ok(!!original, "Failed to read %s.\n", path);
+    /* magic, version and environment key */
+    ok(original_size > 24, "Got unexpected size %u.\n", original_size);
+
+    /* A matching file is used, and isn't written again when every shader is
+     * found in it. The trailing bytes are too short to be an entry. */
+    write_cache_file(path, original, original_size, marker, sizeof(marker));
+    run_shader_cache_child();
+    data = read_cache_file(path, &size);
+    ok(size == original_size + sizeof(marker), "Got unexpected size %u, expected %u.\n",
+            size, original_size + (DWORD)sizeof(marker));
+    ok(!memcmp(data, original, original_size), "The cache file was modified.\n");
+    heap_free(data);
+
+    /* A file created for another configuration is ignored and replaced. */
+    stale = heap_alloc(original_size);
+    memcpy(stale, original, original_size);
+    stale[8] ^= 0xff;
+    write_cache_file(path, stale, original_size, NULL, 0);
+    run_shader_cache_child();
+    data = read_cache_file(path, &size);
+    ok(size == original_size, "Got unexpected size %u, expected %u.\n", size, original_size);
+    ok(!memcmp(data, original, original_size), "The stale cache file was not replaced.\n");
+    heap_free(data);
+    heap_free(stale);
+
+    heap_free(original);
+    DeleteFileA(path);
+
+done:
+    RegDeleteValueA(key, "ShaderCachePath");
+    RegCloseKey(key);
+    RemoveDirectoryA(dir);
+}
+
+/* Replays a frame trace modelled on a game streaming in content: a loading
+ * burst that introduces many materials at once, followed by long stretches
+ * that only reuse them and the occasional frame that needs a new one. Each
+ * new material is a distinct pixel shader. Every frame waits for the GPU, so
+ * the reported frame times include the hitches caused by translating and
+ * linking shaders on first use. Only run in interactive mode. */
+static void test_shader_compile_benchmark(void)
+{
+    static const DWORD ps_code[] =
+    {
+#if 0
+        float4 main(float4 position : SV_POSITION) : SV_Target
+        {
+            return float4(0.0, 1.0, 0.0, 1.0);
+        }
+#endif
+        0x43425844, 0x30240e72, 0x012f250c, 0x8673c6ea, 0x392e4cec, 0x00000001, 0x000000d4, 0x00000003,
+        0x0000002c, 0x00000060, 0x00000094, 0x4e475349, 0x0000002c, 0x00000001, 0x00000008, 0x00000020,
+        0x00000000, 0x00000001, 0x00000003, 0x00000000, 0x0000000f, 0x505f5653, 0x5449534f, 0x004e4f49,
+        0x4e47534f, 0x0000002c, 0x00000001, 0x00000008, 0x00000020, 0x00000000, 0x00000000, 0x00000003,
+        0x00000000, 0x0000000f, 0x545f5653, 0x65677261, 0xabab0074, 0x52444853, 0x00000038, 0x00000040,
+        0x0000000e, 0x03000065, 0x001020f2, 0x00000000, 0x08000036, 0x001020f2, 0x00000000, 0x00004002,
+        0x00000000, 0x3f800000, 0x00000000, 0x3f800000, 0x0100003e,
+    };
+    static const struct
+    {
+        unsigned int frames;
+        unsigned int new_shaders;
+        unsigned int draws;
+    }
+    frames[] =
+    {
+        { 30,  0, 100},
+        {  4, 32, 100},
+        {120,  0, 200},
+        { 60,  1, 200},
+        { 10,  8, 200},
+        {120,  0, 200},
+    };
+    static const struct vec4 green = {0.0f, 1.0f, 0.0f, 1.0f};
+    unsigned int i, j, k, frame, shader_count, frame_count, slow_count;
+    ID3D11PixelShader *shaders[512], *shader;
+    struct d3d11_test_context test_context;
+    LARGE_INTEGER frequency, start, end;
+    D3D11_QUERY_DESC query_desc;
+    double *frame_times, total;
+    ID3D11DeviceContext *context;
+    ID3D11Asynchronous *query;
+    DWORD code[ARRAY_SIZE(ps_code)], color;
+    HRESULT hr;
+
+    if (!init_test_context(&test_context, NULL))
+        return;
+    context = test_context.immediate_context;
+
+    /* Set up the vertex shader, input layout, render target and viewport. */
+    draw_color_quad(&test_context, &green);
+    shaders[0] = test_context.ps;
+    ID3D11PixelShader_AddRef(shaders[0]);
+    shader_count = 1;
+
+    query_desc.Query = D3D11_QUERY_EVENT;
+    query_desc.MiscFlags = 0;
+    hr = ID3D11Device_CreateQuery(test_context.device, &query_desc, (ID3D11Query **)&query);
+    ok(hr == S_OK, "Failed to create query, hr %#x.\n", hr);
+
+    for (i = 0, frame_count = 0; i < ARRAY_SIZE(frames); ++i)
+        frame_count += frames[i].frames;
+    frame_times = heap_alloc(frame_count * sizeof(*frame_times));
+
+    QueryPerformanceFrequency(&frequency);
+    memcpy(code, ps_code, sizeof(code));
+    for (i = 0, frame = 0, total = 0.0, slow_count = 0; i < ARRAY_SIZE(frames); ++i)
+    {
+        for (j = 0; j < frames[i].frames; ++j, ++frame)
+        {
+            QueryPerformanceCounter(&start);
+
+            for (k = 0; k < frames[i].new_shaders && shader_count < ARRAY_SIZE(shaders); ++k)
+            {
+                /* Make every shader distinct, so that neither wined3d nor the
+                 * driver can reuse an earlier translation. The red component
+                 * stays below the colour tolerance. Native validates the DXBC
+                 * checksum, so fall back to the unmodified code there. */
+                *(float *)&code[48] = shader_count / 65536.0f;
+                if (FAILED(ID3D11Device_CreatePixelShader(test_context.device,
+                        code, sizeof(code), NULL, &shaders[shader_count])))
+                {
+                    hr = ID3D11Device_CreatePixelShader(test_context.device,
+                            ps_code, sizeof(ps_code), NULL, &shaders[shader_count]);
+                    ok(hr == S_OK, "Failed to create pixel shader, hr %#x.\n", hr);
+                }
+                ID3D11DeviceContext_PSSetShader(context, shaders[shader_count++], NULL, 0);
+                ID3D11DeviceContext_Draw(context, 4, 0);
+            }
+
+            for (k = 0; k < frames[i].draws; ++k)
+            {
+                shader = shaders[(frame * 7 + k) % shader_count];
+                ID3D11DeviceContext_PSSetShader(context, shader, NULL, 0);
+                ID3D11DeviceContext_Draw(context, 4, 0);
+            }
+
+            ID3D11DeviceContext_End(context, query);
+            while (ID3D11DeviceContext_GetData(context, query, NULL, 0, 0) == S_FALSE)
+                ;
+            QueryPerformanceCounter(&end);
+
+            frame_times[frame] = (end.QuadPart - start.QuadPart) * 1000.0 / frequency.QuadPart;
+            total += frame_times[frame];
+            if (frame_times[frame] > 1000.0 / 60.0)
+                ++slow_count;
+        }
+    }
+
+    color = get_texture_color(test_context.backbuffer, 320, 240);
+    ok(compare_color(color, 0xff00ff00, 1), "Got unexpected color 0x%08x.\n", color);
+
+    qsort(frame_times, frame_count, sizeof(*frame_times), compare_frame_time);
+    trace("%u frames, %u shaders, %.2f ms total: p50 %.3f ms, p90 %.3f ms, p99 %.3f ms, max %.3f ms, "
+            "%u frames over 16.7 ms.\n", frame_count, shader_count, total, frame_times[frame_count / 2],
+            frame_times[frame_count * 90 / 100], frame_times[frame_count * 99 / 100],
+            frame_times[frame_count - 1], slow_count);
+
+    heap_free(frame_times);
+    ID3D11Asynchronous_Release(query);
+    for (i = 0; i < shader_count; ++i)
+        ID3D11PixelShader_Release(shaders[i]);
+    release_test_context(&test_context);
+}
+
+/* Records a command list with many state changes, constant buffer updates
+ * and draws on a deferred context, and reports the time spent recording
+ * and executing it. Only run in interactive mode. */
+static void test_deferred_context_benchmark(void)
+{
+    static const struct vec4 green = {0.0f, 1.0f, 0.0f, 1.0f};
+    ID3D11DeviceContext *immediate, *deferred;
+    struct d3d11_test_context test_context;
+    LARGE_INTEGER frequency, start, end;
+    double record_time, execute_time;
+    D3D11_MAPPED_SUBRESOURCE map_desc;
+    unsigned int i, stride, offset;
+    D3D11_BUFFER_DESC buffer_desc;
+    ID3D11CommandList *list;
+    ID3D11Buffer *cb;
+    DWORD color;
+    HRESULT hr;
+
+    static const unsigned int draw_count = 10000;
+
+    if (!init_test_context(&test_context, NULL))
+        return;
+
+    immediate = test_context.immediate_context;
+
+    /* Create the shaders, input layout and vertex buffer. */
+    draw_color_quad(&test_context, &green);
+
+    buffer_desc.ByteWidth = sizeof(green);
+    buffer_desc.Usage = D3D11_USAGE_DYNAMIC;
+    buffer_desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+    buffer_desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    buffer_desc.MiscFlags = 0;
+    buffer_desc.StructureByteStride = 0;
+    hr = ID3D11Device_CreateBuffer(test_context.device, &buffer_desc, NULL, &cb);
+    ok(hr == S_OK, "Failed to create buffer, hr %#x.\n", hr);
+
+    hr = ID3D11Device_CreateDeferredContext(test_context.device, 0, &deferred);
+    ok(hr == S_OK, "Failed to create deferred context, hr %#x.\n", hr);
+
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&start);
+    stride = sizeof(struct vec3);
+    offset = 0;
+    for (i = 0; i < draw_count; ++i)
+    {
+        struct vec4 c = {0.0f, 1.0f, 0.0f, i / (float)draw_count};
+
+        ID3D11DeviceContext_OMSetRenderTargets(deferred, 1, &test_context.backbuffer_rtv, NULL);
+        set_viewport(deferred, 0.0f, 0.0f, 640.0f, 480.0f, 0.0f, 1.0f);
+        ID3D11DeviceContext_IASetInputLayout(deferred, test_context.input_layout);
+        ID3D11DeviceContext_IASetPrimitiveTopology(deferred, D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
+        ID3D11DeviceContext_IASetVertexBuffers(deferred, 0, 1, &test_context.vb, &stride, &offset);
+        ID3D11DeviceContext_VSSetShader(deferred, test_context.vs, NULL, 0);
+        ID3D11DeviceContext_PSSetShader(deferred, test_context.ps, NULL, 0);
+        ID3D11DeviceContext_PSSetConstantBuffers(deferred, 0, 1, &cb);
+
+        hr = ID3D11DeviceContext_Map(deferred, (ID3D11Resource *)cb, 0, D3D11_MAP_WRITE_DISCARD, 0, &map_desc);
+        ok(hr == S_OK, "Failed to map buffer, hr %#x.\n", hr);
+        memcpy(map_desc.pData, &c, sizeof(c));
+        ID3D11DeviceContext_Unmap(deferred, (ID3D11Resource *)cb, 0);
+
+        ID3D11DeviceContext_Draw(deferred, 4, 0);
+    }
+    hr = ID3D11DeviceContext_FinishCommandList(deferred, FALSE, &list);
+    ok(hr == S_OK, "Failed to create command list, hr %#x.\n", hr);
+    QueryPerformanceCounter(&end);
+    record_time = (end.QuadPart - start.QuadPart) * 1000.0 / frequency.QuadPart;
+
+    QueryPerformanceCounter(&start);
+    ID3D11DeviceContext_ExecuteCommandList(immediate, list, FALSE);
+    color = get_texture_color(test_context.backbuffer, 320, 240);
+    QueryPerformanceCounter(&end);
+    execute_time = (end.QuadPart - start.QuadPart) * 1000.0 / frequency.QuadPart;
+    ok(compare_color(color, 0xff00ff00, 1), "Got unexpected color 0x%08x.\n", color);
+
+    trace("%u draws: recorded in %.3f ms (%.3f us per draw), executed in %.3f ms.\n",
+            draw_count, record_time, record_time * 1000.0 / draw_count, execute_time);
+
+    ID3D11CommandList_Release(list);
+    ID3D11DeviceContext_Release(deferred);
+    ID3D11Buffer_Release(cb);
+    release_test_context(&test_context);
+}
+
 START_TEST(d3d11)
 {
     unsigned int argc, i;
@@ -32371,6 +32918,12 @@ START_TEST(d3d11)
             use_mt = FALSE;
     }
 
+    if (argc >= 3 && !strcmp(argv[2], "shader_cache"))
+    {
+        shader_cache_child();
+        return;
+    }
+
     print_adapter_info();
 
     queue_test(test_create_device);
@@ -32520,6 +33073,14 @@ START_TEST(d3d11)
     queue_test(test_deferred_context_state);
     queue_test(test_deferred_context_swap_state);
     queue_test(test_deferred_context_rendering);
+    queue_test(test_deferred_context_map);
+    queue_test(test_shader_cache);
 
     run_queued_tests();
+
+    if (winetest_interactive)
+    {
+        test_shader_compile_benchmark();
+        test_deferred_context_benchmark();
+    }
 }
@@ -6213,6 +6213,76 @@ static void test_vb_lock_flags(void)
     DestroyWindow(window);
 }
 
+/* Plain locks in between DISCARD and NOOVERWRITE locks must be visible to the
+ * following NOOVERWRITE locks. */
+static void test_vb_lock_interleaved(void)
+{
+    static const unsigned int size = 4096;
+    IDirect3DVertexBuffer9 *buffer;
+    IDirect3DDevice9 *device;
+    unsigned int i, j, *data;
+    IDirect3D9 *d3d9;
+    ULONG refcount;
+    HWND window;
+    HRESULT hr;
+
+    window = create_window();
+    d3d9 = Direct3DCreate9(D3D_SDK_VERSION);
+    ok(!!d3d9, "Failed to create a D3D object.\n");
+    if (!(device = create_device(d3d9, window, NULL)))
+    {
+        skip("Failed to create a D3D device, skipping tests.\n");
+        IDirect3D9_Release(d3d9);
+        DestroyWindow(window);
+        return;
+    }
+
+    hr = IDirect3DDevice9_CreateVertexBuffer(device, size, D3DUSAGE_DYNAMIC, 0, D3DPOOL_DEFAULT, &buffer, NULL);
+    ok(hr == D3D_OK, "Failed to create vertex buffer, hr %#x.\n", hr);
+
+    for (i = 0; i < 4; ++i)
+    {
+        hr = IDirect3DVertexBuffer9_Lock(buffer, 0, 0, (void **)&data, D3DLOCK_DISCARD);
+        ok(hr == D3D_OK, "Failed to lock vertex buffer, hr %#x.\n", hr);
+        for (j = 0; j < size / sizeof(*data); ++j)
+            data[j] = 0xaaaa0000 + i;
+        hr = IDirect3DVertexBuffer9_Unlock(buffer);
+        ok(hr == D3D_OK, "Failed to unlock vertex buffer, hr %#x.\n", hr);
+
+        hr = IDirect3DVertexBuffer9_Lock(buffer, 0, 0, (void **)&data, 0);
+        ok(hr == D3D_OK, "Failed to lock vertex buffer, hr %#x.\n", hr);
+        for (j = 0; j < size / sizeof(*data); ++j)
+            data[j] = 0xbbbb0000 + i;
+        hr = IDirect3DVertexBuffer9_Unlock(buffer);
+        ok(hr == D3D_OK, "Failed to unlock vertex buffer, hr %#x.\n", hr);
+
+        /* Only write part of the locked range. */
+        hr = IDirect3DVertexBuffer9_Lock(buffer, 0, 0, (void **)&data, D3DLOCK_NOOVERWRITE);
+        ok(hr == D3D_OK, "Failed to lock vertex buffer, hr %#x.\n", hr);
+        data[0] = 0xcccc0000 + i;
+        hr = IDirect3DVertexBuffer9_Unlock(buffer);
+        ok(hr == D3D_OK, "Failed to unlock vertex buffer, hr %#x.\n", hr);
+
+        hr = IDirect3DVertexBuffer9_Lock(buffer, 0, 0, (void **)&data, D3DLOCK_READONLY);
+        ok(hr == D3D_OK, "Failed to lock vertex buffer, hr %#x.\n", hr);
+        ok(data[0] == 0xcccc0000 + i, "Test %u: Got unexpected value %#x.\n", i, data[0]);
+        for (j = 1; j < size / sizeof(*data); ++j)
+        {
+            if (data[j] != 0xbbbb0000 + i)
+                break;
+        }
+        ok(j == size / sizeof(*data), "Test %u: Got unexpected value at %u.\n", i, j);
+        hr = IDirect3DVertexBuffer9_Unlock(buffer);
+        ok(hr == D3D_OK, "Failed to unlock vertex buffer, hr %#x.\n", hr);
+    }
+
+    IDirect3DVertexBuffer9_Release(buffer);
+    refcount = IDirect3DDevice9_Release(device);
+    ok(!refcount, "Device has %u references left.\n", refcount);
+    IDirect3D9_Release(d3d9);
+    DestroyWindow(window);
+}
+
 static const char *debug_d3dpool(D3DPOOL pool)
 {
     switch (pool)
@@ -14719,6 +14789,7 @@ START_TEST(device)
     test_volume_get_container();
     test_volume_resource();
     test_vb_lock_flags();
+    test_vb_lock_interleaved();
     test_vertex_buffer_alignment();
     test_query_support();
     test_occlusion_query();
@@ -100,6 +100,79 @@ static float getieee32(const IDirectSoundBufferImpl *dsb, DWORD pos, DWORD chann
 
 const bitsgetfunc getbpp[5] = {get8, get16, get24, get32, getieee32};
 
+/* The block getters convert "frames" contiguous frames starting at "pos" and
+ * store them planar, one run of "stride" floats per channel, so that the
+ * resampler and the mixer can work on plain float arrays. */
+static void get8_block(const IDirectSoundBufferImpl *dsb, DWORD pos, UINT frames, UINT channels, float *out, UINT stride)
+{
+    UINT align = dsb->pwfx->nBlockAlign, channel, i;
+    const BYTE *buf = dsb->buffer->memory;
+
+    for (channel = 0; channel < channels; channel++, out += stride)
+    {
+        const BYTE *src = buf + pos + channel;
+        for (i = 0; i < frames; i++)
+            out[i] = (src[i * align] - 0x80) * (1.0f / 0x80);
+    }
+}
+
+static void get16_block(const IDirectSoundBufferImpl *dsb, DWORD pos, UINT frames, UINT channels, float *out, UINT stride)
+{
+    UINT align = dsb->pwfx->nBlockAlign, channel, i;
+    const BYTE *buf = dsb->buffer->memory;
+
+    for (channel = 0; channel < channels; channel++, out += stride)
+    {
+        const BYTE *src = buf + pos + 2 * channel;
+        for (i = 0; i < frames; i++)
+            out[i] = (SHORT)le16(*(const SHORT *)(src + i * align)) * (1.0f / 0x8000);
+    }
+}
+
+static void get24_block(const IDirectSoundBufferImpl *dsb, DWORD pos, UINT frames, UINT channels, float *out, UINT stride)
+{
+    UINT align = dsb->pwfx->nBlockAlign, channel, i;
+    const BYTE *buf = dsb->buffer->memory;
+
+    for (channel = 0; channel < channels; channel++, out += stride)
+    {
+        const BYTE *src = buf + pos + 3 * channel;
+        for (i = 0; i < frames; i++, src += align)
+        {
+            LONG sample = (src[0] << 8) | (src[1] << 16) | (src[2] << 24);
+            out[i] = sample * (1.0f / 0x80000000U);
+        }
+    }
+}
+
+static void get32_block(const IDirectSoundBufferImpl *dsb, DWORD pos, UINT frames, UINT channels, float *out, UINT stride)
+{
+    UINT align = dsb->pwfx->nBlockAlign, channel, i;
+    const BYTE *buf = dsb->buffer->memory;
+
+    for (channel = 0; channel < channels; channel++, out += stride)
+    {
+        const BYTE *src = buf + pos + 4 * channel;
+        for (i = 0; i < frames; i++)
+            out[i] = (LONG)le32(*(const LONG *)(src + i * align)) * (1.0f / 0x80000000U);
+    }
+}
+
+static void getieee32_block(const IDirectSoundBufferImpl *dsb, DWORD pos, UINT frames, UINT channels, float *out, UINT stride)
+{
+    UINT align = dsb->pwfx->nBlockAlign, channel, i;
+    const BYTE *buf = dsb->buffer->memory;
+
+    for (channel = 0; channel < channels; channel++, out += stride)
+    {
+        const BYTE *src = buf + pos + 4 * channel;
+        for (i = 0; i < frames; i++)
+            out[i] = *(const float *)(src + i * align);
+    }
+}
+
+const bitsgetblockfunc getbpp_block[5] = {get8_block, get16_block, get24_block, get32_block, getieee32_block};
+
 float get_mono(const IDirectSoundBufferImpl *dsb, DWORD pos, DWORD channel)
 {
     DWORD channels = dsb->pwfx->nChannels;
@@ -112,6 +185,30 @@ float get_mono(const IDirectSoundBufferImpl *dsb, DWORD pos, DWORD channel)
     return val;
 }
 
+void get_mono_block(const IDirectSoundBufferImpl *dsb, DWORD pos, UINT frames, UINT channels, float *out, UINT stride)
+{
+    DWORD c, count = dsb->pwfx->nChannels;
+    float tmp[256];
+    UINT i, n;
+
+    while (frames)
+    {
+        n = min(frames, ARRAY_SIZE(tmp));
+        dsb->get_block_aux(dsb, pos, n, 1, out, stride);
+        for (c = 1; c < count; c++)
+        {
+            dsb->get_block_aux(dsb, pos + c * (dsb->pwfx->wBitsPerSample / 8), n, 1, tmp, n);
+            for (i = 0; i < n; i++)
+                out[i] += tmp[i];
+        }
+        for (i = 0; i < n; i++)
+            out[i] /= count;
+        pos += n * dsb->pwfx->nBlockAlign;
+        out += n;
+        frames -= n;
+    }
+}
+
 static inline unsigned char f_to_8(float value)
 {
     if(value <= -1.f)
@@ -45,7 +45,9 @@ typedef struct DirectSoundDevice             DirectSoundDevice;
 /* dsound_convert.h */
 typedef float (*bitsgetfunc)(const IDirectSoundBufferImpl *, DWORD, DWORD);
 typedef void (*bitsputfunc)(const IDirectSoundBufferImpl *, DWORD, DWORD, float);
+typedef void (*bitsgetblockfunc)(const IDirectSoundBufferImpl *, DWORD, UINT, UINT, float *, UINT);
 extern const bitsgetfunc getbpp[5] DECLSPEC_HIDDEN;
+extern const bitsgetblockfunc getbpp_block[5] DECLSPEC_HIDDEN;
 void putieee32(const IDirectSoundBufferImpl *dsb, DWORD pos, DWORD channel, float value) DECLSPEC_HIDDEN;
 void putieee32_sum(const IDirectSoundBufferImpl *dsb, DWORD pos, DWORD channel, float value) DECLSPEC_HIDDEN;
 void mixieee32(float *src, float *dst, unsigned samples) DECLSPEC_HIDDEN;
@@ -149,6 +151,7 @@ struct IDirectSoundBufferImpl
     ULONG                       freqneeded;
     DWORD                       firstep;
     float                       firgain;
+    const struct fir_table     *fir_table;
     LONG64                      freqAdjustNum,freqAdjustDen;
     LONG64                      freqAccNum;
     /* used for mixing */
@@ -165,6 +168,7 @@ struct IDirectSoundBufferImpl
     int                         mix_channels;
     bitsgetfunc get, get_aux;
     bitsputfunc put, put_aux;
+    bitsgetblockfunc get_block, get_block_aux;
     int                         num_filters;
     DSFilter*                   filters;
 
@@ -172,6 +176,7 @@ struct IDirectSoundBufferImpl
 };
 
 float get_mono(const IDirectSoundBufferImpl *dsb, DWORD pos, DWORD channel) DECLSPEC_HIDDEN;
+void get_mono_block(const IDirectSoundBufferImpl *dsb, DWORD pos, UINT frames, UINT channels, float *out, UINT stride) DECLSPEC_HIDDEN;
 void put_mono2stereo(const IDirectSoundBufferImpl *dsb, DWORD pos, DWORD channel, float value) DECLSPEC_HIDDEN;
 void put_mono2quad(const IDirectSoundBufferImpl *dsb, DWORD pos, DWORD channel, float value) DECLSPEC_HIDDEN;
 void put_stereo2quad(const IDirectSoundBufferImpl *dsb, DWORD pos, DWORD channel, float value) DECLSPEC_HIDDEN;
@@ -86,6 +86,73 @@ void DSOUND_AmpFactorToVolPan(PDSVOLUMEPAN volpan)
     TRACE("Vol=%d Pan=%d\n", volpan->lVolume, volpan->lPan);
 }
 
+/**
+ * Polyphase view of the FIR for a given step.
+ *
+ * Row r holds the taps fir[r + k * step] that the resampler would otherwise
+ * gather for every output frame, and row step + r holds the difference to the
+ * next FIR point, so the linear interpolation between both turns into a
+ * second dot product against the same input. Taps past the end of the FIR
+ * are zero. There are at most fir_step tables of roughly fir_len * 2 floats
+ * each, so they are built on first use and kept for the process lifetime.
+ */
+struct fir_table
+{
+	struct list entry;
+	UINT step;
+	UINT taps;
+	float coefs[1];
+};
+
+static struct list fir_tables = LIST_INIT(fir_tables);
+static SRWLOCK fir_tables_lock = SRWLOCK_INIT;
+
+static const struct fir_table *get_fir_table(UINT step)
+{
+	struct fir_table *table;
+	UINT taps = (fir_len + step - 2) / step, r, k;
+
+	AcquireSRWLockExclusive(&fir_tables_lock);
+
+	LIST_FOR_EACH_ENTRY(table, &fir_tables, struct fir_table, entry)
+	{
+		if (table->step == step)
+		{
+			ReleaseSRWLockExclusive(&fir_tables_lock);
+			return table;
+		}
+	}
+
+	if ((table = HeapAlloc(GetProcessHeap(), 0, FIELD_OFFSET(struct fir_table, coefs[2 * step * taps]))))
+	{
+		table->step = step;
+		table->taps = taps;
+		for (r = 0; r < step; r++)
+		{
+			float *a = table->coefs + r * taps, *d = table->coefs + (step + r) * taps;
+
+			for (k = 0; k < taps; k++)
+			{
+				UINT idx = r + k * step;
+
+				if (idx < fir_len - 1)
+				{
+					a[k] = fir[idx];
+					d[k] = fir[idx + 1] - fir[idx];
+				}
+				else
+					a[k] = d[k] = 0.0f;
+			}
+		}
+		list_add_head(&fir_tables, &table->entry);
+	}
+	else
+		ERR("Failed to allocate FIR table for step %u\n", step);
+
+	ReleaseSRWLockExclusive(&fir_tables_lock);
+	return table;
+}
+
 /**
  * Recalculate the size for temporary buffer, and new writelead
  * Should be called when one of the following things occur:
@@ -126,6 +193,7 @@ void DSOUND_RecalcFormat(IDirectSoundBufferImpl *dsb)
 		dsb->firstep = fir_step;
 	}
 	dsb->firgain = (float)dsb->firstep / fir_step;
+	dsb->fir_table = dsb->freqAdjustNum == dsb->freqAdjustDen ? NULL : get_fir_table(dsb->firstep);
 
 	/* calculate the 10ms write lead */
 	dsb->writelead = (dsb->freq / 100) * dsb->pwfx->nBlockAlign;
@@ -135,8 +203,11 @@ void DSOUND_RecalcFormat(IDirectSoundBufferImpl *dsb)
 	dsb->get_aux = ieee ? getbpp[4] : getbpp[dsb->pwfx->wBitsPerSample/8 - 1];
 	dsb->put_aux = putieee32;
 
+	dsb->get_block_aux = ieee ? getbpp_block[4] : getbpp_block[dsb->pwfx->wBitsPerSample/8 - 1];
+
 	dsb->get = dsb->get_aux;
 	dsb->put = dsb->put_aux;
+	dsb->get_block = dsb->get_block_aux;
 
 	if (ichannels == ochannels)
 	{
@@ -161,6 +232,7 @@ void DSOUND_RecalcFormat(IDirectSoundBufferImpl *dsb)
 	{
 		dsb->mix_channels = 1;
 		dsb->get = get_mono;
+		dsb->get_block = get_mono_block;
 	}
 	else if (ichannels == 2 && ochannels == 4)
 	{
@@ -275,67 +347,101 @@ void DSOUND_CheckEvent(const IDirectSoundBufferImpl *dsb, DWORD playpos, int len
     }
 }
 
-static inline float get_current_sample(const IDirectSoundBufferImpl *dsb,
-        DWORD mixpos, DWORD channel)
+/**
+ * Convert "frames" frames starting at the byte offset "pos" of the secondary
+ * buffer into planar floats, one run of "stride" floats per mixed channel.
+ * Wraps around looping buffers and pads non-looping ones with silence.
+ */
+static void get_fields(const IDirectSoundBufferImpl *dsb, DWORD pos, UINT frames, float *out, UINT stride)
+{
+    UINT istride = dsb->pwfx->nBlockAlign;
+    UINT channels = dsb->mix_channels;
+    UINT channel, n;
+
+    while (frames)
+    {
+        if (pos >= dsb->buflen)
+        {
+            if (!(dsb->playflags & DSBPLAY_LOOPING))
+            {
+                for (channel = 0; channel < channels; channel++)
+                    memset(out + channel * stride, 0, frames * sizeof(float));
+                return;
+            }
+            pos %= dsb->buflen;
+        }
+
+        n = min(frames, (dsb->buflen - pos + istride - 1) / istride);
+        dsb->get_block(dsb, pos, n, channels, out, stride);
+        pos += n * istride;
+        out += n;
+        frames -= n;
+    }
+}
+
+static float *get_cp_buffer(DirectSoundDevice *device, DWORD len)
 {
-    if (mixpos >= dsb->buflen && !(dsb->playflags & DSBPLAY_LOOPING))
-        return 0.0f;
-    return dsb->get(dsb, mixpos % dsb->buflen, channel);
+    len *= sizeof(float);
+    if (!device->cp_buffer) {
+        device->cp_buffer = HeapAlloc(GetProcessHeap(), 0, len);
+        device->cp_buffer_len = len;
+    } else if (len > device->cp_buffer_len) {
+        device->cp_buffer = HeapReAlloc(GetProcessHeap(), 0, device->cp_buffer, len);
+        device->cp_buffer_len = len;
+    }
+    return device->cp_buffer;
 }
 
-static UINT cp_fields_noresample(IDirectSoundBufferImpl *dsb, UINT count)
+/* Four independent partial sums let the compiler keep them in one vector
+ * register without reassociating the floating point additions itself. */
+static inline float fir_dot(const float *coefs, const float *samples, UINT count)
 {
-    UINT istride = dsb->pwfx->nBlockAlign;
-    UINT ostride = dsb->device->pwfx->nChannels * sizeof(float);
-    DWORD channel, i;
-    for (i = 0; i < count; i++)
-        for (channel = 0; channel < dsb->mix_channels; channel++)
-            dsb->put(dsb, i * ostride, channel, get_current_sample(dsb,
-                    dsb->sec_mixpos + i * istride, channel));
+    float sum0 = 0.0f, sum1 = 0.0f, sum2 = 0.0f, sum3 = 0.0f;
+    UINT j;
+
+    for (j = 0; j + 4 <= count; j += 4)
+    {
+        sum0 += coefs[j] * samples[j];
+        sum1 += coefs[j + 1] * samples[j + 1];
+        sum2 += coefs[j + 2] * samples[j + 2];
+        sum3 += coefs[j + 3] * samples[j + 3];
+    }
+    for (; j < count; j++)
+        sum0 += coefs[j] * samples[j];
+    return (sum0 + sum1) + (sum2 + sum3);
+}
+
+static UINT cp_fields_noresample(IDirectSoundBufferImpl *dsb, UINT count, float **fields)
+{
+    *fields = get_cp_buffer(dsb->device, count * dsb->mix_channels);
+    get_fields(dsb, dsb->sec_mixpos, count, *fields, count);
     return count;
 }
 
-static UINT cp_fields_resample(IDirectSoundBufferImpl *dsb, UINT count, LONG64 *freqAccNum)
+static UINT cp_fields_resample(IDirectSoundBufferImpl *dsb, UINT count, LONG64 *freqAccNum, float **fields)
 {
     UINT i, channel;
-    UINT istride = dsb->pwfx->nBlockAlign;
-    UINT ostride = dsb->device->pwfx->nChannels * sizeof(float);
 
     LONG64 freqAcc_start = *freqAccNum;
     LONG64 freqAcc_end = freqAcc_start + count * dsb->freqAdjustNum;
     UINT dsbfirstep = dsb->firstep;
     UINT channels = dsb->mix_channels;
     UINT max_ipos = (freqAcc_start + count * dsb->freqAdjustNum) / dsb->freqAdjustDen;
+    const struct fir_table *table = dsb->fir_table;
 
     UINT fir_cachesize = (fir_len + dsbfirstep - 2) / dsbfirstep;
     UINT required_input = max_ipos + fir_cachesize;
-    float *intermediate, *fir_copy, *itmp;
-
-    DWORD len = required_input * channels;
-    len += fir_cachesize;
-    len *= sizeof(float);
+    float *out, *intermediate, *fir_copy;
 
-    if (!dsb->device->cp_buffer) {
-        dsb->device->cp_buffer = HeapAlloc(GetProcessHeap(), 0, len);
-        dsb->device->cp_buffer_len = len;
-    } else if (len > dsb->device->cp_buffer_len) {
-        dsb->device->cp_buffer = HeapReAlloc(GetProcessHeap(), 0, dsb->device->cp_buffer, len);
-        dsb->device->cp_buffer_len = len;
-    }
-
-    fir_copy = dsb->device->cp_buffer;
+    out = get_cp_buffer(dsb->device, (count + required_input) * channels + fir_cachesize);
+    fir_copy = out + count * channels;
     intermediate = fir_copy + fir_cachesize;
 
-
     /* Important: this buffer MUST be non-interleaved
-     * if you want -msse3 to have any effect.
+     * if you want the dot products below to vectorize.
      * This is good for CPU cache effects, too.
      */
-    itmp = intermediate;
-    for (channel = 0; channel < channels; channel++)
-        for (i = 0; i < required_input; i++)
-            *(itmp++) = get_current_sample(dsb,
-                    dsb->sec_mixpos + i * istride, channel);
+    get_fields(dsb, dsb->sec_mixpos, required_input, intermediate, required_input);
 
     for(i = 0; i < count; ++i) {
         UINT int_fir_steps = (freqAcc_start + i * dsb->freqAdjustNum) * dsbfirstep / dsb->freqAdjustDen;
@@ -345,38 +451,53 @@ static UINT cp_fields_resample(IDirectSoundBufferImpl *dsb, UINT count, LONG64 *
         UINT idx = (ipos + 1) * dsbfirstep - int_fir_steps - 1;
         float rem = int_fir_steps + 1.0 - total_fir_steps;
 
-        int fir_used = 0;
-        while (idx < fir_len - 1) {
-            fir_copy[fir_used++] = fir[idx] * (1.0 - rem) + fir[idx + 1] * rem;
-            idx += dsb->firstep;
-        }
-
-        assert(fir_used <= fir_cachesize);
-        assert(ipos + fir_used <= required_input);
-
-        for (channel = 0; channel < dsb->mix_channels; channel++) {
-            int j;
-            float sum = 0.0;
-            float* cache = &intermediate[channel * required_input + ipos];
-            for (j = 0; j < fir_used; j++)
-                sum += fir_copy[j] * cache[j];
-            dsb->put(dsb, i * ostride, channel, sum * dsb->firgain);
+        assert(ipos + fir_cachesize <= required_input);
+
+        if (table) {
+            const float *a = table->coefs + idx * table->taps;
+            const float *d = table->coefs + (dsbfirstep + idx) * table->taps;
+
+            for (channel = 0; channel < channels; channel++) {
+                const float *cache = &intermediate[channel * required_input + ipos];
+                float sum = fir_dot(a, cache, fir_cachesize) + rem * fir_dot(d, cache, fir_cachesize);
+                out[channel * count + i] = sum * dsb->firgain;
+            }
+        } else {
+            int fir_used = 0;
+            while (idx < fir_len - 1) {
+                fir_copy[fir_used++] = fir[idx] * (1.0 - rem) + fir[idx + 1] * rem;
+                idx += dsbfirstep;
+            }
+
+            assert(fir_used <= fir_cachesize);
+
+            for (channel = 0; channel < channels; channel++) {
+                const float *cache = &intermediate[channel * required_input + ipos];
+                out[channel * count + i] = fir_dot(fir_copy, cache, fir_used) * dsb->firgain;
+            }
         }
     }
 
     *freqAccNum = freqAcc_end % dsb->freqAdjustDen;
+    *fields = out;
 
     return max_ipos;
 }
 
-static void cp_fields(IDirectSoundBufferImpl *dsb, UINT count, LONG64 *freqAccNum)
+/**
+ * Read, convert and resample the next "count" frames of the secondary buffer
+ * and advance the mix position accordingly. Returns dsb->mix_channels planar
+ * runs of "count" floats, which stay valid until the next call.
+ */
+static float *cp_fields(IDirectSoundBufferImpl *dsb, UINT count, LONG64 *freqAccNum)
 {
     DWORD ipos, adv;
+    float *fields;
 
     if (dsb->freqAdjustNum == dsb->freqAdjustDen)
-        adv = cp_fields_noresample(dsb, count); /* *freqAccNum is unmodified */
+        adv = cp_fields_noresample(dsb, count, &fields); /* *freqAccNum is unmodified */
     else
-        adv = cp_fields_resample(dsb, count, freqAccNum);
+        adv = cp_fields_resample(dsb, count, freqAccNum, &fields);
 
     ipos = dsb->sec_mixpos + adv * dsb->pwfx->nBlockAlign;
     if (ipos >= dsb->buflen) {
@@ -389,6 +510,32 @@ static void cp_fields(IDirectSoundBufferImpl *dsb, UINT count, LONG64 *freqAccNu
     }
 
     dsb->sec_mixpos = ipos;
+    return fields;
+}
+
+/**
+ * Store planar fields into the interleaved device->tmp_buffer, going through
+ * the channel mapping of the buffer unless it is a plain copy.
+ */
+static void put_fields(const IDirectSoundBufferImpl *dsb, const float *fields, UINT count)
+{
+    UINT ochannels = dsb->device->pwfx->nChannels;
+    UINT ostride = ochannels * sizeof(float);
+    float *tmp = dsb->device->tmp_buffer;
+    UINT i, channel;
+
+    if (dsb->put == putieee32) {
+        for (channel = 0; channel < dsb->mix_channels; channel++) {
+            const float *src = fields + channel * count;
+            for (i = 0; i < count; i++)
+                tmp[i * ochannels + channel] = src[i];
+        }
+        return;
+    }
+
+    for (i = 0; i < count; i++)
+        for (channel = 0; channel < dsb->mix_channels; channel++)
+            dsb->put(dsb, i * ostride, channel, fields[channel * count + i]);
 }
 
 /**
@@ -414,12 +561,10 @@ static inline DWORD DSOUND_BufPtrDiff(DWORD buflen, DWORD ptr1, DWORD ptr2)
  * Doesn't perform any mixing - this is a straight copy/convert operation.
  *
  * dsb = the secondary buffer
- * writepos = Starting position of changed buffer
- * len = number of bytes to resample from writepos
- *
- * NOTE: writepos + len <= buflen. When called by mixer, MixOne makes sure of this.
+ * fields = the planar output of cp_fields
+ * frames = number of frames in fields
  */
-static void DSOUND_MixToTemporary(IDirectSoundBufferImpl *dsb, DWORD frames)
+static void DSOUND_MixToTemporary(IDirectSoundBufferImpl *dsb, const float *fields, DWORD frames)
 {
 	UINT size_bytes = frames * sizeof(float) * dsb->device->pwfx->nChannels;
 	HRESULT hr;
@@ -436,7 +581,7 @@ static void DSOUND_MixToTemporary(IDirectSoundBufferImpl *dsb, DWORD frames)
 	if(dsb->put_aux == putieee32_sum)
 		memset(dsb->device->tmp_buffer, 0, dsb->device->tmp_buffer_len);
 
-	cp_fields(dsb, frames, &dsb->freqAccNum);
+	put_fields(dsb, fields, frames);
 
 	if (size_bytes > 0) {
 		for (i = 0; i < dsb->num_filters; i++) {
@@ -451,37 +596,111 @@ static void DSOUND_MixToTemporary(IDirectSoundBufferImpl *dsb, DWORD frames)
 	}
 }
 
-static void DSOUND_MixerVol(const IDirectSoundBufferImpl *dsb, INT frames)
+/**
+ * Compute the per channel gain of the buffer.
+ * Returns FALSE if the buffer is mixed at unity gain.
+ */
+static BOOL DSOUND_GetMixerVols(const IDirectSoundBufferImpl *dsb, float *vols)
 {
-	INT	i;
-	float vols[DS_MAX_CHANNELS];
 	UINT channels = dsb->device->pwfx->nChannels, chan;
 
-	TRACE("(%p,%d)\n",dsb,frames);
 	TRACE("left = %x, right = %x\n", dsb->volpan.dwTotalAmpFactor[0],
 		dsb->volpan.dwTotalAmpFactor[1]);
 
 	if ((!(dsb->dsbd.dwFlags & DSBCAPS_CTRLPAN) || (dsb->volpan.lPan == 0)) &&
 	    (!(dsb->dsbd.dwFlags & DSBCAPS_CTRLVOLUME) || (dsb->volpan.lVolume == 0)) &&
 	     !(dsb->dsbd.dwFlags & DSBCAPS_CTRL3D))
-		return; /* Nothing to do */
+		return FALSE; /* Nothing to do */
 
 	if (channels > DS_MAX_CHANNELS)
 	{
 		FIXME("There is no support for %u channels\n", channels);
-		return;
+		return FALSE;
 	}
 
-	for (i = 0; i < channels; ++i)
-		vols[i] = dsb->volpan.dwTotalAmpFactor[i] / ((float)0xFFFF);
+	for (chan = 0; chan < channels; ++chan)
+		vols[chan] = dsb->volpan.dwTotalAmpFactor[chan] / ((float)0xFFFF);
+	return TRUE;
+}
+
+static void DSOUND_MixerVol(const IDirectSoundBufferImpl *dsb, INT frames)
+{
+	INT	i;
+	float vols[DS_MAX_CHANNELS];
+	float *buf = dsb->device->tmp_buffer;
+	UINT channels = dsb->device->pwfx->nChannels, chan;
+
+	TRACE("(%p,%d)\n",dsb,frames);
+
+	if (!DSOUND_GetMixerVols(dsb, vols))
+		return;
+
+	if (channels == 2)
+	{
+		for (i = 0; i < frames; ++i)
+		{
+			buf[2 * i] *= vols[0];
+			buf[2 * i + 1] *= vols[1];
+		}
+		return;
+	}
 
 	for(i = 0; i < frames; ++i){
 		for(chan = 0; chan < channels; ++chan){
-			dsb->device->tmp_buffer[i * channels + chan] *= vols[chan];
+			buf[i * channels + chan] *= vols[chan];
 		}
 	}
 }
 
+/**
+ * Whether the planar fields of the buffer can be accumulated straight into
+ * the mix buffer: no effects, and either the same channel layout as the
+ * device or a mono buffer duplicated to every device channel.
+ */
+static BOOL DSOUND_CanMixDirect(const IDirectSoundBufferImpl *dsb)
+{
+	UINT channels = dsb->device->pwfx->nChannels;
+
+	if (dsb->num_filters || channels > DS_MAX_CHANNELS)
+		return FALSE;
+	if (dsb->put == putieee32)
+		return dsb->mix_channels == channels;
+	return dsb->put_aux == putieee32 && (dsb->put == put_mono2stereo ||
+		dsb->put == put_mono2quad || dsb->put == put_mono2surround51);
+}
+
+static void DSOUND_MixDirect(const IDirectSoundBufferImpl *dsb, const float *fields, float *mix_buffer, DWORD frames)
+{
+	UINT channels = dsb->device->pwfx->nChannels, chan;
+	float vols[DS_MAX_CHANNELS];
+	DWORD i;
+
+	if (!DSOUND_GetMixerVols(dsb, vols))
+		for (chan = 0; chan < channels; ++chan)
+			vols[chan] = 1.0f;
+
+	if (channels == 2)
+	{
+		const float *left = fields, *right = dsb->mix_channels == 1 ? fields : fields + frames;
+
+		for (i = 0; i < frames; ++i)
+		{
+			mix_buffer[2 * i] += left[i] * vols[0];
+			mix_buffer[2 * i + 1] += right[i] * vols[1];
+		}
+		return;
+	}
+
+	for (chan = 0; chan < channels; ++chan)
+	{
+		const float *src = dsb->mix_channels == 1 ? fields : fields + chan * frames;
+		float vol = vols[chan];
+
+		for (i = 0; i < frames; ++i)
+			mix_buffer[i * channels + chan] += src[i] * vol;
+	}
+}
+
 /**
  * Mix (at most) the given number of bytes into the given position of the
  * device buffer, from the secondary buffer "dsb" (starting at the current
@@ -496,21 +715,27 @@ static void DSOUND_MixerVol(const IDirectSoundBufferImpl *dsb, INT frames)
  */
 static DWORD DSOUND_MixInBuffer(IDirectSoundBufferImpl *dsb, float *mix_buffer, DWORD frames)
 {
-	float *ibuf;
+	float *fields;
 	DWORD oldpos;
 
 	TRACE("sec_mixpos=%d/%d\n", dsb->sec_mixpos, dsb->buflen);
 	TRACE("(%p, frames=%d)\n",dsb,frames);
 
-	/* Resample buffer to temporary buffer specifically allocated for this purpose, if needed */
 	oldpos = dsb->sec_mixpos;
-	DSOUND_MixToTemporary(dsb, frames);
-	ibuf = dsb->device->tmp_buffer;
+	fields = cp_fields(dsb, frames, &dsb->freqAccNum);
 
-	/* Apply volume if needed */
-	DSOUND_MixerVol(dsb, frames);
+	if (DSOUND_CanMixDirect(dsb))
+		DSOUND_MixDirect(dsb, fields, mix_buffer, frames);
+	else
+	{
+		/* Map channels and apply effects in the temporary buffer */
+		DSOUND_MixToTemporary(dsb, fields, frames);
+
+		/* Apply volume if needed */
+		DSOUND_MixerVol(dsb, frames);
 
-	mixieee32(ibuf, mix_buffer, frames * dsb->device->pwfx->nChannels);
+		mixieee32(dsb->device->tmp_buffer, mix_buffer, frames * dsb->device->pwfx->nChannels);
+	}
 
 	/* check for notification positions */
 	if (dsb->dsbd.dwFlags & DSBCAPS_CTRLPOSITIONNOTIFY &&
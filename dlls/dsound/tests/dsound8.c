@@ -29,6 +29,7 @@
 #define NONAMELESSUNION
 #include <windows.h>
 #include <stdio.h>
+#include <math.h>
 
 #include "wine/test.h"
 #include "mmsystem.h"
@@ -1882,6 +1883,911 @@ static void test_AcquireResources(void)
     IDirectSound_Release(dsound);
 }
 
+static ULONGLONG mixer_benchmark_cpu_time(void)
+{
+    FILETIME create, exit, kernel, user;
+
+    GetProcessTimes(GetCurrentProcess(), &create, &exit, &kernel, &user);
+    return (((ULONGLONG)kernel.dwHighDateTime << 32) | kernel.dwLowDateTime) +
+            (((ULONGLONG)user.dwHighDateTime << 32) | user.dwLowDateTime);
+}
+
+static void run_mixer_benchmark(IDirectSound8 *ds, DWORD rate, WORD channels, UINT count)
+{
+    IDirectSoundBuffer **buffers;
+    DSBUFFERDESC bufdesc;
+    WAVEFORMATEX fmt;
+    ULONGLONG start;
+    DWORD size, i, j;
+    SHORT *data;
+    HRESULT hr;
+
+    fmt.wFormatTag = WAVE_FORMAT_PCM;
+    fmt.nChannels = channels;
+    fmt.nSamplesPerSec = rate;
+    fmt.wBitsPerSample = 16;
+    fmt.nBlockAlign = fmt.nChannels * fmt.wBitsPerSample / 8;
+    fmt.nAvgBytesPerSec = fmt.nSamplesPerSec * fmt.nBlockAlign;
+    fmt.cbSize = 0;
+
+    bufdesc.dwSize = sizeof(bufdesc);
+    bufdesc.dwFlags = DSBCAPS_GETCURRENTPOSITION2 | DSBCAPS_CTRLVOLUME | DSBCAPS_CTRLFREQUENCY;
+    bufdesc.dwBufferBytes = fmt.nAvgBytesPerSec / 2;
+    bufdesc.dwReserved = 0;
+    bufdesc.lpwfxFormat = &fmt;
+    bufdesc.guid3DAlgorithm = GUID_NULL;
+
+    buffers = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, count * sizeof(*buffers));
+    for (i = 0; i < count; i++)
+    {
+        hr = IDirectSound8_CreateSoundBuffer(ds, &bufdesc, &buffers[i], NULL);
+        ok(hr == S_OK, "CreateSoundBuffer failed: %08x\n", hr);
+        if (hr != S_OK)
+            break;
+
+        hr = IDirectSoundBuffer_Lock(buffers[i], 0, 0, (void **)&data, &size, NULL, NULL, DSBLOCK_ENTIREBUFFER);
+        ok(hr == S_OK, "Lock failed: %08x\n", hr);
+        for (j = 0; j < size / sizeof(*data); j++)
+            data[j] = (SHORT)((j * (i + 1) * 97) & 0xfff) - 0x800;
+        IDirectSoundBuffer_Unlock(buffers[i], data, size, NULL, 0);
+
+        IDirectSoundBuffer_SetVolume(buffers[i], -600);
+        hr = IDirectSoundBuffer_Play(buffers[i], 0, 0, DSBPLAY_LOOPING);
+        ok(hr == S_OK, "Play failed: %08x\n", hr);
+    }
+
+    /* let the mixer pick up all buffers before measuring */
+    Sleep(200);
+    start = mixer_benchmark_cpu_time();
+    Sleep(2000);
+    trace("%u buffers, %u Hz, %u channels: %.1f%% CPU\n", count, rate, channels,
+            (mixer_benchmark_cpu_time() - start) / 20000.0 / 10.0);
+
+    for (i = 0; i < count && buffers[i]; i++)
+    {
+        IDirectSoundBuffer_Stop(buffers[i]);
+        IDirectSoundBuffer_Release(buffers[i]);
+    }
+    HeapFree(GetProcessHeap(), 0, buffers);
+}
+
+/* Measures the CPU time the mixer thread spends on many playing buffers.
+ * This needs a working default playback device, so it is only run
+ * interactively. */
+static void test_mixer_benchmark(void)
+{
+    IDirectSound8 *ds;
+    HRESULT hr;
+
+    hr = DirectSoundCreate8(NULL, &ds, NULL);
+    if (hr != S_OK)
+    {
+        skip("No playback device, hr %#x.\n", hr);
+        return;
+    }
+
+    hr = IDirectSound8_SetCooperativeLevel(ds, get_hwnd(), DSSCL_PRIORITY);
+    ok(hr == S_OK, "SetCooperativeLevel failed: %08x\n", hr);
+
+    run_mixer_benchmark(ds, 22050, 1, 128);
+    run_mixer_benchmark(ds, 44100, 2, 128);
+    run_mixer_benchmark(ds, 48000, 2, 128);
+
+    IDirectSound8_Release(ds);
+}
+
+/* A fake render endpoint, registered in place of the MMDevice enumerator,
+ * lets the mixer output be captured and compared against reference samples
+ * without a sound card. The device takes 44.1 kHz stereo float and asks
+ * for one 10 ms period per mixer pass. */
+
+#define TEST_DEVICE_RATE     44100
+#define TEST_DEVICE_PERIOD   441
+#define TEST_DEVICE_FRAMES   (3 * TEST_DEVICE_PERIOD)
+#define TEST_CAPTURE_FRAMES  (4 * TEST_DEVICE_RATE)
+
+static const GUID test_device_guid = {0x5f2a13c1, 0x77e0, 0x4b6a, {0x9d, 0x3e, 0x1a, 0x08, 0x52, 0xc4, 0x6e, 0x19}};
+
+static IMMDeviceEnumerator test_devenum;
+static IMMDeviceCollection test_devcoll;
+static IMMDevice test_device;
+static IPropertyStore test_propstore;
+static IAudioClient test_client;
+static IAudioRenderClient test_render;
+static IAudioStreamVolume test_volume;
+
+static HANDLE test_device_event;
+static float test_render_buffer[TEST_DEVICE_FRAMES * 2];
+static float *test_capture;
+static UINT test_capture_len;
+static BOOL test_capturing;
+static CRITICAL_SECTION test_capture_cs;
+
+static BOOL is_test_device_format(const WAVEFORMATEX *fmt)
+{
+    const WAVEFORMATEXTENSIBLE *ext = (const WAVEFORMATEXTENSIBLE *)fmt;
+
+    if (fmt->nChannels != 2 || fmt->nSamplesPerSec != TEST_DEVICE_RATE || fmt->wBitsPerSample != 32)
+        return FALSE;
+    if (fmt->wFormatTag == WAVE_FORMAT_IEEE_FLOAT)
+        return TRUE;
+    return fmt->wFormatTag == WAVE_FORMAT_EXTENSIBLE && IsEqualGUID(&ext->SubFormat, &KSDATAFORMAT_SUBTYPE_IEEE_FLOAT);
+}
+
+static HRESULT WINAPI devenum_QueryInterface(IMMDeviceEnumerator *iface, REFIID iid, void **out)
+{
+    if (IsEqualGUID(iid, &IID_IUnknown) || IsEqualGUID(iid, &IID_IMMDeviceEnumerator))
+    {
+        *out = iface;
+        return S_OK;
+    }
+    *out = NULL;
+    return E_NOINTERFACE;
+}
+
+static ULONG WINAPI devenum_AddRef(IMMDeviceEnumerator *iface)
+{
+    return 2;
+}
+
+static ULONG WINAPI devenum_Release(IMMDeviceEnumerator *iface)
+{
+    return 1;
+}
+
+static HRESULT WINAPI devenum_EnumAudioEndpoints(IMMDeviceEnumerator *iface, EDataFlow flow,
+        DWORD mask, IMMDeviceCollection **devices)
+{
+    *devices = &test_devcoll;
+    return S_OK;
+}
+
+static HRESULT WINAPI devenum_GetDefaultAudioEndpoint(IMMDeviceEnumerator *iface, EDataFlow flow,
+        ERole role, IMMDevice **device)
+{
+    if (flow != eRender)
+        return E_NOTFOUND;
+    *device = &test_device;
+    return S_OK;
+}
+
+static HRESULT WINAPI devenum_GetDevice(IMMDeviceEnumerator *iface, const WCHAR *id, IMMDevice **device)
+{
+    return E_NOTIMPL;
+}
+
+static HRESULT WINAPI devenum_RegisterEndpointNotificationCallback(IMMDeviceEnumerator *iface,
+        IMMNotificationClient *client)
+{
+    return S_OK;
+}
+
+static HRESULT WINAPI devenum_UnregisterEndpointNotificationCallback(IMMDeviceEnumerator *iface,
+        IMMNotificationClient *client)
+{
+    return S_OK;
+}
+
+static const IMMDeviceEnumeratorVtbl devenum_vtbl =
+{
+    devenum_QueryInterface,
+    devenum_AddRef,
+    devenum_Release,
+    devenum_EnumAudioEndpoints,
+    devenum_GetDefaultAudioEndpoint,
+    devenum_GetDevice,
+    devenum_RegisterEndpointNotificationCallback,
+    devenum_UnregisterEndpointNotificationCallback,
+};
+
+static IMMDeviceEnumerator test_devenum = {&devenum_vtbl};
+
+static HRESULT WINAPI devcoll_QueryInterface(IMMDeviceCollection *iface, REFIID iid, void **out)
+{
+    *out = NULL;
+    return E_NOINTERFACE;
+}
+
+static ULONG WINAPI devcoll_AddRef(IMMDeviceCollection *iface)
+{
+    return 2;
+}
+
+static ULONG WINAPI devcoll_Release(IMMDeviceCollection *iface)
+{
+    return 1;
+}
+
+static HRESULT WINAPI devcoll_GetCount(IMMDeviceCollection *iface, UINT *count)
+{
+    *count = 1;
+    return S_OK;
+}
+
+static HRESULT WINAPI devcoll_Item(IMMDeviceCollection *iface, UINT index, IMMDevice **device)
+{
+    if (index)
+        return E_INVALIDARG;
+    *device = &test_device;
+    return S_OK;
+}
+
+static const IMMDeviceCollectionVtbl devcoll_vtbl =
+{
+    devcoll_QueryInterface,
+    devcoll_AddRef,
+    devcoll_Release,
+    devcoll_GetCount,
+    devcoll_Item,
+};
+
+static IMMDeviceCollection test_devcoll = {&devcoll_vtbl};
+
+static HRESULT WINAPI device_QueryInterface(IMMDevice *iface, REFIID iid, void **out)
+{
+    if (IsEqualGUID(iid, &IID_IUnknown) || IsEqualGUID(iid, &IID_IMMDevice))
+    {
+        *out = iface;
+        return S_OK;
+    }
+    *out = NULL;
+    return E_NOINTERFACE;
+}
+
+static ULONG WINAPI device_AddRef(IMMDevice *iface)
+{
+    return 2;
+}
+
+static ULONG WINAPI device_Release(IMMDevice *iface)
+{
+    return 1;
+}
+
+static HRESULT WINAPI device_Activate(IMMDevice *iface, REFIID iid, DWORD clsctx,
+        PROPVARIANT *params, void **out)
+{
+    if (!IsEqualGUID(iid, &IID_IAudioClient))
+        return E_NOINTERFACE;
+    *out = &test_client;
+    return S_OK;
+}
+
+static HRESULT WINAPI device_OpenPropertyStore(IMMDevice *iface, DWORD access, IPropertyStore **store)
+{
+    *store = &test_propstore;
+    return S_OK;
+}
+
+static HRESULT WINAPI device_GetId(IMMDevice *iface, WCHAR **id)
+{
+    return E_NOTIMPL;
+}
+
+static HRESULT WINAPI device_GetState(IMMDevice *iface, DWORD *state)
+{
+    *state = DEVICE_STATE_ACTIVE;
+    return S_OK;
+}
+
+static const IMMDeviceVtbl device_vtbl =
+{
+    device_QueryInterface,
+    device_AddRef,
+    device_Release,
+    device_Activate,
+    device_OpenPropertyStore,
+    device_GetId,
+    device_GetState,
+};
+
+static IMMDevice test_device = {&device_vtbl};
+
+static HRESULT WINAPI propstore_QueryInterface(IPropertyStore *iface, REFIID iid, void **out)
+{
+    *out = NULL;
+    return E_NOINTERFACE;
+}
+
+static ULONG WINAPI propstore_AddRef(IPropertyStore *iface)
+{
+    return 2;
+}
+
+static ULONG WINAPI propstore_Release(IPropertyStore *iface)
+{
+    return 1;
+}
+
+static HRESULT WINAPI propstore_GetCount(IPropertyStore *iface, DWORD *count)
+{
+    return E_NOTIMPL;
+}
+
+static HRESULT WINAPI propstore_GetAt(IPropertyStore *iface, DWORD index, PROPERTYKEY *key)
+{
+    return E_NOTIMPL;
+}
+
+static HRESULT WINAPI propstore_GetValue(IPropertyStore *iface, REFPROPERTYKEY key, PROPVARIANT *pv)
+{
+    static const WCHAR name[] = L"Wine test device";
+
+    if (IsEqualPropertyKey(*key, PKEY_AudioEndpoint_GUID))
+    {
+        pv->vt = VT_LPWSTR;
+        pv->pwszVal = CoTaskMemAlloc(39 * sizeof(WCHAR));
+        StringFromGUID2(&test_device_guid, pv->pwszVal, 39);
+        return S_OK;
+    }
+    if (IsEqualPropertyKey(*key, DEVPKEY_Device_FriendlyName))
+    {
+        pv->vt = VT_LPWSTR;
+        pv->pwszVal = CoTaskMemAlloc(sizeof(name));
+        memcpy(pv->pwszVal, name, sizeof(name));
+        return S_OK;
+    }
+    pv->vt = VT_EMPTY;
+    return E_FAIL;
+}
+
+static HRESULT WINAPI propstore_SetValue(IPropertyStore *iface, REFPROPERTYKEY key, REFPROPVARIANT pv)
+{
+    return E_NOTIMPL;
+}
+
+static HRESULT WINAPI propstore_Commit(IPropertyStore *iface)
+{
+    return E_NOTIMPL;
+}
+
+static const IPropertyStoreVtbl propstore_vtbl =
+{
+    propstore_QueryInterface,
+    propstore_AddRef,
+    propstore_Release,
+    propstore_GetCount,
+    propstore_GetAt,
+    propstore_GetValue,
+    propstore_SetValue,
+    propstore_Commit,
+};
+
+static IPropertyStore test_propstore = {&propstore_vtbl};
+
+static HRESULT WINAPI client_QueryInterface(IAudioClient *iface, REFIID iid, void **out)
+{
+    if (IsEqualGUID(iid, &IID_IUnknown) || IsEqualGUID(iid, &IID_IAudioClient))
+    {
+        *out = iface;
+        return S_OK;
+    }
+    *out = NULL;
+    return E_NOINTERFACE;
+}
+
+static ULONG WINAPI client_AddRef(IAudioClient *iface)
+{
+    return 2;
+}
+
+static ULONG WINAPI client_Release(IAudioClient *iface)
+{
+    return 1;
+}
+
+static HRESULT WINAPI client_Initialize(IAudioClient *iface, AUDCLNT_SHAREMODE mode, DWORD flags,
+        REFERENCE_TIME duration, REFERENCE_TIME period, const WAVEFORMATEX *fmt, const GUID *session)
+{
+    ok(is_test_device_format(fmt), "Got unexpected device format.\n");
+    return S_OK;
+}
+
+static HRESULT WINAPI client_GetBufferSize(IAudioClient *iface, UINT32 *frames)
+{
+    *frames = TEST_DEVICE_RATE / 10;
+    return S_OK;
+}
+
+static HRESULT WINAPI client_GetStreamLatency(IAudioClient *iface, REFERENCE_TIME *latency)
+{
+    *latency = 100000;
+    return S_OK;
+}
+
+static HRESULT WINAPI client_GetCurrentPadding(IAudioClient *iface, UINT32 *frames)
+{
+    /* leave room for exactly one period, so that the mixer never skips input */
+    *frames = TEST_DEVICE_FRAMES - TEST_DEVICE_PERIOD;
+    return S_OK;
+}
+
+static HRESULT WINAPI client_IsFormatSupported(IAudioClient *iface, AUDCLNT_SHAREMODE mode,
+        const WAVEFORMATEX *fmt, WAVEFORMATEX **closest)
+{
+    if (closest)
+        *closest = NULL;
+    return is_test_device_format(fmt) ? S_OK : AUDCLNT_E_UNSUPPORTED_FORMAT;
+}
+
+static HRESULT WINAPI client_GetMixFormat(IAudioClient *iface, WAVEFORMATEX **fmt)
+{
+    WAVEFORMATEXTENSIBLE *ext = CoTaskMemAlloc(sizeof(*ext));
+
+    ext->Format.wFormatTag = WAVE_FORMAT_EXTENSIBLE;
+    ext->Format.nChannels = 2;
+    ext->Format.nSamplesPerSec = TEST_DEVICE_RATE;
+    ext->Format.wBitsPerSample = 32;
+    ext->Format.nBlockAlign = 2 * sizeof(float);
+    ext->Format.nAvgBytesPerSec = TEST_DEVICE_RATE * ext->Format.nBlockAlign;
+    ext->Format.cbSize = sizeof(*ext) - sizeof(ext->Format);
+    ext->Samples.wValidBitsPerSample = 32;
+    ext->dwChannelMask = SPEAKER_FRONT_LEFT | SPEAKER_FRONT_RIGHT;
+    ext->SubFormat = KSDATAFORMAT_SUBTYPE_IEEE_FLOAT;
+    *fmt = &ext->Format;
+    return S_OK;
+}
+
+static HRESULT WINAPI client_GetDevicePeriod(IAudioClient *iface, REFERENCE_TIME *period, REFERENCE_TIME *min_period)
+{
+    if (period)
+        *period = 100000;
+    if (min_period)
+        *min_period = 100000;
+    return S_OK;
+}
+
+static HRESULT WINAPI client_Start(IAudioClient *iface)
+{
+    return S_OK;
+}
+
+static HRESULT WINAPI client_Stop(IAudioClient *iface)
+{
+    return S_OK;
+}
+
+static HRESULT WINAPI client_Reset(IAudioClient *iface)
+{
+    return S_OK;
+}
+
+static HRESULT WINAPI client_SetEventHandle(IAudioClient *iface, HANDLE event)
+{
+    test_device_event = event;
+    return S_OK;
+}
+
+static HRESULT WINAPI client_GetService(IAudioClient *iface, REFIID iid, void **out)
+{
+    if (IsEqualGUID(iid, &IID_IAudioRenderClient))
+        *out = &test_render;
+    else if (IsEqualGUID(iid, &IID_IAudioStreamVolume))
+        *out = &test_volume;
+    else
+        return E_NOINTERFACE;
+    return S_OK;
+}
+
+static const IAudioClientVtbl client_vtbl =
+{
+    client_QueryInterface,
+    client_AddRef,
+    client_Release,
+    client_Initialize,
+    client_GetBufferSize,
+    client_GetStreamLatency,
+    client_GetCurrentPadding,
+    client_IsFormatSupported,
+    client_GetMixFormat,
+    client_GetDevicePeriod,
+    client_Start,
+    client_Stop,
+    client_Reset,
+    client_SetEventHandle,
+    client_GetService,
+};
+
+static IAudioClient test_client = {&client_vtbl};
+
+static HRESULT WINAPI render_QueryInterface(IAudioRenderClient *iface, REFIID iid, void **out)
+{
+    *out = NULL;
+    return E_NOINTERFACE;
+}
+
+static ULONG WINAPI render_AddRef(IAudioRenderClient *iface)
+{
+    return 2;
+}
+
+static ULONG WINAPI render_Release(IAudioRenderClient *iface)
+{
+    return 1;
+}
+
+static HRESULT WINAPI render_GetBuffer(IAudioRenderClient *iface, UINT32 frames, BYTE **data)
+{
+    if (frames > TEST_DEVICE_FRAMES)
+        return AUDCLNT_E_BUFFER_TOO_LARGE;
+    *data = (BYTE *)test_render_buffer;
+    return S_OK;
+}
+
+static HRESULT WINAPI render_ReleaseBuffer(IAudioRenderClient *iface, UINT32 frames, DWORD flags)
+{
+    EnterCriticalSection(&test_capture_cs);
+    if (test_capturing)
+    {
+        frames = min(frames, TEST_CAPTURE_FRAMES - test_capture_len);
+        memcpy(test_capture + 2 * test_capture_len, test_render_buffer, frames * 2 * sizeof(float));
+        test_capture_len += frames;
+    }
+    LeaveCriticalSection(&test_capture_cs);
+    return S_OK;
+}
+
+static const IAudioRenderClientVtbl render_vtbl =
+{
+    render_QueryInterface,
+    render_AddRef,
+    render_Release,
+    render_GetBuffer,
+    render_ReleaseBuffer,
+};
+
+static IAudioRenderClient test_render = {&render_vtbl};
+
+static HRESULT WINAPI volume_QueryInterface(IAudioStreamVolume *iface, REFIID iid, void **out)
+{
+    *out = NULL;
+    return E_NOINTERFACE;
+}
+
+static ULONG WINAPI volume_AddRef(IAudioStreamVolume *iface)
+{
+    return 2;
+}
+
+static ULONG WINAPI volume_Release(IAudioStreamVolume *iface)
+{
+    return 1;
+}
+
+static HRESULT WINAPI volume_GetChannelCount(IAudioStreamVolume *iface, UINT32 *count)
+{
+    *count = 2;
+    return S_OK;
+}
+
+static HRESULT WINAPI volume_SetChannelVolume(IAudioStreamVolume *iface, UINT32 index, const float level)
+{
+    return S_OK;
+}
+
+static HRESULT WINAPI volume_GetChannelVolume(IAudioStreamVolume *iface, UINT32 index, float *level)
+{
+    *level = 1.0f;
+    return S_OK;
+}
+
+static HRESULT WINAPI volume_SetAllVolumes(IAudioStreamVolume *iface, UINT32 count, const float *levels)
+{
+    return S_OK;
+}
+
+static HRESULT WINAPI volume_GetAllVolumes(IAudioStreamVolume *iface, UINT32 count, float *levels)
+{
+    while (count--)
+        levels[count] = 1.0f;
+    return S_OK;
+}
+
+static const IAudioStreamVolumeVtbl volume_vtbl =
+{
+    volume_QueryInterface,
+    volume_AddRef,
+    volume_Release,
+    volume_GetChannelCount,
+    volume_SetChannelVolume,
+    volume_GetChannelVolume,
+    volume_SetAllVolumes,
+    volume_GetAllVolumes,
+};
+
+static IAudioStreamVolume test_volume = {&volume_vtbl};
+
+static HRESULT WINAPI devenum_cf_QueryInterface(IClassFactory *iface, REFIID iid, void **out)
+{
+    if (IsEqualGUID(iid, &IID_IUnknown) || IsEqualGUID(iid, &IID_IClassFactory))
+    {
+        *out = iface;
+        return S_OK;
+    }
+    return E_NOINTERFACE;
+}
+
+static ULONG WINAPI devenum_cf_AddRef(IClassFactory *iface)
+{
+    return 2;
+}
+
+static ULONG WINAPI devenum_cf_Release(IClassFactory *iface)
+{
+    return 1;
+}
+
+static HRESULT WINAPI devenum_cf_CreateInstance(IClassFactory *iface, IUnknown *outer, REFIID iid, void **out)
+{
+    return IMMDeviceEnumerator_QueryInterface(&test_devenum, iid, out);
+}
+
+static HRESULT WINAPI devenum_cf_LockServer(IClassFactory *iface, BOOL lock)
+{
+    return S_OK;
+}
+
+static const IClassFactoryVtbl devenum_cf_vtbl =
+{
+    devenum_cf_QueryInterface,
+    devenum_cf_AddRef,
+    devenum_cf_Release,
+    devenum_cf_CreateInstance,
+    devenum_cf_LockServer,
+};
+
+static IClassFactory test_devenum_cf = {&devenum_cf_vtbl};
+
+/* Plays the data once, or looping until enough frames were mixed, and
+ * returns the captured device frames starting with the first audible one. */
+static const float *capture_mixer_output(IDirectSound8 *ds, WAVEFORMATEX *fmt, const void *data,
+        DWORD size, BOOL looping, UINT frames)
+{
+    DSBUFFERDESC bufdesc = {sizeof(bufdesc)};
+    IDirectSoundBuffer *buffer;
+    DWORD start_time, i;
+    void *ptr;
+    HRESULT hr;
+
+    bufdesc.dwFlags = DSBCAPS_GETCURRENTPOSITION2;
+    bufdesc.dwBufferBytes = size;
+    bufdesc.lpwfxFormat = fmt;
+    hr = IDirectSound8_CreateSoundBuffer(ds, &bufdesc, &buffer, NULL);
+    ok(hr == S_OK, "CreateSoundBuffer failed: %08x\n", hr);
+    if (hr != S_OK)
+        return NULL;
+
+    hr = IDirectSoundBuffer_Lock(buffer, 0, 0, &ptr, &size, NULL, NULL, DSBLOCK_ENTIREBUFFER);
+    ok(hr == S_OK, "Lock failed: %08x\n", hr);
+    memcpy(ptr, data, size);
+    IDirectSoundBuffer_Unlock(buffer, ptr, size, NULL, 0);
+
+    EnterCriticalSection(&test_capture_cs);
+    test_capture_len = 0;
+    test_capturing = TRUE;
+    LeaveCriticalSection(&test_capture_cs);
+
+    hr = IDirectSoundBuffer_Play(buffer, 0, 0, looping ? DSBPLAY_LOOPING : 0);
+    ok(hr == S_OK, "Play failed: %08x\n", hr);
+
+    /* run the mixer as fast as it goes, leaving room for the silence before the buffer starts */
+    start_time = GetTickCount();
+    while (test_capture_len < frames + 2 * TEST_DEVICE_FRAMES && GetTickCount() - start_time < 10000)
+    {
+        SetEvent(test_device_event);
+        Sleep(1);
+    }
+
+    IDirectSoundBuffer_Stop(buffer);
+    IDirectSoundBuffer_Release(buffer);
+
+    EnterCriticalSection(&test_capture_cs);
+    test_capturing = FALSE;
+    LeaveCriticalSection(&test_capture_cs);
+
+    for (i = 0; i < test_capture_len; i++)
+        if (test_capture[2 * i] || test_capture[2 * i + 1])
+            break;
+    ok(test_capture_len >= i + frames, "Captured %u frames, %u silent.\n", test_capture_len, i);
+    if (test_capture_len < i + frames)
+        return NULL;
+    return test_capture + 2 * i;
+}
+
+static void init_test_format(WAVEFORMATEX *fmt, WORD tag, DWORD rate, WORD bits, WORD channels)
+{
+    fmt->wFormatTag = tag;
+    fmt->nChannels = channels;
+    fmt->nSamplesPerSec = rate;
+    fmt->wBitsPerSample = bits;
+    fmt->nBlockAlign = channels * bits / 8;
+    fmt->nAvgBytesPerSec = rate * fmt->nBlockAlign;
+    fmt->cbSize = 0;
+}
+
+/* Without resampling, the converted samples must come out unchanged. */
+static void test_mixer_conversion(IDirectSound8 *ds, WORD tag, WORD bits, WORD channels,
+        UINT frames, UINT played)
+{
+    BYTE *data = HeapAlloc(GetProcessHeap(), 0, frames * channels * bits / 8);
+    float *expect = HeapAlloc(GetProcessHeap(), 0, frames * 2 * sizeof(float));
+    unsigned int i, c, errors = 0;
+    const float *out;
+    WAVEFORMATEX fmt;
+
+    init_test_format(&fmt, tag, TEST_DEVICE_RATE, bits, channels);
+
+    /* no sample is silent, so that the start of the buffer can be found */
+    for (i = 0; i < frames; i++)
+    {
+        for (c = 0; c < channels; c++)
+        {
+            unsigned int n = i * channels + c, v = (i * 2654435761u) ^ (c * 0x9e3779b9u);
+            float value;
+
+            switch (bits)
+            {
+            case 8:
+                data[n] = 1 + v % 255;
+                if (data[n] == 0x80)
+                    data[n]++;
+                value = (data[n] - 0x80) / (float)0x80;
+                break;
+            case 16:
+                ((SHORT *)data)[n] = (v >> 8) | 1;
+                value = ((SHORT *)data)[n] / (float)0x8000;
+                break;
+            case 24:
+                data[3 * n] = v;
+                data[3 * n + 1] = v >> 8;
+                data[3 * n + 2] = (v >> 16) | 1;
+                value = (LONG)((data[3 * n] << 8) | (data[3 * n + 1] << 16) | (data[3 * n + 2] << 24)) / (float)0x80000000u;
+                break;
+            default:
+                if (tag == WAVE_FORMAT_IEEE_FLOAT)
+                {
+                    ((float *)data)[n] = ((int)(v % 20001) - 10000) / 10000.0f;
+                    if (!((float *)data)[n])
+                        ((float *)data)[n] = 0.5f;
+                    value = ((float *)data)[n];
+                }
+                else
+                {
+                    ((LONG *)data)[n] = v | 1;
+                    value = ((LONG *)data)[n] / (float)0x80000000u;
+                }
+                break;
+            }
+            expect[2 * i + c] = value;
+            if (channels == 1)
+                expect[2 * i + 1] = value;
+        }
+    }
+
+    if ((out = capture_mixer_output(ds, &fmt, data, frames * fmt.nBlockAlign, played > frames, played)))
+    {
+        for (i = 0; i < played; i++)
+        {
+            for (c = 0; c < 2; c++)
+            {
+                if (out[2 * i + c] == expect[2 * (i % frames) + c])
+                    continue;
+                if (!errors++)
+                    ok(0, "%u bits, %u channels: frame %u channel %u: got %.8e, expected %.8e.\n", bits, channels,
+                            i, c, out[2 * i + c], expect[2 * (i % frames) + c]);
+            }
+        }
+        ok(!errors, "%u bits, %u channels: got %u wrong samples.\n", bits, channels, errors);
+
+        /* a buffer played once is followed by silence */
+        if (played == frames)
+            ok(!out[2 * frames] && !out[2 * frames + 1], "%u bits, %u channels: got %.8e %.8e after the end.\n",
+                    bits, channels, out[2 * frames], out[2 * frames + 1]);
+    }
+
+    HeapFree(GetProcessHeap(), 0, expect);
+    HeapFree(GetProcessHeap(), 0, data);
+}
+
+/* The resampled output of sine waves must be the same sine waves at the
+ * device rate. Fit them over the output, away from the filter transients,
+ * and check the amplitude and the largest deviation. */
+static void test_mixer_resampling(IDirectSound8 *ds, DWORD rate, WORD channels)
+{
+    static const double freqs[2] = {1000.0, 3000.0}, amps[2] = {0.5, 0.25};
+    UINT frames = rate / 4, out_frames = MulDiv(frames, TEST_DEVICE_RATE, rate) - 512;
+    SHORT *data = HeapAlloc(GetProcessHeap(), 0, frames * channels * sizeof(SHORT));
+    const float *out;
+    WAVEFORMATEX fmt;
+    unsigned int i, c;
+
+    init_test_format(&fmt, WAVE_FORMAT_PCM, rate, 16, channels);
+    for (i = 0; i < frames; i++)
+        for (c = 0; c < channels; c++)
+            data[i * channels + c] = floor(amps[c] * 32767.0 * sin(2.0 * M_PI * freqs[c] * i / rate) + 0.5);
+
+    if ((out = capture_mixer_output(ds, &fmt, data, frames * fmt.nBlockAlign, FALSE, out_frames)))
+    {
+        for (c = 0; c < 2; c++)
+        {
+            double w = 2.0 * M_PI * freqs[channels == 1 ? 0 : c] / TEST_DEVICE_RATE;
+            double ss = 0.0, cc = 0.0, sc = 0.0, ys = 0.0, yc = 0.0, det, a, b, amp, err, max_err = 0.0;
+
+            for (i = 256; i < out_frames; i++)
+            {
+                double s = sin(w * i), co = cos(w * i), y = out[2 * i + c];
+
+                ss += s * s;
+                cc += co * co;
+                sc += s * co;
+                ys += y * s;
+                yc += y * co;
+            }
+            det = ss * cc - sc * sc;
+            a = (ys * cc - yc * sc) / det;
+            b = (yc * ss - ys * sc) / det;
+            amp = sqrt(a * a + b * b);
+            for (i = 256; i < out_frames; i++)
+            {
+                err = fabs(out[2 * i + c] - a * sin(w * i) - b * cos(w * i));
+                if (err > max_err)
+                    max_err = err;
+            }
+
+            ok(fabs(amp - amps[channels == 1 ? 0 : c]) < 0.01, "%u Hz, channel %u: got amplitude %.4f.\n",
+                    rate, c, amp);
+            ok(max_err < 0.01, "%u Hz, channel %u: got deviation %.4f.\n", rate, c, max_err);
+        }
+    }
+
+    HeapFree(GetProcessHeap(), 0, data);
+}
+
+static void test_mixer_output(void)
+{
+    IDirectSound8 *ds;
+    DWORD cookie;
+    HRESULT hr;
+
+    if (strcmp(winetest_platform, "wine"))
+    {
+        skip("The fake audio device only works with Wine's dsound.\n");
+        return;
+    }
+
+    hr = CoRegisterClassObject(&CLSID_MMDeviceEnumerator, (IUnknown *)&test_devenum_cf,
+            CLSCTX_INPROC_SERVER, REGCLS_MULTIPLEUSE, &cookie);
+    ok(hr == S_OK, "Failed to register class, hr %#x.\n", hr);
+
+    InitializeCriticalSection(&test_capture_cs);
+    test_capture = HeapAlloc(GetProcessHeap(), 0, TEST_CAPTURE_FRAMES * 2 * sizeof(float));
+
+    hr = DirectSoundCreate8(&test_device_guid, &ds, NULL);
+    ok(hr == S_OK, "DirectSoundCreate8 failed: %08x\n", hr);
+    if (hr == S_OK)
+    {
+        hr = IDirectSound8_SetCooperativeLevel(ds, get_hwnd(), DSSCL_PRIORITY);
+        ok(hr == S_OK, "SetCooperativeLevel failed: %08x\n", hr);
+
+        test_mixer_conversion(ds, WAVE_FORMAT_PCM, 8, 1, 1000, 1000);
+        test_mixer_conversion(ds, WAVE_FORMAT_PCM, 16, 2, 1000, 1000);
+        test_mixer_conversion(ds, WAVE_FORMAT_PCM, 24, 2, 1000, 1000);
+        test_mixer_conversion(ds, WAVE_FORMAT_PCM, 32, 1, 1000, 1000);
+        test_mixer_conversion(ds, WAVE_FORMAT_IEEE_FLOAT, 32, 2, 1000, 1000);
+        /* wrapping around a looping buffer */
+        test_mixer_conversion(ds, WAVE_FORMAT_PCM, 16, 1, 300, 2000);
+
+        test_mixer_resampling(ds, 22050, 1);
+        test_mixer_resampling(ds, 48000, 2);
+
+        IDirectSound8_Release(ds);
+    }
+
+    HeapFree(GetProcessHeap(), 0, test_capture);
+    DeleteCriticalSection(&test_capture_cs);
+    CoRevokeClassObject(cookie);
+}
+
 START_TEST(dsound8)
 {
     DWORD cookie;
@@ -1905,5 +2811,10 @@ START_TEST(dsound8)
 
     CoRevokeClassObject(cookie);
 
+    test_mixer_output();
+
+    if (winetest_interactive)
+        test_mixer_benchmark();
+
     CoUninitialize();
 }
@@ -1308,6 +1308,117 @@ static void test_dbcs_to_widechar(void)
     }
 }
 
+static void test_utf8_ascii_runs(void)
+{
+    char str[80], buf[80];
+    WCHAR strW[80], bufW[80];
+    int i, j, ret;
+
+    /* non-ASCII characters and invalid bytes at every position of a long ASCII string */
+    for (i = 0; i < 70; i++)
+    {
+        for (j = 0; j < 72; j++) str[j] = 'a' + j % 26;
+        str[i] = 0xc3;
+        str[i + 1] = 0xa9;
+        memset(bufW, 0xcc, sizeof(bufW));
+        ret = MultiByteToWideChar(CP_UTF8, 0, str, 72, bufW, ARRAY_SIZE(bufW));
+        ok(ret == 71, "%d: got %d\n", i, ret);
+        for (j = 0; j < ret; j++)
+        {
+            WCHAR expect = j < i ? 'a' + j % 26 : j == i ? 0xe9 : 'a' + (j + 1) % 26;
+            if (bufW[j] != expect) break;
+        }
+        ok(j == ret, "%d: wrong character %#x at %d\n", i, bufW[j], j);
+        ok(bufW[ret] == 0xcccc, "%d: buffer overrun\n", i);
+
+        ret = WideCharToMultiByte(CP_UTF8, 0, bufW, 71, buf, sizeof(buf), NULL, NULL);
+        ok(ret == 72 && !memcmp(buf, str, 72), "%d: got %d\n", i, ret);
+        ret = WideCharToMultiByte(CP_UTF8, 0, bufW, 71, NULL, 0, NULL, NULL);
+        ok(ret == 72, "%d: got %d\n", i, ret);
+
+        /* the destination ends in the middle of the ASCII run */
+        memset(buf, 0xcc, sizeof(buf));
+        SetLastError(0xdeadbeef);
+        ret = WideCharToMultiByte(CP_UTF8, 0, bufW, 71, buf, i + 1, NULL, NULL);
+        ok(!ret && GetLastError() == ERROR_INSUFFICIENT_BUFFER, "%d: got %d, error %u\n", i, ret, GetLastError());
+        ok(buf[i + 1] == (char)0xcc, "%d: buffer overrun\n", i);
+
+        str[i + 1] = 'x';
+        str[i] = 0xff;
+        ret = MultiByteToWideChar(CP_UTF8, 0, str, 72, bufW, ARRAY_SIZE(bufW));
+        ok(ret == 72 && bufW[i] == 0xfffd && bufW[i + 1] == 'x', "%d: got %d\n", i, ret);
+        ret = MultiByteToWideChar(CP_UTF8, 0, str, 72, NULL, 0);
+        ok(ret == 72, "%d: got %d\n", i, ret);
+        SetLastError(0xdeadbeef);
+        ret = MultiByteToWideChar(CP_UTF8, MB_ERR_INVALID_CHARS, str, 72, bufW, ARRAY_SIZE(bufW));
+        ok(!ret && GetLastError() == ERROR_NO_UNICODE_TRANSLATION, "%d: got %d, error %u\n", i, ret, GetLastError());
+
+        for (j = 0; j < 72; j++) strW[j] = 'a' + j % 26;
+        strW[i] = 0xd800;
+        SetLastError(0xdeadbeef);
+        ret = WideCharToMultiByte(CP_UTF8, WC_ERR_INVALID_CHARS, strW, 72, buf, sizeof(buf), NULL, NULL);
+        ok(!ret && GetLastError() == ERROR_NO_UNICODE_TRANSLATION, "%d: got %d, error %u\n", i, ret, GetLastError());
+    }
+}
+
+static const WCHAR *conversion_corpus[] =
+{
+    /* English */
+    L"The quick brown fox jumps over the lazy dog. Pack my box with five dozen liquor jugs. "
+    L"C:\\Program Files\\Common Files\\Microsoft Shared\\ink\\InkObj.dll, Version=10.0.19041.1",
+    /* French */
+    L"Le c\x0153ur d\x00e9\x00e7u mais l'\x00e2me plut\x00f4t na\x00efve, Lou\x00ffs r\x00eava "
+    L"de crapa\x00fcter en cano\x00eb au del\x00e0 des \x00eeles, pr\x00e8s du m\x00e4lstr\x00f6m o\x00f9 br\x00fblent les nov\x00e6.",
+    /* Russian */
+    L"\x0421\x044a\x0435\x0448\x044c \x0436\x0435 \x0435\x0449\x0451 \x044d\x0442\x0438\x0445 "
+    L"\x043c\x044f\x0433\x043a\x0438\x0445 \x0444\x0440\x0430\x043d\x0446\x0443\x0437\x0441\x043a\x0438\x0445 "
+    L"\x0431\x0443\x043b\x043e\x043a, \x0434\x0430 \x0432\x044b\x043f\x0435\x0439 \x0447\x0430\x044e.",
+    /* Japanese */
+    L"\x3044\x308d\x306f\x306b\x307b\x3078\x3068\x3061\x308a\x306c\x308b\x3092\x3000"
+    L"\x308f\x304b\x3088\x305f\x308c\x305d\x3064\x306d\x306a\x3089\x3080 (ASCII text) \xd83d\xde00",
+};
+
+static void test_conversion_benchmark(void)
+{
+    static const UINT codepages[] = { CP_UTF8, CP_ACP };
+    char *buffer = HeapAlloc(GetProcessHeap(), 0, 1 << 20);
+    WCHAR *bufferW = HeapAlloc(GetProcessHeap(), 0, 1 << 21);
+    WCHAR *text = HeapAlloc(GetProcessHeap(), 0, 1 << 21);
+    unsigned int i, j, k, len, count, iterations = 200;
+    DWORD start, elapsed;
+
+    for (i = 0; i < ARRAY_SIZE(conversion_corpus); i++)
+    {
+        /* build about 512K characters of each corpus */
+        for (len = 0; len + lstrlenW(conversion_corpus[i]) < (1 << 19); len += lstrlenW(conversion_corpus[i]))
+            memcpy(text + len, conversion_corpus[i], lstrlenW(conversion_corpus[i]) * sizeof(WCHAR));
+
+        for (j = 0; j < ARRAY_SIZE(codepages); j++)
+        {
+            count = WideCharToMultiByte(codepages[j], 0, text, len, buffer, 1 << 20, NULL, NULL);
+            ok(count, "WideCharToMultiByte failed, error %u\n", GetLastError());
+
+            start = GetTickCount();
+            for (k = 0; k < iterations; k++)
+                WideCharToMultiByte(codepages[j], 0, text, len, buffer, 1 << 20, NULL, NULL);
+            elapsed = GetTickCount() - start;
+            trace("corpus %u, code page %u: WideCharToMultiByte %u MB in %u ms\n",
+                  i, codepages[j], len * iterations / (1 << 20), elapsed);
+
+            start = GetTickCount();
+            for (k = 0; k < iterations; k++)
+                MultiByteToWideChar(codepages[j], 0, buffer, count, bufferW, 1 << 20);
+            elapsed = GetTickCount() - start;
+            trace("corpus %u, code page %u: MultiByteToWideChar %u MB in %u ms\n",
+                  i, codepages[j], count * iterations / (1 << 20), elapsed);
+        }
+    }
+
+    HeapFree(GetProcessHeap(), 0, text);
+    HeapFree(GetProcessHeap(), 0, bufferW);
+    HeapFree(GetProcessHeap(), 0, buffer);
+}
+
 START_TEST(codepage)
 {
     BOOL bUsedDefaultChar;
@@ -1330,4 +1441,6 @@ START_TEST(codepage)
     test_threadcp();
 
     test_dbcs_to_widechar();
+    test_utf8_ascii_runs();
+    if (winetest_interactive) test_conversion_benchmark();
 }
@@ -2075,6 +2075,70 @@ static void test_CompareStringW(void)
     ok(ret == CSTR_LESS_THAN, "expected CSTR_LESS_THAN, got %d\n", ret);
     ret = CompareStringW(CP_ACP, NORM_IGNORENONSPACE, A_NULL_BC, 4, A_ACUTE_BC_DECOMP, 5);
     todo_wine ok(ret == CSTR_EQUAL, "expected CSTR_EQUAL, got %d\n", ret);
+
+    /* differences in the primary weights win over earlier diacritic or case differences */
+    ret = CompareStringW(CP_ACP, 0, L"Abc", -1, L"abd", -1);
+    ok(ret == CSTR_LESS_THAN, "expected CSTR_LESS_THAN, got %d\n", ret);
+    ret = CompareStringW(CP_ACP, 0, L"abd", -1, L"Abc", -1);
+    ok(ret == CSTR_GREATER_THAN, "expected CSTR_GREATER_THAN, got %d\n", ret);
+    ret = CompareStringW(CP_ACP, 0, L"r\xe9sume", -1, L"resumf", -1);
+    ok(ret == CSTR_LESS_THAN, "expected CSTR_LESS_THAN, got %d\n", ret);
+    ret = CompareStringW(CP_ACP, 0, L"resume", -1, L"Resume", -1);
+    ok(ret == CSTR_LESS_THAN, "expected CSTR_LESS_THAN, got %d\n", ret);
+    ret = CompareStringW(CP_ACP, NORM_IGNORECASE, L"resume", -1, L"Resume", -1);
+    ok(ret == CSTR_EQUAL, "expected CSTR_EQUAL, got %d\n", ret);
+    /* and diacritic differences win over earlier case differences */
+    ret = CompareStringW(CP_ACP, 0, L"Resume", -1, L"r\xe9sum\xe9", -1);
+    ok(ret == CSTR_LESS_THAN, "expected CSTR_LESS_THAN, got %d\n", ret);
+    ret = CompareStringW(CP_ACP, 0, L"R\xe9sum\xe9", -1, L"resume", -1);
+    ok(ret == CSTR_GREATER_THAN, "expected CSTR_GREATER_THAN, got %d\n", ret);
+    ret = CompareStringW(CP_ACP, NORM_IGNORENONSPACE, L"Resume", -1, L"r\xe9sum\xe9", -1);
+    ok(ret == CSTR_GREATER_THAN, "expected CSTR_GREATER_THAN, got %d\n", ret);
+}
+
+static const WCHAR *collation_corpus[] =
+{
+    L"Smith, John", L"smith, john", L"Smythe, Jane", L"O'Brien, Patrick", L"Obrien, Pat",
+    L"van der Berg, Anna", L"Van Der Berg, Anna", L"M\xfcller, J\xfcrgen", L"Mueller, Juergen",
+    L"Andr\xe9 Dupont", L"Andre Dupont", L"Zo\xeb Saldana", L"co-op", L"coop", L"Coop",
+    L"C:\\Program Files\\Common Files\\System", L"C:\\Program Files (x86)\\Common Files",
+    L"C:\\Windows\\system32\\drivers\\etc\\hosts", L"c:\\windows\\System32\\kernel32.dll",
+    L"Invoice 2021-0001", L"Invoice 2021-0002", L"invoice 2021-0010", L"Report Q1.xlsx",
+    L"Report Q2.xlsx", L"report q10.xlsx", L"readme.txt", L"README.TXT", L"ReadMe",
+    L"\x00c5ngstr\xf6m", L"Angstrom", L"stra\xdf" L"e", L"strasse", L"na\xefve", L"naive",
+    L"\x0410\x043b\x0435\x043a\x0441\x0435\x0439", L"\x65e5\x672c\x8a9e", L"",
+};
+
+static void test_CompareString_benchmark(void)
+{
+    static const DWORD flags[] = { 0, NORM_IGNORECASE, NORM_IGNORECASE | NORM_IGNORENONSPACE | NORM_IGNORESYMBOLS };
+    unsigned int i, j, k, n, count = ARRAY_SIZE(collation_corpus), iterations = 2000, failures;
+    DWORD start, elapsed;
+    BYTE key[512];
+
+    for (k = 0; k < ARRAY_SIZE(flags); k++)
+    {
+        failures = 0;
+        start = GetTickCount();
+        for (n = 0; n < iterations; n++)
+            for (i = 0; i < count; i++)
+                for (j = 0; j < count; j++)
+                    if (!CompareStringW(LOCALE_USER_DEFAULT, flags[k], collation_corpus[i], -1,
+                                        collation_corpus[j], -1)) failures++;
+        elapsed = GetTickCount() - start;
+        ok(!failures, "CompareStringW failed %u times\n", failures);
+        trace("CompareStringW flags %#x: %u comparisons in %u ms\n", flags[k], iterations * count * count, elapsed);
+    }
+
+    failures = 0;
+    start = GetTickCount();
+    for (n = 0; n < iterations; n++)
+        for (i = 0; i < count; i++)
+            if (!LCMapStringW(LOCALE_USER_DEFAULT, LCMAP_SORTKEY, collation_corpus[i], -1,
+                              (WCHAR *)key, sizeof(key))) failures++;
+    elapsed = GetTickCount() - start;
+    ok(!failures, "LCMapStringW failed %u times\n", failures);
+    trace("LCMapStringW LCMAP_SORTKEY: %u keys in %u ms\n", iterations * count, elapsed);
 }
 
 struct comparestringex_test {
@@ -6263,6 +6327,24 @@ static void test_NormalizeString(void)
     ok( dstlen == 3, "wrong len %d\n", dstlen );
     ok(GetLastError() == ERROR_SUCCESS, "got error %u\n", GetLastError());
 
+    /* already normalized strings */
+    SetLastError(0xdeadbeef);
+    dstlen = pNormalizeString( NormalizationC, part0_nfc2, -1, dst, 3 );
+    ok( dstlen == 3, "wrong len %d\n", dstlen );
+    ok(GetLastError() == ERROR_SUCCESS, "got error %u\n", GetLastError());
+    ok( !wcscmp( dst, part0_nfc2 ), "wrong string %s\n", wine_dbgstr_w(dst) );
+
+    SetLastError(0xdeadbeef);
+    dstlen = pNormalizeString( NormalizationD, part0_nfd1, -1, dst, 2 );
+    ok( dstlen <= 0, "wrong len %d\n", dstlen );
+    ok(GetLastError() == ERROR_INSUFFICIENT_BUFFER, "got error %u\n", GetLastError());
+
+    SetLastError(0xdeadbeef);
+    dstlen = pNormalizeString( NormalizationKC, L"file name.txt", 13, dst, 13 );
+    ok( dstlen == 13, "wrong len %d\n", dstlen );
+    ok(GetLastError() == ERROR_SUCCESS, "got error %u\n", GetLastError());
+    ok( !wcsncmp( dst, L"file name.txt", 13 ), "wrong string %s\n", wine_dbgstr_wn(dst, 13) );
+
     SetLastError(0xdeadbeef);
     dstlen = pNormalizeString( NormalizationC, part0_str2, 0, NULL, 0 );
     ok( dstlen == 0, "wrong len %d\n", dstlen );
@@ -7153,6 +7235,7 @@ START_TEST(locale)
   test_CompareStringA();
   test_CompareStringW();
   test_CompareStringEx();
+  if (winetest_interactive) test_CompareString_benchmark();
   test_LCMapStringA();
   test_LCMapStringW();
   test_LCMapStringEx();
@@ -2164,6 +2164,55 @@ static int wcstombs_codepage( UINT codepage, DWORD flags, const WCHAR *src, int
 }
 
 
+/* Latin-1 characters are looked up in a flat copy of the collation table,
+ * along with the properties that decide whether the comparison loops can
+ * handle them without decomposing or skipping anything. */
+
+#define SORT_COMPLEX 0x01  /* decomposes or has a zero weight */
+#define SORT_SYMBOL  0x02  /* ignored with NORM_IGNORESYMBOLS */
+#define SORT_HYPHEN  0x04  /* ignored in the first pass without SORT_STRINGSORT */
+
+static unsigned int latin1_collation[256];
+static BYTE latin1_sort_flags[256];
+
+static BOOL CALLBACK init_latin1_collation( INIT_ONCE *once, void *param, void **context )
+{
+    unsigned int ch, ce, len;
+
+    for (ch = 0; ch < 256; ch++)
+    {
+        ce = collation_table[collation_table[collation_table[0] + (ch >> 4)] + (ch & 0xf)];
+        latin1_collation[ch] = ce;
+        if (ce == ~0u || !(ce >> 16) || !(ce & 0xff00) || !(ce & 0xf0) || get_decomposition( ch, &len ))
+            latin1_sort_flags[ch] |= SORT_COMPLEX;
+        if (get_char_type( CT_CTYPE1, ch ) & (C1_PUNCT | C1_SPACE))
+            latin1_sort_flags[ch] |= SORT_SYMBOL;
+        if (ch == '-' || ch == '\'')
+            latin1_sort_flags[ch] |= SORT_HYPHEN;
+    }
+    return TRUE;
+}
+
+static inline void init_collation(void)
+{
+    static INIT_ONCE init_once = INIT_ONCE_STATIC_INIT;
+
+    InitOnceExecuteOnce( &init_once, init_latin1_collation, NULL, NULL );
+}
+
+static inline unsigned int get_collation_element( WCHAR ch )
+{
+    if (ch < 256) return latin1_collation[ch];
+    return collation_table[collation_table[collation_table[ch >> 8] + ((ch >> 4) & 0x0f)] + (ch & 0xf)];
+}
+
+static inline BOOL is_sort_symbol( WCHAR ch )
+{
+    if (ch < 256) return latin1_sort_flags[ch] & SORT_SYMBOL;
+    return get_char_type( CT_CTYPE1, ch ) & (C1_PUNCT | C1_SPACE);
+}
+
+
 static int get_sortkey( DWORD flags, const WCHAR *src, int srclen, char *dst, int dstlen )
 {
     WCHAR dummy[4]; /* no decomposition is larger than 4 chars */
@@ -2172,6 +2221,7 @@ static int get_sortkey( DWORD flags, const WCHAR *src, int srclen, char *dst, in
     const WCHAR *src_save = src;
     int srclen_save = srclen;
 
+    init_collation();
     key_len[0] = key_len[1] = key_len[2] = key_len[3] = 0;
     for (; srclen; srclen--, src++)
     {
@@ -2184,13 +2234,12 @@ static int get_sortkey( DWORD flags, const WCHAR *src, int srclen, char *dst, in
                 WCHAR wch = dummy[i];
                 unsigned int ce;
 
-                if ((flags & NORM_IGNORESYMBOLS) &&
-                    (get_char_type( CT_CTYPE1, wch ) & (C1_PUNCT | C1_SPACE)))
+                if ((flags & NORM_IGNORESYMBOLS) && is_sort_symbol( wch ))
                     continue;
 
                 if (flags & NORM_IGNORECASE) wch = casemap( nls_info.LowerCaseTable, wch );
 
-                ce = collation_table[collation_table[collation_table[wch >> 8] + ((wch >> 4) & 0x0f)] + (wch & 0xf)];
+                ce = get_collation_element( wch );
                 if (ce != (unsigned int)-1)
                 {
                     if (ce >> 16) key_len[0] += 2;
@@ -2238,13 +2287,12 @@ static int get_sortkey( DWORD flags, const WCHAR *src, int srclen, char *dst, in
                 WCHAR wch = dummy[i];
                 unsigned int ce;
 
-                if ((flags & NORM_IGNORESYMBOLS) &&
-                    (get_char_type( CT_CTYPE1, wch ) & (C1_PUNCT | C1_SPACE)))
+                if ((flags & NORM_IGNORESYMBOLS) && is_sort_symbol( wch ))
                     continue;
 
                 if (flags & NORM_IGNORECASE) wch = casemap( nls_info.LowerCaseTable, wch );
 
-                ce = collation_table[collation_table[collation_table[wch >> 8] + ((wch >> 4) & 0x0f)] + (wch & 0xf)];
+                ce = get_collation_element( wch );
                 if (ce != (unsigned int)-1)
                 {
                     WCHAR key;
@@ -2503,7 +2551,7 @@ static unsigned int get_weight( WCHAR ch, enum weight type )
 {
     unsigned int ret;
 
-    ret = collation_table[collation_table[collation_table[ch >> 8] + ((ch >> 4) & 0x0f)] + (ch & 0xf)];
+    ret = get_collation_element( ch );
     if (ret == ~0u) return ch;
 
     switch (type)
@@ -2612,6 +2660,55 @@ static int compare_weights(int flags, const WCHAR *str1, int len1,
 }
 
 
+/* Compare the strings with all the weights in a single pass for as long as
+ * both only contain characters that every pass would step over in lockstep,
+ * and fall back to the per-weight passes for the remaining part. */
+static int compare_string( DWORD flags, const WCHAR *str1, int len1, const WCHAR *str2, int len2 )
+{
+    BYTE skip = SORT_COMPLEX;
+    int i, len = min( len1, len2 ), diacritic = 0, case_diff = 0, ret;
+    unsigned int ce1, ce2;
+    WCHAR ch1, ch2;
+
+    if (flags & NORM_IGNORESYMBOLS) skip |= SORT_SYMBOL;
+    if (!(flags & SORT_STRINGSORT)) skip |= SORT_HYPHEN;
+
+    init_collation();
+
+    for (i = 0; i < len; i++)
+    {
+        ch1 = str1[i];
+        ch2 = str2[i];
+        if ((ch1 | ch2) >= 256 || ((latin1_sort_flags[ch1] | latin1_sort_flags[ch2]) & skip)) break;
+        if (ch1 == ch2) continue;
+
+        ce1 = latin1_collation[ch1];
+        ce2 = latin1_collation[ch2];
+        if ((ret = (ce1 >> 16) - (ce2 >> 16))) return ret;
+        if (!diacritic) diacritic = ((ce1 >> 8) & 0xff) - ((ce2 >> 8) & 0xff);
+        if (!case_diff) case_diff = ((ce1 >> 4) & 0x0f) - ((ce2 >> 4) & 0x0f);
+    }
+
+    str1 += i;
+    str2 += i;
+    len1 -= i;
+    len2 -= i;
+
+    if ((ret = compare_weights( flags, str1, len1, str2, len2, UNICODE_WEIGHT ))) return ret;
+    if (!(flags & NORM_IGNORENONSPACE))
+    {
+        if (diacritic) return diacritic;
+        if ((ret = compare_weights( flags, str1, len1, str2, len2, DIACRITIC_WEIGHT ))) return ret;
+    }
+    if (!(flags & NORM_IGNORECASE))
+    {
+        if (case_diff) return case_diff;
+        ret = compare_weights( flags, str1, len1, str2, len2, CASE_WEIGHT );
+    }
+    return ret;
+}
+
+
 static const struct geoinfo *get_geoinfo_ptr( GEOID geoid )
 {
     int min = 0, max = ARRAY_SIZE( geoinfodata )-1;
@@ -3086,14 +3183,7 @@ INT WINAPI CompareStringEx( const WCHAR *locale, DWORD flags, const WCHAR *str1,
     if (len1 < 0) len1 = lstrlenW(str1);
     if (len2 < 0) len2 = lstrlenW(str2);
 
-    ret = compare_weights( flags, str1, len1, str2, len2, UNICODE_WEIGHT );
-    if (!ret)
-    {
-        if (!(flags & NORM_IGNORENONSPACE))
-            ret = compare_weights( flags, str1, len1, str2, len2, DIACRITIC_WEIGHT );
-        if (!ret && !(flags & NORM_IGNORECASE))
-            ret = compare_weights( flags, str1, len1, str2, len2, CASE_WEIGHT );
-    }
+    ret = compare_string( flags, str1, len1, str2, len2 );
     if (!ret) return CSTR_EQUAL;
     return (ret < 0) ? CSTR_LESS_THAN : CSTR_GREATER_THAN;
 }
@@ -21,6 +21,10 @@
 #include <stdarg.h>
 #include "windef.h"
 
+#if defined(__i386__) || defined(__x86_64__)
+#include <intrin.h>
+#endif
+
 /* SHA1 algorithm
  *
  * Based on public domain SHA code by Steve Reid <steve@edmweb.com>
@@ -98,6 +102,95 @@ static void SHA1Transform(ULONG State[5], UCHAR Buffer[64])
    a = b = c = d = e = 0;
 }
 
+#if defined(__i386__) || defined(__x86_64__)
+
+static BOOL have_sha_ni(void)
+{
+   static int supported = -1;
+   int regs[4];
+
+   if (supported == -1)
+   {
+      supported = 0;
+      __cpuid(regs, 0);
+      if (regs[0] >= 7)
+      {
+         __cpuid(regs, 1);
+         /* SSSE3 and SSE4.1 */
+         if ((regs[2] & (1 << 9)) && (regs[2] & (1 << 19)))
+         {
+            __cpuidex(regs, 7, 0);
+            supported = !!(regs[1] & (1 << 29));
+         }
+      }
+   }
+   return supported;
+}
+
+/* Four rounds with the SHA extensions. "e" is the E value used for these
+ * rounds, "e_next" receives the current ABCD for the next group. The message
+ * schedule for group i + 1 is finished with sha1msg2 while the next groups
+ * are prepared with the xor and sha1msg1 steps. */
+#define ROUNDS4(e, e_next, cur, f) \
+   e = _mm_sha1nexte_epu32(e, cur); e_next = abcd; abcd = _mm_sha1rnds4_epu32(abcd, e, f)
+#define MSG2(next, cur)   next = _mm_sha1msg2_epu32(next, cur)
+#define MSG1(prev, cur)   prev = _mm_sha1msg1_epu32(prev, cur)
+#define XOR(next2, cur)   next2 = _mm_xor_si128(next2, cur)
+
+/* Hash "count" 512-bit blocks straight from the input buffer. */
+static void __attribute__((target("sha,ssse3,sse4.1"))) SHA1Transform_sha_ni(ULONG State[5], const UCHAR *Buffer, ULONG count)
+{
+   const __m128i mask = _mm_set_epi64x(0x0001020304050607ULL, 0x08090a0b0c0d0e0fULL);
+   __m128i abcd, abcd_save, e0, e0_save, e1, m0, m1, m2, m3;
+
+   abcd = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)State), 0x1b);
+   e0 = _mm_set_epi32(State[4], 0, 0, 0);
+
+   for (; count; count--, Buffer += 64)
+   {
+      abcd_save = abcd;
+      e0_save = e0;
+
+      m0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)Buffer), mask);
+      m1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(Buffer + 16)), mask);
+      m2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(Buffer + 32)), mask);
+      m3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(Buffer + 48)), mask);
+
+      e0 = _mm_add_epi32(e0, m0); e1 = abcd; abcd = _mm_sha1rnds4_epu32(abcd, e0, 0);
+      ROUNDS4(e1, e0, m1, 0); MSG1(m0, m1);
+      ROUNDS4(e0, e1, m2, 0); MSG1(m1, m2); XOR(m0, m2);
+      ROUNDS4(e1, e0, m3, 0); MSG2(m0, m3); MSG1(m2, m3); XOR(m1, m3);
+      ROUNDS4(e0, e1, m0, 0); MSG2(m1, m0); MSG1(m3, m0); XOR(m2, m0);
+      ROUNDS4(e1, e0, m1, 1); MSG2(m2, m1); MSG1(m0, m1); XOR(m3, m1);
+      ROUNDS4(e0, e1, m2, 1); MSG2(m3, m2); MSG1(m1, m2); XOR(m0, m2);
+      ROUNDS4(e1, e0, m3, 1); MSG2(m0, m3); MSG1(m2, m3); XOR(m1, m3);
+      ROUNDS4(e0, e1, m0, 1); MSG2(m1, m0); MSG1(m3, m0); XOR(m2, m0);
+      ROUNDS4(e1, e0, m1, 1); MSG2(m2, m1); MSG1(m0, m1); XOR(m3, m1);
+      ROUNDS4(e0, e1, m2, 2); MSG2(m3, m2); MSG1(m1, m2); XOR(m0, m2);
+      ROUNDS4(e1, e0, m3, 2); MSG2(m0, m3); MSG1(m2, m3); XOR(m1, m3);
+      ROUNDS4(e0, e1, m0, 2); MSG2(m1, m0); MSG1(m3, m0); XOR(m2, m0);
+      ROUNDS4(e1, e0, m1, 2); MSG2(m2, m1); MSG1(m0, m1); XOR(m3, m1);
+      ROUNDS4(e0, e1, m2, 2); MSG2(m3, m2); MSG1(m1, m2); XOR(m0, m2);
+      ROUNDS4(e1, e0, m3, 3); MSG2(m0, m3); MSG1(m2, m3); XOR(m1, m3);
+      ROUNDS4(e0, e1, m0, 3); MSG2(m1, m0); MSG1(m3, m0); XOR(m2, m0);
+      ROUNDS4(e1, e0, m1, 3); MSG2(m2, m1); XOR(m3, m1);
+      ROUNDS4(e0, e1, m2, 3); MSG2(m3, m2);
+      ROUNDS4(e1, e0, m3, 3);
+
+      e0 = _mm_sha1nexte_epu32(e0, e0_save);
+      abcd = _mm_add_epi32(abcd, abcd_save);
+   }
+
+   _mm_storeu_si128((__m128i *)State, _mm_shuffle_epi32(abcd, 0x1b));
+   State[4] = _mm_extract_epi32(e0, 3);
+}
+
+#undef ROUNDS4
+#undef MSG2
+#undef MSG1
+#undef XOR
+
+#endif
 
 /******************************************************************************
  * A_SHAInit (ntdll.@)
@@ -150,6 +243,22 @@ void WINAPI A_SHAUpdate(PSHA_CTX Context, const unsigned char *Buffer, UINT Buff
       RtlCopyMemory(&Context->Buffer[BufferContentSize], Buffer,
                     BufferSize);
    }
+#if defined(__i386__) || defined(__x86_64__)
+   else if (have_sha_ni())
+   {
+      /* the SHA extensions don't modify the block, hash the input in place */
+      if (BufferContentSize)
+      {
+         RtlCopyMemory(Context->Buffer + BufferContentSize, Buffer,
+                       64 - BufferContentSize);
+         Buffer += 64 - BufferContentSize;
+         BufferSize -= 64 - BufferContentSize;
+         SHA1Transform_sha_ni(Context->State, Context->Buffer, 1);
+      }
+      SHA1Transform_sha_ni(Context->State, Buffer, BufferSize / 64);
+      RtlCopyMemory(Context->Buffer, Buffer + (BufferSize & ~63), BufferSize & 63);
+   }
+#endif
    else
    {
       while (BufferContentSize + BufferSize >= 64)
@@ -32,6 +32,10 @@
 #include "ntdll_misc.h"
 #include "wine/debug.h"
 
+#if defined(__i386__) || defined(__x86_64__)
+#include <intrin.h>
+#endif
+
 WINE_DEFAULT_DEBUG_CHANNEL(nls);
 
 /* NLS codepage file format:
@@ -197,6 +201,192 @@ static void put_utf16( WCHAR *dst, unsigned int ch )
 }
 
 
+/* Runs of 7-bit ASCII are by far the most common input of the conversion
+ * functions, so they are handled a vector at a time. The helpers below return
+ * the length of the ASCII prefix of src, copying it to dst unless dst is NULL.
+ */
+
+#if defined(__i386__) || defined(__x86_64__)
+
+static BOOL have_sse2(void)
+{
+#ifdef __x86_64__
+    return TRUE;
+#else
+    static int supported = -1;
+    int regs[4];
+
+    if (supported == -1)
+    {
+        __cpuid( regs, 1 );
+        supported = !!(regs[3] & (1 << 26));
+    }
+    return supported;
+#endif
+}
+
+static BOOL have_avx2(void)
+{
+    static int supported = -1;
+    unsigned int xcr0_lo, xcr0_hi;
+    int regs[4];
+
+    if (supported == -1)
+    {
+        supported = 0;
+        __cpuid( regs, 0 );
+        if (regs[0] >= 7)
+        {
+            __cpuid( regs, 1 );
+            /* OSXSAVE and AVX, then check that the OS saves the YMM state */
+            if ((regs[2] & (1 << 27)) && (regs[2] & (1 << 28)))
+            {
+                __asm__ ( "xgetbv" : "=a" (xcr0_lo), "=d" (xcr0_hi) : "c" (0) );
+                __cpuidex( regs, 7, 0 );
+                supported = (xcr0_lo & 6) == 6 && (regs[1] & (1 << 5));
+            }
+        }
+    }
+    return supported;
+}
+
+static unsigned int __attribute__((target("sse2"))) ascii_to_utf16_sse2( WCHAR *dst, const char *src,
+                                                                         unsigned int len )
+{
+    const __m128i zero = _mm_setzero_si128();
+    unsigned int pos;
+    __m128i v;
+
+    for (pos = 0; pos + 16 <= len; pos += 16)
+    {
+        v = _mm_loadu_si128( (const __m128i *)(src + pos) );
+        if (_mm_movemask_epi8( v )) break;
+        if (!dst) continue;
+        _mm_storeu_si128( (__m128i *)(dst + pos), _mm_unpacklo_epi8( v, zero ));
+        _mm_storeu_si128( (__m128i *)(dst + pos + 8), _mm_unpackhi_epi8( v, zero ));
+    }
+    return pos;
+}
+
+static unsigned int __attribute__((target("avx2"))) ascii_to_utf16_avx2( WCHAR *dst, const char *src,
+                                                                         unsigned int len )
+{
+    unsigned int pos;
+    __m256i v;
+
+    for (pos = 0; pos + 32 <= len; pos += 32)
+    {
+        v = _mm256_loadu_si256( (const __m256i *)(src + pos) );
+        if (_mm256_movemask_epi8( v )) break;
+        if (!dst) continue;
+        _mm256_storeu_si256( (__m256i *)(dst + pos), _mm256_cvtepu8_epi16( _mm256_castsi256_si128( v )));
+        _mm256_storeu_si256( (__m256i *)(dst + pos + 16), _mm256_cvtepu8_epi16( _mm256_extracti128_si256( v, 1 )));
+    }
+    return pos;
+}
+
+static unsigned int __attribute__((target("sse2"))) utf16_to_ascii_sse2( char *dst, const WCHAR *src,
+                                                                         unsigned int len )
+{
+    const __m128i zero = _mm_setzero_si128(), mask = _mm_set1_epi16( (short)0xff80 );
+    unsigned int pos;
+    __m128i v1, v2;
+
+    for (pos = 0; pos + 16 <= len; pos += 16)
+    {
+        v1 = _mm_loadu_si128( (const __m128i *)(src + pos) );
+        v2 = _mm_loadu_si128( (const __m128i *)(src + pos + 8) );
+        if (_mm_movemask_epi8( _mm_cmpeq_epi16( _mm_and_si128( _mm_or_si128( v1, v2 ), mask ), zero )) != 0xffff)
+            break;
+        if (dst) _mm_storeu_si128( (__m128i *)(dst + pos), _mm_packus_epi16( v1, v2 ));
+    }
+    return pos;
+}
+
+static unsigned int __attribute__((target("avx2"))) utf16_to_ascii_avx2( char *dst, const WCHAR *src,
+                                                                         unsigned int len )
+{
+    const __m256i mask = _mm256_set1_epi16( (short)0xff80 );
+    unsigned int pos;
+    __m256i v1, v2;
+
+    for (pos = 0; pos + 32 <= len; pos += 32)
+    {
+        v1 = _mm256_loadu_si256( (const __m256i *)(src + pos) );
+        v2 = _mm256_loadu_si256( (const __m256i *)(src + pos + 16) );
+        if (!_mm256_testz_si256( _mm256_or_si256( v1, v2 ), mask )) break;
+        /* the packing works on each 128-bit lane, put the quadwords back in order */
+        if (dst) _mm256_storeu_si256( (__m256i *)(dst + pos),
+                                      _mm256_permute4x64_epi64( _mm256_packus_epi16( v1, v2 ), 0xd8 ));
+    }
+    return pos;
+}
+
+#endif
+
+static unsigned int ascii_to_utf16( WCHAR *dst, const char *src, unsigned int len )
+{
+    unsigned int pos = 0;
+
+#if defined(__i386__) || defined(__x86_64__)
+    if (len >= 32 && have_avx2()) pos = ascii_to_utf16_avx2( dst, src, len );
+    else if (len >= 16 && have_sse2()) pos = ascii_to_utf16_sse2( dst, src, len );
+#else
+    for (; pos + 8 <= len; pos += 8)
+    {
+        UINT64 word;
+        unsigned int i;
+
+        memcpy( &word, src + pos, sizeof(word) );
+        if (word & 0x8080808080808080ull) break;
+        if (dst) for (i = 0; i < 8; i++) dst[pos + i] = (unsigned char)src[pos + i];
+    }
+#endif
+    for (; pos < len && !(src[pos] & 0x80); pos++) if (dst) dst[pos] = src[pos];
+    return pos;
+}
+
+static unsigned int utf16_to_ascii( char *dst, const WCHAR *src, unsigned int len )
+{
+    unsigned int pos = 0;
+
+#if defined(__i386__) || defined(__x86_64__)
+    if (len >= 32 && have_avx2()) pos = utf16_to_ascii_avx2( dst, src, len );
+    else if (len >= 16 && have_sse2()) pos = utf16_to_ascii_sse2( dst, src, len );
+#else
+    for (; pos + 4 <= len; pos += 4)
+    {
+        UINT64 word;
+        unsigned int i;
+
+        memcpy( &word, src + pos, sizeof(word) );
+        if (word & 0xff80ff80ff80ff80ull) break;
+        if (dst) for (i = 0; i < 4; i++) dst[pos + i] = src[pos + i];
+    }
+#endif
+    for (; pos < len && src[pos] < 0x80; pos++) if (dst) dst[pos] = src[pos];
+    return pos;
+}
+
+/* whether the 7-bit ASCII range of the code page maps to the same Unicode characters */
+static BOOL is_ascii_codepage( const CPTABLEINFO *info )
+{
+    unsigned int i;
+
+    for (i = 0; i < 0x80; i++)
+    {
+        if (info->MultiByteTable[i] != i) return FALSE;
+        if (info->DBCSOffsets && info->DBCSOffsets[i]) return FALSE;
+        if (info->DBCSCodePage)
+        {
+            if (((const WCHAR *)info->WideCharTable)[i] != i) return FALSE;
+        }
+        else if (((const char *)info->WideCharTable)[i] != i) return FALSE;
+    }
+    return TRUE;
+}
+
+
 static NTSTATUS load_norm_table( ULONG form, const struct norm_table **info )
 {
     unsigned int i;
@@ -813,14 +1003,25 @@ NTSTATUS WINAPI RtlHashUnicodeString( const UNICODE_STRING *string, BOOLEAN case
 NTSTATUS WINAPI RtlCustomCPToUnicodeN( CPTABLEINFO *info, WCHAR *dst, DWORD dstlen, DWORD *reslen,
                                        const char *src, DWORD srclen )
 {
-    DWORD i, ret;
+    DWORD i, ret, len;
+    BOOL ascii;
 
     dstlen /= sizeof(WCHAR);
+    ascii = min( srclen, dstlen ) >= 64 && is_ascii_codepage( info );
     if (info->DBCSOffsets)
     {
         for (i = dstlen; srclen && i; i--, srclen--, src++, dst++)
         {
             USHORT off = info->DBCSOffsets[(unsigned char)*src];
+            if (ascii && !(*src & 0x80))
+            {
+                len = ascii_to_utf16( dst, src, min( srclen, i )) - 1;
+                src += len;
+                dst += len;
+                srclen -= len;
+                i -= len;
+                continue;
+            }
             if (off && srclen > 1)
             {
                 src++;
@@ -834,7 +1035,15 @@ NTSTATUS WINAPI RtlCustomCPToUnicodeN( CPTABLEINFO *info, WCHAR *dst, DWORD dstl
     else
     {
         ret = min( srclen, dstlen );
-        for (i = 0; i < ret; i++) dst[i] = info->MultiByteTable[(unsigned char)src[i]];
+        if (ascii)
+        {
+            for (i = 0; i < ret; i++)
+            {
+                i += ascii_to_utf16( dst + i, src + i, ret - i );
+                if (i < ret) dst[i] = info->MultiByteTable[(unsigned char)src[i]];
+            }
+        }
+        else for (i = 0; i < ret; i++) dst[i] = info->MultiByteTable[(unsigned char)src[i]];
     }
     if (reslen) *reslen = ret * sizeof(WCHAR);
     return STATUS_SUCCESS;
@@ -847,15 +1056,26 @@ NTSTATUS WINAPI RtlCustomCPToUnicodeN( CPTABLEINFO *info, WCHAR *dst, DWORD dstl
 NTSTATUS WINAPI RtlUnicodeToCustomCPN( CPTABLEINFO *info, char *dst, DWORD dstlen, DWORD *reslen,
                                        const WCHAR *src, DWORD srclen )
 {
-    DWORD i, ret;
+    DWORD i, ret, len;
+    BOOL ascii;
 
     srclen /= sizeof(WCHAR);
+    ascii = min( srclen, dstlen ) >= 64 && is_ascii_codepage( info );
     if (info->DBCSCodePage)
     {
         WCHAR *uni2cp = info->WideCharTable;
 
         for (i = dstlen; srclen && i; i--, srclen--, src++)
         {
+            if (ascii && *src < 0x80)
+            {
+                len = utf16_to_ascii( dst, src, min( srclen, i ));
+                dst += len;
+                src += len - 1;
+                srclen -= len - 1;
+                i -= len - 1;
+                continue;
+            }
             if (uni2cp[*src] & 0xff00)
             {
                 if (i == 1) break;  /* do not output a partial char */
@@ -870,7 +1090,15 @@ NTSTATUS WINAPI RtlUnicodeToCustomCPN( CPTABLEINFO *info, char *dst, DWORD dstle
     {
         char *uni2cp = info->WideCharTable;
         ret = min( srclen, dstlen );
-        for (i = 0; i < ret; i++) dst[i] = uni2cp[src[i]];
+        if (ascii)
+        {
+            for (i = 0; i < ret; i++)
+            {
+                i += utf16_to_ascii( dst + i, src + i, ret - i );
+                if (i < ret) dst[i] = uni2cp[src[i]];
+            }
+        }
+        else for (i = 0; i < ret; i++) dst[i] = uni2cp[src[i]];
     }
     if (reslen) *reslen = ret;
     return STATUS_SUCCESS;
@@ -1317,7 +1545,13 @@ NTSTATUS WINAPI RtlUTF8ToUnicodeN( WCHAR *dst, DWORD dstlen, DWORD *reslen, cons
         for (len = 0; src < srcend; len++)
         {
             unsigned char ch = *src++;
-            if (ch < 0x80) continue;
+            if (ch < 0x80)
+            {
+                res = ascii_to_utf16( NULL, src, srcend - src );
+                src += res;
+                len += res;
+                continue;
+            }
             if ((res = decode_utf8_char( ch, &src, srcend )) > 0x10ffff)
                 status = STATUS_SOME_NOT_MAPPED;
             else
@@ -1333,6 +1567,9 @@ NTSTATUS WINAPI RtlUTF8ToUnicodeN( WCHAR *dst, DWORD dstlen, DWORD *reslen, cons
         if (ch < 0x80)  /* special fast case for 7-bit ASCII */
         {
             *dst++ = ch;
+            len = ascii_to_utf16( dst, src, min( srcend - src, dstend - dst ));
+            src += len;
+            dst += len;
             continue;
         }
         if ((res = decode_utf8_char( ch, &src, srcend )) <= 0xffff)
@@ -1364,7 +1601,7 @@ NTSTATUS WINAPI RtlUTF8ToUnicodeN( WCHAR *dst, DWORD dstlen, DWORD *reslen, cons
 NTSTATUS WINAPI RtlUnicodeToUTF8N( char *dst, DWORD dstlen, DWORD *reslen, const WCHAR *src, DWORD srclen )
 {
     char *end;
-    unsigned int val, len;
+    unsigned int val, len, run;
     NTSTATUS status = STATUS_SUCCESS;
 
     if (!src) return STATUS_INVALID_PARAMETER_4;
@@ -1377,7 +1614,13 @@ NTSTATUS WINAPI RtlUnicodeToUTF8N( char *dst, DWORD dstlen, DWORD *reslen, const
     {
         for (len = 0; srclen; srclen--, src++)
         {
-            if (*src < 0x80) len++;  /* 0x00-0x7f: 1 byte */
+            if (*src < 0x80)  /* 0x00-0x7f: 1 byte */
+            {
+                run = utf16_to_ascii( NULL, src + 1, srclen - 1 );
+                src += run;
+                srclen -= run;
+                len += run + 1;
+            }
             else if (*src < 0x800) len += 2;  /* 0x80-0x7ff: 2 bytes */
             else
             {
@@ -1407,6 +1650,10 @@ NTSTATUS WINAPI RtlUnicodeToUTF8N( char *dst, DWORD dstlen, DWORD *reslen, const
         {
             if (dst > end - 1) break;
             *dst++ = ch;
+            run = utf16_to_ascii( dst, src + 1, min( srclen - 1, end - dst ));
+            dst += run;
+            src += run;
+            srclen -= run;
             continue;
         }
         if (ch < 0x800)  /* 0x80-0x7ff: 2 bytes */
@@ -1454,21 +1701,14 @@ NTSTATUS WINAPI RtlUnicodeToUTF8N( char *dst, DWORD dstlen, DWORD *reslen, const
 }
 
 
-/******************************************************************************
- *      RtlIsNormalizedString   (NTDLL.@)
- */
-NTSTATUS WINAPI RtlIsNormalizedString( ULONG form, const WCHAR *str, INT len, BOOLEAN *res )
+/* Unicode quick check (UAX #15): result is 1 if the string is normalized,
+ * 0 if it isn't and -1 if only a full normalization can tell (QC=Maybe). */
+static NTSTATUS quick_check( const struct norm_table *info, const WCHAR *str, int len, int *ret )
 {
-    const struct norm_table *info;
-    NTSTATUS status;
     BYTE props, class, last_class = 0;
     unsigned int ch;
     int i, r, result = 1;
 
-    if ((status = load_norm_table( form, &info ))) return status;
-
-    if (len == -1) len = wcslen( str );
-
     for (i = 0; i < len && result; i += r)
     {
         if (!(r = get_utf16( str + i, len - i, &ch ))) return STATUS_NO_UNICODE_TRANSLATION;
@@ -1511,6 +1751,26 @@ NTSTATUS WINAPI RtlIsNormalizedString( ULONG form, const WCHAR *str, INT len, BO
         else last_class = 0;
     }
 
+    *ret = result;
+    return STATUS_SUCCESS;
+}
+
+
+/******************************************************************************
+ *      RtlIsNormalizedString   (NTDLL.@)
+ */
+NTSTATUS WINAPI RtlIsNormalizedString( ULONG form, const WCHAR *str, INT len, BOOLEAN *res )
+{
+    const struct norm_table *info;
+    NTSTATUS status;
+    int result;
+
+    if ((status = load_norm_table( form, &info ))) return status;
+
+    if (len == -1) len = wcslen( str );
+
+    if ((status = quick_check( info, str, len, &result ))) return status;
+
     if (result == -1)
     {
         int dstlen = len * 4;
@@ -1531,7 +1791,7 @@ NTSTATUS WINAPI RtlIsNormalizedString( ULONG form, const WCHAR *str, INT len, BO
  */
 NTSTATUS WINAPI RtlNormalizeString( ULONG form, const WCHAR *src, INT src_len, WCHAR *dst, INT *dst_len )
 {
-    int buf_len;
+    int buf_len, result;
     WCHAR *buf = NULL;
     const struct norm_table *info;
     NTSTATUS status = STATUS_SUCCESS;
@@ -1554,8 +1814,24 @@ NTSTATUS WINAPI RtlNormalizeString( ULONG form, const WCHAR *src, INT src_len, W
         return STATUS_SUCCESS;
     }
 
+    /* most strings are already normalized, return them as is */
+    if (*dst_len >= src_len && !quick_check( info, src, src_len, &result ) && result == 1)
+    {
+        memcpy( dst, src, src_len * sizeof(WCHAR) );
+        *dst_len = src_len;
+        return STATUS_SUCCESS;
+    }
+
     if (!info->comp_size) return decompose_string( info, src, src_len, dst, dst_len );
 
+    /* compose in place if the decomposed string fits in the destination */
+    buf_len = *dst_len;
+    if (!decompose_string( info, src, src_len, dst, &buf_len ))
+    {
+        *dst_len = compose_string( info, dst, buf_len );
+        return STATUS_SUCCESS;
+    }
+
     buf_len = src_len * 4;
     for (;;)
     {
@@ -1604,6 +1604,8 @@
 @ cdecl -syscall wine_server_fd_to_handle(long long long ptr)
 @ cdecl -syscall wine_server_handle_to_fd(long long ptr ptr)
 @ cdecl -syscall __wine_make_process_system()
+@ cdecl -syscall __wine_add_fd_completion(long long long long long)
+@ cdecl -syscall __wine_set_client_io_callback(ptr)
 
 # Unix interface
 @ cdecl __wine_set_unix_funcs(long ptr)
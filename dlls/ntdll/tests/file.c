@@ -1079,6 +1079,241 @@ static void test_set_io_completion(void)
     pNtClose( h );
 }
 
+static DWORD WINAPI remove_io_completion_thread( void *arg )
+{
+    HANDLE h = arg;
+    IO_STATUS_BLOCK iosb;
+    ULONG_PTR key, value;
+    NTSTATUS res;
+
+    res = pNtRemoveIoCompletion( h, &key, &value, &iosb, NULL );
+    ok( res == STATUS_SUCCESS, "NtRemoveIoCompletion failed: %#x\n", res );
+    ok( key == CKEY_FIRST, "Invalid completion key: %#lx\n", key );
+    ok( value == CVALUE_FIRST, "Invalid completion value: %#lx\n", value );
+    return 0;
+}
+
+static LONG io_completion_thread_done;
+
+static DWORD WINAPI remove_io_completion_timeout_thread( void *arg )
+{
+    LARGE_INTEGER timeout;
+    IO_STATUS_BLOCK iosb;
+    ULONG_PTR key, value;
+    HANDLE h = arg;
+    NTSTATUS res;
+
+    /* the port allows a single active thread, and the main thread is running */
+    timeout.QuadPart = -100 * 10000;
+    res = pNtRemoveIoCompletion( h, &key, &value, &iosb, &timeout );
+    ok( res == STATUS_TIMEOUT, "NtRemoveIoCompletion returned %#x\n", res );
+    InterlockedExchange( &io_completion_thread_done, 1 );
+    return 0;
+}
+
+static void test_io_completion_child( HANDLE h )
+{
+    LARGE_INTEGER timeout = {{0}};
+    IO_STATUS_BLOCK iosb;
+    ULONG_PTR key, value;
+    NTSTATUS res;
+    ULONG count;
+
+    count = get_pending_msgs( h );
+    ok( count == 2, "Unexpected msg count: %d\n", count );
+    res = pNtRemoveIoCompletion( h, &key, &value, &iosb, &timeout );
+    ok( res == STATUS_SUCCESS, "NtRemoveIoCompletion failed: %#x\n", res );
+    ok( key == CKEY_FIRST, "Invalid completion key: %#lx\n", key );
+    res = pNtRemoveIoCompletion( h, &key, &value, &iosb, &timeout );
+    ok( res == STATUS_SUCCESS, "NtRemoveIoCompletion failed: %#x\n", res );
+    ok( key == CKEY_SECOND, "Invalid completion key: %#lx\n", key );
+}
+
+static void test_io_completion_handles(void)
+{
+    FILE_IO_COMPLETION_INFORMATION info[4];
+    LARGE_INTEGER timeout = {{0}};
+    PROCESS_INFORMATION pi;
+    STARTUPINFOA si = {0};
+    char cmdline[MAX_PATH];
+    IO_STATUS_BLOCK iosb;
+    ULONG_PTR key, value;
+    HANDLE h, h2, thread;
+    NTSTATUS res;
+    ULONG count;
+    char **argv;
+    BOOL ret;
+
+    res = pNtCreateIoCompletion( &h, IO_COMPLETION_ALL_ACCESS, NULL, 0 );
+    ok( res == STATUS_SUCCESS, "NtCreateIoCompletion failed: %#x\n", res );
+
+    /* packets posted before duplicating the handle are visible through both handles */
+    res = pNtSetIoCompletion( h, CKEY_FIRST, CVALUE_FIRST, STATUS_SUCCESS, 0 );
+    ok( res == STATUS_SUCCESS, "NtSetIoCompletion failed: %#x\n", res );
+    ret = DuplicateHandle( GetCurrentProcess(), h, GetCurrentProcess(), &h2, 0, FALSE, DUPLICATE_SAME_ACCESS );
+    ok( ret, "DuplicateHandle failed: %u\n", GetLastError() );
+    count = get_pending_msgs( h2 );
+    ok( count == 1, "Unexpected msg count: %d\n", count );
+
+    res = pNtSetIoCompletion( h, CKEY_SECOND, CVALUE_FIRST, STATUS_SUCCESS, 0 );
+    ok( res == STATUS_SUCCESS, "NtSetIoCompletion failed: %#x\n", res );
+    res = pNtRemoveIoCompletion( h2, &key, &value, &iosb, &timeout );
+    ok( res == STATUS_SUCCESS, "NtRemoveIoCompletion failed: %#x\n", res );
+    ok( key == CKEY_FIRST, "Invalid completion key: %#lx\n", key );
+    res = pNtRemoveIoCompletion( h2, &key, &value, &iosb, &timeout );
+    ok( res == STATUS_SUCCESS, "NtRemoveIoCompletion failed: %#x\n", res );
+    ok( key == CKEY_SECOND, "Invalid completion key: %#lx\n", key );
+    pNtClose( h2 );
+    pNtClose( h );
+
+    /* a thread blocked in NtRemoveIoCompletion is woken up by a packet */
+    res = pNtCreateIoCompletion( &h, IO_COMPLETION_ALL_ACCESS, NULL, 0 );
+    ok( res == STATUS_SUCCESS, "NtCreateIoCompletion failed: %#x\n", res );
+    thread = CreateThread( NULL, 0, remove_io_completion_thread, h, 0, NULL );
+    Sleep( 100 );
+    res = pNtSetIoCompletion( h, CKEY_FIRST, CVALUE_FIRST, STATUS_SUCCESS, 0 );
+    ok( res == STATUS_SUCCESS, "NtSetIoCompletion failed: %#x\n", res );
+    ok( !WaitForSingleObject( thread, 5000 ), "thread didn't finish\n" );
+    CloseHandle( thread );
+    count = get_pending_msgs( h );
+    ok( !count, "Unexpected msg count: %d\n", count );
+    pNtClose( h );
+
+    /* NtRemoveIoCompletionEx returns the available packets without blocking */
+    res = pNtCreateIoCompletion( &h, IO_COMPLETION_ALL_ACCESS, NULL, 0 );
+    ok( res == STATUS_SUCCESS, "NtCreateIoCompletion failed: %#x\n", res );
+    pNtSetIoCompletion( h, CKEY_FIRST, CVALUE_FIRST, STATUS_SUCCESS, 0 );
+    pNtSetIoCompletion( h, CKEY_SECOND, CVALUE_FIRST, STATUS_SUCCESS, 0 );
+    count = 0xdeadbeef;
+    res = pNtRemoveIoCompletionEx( h, info, ARRAY_SIZE(info), &count, NULL, FALSE );
+    ok( res == STATUS_SUCCESS, "NtRemoveIoCompletionEx failed: %#x\n", res );
+    ok( count == 2, "wrong count %u\n", count );
+    ok( info[0].CompletionKey == CKEY_FIRST, "Invalid completion key: %#lx\n", info[0].CompletionKey );
+    ok( info[1].CompletionKey == CKEY_SECOND, "Invalid completion key: %#lx\n", info[1].CompletionKey );
+    pNtClose( h );
+
+    /* a thread processing a packet counts against the concurrency limit until it blocks */
+    res = pNtCreateIoCompletion( &h, IO_COMPLETION_ALL_ACCESS, NULL, 1 );
+    ok( res == STATUS_SUCCESS, "NtCreateIoCompletion failed: %#x\n", res );
+    pNtSetIoCompletion( h, CKEY_FIRST, CVALUE_FIRST, STATUS_SUCCESS, 0 );
+    res = pNtRemoveIoCompletion( h, &key, &value, &iosb, &timeout );
+    ok( res == STATUS_SUCCESS, "NtRemoveIoCompletion failed: %#x\n", res );
+    pNtSetIoCompletion( h, CKEY_FIRST, CVALUE_FIRST, STATUS_SUCCESS, 0 );
+    io_completion_thread_done = 0;
+    thread = CreateThread( NULL, 0, remove_io_completion_timeout_thread, h, 0, NULL );
+    while (!io_completion_thread_done) YieldProcessor();
+    ok( !WaitForSingleObject( thread, 5000 ), "thread didn't finish\n" );
+    CloseHandle( thread );
+    /* now that we blocked, another thread can take the packet */
+    thread = CreateThread( NULL, 0, remove_io_completion_thread, h, 0, NULL );
+    ok( !WaitForSingleObject( thread, 5000 ), "thread didn't finish\n" );
+    CloseHandle( thread );
+    count = get_pending_msgs( h );
+    ok( !count, "Unexpected msg count: %d\n", count );
+    pNtClose( h );
+
+    /* packets are visible to a child process once the handle is made inheritable */
+    res = pNtCreateIoCompletion( &h, IO_COMPLETION_ALL_ACCESS, NULL, 0 );
+    ok( res == STATUS_SUCCESS, "NtCreateIoCompletion failed: %#x\n", res );
+    pNtSetIoCompletion( h, CKEY_FIRST, CVALUE_FIRST, STATUS_SUCCESS, 0 );
+    ret = SetHandleInformation( h, HANDLE_FLAG_INHERIT, HANDLE_FLAG_INHERIT );
+    ok( ret, "SetHandleInformation failed: %u\n", GetLastError() );
+    pNtSetIoCompletion( h, CKEY_SECOND, CVALUE_FIRST, STATUS_SUCCESS, 0 );
+
+    winetest_get_mainargs( &argv );
+    sprintf( cmdline, "%s file completion %p", argv[0], h );
+    si.cb = sizeof(si);
+    ret = CreateProcessA( NULL, cmdline, NULL, NULL, TRUE, 0, NULL, NULL, &si, &pi );
+    ok( ret, "CreateProcess failed: %u\n", GetLastError() );
+    wait_child_process( pi.hProcess );
+    CloseHandle( pi.hProcess );
+    CloseHandle( pi.hThread );
+    count = get_pending_msgs( h );
+    ok( !count, "Unexpected msg count: %d\n", count );
+    pNtClose( h );
+}
+
+#define IO_COMPLETION_BENCHMARK_PACKETS 1000000
+
+static LONG io_completion_benchmark_received;
+static LONG io_completion_benchmark_expected;
+static unsigned int io_completion_benchmark_threads;
+
+static DWORD WINAPI io_completion_producer_thread( void *arg )
+{
+    HANDLE h = arg;
+    unsigned int i;
+
+    for (i = 0; i < IO_COMPLETION_BENCHMARK_PACKETS; i++)
+        pNtSetIoCompletion( h, 1, i, STATUS_SUCCESS, 0 );
+    return 0;
+}
+
+static DWORD WINAPI io_completion_consumer_thread( void *arg )
+{
+    FILE_IO_COMPLETION_INFORMATION info[16];
+    HANDLE h = arg;
+    ULONG i, count;
+    NTSTATUS res;
+
+    for (;;)
+    {
+        res = pNtRemoveIoCompletionEx( h, info, ARRAY_SIZE(info), &count, NULL, FALSE );
+        if (res) return res;
+        for (i = 0; i < count; i++)
+        {
+            /* a null key tells the consumer to exit */
+            if (!info[i].CompletionKey) return 0;
+            if (InterlockedIncrement( &io_completion_benchmark_received ) == io_completion_benchmark_expected)
+            {
+                unsigned int j;
+                for (j = 0; j < io_completion_benchmark_threads; j++)
+                    pNtSetIoCompletion( h, 0, 0, STATUS_SUCCESS, 0 );
+            }
+        }
+    }
+}
+
+static void test_io_completion_benchmark( unsigned int threads )
+{
+    LARGE_INTEGER frequency, start, end;
+    HANDLE h, producers[8], consumers[8];
+    unsigned int i;
+    double time;
+    NTSTATUS res;
+
+    res = pNtCreateIoCompletion( &h, IO_COMPLETION_ALL_ACCESS, NULL, 0 );
+    ok( res == STATUS_SUCCESS, "NtCreateIoCompletion failed: %#x\n", res );
+
+    io_completion_benchmark_received = 0;
+    io_completion_benchmark_expected = threads * IO_COMPLETION_BENCHMARK_PACKETS;
+    io_completion_benchmark_threads = threads;
+
+    QueryPerformanceFrequency( &frequency );
+    QueryPerformanceCounter( &start );
+    for (i = 0; i < threads; i++)
+    {
+        consumers[i] = CreateThread( NULL, 0, io_completion_consumer_thread, h, 0, NULL );
+        producers[i] = CreateThread( NULL, 0, io_completion_producer_thread, h, 0, NULL );
+    }
+    WaitForMultipleObjects( threads, producers, TRUE, INFINITE );
+    WaitForMultipleObjects( threads, consumers, TRUE, INFINITE );
+    QueryPerformanceCounter( &end );
+
+    for (i = 0; i < threads; i++)
+    {
+        CloseHandle( consumers[i] );
+        CloseHandle( producers[i] );
+    }
+    ok( io_completion_benchmark_received == io_completion_benchmark_expected, "got %u packets\n",
+        io_completion_benchmark_received );
+
+    time = (double)(end.QuadPart - start.QuadPart) / frequency.QuadPart;
+    trace( "%u producers, %u consumers: %u packets in %.3f s, %.0f packets/s\n", threads, threads,
+           io_completion_benchmark_received, time, io_completion_benchmark_received / time );
+    pNtClose( h );
+}
+
 static void test_file_io_completion(void)
 {
     static const char pipe_name[] = "\\\\.\\pipe\\iocompletiontestnamedpipe";
@@ -5075,6 +5310,9 @@ START_TEST(file)
 {
     HMODULE hkernel32 = GetModuleHandleA("kernel32.dll");
     HMODULE hntdll = GetModuleHandleA("ntdll.dll");
+    char **argv;
+    int argc;
+
     if (!hntdll)
     {
         skip("not running on NT, skipping test\n");
@@ -5112,6 +5350,16 @@ START_TEST(file)
     pNtQueryFullAttributesFile = (void *)GetProcAddress(hntdll, "NtQueryFullAttributesFile");
     pNtFlushBuffersFile = (void *)GetProcAddress(hntdll, "NtFlushBuffersFile");
 
+    argc = winetest_get_mainargs( &argv );
+    if (argc >= 4 && !strcmp( argv[2], "completion" ))
+    {
+        HANDLE h;
+
+        sscanf( argv[3], "%p", &h );
+        test_io_completion_child( h );
+        return;
+    }
+
     test_read_write();
     test_NtCreateFile();
     create_file_test();
@@ -5121,6 +5369,13 @@ START_TEST(file)
     append_file_test();
     nt_mailslot_test();
     test_set_io_completion();
+    test_io_completion_handles();
+    if (winetest_interactive)
+    {
+        test_io_completion_benchmark( 1 );
+        test_io_completion_benchmark( 4 );
+        test_io_completion_benchmark( 8 );
+    }
     test_file_io_completion();
     test_file_basic_information();
     test_file_all_information();
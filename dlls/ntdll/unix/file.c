@@ -4418,6 +4418,8 @@ NTSTATUS WINAPI NtSetInformationFile( HANDLE handle, IO_STATUS_BLOCK *io,
                 io->u.Status  = wine_server_call( req );
             }
             SERVER_END_REQ;
+            if (!io->u.Status)
+                set_completion_file( handle, info->CompletionPort, info->CompletionKey );
         } else
             io->u.Status = STATUS_INVALID_PARAMETER_3;
         break;
@@ -5939,6 +5941,8 @@ NTSTATUS WINAPI NtCancelIoFile( HANDLE handle, IO_STATUS_BLOCK *io_status )
 {
     TRACE( "%p %p\n", handle, io_status );
 
+    cancel_client_io( handle, NULL, TRUE, FALSE );
+
     SERVER_START_REQ( cancel_async )
     {
         req->handle      = wine_server_obj_handle( handle );
@@ -5955,8 +5959,12 @@ NTSTATUS WINAPI NtCancelIoFile( HANDLE handle, IO_STATUS_BLOCK *io_status )
  */
 NTSTATUS WINAPI NtCancelIoFileEx( HANDLE handle, IO_STATUS_BLOCK *io, IO_STATUS_BLOCK *io_status )
 {
+    ULONG count;
+
     TRACE( "%p %p %p\n", handle, io, io_status );
 
+    count = cancel_client_io( handle, io, FALSE, FALSE );
+
     SERVER_START_REQ( cancel_async )
     {
         req->handle = wine_server_obj_handle( handle );
@@ -5964,6 +5972,7 @@ NTSTATUS WINAPI NtCancelIoFileEx( HANDLE handle, IO_STATUS_BLOCK *io, IO_STATUS_
         io_status->u.Status = wine_server_call( req );
     }
     SERVER_END_REQ;
+    if (io_status->u.Status == STATUS_NOT_FOUND && count) io_status->u.Status = STATUS_SUCCESS;
     return io_status->u.Status;
 }
 
@@ -6935,6 +6944,8 @@ NTSTATUS WINAPI NtSetInformationObject( HANDLE handle, OBJECT_INFORMATION_CLASS
             status = wine_server_call( req );
         }
         SERVER_END_REQ;
+        /* child processes can't see the client-side queue of a port */
+        if (!status && p->InheritHandle) close_completion_queue( handle );
     break;
     }
 
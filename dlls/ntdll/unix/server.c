@@ -715,6 +715,9 @@ unsigned int server_wait( const select_op_t *select_op, data_size_t size, UINT f
         abs_timeout -= now.QuadPart;
     }
 
+    /* a blocked thread no longer counts against the concurrency limit of a port */
+    if (ntdll_get_thread_data()->completion_queue) deactivate_completion_thread( TRUE );
+
     ret = server_select( select_op, size, flags, abs_timeout, NULL, NULL, &apc );
     if (ret == STATUS_USER_APC) invoke_apc( NULL, &apc );
 
@@ -1687,6 +1690,47 @@ NTSTATUS WINAPI DbgUiIssueRemoteBreakin( HANDLE process )
 }
 
 
+static ULONG (CDECL *client_io_cancel)( HANDLE handle, IO_STATUS_BLOCK *io, BOOL only_thread, BOOL close );
+
+/***********************************************************************
+ *           __wine_set_client_io_callback   (NTDLL.@)
+ *
+ * Set the function cancelling the I/O that a dll performs on the client
+ * side without queuing an async in the server. It is called with the
+ * arguments of NtCancelIoFile() and NtCancelIoFileEx(), and when a handle
+ * is closed, only for socket handles, and returns the number of operations
+ * it cancelled.
+ */
+void CDECL __wine_set_client_io_callback( ULONG (CDECL *func)( HANDLE, IO_STATUS_BLOCK *, BOOL, BOOL ) )
+{
+    client_io_cancel = func;
+}
+
+
+/***********************************************************************
+ *           cancel_client_io
+ */
+ULONG cancel_client_io( HANDLE handle, IO_STATUS_BLOCK *io, BOOL only_thread, BOOL close )
+{
+    enum server_fd_type type;
+    void *saved_frame;
+    ULONG count;
+    int fd;
+
+    if (!client_io_cancel) return 0;
+
+    /* only sockets have client side I/O, and their fd is in the cache as
+     * soon as any I/O was started on them */
+    if (get_cached_fd( handle, &fd, &type, NULL, NULL ) || type != FD_TYPE_SOCKET) return 0;
+
+    /* the callback is in the user part and may make syscalls */
+    saved_frame = get_syscall_frame();
+    count = client_io_cancel( handle, io, only_thread, close );
+    if (get_syscall_frame() != saved_frame) set_syscall_frame( saved_frame );
+    return count;
+}
+
+
 /******************************************************************************
  *           NtDuplicateObject
  */
@@ -1718,6 +1762,13 @@ NTSTATUS WINAPI NtDuplicateObject( HANDLE source_process, HANDLE source, HANDLE
         return result.dup_handle.status;
     }
 
+    if (source_process == NtCurrentProcess())
+    {
+        if (options & DUPLICATE_CLOSE_SOURCE) cancel_client_io( source, NULL, FALSE, TRUE );
+        /* the duplicated handle can't see packets queued on the client side */
+        close_completion_queue( source );
+    }
+
     server_enter_uninterrupted_section( &fd_cache_mutex, &sigset );
 
     /* always remove the cached fd; if the server request fails we'll just
@@ -1757,6 +1808,9 @@ NTSTATUS WINAPI NtClose( HANDLE handle )
     NTSTATUS ret;
     int fd;
 
+    cancel_client_io( handle, NULL, FALSE, TRUE );
+    close_completion_queue( handle );
+
     server_enter_uninterrupted_section( &fd_cache_mutex, &sigset );
 
     /* always remove the cached fd; if the server request fails we'll just
@@ -1728,6 +1728,367 @@ NTSTATUS WINAPI NtReleaseKeyedEvent( HANDLE handle, const void *key,
 }
 
 
+/* Packets posted with NtSetIoCompletion() to a port created by this process
+ * are queued in a client-side ring buffer, so that posting and dequeuing
+ * them doesn't need a server round trip. The server queue remains the
+ * authority: I/O completions are queued there, and threads that need to
+ * block wait on the server object. A producer that sees blocked waiters
+ * moves a packet to the server queue to wake one of them up.
+ *
+ * The ring is a bounded MPMC queue where each slot carries a sequence
+ * number telling whether it is ready to be written or read. When it is
+ * full, packets are posted to the server instead.
+ *
+ * The concurrency limit of the port is enforced for packets taken from the
+ * ring: a thread that dequeued one is counted as active until it asks for
+ * another packet, blocks in the server or exits, and threads beyond the
+ * limit wait in the server. When an active thread blocks or exits it moves
+ * a packet to the server to wake up one of them. Like on Windows, a thread
+ * woken up in the server is not counted again, and the server queue itself
+ * doesn't enforce the limit.
+ *
+ * Queues are reference counted, so that a slot isn't reused for another
+ * port while a thread that looked up the closed handle still uses it. */
+
+#define COMPLETION_QUEUE_SIZE 4096  /* must be a power of two */
+#define MAX_COMPLETION_QUEUES 64
+
+struct completion_packet
+{
+    LONG      seq;
+    NTSTATUS  status;
+    ULONG_PTR key;
+    ULONG_PTR value;
+    SIZE_T    information;
+};
+
+struct completion_queue
+{
+    HANDLE                   handle;       /* port handle, or 0 if the queue is unused */
+    LONG                     refs;         /* threads using the queue */
+    LONG                     waiters;      /* threads waiting in the server */
+    LONG                     active;       /* threads processing a packet from the queue */
+    LONG                     concurrency;  /* maximum number of active threads */
+    LONG                     head;     /* next packet to dequeue */
+    LONG                     tail;     /* next slot to fill */
+    struct completion_packet packets[COMPLETION_QUEUE_SIZE];
+};
+
+static struct completion_queue *completion_queues[MAX_COMPLETION_QUEUES];
+static LONG completion_queue_count;
+static pthread_mutex_t completion_queue_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* Files associated through one of our handles with a port that has a
+ * client-side queue, so that I/O completed on the client side can be
+ * posted there without a server round trip. Protected by
+ * completion_queue_mutex. */
+
+#define COMPLETION_FILE_BUCKETS 64
+
+struct completion_file
+{
+    struct completion_file *next;
+    HANDLE                  file;
+    HANDLE                  port;
+    ULONG_PTR               key;
+};
+
+static struct completion_file *completion_files[COMPLETION_FILE_BUCKETS];
+static LONG completion_file_count;
+
+static inline unsigned int completion_file_hash( HANDLE file )
+{
+    return ((ULONG_PTR)file >> 2) % COMPLETION_FILE_BUCKETS;
+}
+
+static BOOL completion_queue_push( struct completion_queue *queue, ULONG_PTR key, ULONG_PTR value,
+                                   NTSTATUS status, SIZE_T information )
+{
+    struct completion_packet *packet;
+    LONG pos = queue->tail, seq;
+
+    for (;;)
+    {
+        packet = &queue->packets[pos & (COMPLETION_QUEUE_SIZE - 1)];
+        seq = __atomic_load_n( &packet->seq, __ATOMIC_ACQUIRE );
+        if (seq == pos)
+        {
+            if (InterlockedCompareExchange( &queue->tail, pos + 1, pos ) == pos) break;
+        }
+        else if ((LONG)((ULONG)seq - (ULONG)pos) < 0) return FALSE;  /* full */
+        pos = *(volatile LONG *)&queue->tail;
+    }
+
+    packet->key         = key;
+    packet->value       = value;
+    packet->status      = status;
+    packet->information = information;
+    __atomic_store_n( &packet->seq, pos + 1, __ATOMIC_RELEASE );
+    return TRUE;
+}
+
+static BOOL completion_queue_pop( struct completion_queue *queue, ULONG_PTR *key, ULONG_PTR *value,
+                                  NTSTATUS *status, SIZE_T *information )
+{
+    struct completion_packet *packet;
+    LONG pos = queue->head, seq;
+
+    for (;;)
+    {
+        packet = &queue->packets[pos & (COMPLETION_QUEUE_SIZE - 1)];
+        seq = __atomic_load_n( &packet->seq, __ATOMIC_ACQUIRE );
+        if (seq == pos + 1)
+        {
+            if (InterlockedCompareExchange( &queue->head, pos + 1, pos ) == pos) break;
+        }
+        else if ((LONG)((ULONG)seq - (ULONG)pos - 1) < 0) return FALSE;  /* empty */
+        pos = *(volatile LONG *)&queue->head;
+    }
+
+    *key         = packet->key;
+    *value       = packet->value;
+    *status      = packet->status;
+    *information = packet->information;
+    __atomic_store_n( &packet->seq, pos + COMPLETION_QUEUE_SIZE, __ATOMIC_RELEASE );
+    return TRUE;
+}
+
+static NTSTATUS server_add_completion( HANDLE handle, ULONG_PTR key, ULONG_PTR value,
+                                       NTSTATUS status, SIZE_T count )
+{
+    NTSTATUS ret;
+
+    SERVER_START_REQ( add_completion )
+    {
+        req->handle      = wine_server_obj_handle( handle );
+        req->ckey        = key;
+        req->cvalue      = value;
+        req->status      = status;
+        req->information = count;
+        ret = wine_server_call( req );
+    }
+    SERVER_END_REQ;
+    return ret;
+}
+
+/* move queued packets to the server queue; returns the number of packets moved */
+static ULONG flush_completion_queue( struct completion_queue *queue, HANDLE handle, ULONG max )
+{
+    ULONG_PTR key, value;
+    NTSTATUS status;
+    SIZE_T info;
+    ULONG count = 0;
+
+    while (count < max && completion_queue_pop( queue, &key, &value, &status, &info ))
+    {
+        if (handle) server_add_completion( handle, key, value, status, info );
+        count++;
+    }
+    return count;
+}
+
+static struct completion_queue *get_completion_queue( HANDLE handle )
+{
+    unsigned int i;
+
+    if (!handle || !completion_queue_count) return NULL;
+    for (i = 0; i < MAX_COMPLETION_QUEUES; i++)
+    {
+        struct completion_queue *queue = completion_queues[i];
+        if (queue && queue->handle == handle) return queue;
+    }
+    return NULL;
+}
+
+/* get a reference to the queue of a port, which keeps its slot from being reused */
+static struct completion_queue *grab_completion_queue( HANDLE handle )
+{
+    struct completion_queue *queue;
+
+    if (!(queue = get_completion_queue( handle ))) return NULL;
+    InterlockedIncrement( &queue->refs );
+    /* the handle may have been closed before we got the reference */
+    if (__atomic_load_n( &queue->handle, __ATOMIC_ACQUIRE ) == handle) return queue;
+    InterlockedDecrement( &queue->refs );
+    return NULL;
+}
+
+static void release_completion_queue( struct completion_queue *queue )
+{
+    InterlockedDecrement( &queue->refs );
+}
+
+/* whether a producer should move a packet to the server to wake up a waiting thread */
+static inline BOOL completion_queue_can_wake( struct completion_queue *queue )
+{
+    return queue->waiters && queue->active < queue->concurrency;
+}
+
+/* dequeue a packet if the concurrency limit allows the thread to process it */
+static BOOL completion_queue_remove( struct completion_queue *queue, ULONG_PTR *key, ULONG_PTR *value,
+                                     NTSTATUS *status, SIZE_T *information )
+{
+    LONG active = queue->active, prev;
+
+    for (;;)
+    {
+        if (active >= queue->concurrency) return FALSE;
+        if ((prev = InterlockedCompareExchange( &queue->active, active + 1, active )) == active) break;
+        active = prev;
+    }
+    if (completion_queue_pop( queue, key, value, status, information )) return TRUE;
+    InterlockedDecrement( &queue->active );
+    return FALSE;
+}
+
+/***********************************************************************
+ *             deactivate_completion_thread
+ *
+ * Stop counting the current thread as active for the port it last took a
+ * packet from. If flush is set, the thread is about to block or exit, so
+ * let a thread waiting in the server take its place.
+ */
+void deactivate_completion_thread( BOOL flush )
+{
+    struct ntdll_thread_data *thread_data = ntdll_get_thread_data();
+    struct completion_queue *queue = thread_data->completion_queue;
+    HANDLE handle;
+
+    if (!queue) return;
+    thread_data->completion_queue = NULL;
+    InterlockedDecrement( &queue->active );
+    if (flush && queue->waiters && (handle = __atomic_load_n( &queue->handle, __ATOMIC_ACQUIRE )))
+        flush_completion_queue( queue, handle, 1 );
+    release_completion_queue( queue );
+}
+
+static void create_completion_queue( HANDLE handle, ULONG concurrency )
+{
+    struct completion_queue *queue = NULL;
+    unsigned int i;
+    LONG pos;
+
+    mutex_lock( &completion_queue_mutex );
+    for (i = 0; i < MAX_COMPLETION_QUEUES; i++)
+    {
+        if (!completion_queues[i])
+        {
+            if (!(queue = malloc( sizeof(*queue) ))) break;
+            for (pos = 0; pos < COMPLETION_QUEUE_SIZE; pos++) queue->packets[pos].seq = pos;
+            completion_queues[i] = queue;
+            break;
+        }
+        if (!completion_queues[i]->handle && !completion_queues[i]->refs)
+        {
+            queue = completion_queues[i];
+            break;
+        }
+    }
+    if (queue)
+    {
+        queue->waiters     = 0;
+        queue->active      = 0;
+        queue->concurrency = concurrency ? concurrency : NtCurrentTeb()->Peb->NumberOfProcessors;
+        /* drop anything left over by racing users of a closed handle */
+        flush_completion_queue( queue, 0, ~0u );
+        __atomic_store_n( &queue->handle, handle, __ATOMIC_RELEASE );
+        InterlockedIncrement( &completion_queue_count );
+    }
+    mutex_unlock( &completion_queue_mutex );
+}
+
+/* must be called with completion_queue_mutex held */
+static struct completion_file *find_completion_file( HANDLE file )
+{
+    struct completion_file *entry;
+
+    for (entry = completion_files[completion_file_hash( file )]; entry; entry = entry->next)
+        if (entry->file == file) return entry;
+    return NULL;
+}
+
+/* must be called with completion_queue_mutex held */
+static void remove_completion_files( HANDLE handle, BOOL port )
+{
+    struct completion_file **entry, *next;
+    unsigned int i;
+
+    for (i = 0; i < COMPLETION_FILE_BUCKETS; i++)
+    {
+        if (!port && i != completion_file_hash( handle )) continue;
+        for (entry = &completion_files[i]; *entry;)
+        {
+            if ((port ? (*entry)->port : (*entry)->file) != handle)
+            {
+                entry = &(*entry)->next;
+                continue;
+            }
+            next = (*entry)->next;
+            free( *entry );
+            *entry = next;
+            InterlockedDecrement( &completion_file_count );
+        }
+    }
+}
+
+/***********************************************************************
+ *             set_completion_file
+ *
+ * Remember the port a file has been associated with through one of our
+ * handles, if that port has a client-side queue.
+ */
+void set_completion_file( HANDLE file, HANDLE port, ULONG_PTR key )
+{
+    struct completion_file *entry;
+    unsigned int hash = completion_file_hash( file );
+
+    if (!get_completion_queue( port )) return;
+    if (!(entry = malloc( sizeof(*entry) ))) return;
+    entry->file = file;
+    entry->port = port;
+    entry->key  = key;
+
+    mutex_lock( &completion_queue_mutex );
+    remove_completion_files( file, FALSE );
+    /* the port may have been closed in the meantime */
+    if (get_completion_queue( port ))
+    {
+        entry->next = completion_files[hash];
+        completion_files[hash] = entry;
+        InterlockedIncrement( &completion_file_count );
+        entry = NULL;
+    }
+    mutex_unlock( &completion_queue_mutex );
+    free( entry );
+}
+
+/***********************************************************************
+ *             close_completion_queue
+ *
+ * Stop using the client-side queue of a completion port, moving its
+ * packets to the server. Called when the port handle is closed or
+ * duplicated, since other handles can't see the client-side queue.
+ * Also forget the association of a file handle being closed.
+ */
+void close_completion_queue( HANDLE handle )
+{
+    struct completion_queue *queue;
+
+    if (!get_completion_queue( handle ) && !completion_file_count) return;
+
+    mutex_lock( &completion_queue_mutex );
+    if ((queue = get_completion_queue( handle )))
+    {
+        __atomic_store_n( &queue->handle, 0, __ATOMIC_RELEASE );
+        InterlockedDecrement( &completion_queue_count );
+        flush_completion_queue( queue, handle, ~0u );
+        if (completion_file_count) remove_completion_files( handle, TRUE );
+    }
+    else if (completion_file_count) remove_completion_files( handle, FALSE );
+    mutex_unlock( &completion_queue_mutex );
+}
+
+
 /***********************************************************************
  *             NtCreateIoCompletion (NTDLL.@)
  */
@@ -1752,6 +2113,10 @@ NTSTATUS WINAPI NtCreateIoCompletion( HANDLE *handle, ACCESS_MASK access, OBJECT
     }
     SERVER_END_REQ;
 
+    /* named and inheritable ports may be opened by other processes */
+    if (!status && (!attr || (!attr->ObjectName && !(attr->Attributes & OBJ_INHERIT))))
+        create_completion_queue( *handle, threads );
+
     free( objattr );
     return status;
 }
@@ -1788,17 +2153,65 @@ NTSTATUS WINAPI NtOpenIoCompletion( HANDLE *handle, ACCESS_MASK access, const OB
 NTSTATUS WINAPI NtSetIoCompletion( HANDLE handle, ULONG_PTR key, ULONG_PTR value,
                                    NTSTATUS status, SIZE_T count )
 {
-    NTSTATUS ret;
+    struct completion_queue *queue;
 
     TRACE( "(%p, %lx, %lx, %x, %lx)\n", handle, key, value, status, count );
 
-    SERVER_START_REQ( add_completion )
+    if ((queue = grab_completion_queue( handle )))
+    {
+        if (!completion_queue_can_wake( queue ) && completion_queue_push( queue, key, value, status, count ))
+        {
+            /* a thread may have started waiting in the server or become inactive before
+             * seeing the packet, or the handle may have been closed while we pushed it */
+            __atomic_thread_fence( __ATOMIC_SEQ_CST );
+            if (completion_queue_can_wake( queue ) || queue->handle != handle)
+                flush_completion_queue( queue, handle, 1 );
+            release_completion_queue( queue );
+            return STATUS_SUCCESS;
+        }
+        release_completion_queue( queue );
+    }
+    return server_add_completion( handle, key, value, status, count );
+}
+
+
+/***********************************************************************
+ *             __wine_add_fd_completion (NTDLL.@)
+ *
+ * Post the completion of an I/O operation performed on the client side to
+ * the port associated with a file, if any. Asynchronous completions go to
+ * the client-side queue of the port when the file was associated through
+ * this handle; anything else is handed to the server, which also knows
+ * about the completion notification modes of the file.
+ */
+NTSTATUS CDECL __wine_add_fd_completion( HANDLE handle, ULONG_PTR value, NTSTATUS status,
+                                         SIZE_T information, BOOL async )
+{
+    struct completion_file *file;
+    NTSTATUS ret;
+
+    TRACE( "(%p, %lx, %x, %lx, %d)\n", handle, value, status, information, async );
+
+    if (async && completion_file_count)
+    {
+        /* the port handle can't be closed while we hold the mutex */
+        mutex_lock( &completion_queue_mutex );
+        if ((file = find_completion_file( handle )))
+        {
+            ret = NtSetIoCompletion( file->port, file->key, value, status, information );
+            mutex_unlock( &completion_queue_mutex );
+            return ret;
+        }
+        mutex_unlock( &completion_queue_mutex );
+    }
+
+    SERVER_START_REQ( add_fd_completion )
     {
         req->handle      = wine_server_obj_handle( handle );
-        req->ckey        = key;
         req->cvalue      = value;
         req->status      = status;
-        req->information = count;
+        req->information = information;
+        req->async       = async;
         ret = wine_server_call( req );
     }
     SERVER_END_REQ;
@@ -1812,10 +2225,31 @@ NTSTATUS WINAPI NtSetIoCompletion( HANDLE handle, ULONG_PTR key, ULONG_PTR value
 NTSTATUS WINAPI NtRemoveIoCompletion( HANDLE handle, ULONG_PTR *key, ULONG_PTR *value,
                                       IO_STATUS_BLOCK *io, LARGE_INTEGER *timeout )
 {
+    struct completion_queue *queue;
     NTSTATUS status;
 
     TRACE( "(%p, %p, %p, %p, %p)\n", handle, key, value, io, timeout );
 
+    if ((queue = grab_completion_queue( handle )))
+    {
+        /* asking for another packet ends the processing of the previous one */
+        deactivate_completion_thread( ntdll_get_thread_data()->completion_queue != queue );
+        if (completion_queue_remove( queue, key, value, &io->u.Status, &io->Information ))
+        {
+            ntdll_get_thread_data()->completion_queue = queue;
+            return STATUS_SUCCESS;
+        }
+        /* let producers know that they need to go through the server, then check again */
+        InterlockedIncrement( &queue->waiters );
+        if (completion_queue_remove( queue, key, value, &io->u.Status, &io->Information ))
+        {
+            InterlockedDecrement( &queue->waiters );
+            ntdll_get_thread_data()->completion_queue = queue;
+            return STATUS_SUCCESS;
+        }
+    }
+    else deactivate_completion_thread( TRUE );
+
     for (;;)
     {
         SERVER_START_REQ( remove_completion )
@@ -1830,10 +2264,22 @@ NTSTATUS WINAPI NtRemoveIoCompletion( HANDLE handle, ULONG_PTR *key, ULONG_PTR *
             }
         }
         SERVER_END_REQ;
-        if (status != STATUS_PENDING) return status;
+        if (status != STATUS_PENDING) break;
         status = NtWaitForSingleObject( handle, FALSE, timeout );
-        if (status != WAIT_OBJECT_0) return status;
+        if (status != WAIT_OBJECT_0) break;
+    }
+
+    if (queue)
+    {
+        InterlockedDecrement( &queue->waiters );
+        if (!status)
+        {
+            InterlockedIncrement( &queue->active );
+            ntdll_get_thread_data()->completion_queue = queue;
+        }
+        else release_completion_queue( queue );
     }
+    return status;
 }
 
 
@@ -1843,11 +2289,44 @@ NTSTATUS WINAPI NtRemoveIoCompletion( HANDLE handle, ULONG_PTR *key, ULONG_PTR *
 NTSTATUS WINAPI NtRemoveIoCompletionEx( HANDLE handle, FILE_IO_COMPLETION_INFORMATION *info, ULONG count,
                                         ULONG *written, LARGE_INTEGER *timeout, BOOLEAN alertable )
 {
+    struct completion_queue *queue;
     NTSTATUS status;
     ULONG i = 0;
 
     TRACE( "%p %p %u %p %p %u\n", handle, info, count, written, timeout, alertable );
 
+    if ((queue = grab_completion_queue( handle )))
+    {
+        /* asking for more packets ends the processing of the previous ones */
+        deactivate_completion_thread( ntdll_get_thread_data()->completion_queue != queue );
+        if (count && completion_queue_remove( queue, &info[0].CompletionKey, &info[0].CompletionValue,
+                                              &info[0].IoStatusBlock.u.Status,
+                                              &info[0].IoStatusBlock.Information ))
+        {
+            for (i = 1; i < count; i++)
+                if (!completion_queue_pop( queue, &info[i].CompletionKey, &info[i].CompletionValue,
+                                           &info[i].IoStatusBlock.u.Status,
+                                           &info[i].IoStatusBlock.Information ))
+                    break;
+            /* don't wait for the server queue when we already have packets to return */
+            ntdll_get_thread_data()->completion_queue = queue;
+            *written = i;
+            return STATUS_SUCCESS;
+        }
+        /* let producers know that they need to go through the server, then check again */
+        InterlockedIncrement( &queue->waiters );
+        if (count && completion_queue_remove( queue, &info[0].CompletionKey, &info[0].CompletionValue,
+                                              &info[0].IoStatusBlock.u.Status,
+                                              &info[0].IoStatusBlock.Information ))
+        {
+            InterlockedDecrement( &queue->waiters );
+            ntdll_get_thread_data()->completion_queue = queue;
+            *written = 1;
+            return STATUS_SUCCESS;
+        }
+    }
+    else deactivate_completion_thread( TRUE );
+
     for (;;)
     {
         while (i < count)
@@ -1875,6 +2354,16 @@ NTSTATUS WINAPI NtRemoveIoCompletionEx( HANDLE handle, FILE_IO_COMPLETION_INFORM
         status = NtWaitForSingleObject( handle, alertable, timeout );
         if (status != WAIT_OBJECT_0) break;
     }
+    if (queue)
+    {
+        InterlockedDecrement( &queue->waiters );
+        if (i)
+        {
+            InterlockedIncrement( &queue->active );
+            ntdll_get_thread_data()->completion_queue = queue;
+        }
+        else release_completion_queue( queue );
+    }
     *written = i ? i : 1;
     return status;
 }
@@ -1886,6 +2375,7 @@ NTSTATUS WINAPI NtRemoveIoCompletionEx( HANDLE handle, FILE_IO_COMPLETION_INFORM
 NTSTATUS WINAPI NtQueryIoCompletion( HANDLE handle, IO_COMPLETION_INFORMATION_CLASS class,
                                      void *buffer, ULONG len, ULONG *ret_len )
 {
+    struct completion_queue *queue;
     NTSTATUS status;
 
     TRACE( "(%p, %d, %p, 0x%x, %p)\n", handle, class, buffer, len, ret_len );
@@ -1906,6 +2396,11 @@ NTSTATUS WINAPI NtQueryIoCompletion( HANDLE handle, IO_COMPLETION_INFORMATION_CL
                 if (!(status = wine_server_call( req ))) *info = reply->depth;
             }
             SERVER_END_REQ;
+            if (!status && (queue = grab_completion_queue( handle )))
+            {
+                *info += queue->tail - queue->head;
+                release_completion_queue( queue );
+            }
         }
         else status = STATUS_INFO_LENGTH_MISMATCH;
         break;
@@ -284,6 +284,7 @@ done:
  */
 void abort_thread( int status )
 {
+    deactivate_completion_thread( FALSE );
     pthread_sigmask( SIG_BLOCK, &server_block_set, NULL );
     if (InterlockedDecrement( &nb_threads ) <= 0) abort_process( status );
     signal_exit_thread( status, pthread_exit_wrapper );
@@ -307,6 +308,7 @@ static void exit_thread( int status )
     static void *prev_teb;
     TEB *teb;
 
+    deactivate_completion_thread( TRUE );
     pthread_sigmask( SIG_BLOCK, &server_block_set, NULL );
 
     if ((teb = InterlockedExchangePointer( &prev_teb, NtCurrentTeb() )))
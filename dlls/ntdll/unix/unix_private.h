@@ -64,6 +64,7 @@ struct ntdll_thread_data
     struct list        entry;         /* entry in TEB list */
     PRTL_THREAD_START_ROUTINE start;  /* thread entry point */
     void              *param;         /* thread entry point parameter */
+    struct completion_queue *completion_queue; /* port queue the thread is active for */
 };
 
 C_ASSERT( sizeof(struct ntdll_thread_data) <= sizeof(((TEB *)0)->GdiTebBatch) );
@@ -184,6 +185,10 @@ extern NTSTATUS set_thread_context( HANDLE handle, const context_t *context, BOO
 extern NTSTATUS get_thread_context( HANDLE handle, context_t *context, unsigned int flags, BOOL *self ) DECLSPEC_HIDDEN;
 extern NTSTATUS alloc_object_attributes( const OBJECT_ATTRIBUTES *attr, struct object_attributes **ret,
                                          data_size_t *ret_len ) DECLSPEC_HIDDEN;
+extern void close_completion_queue( HANDLE handle ) DECLSPEC_HIDDEN;
+extern void set_completion_file( HANDLE file, HANDLE port, ULONG_PTR key ) DECLSPEC_HIDDEN;
+extern void deactivate_completion_thread( BOOL flush ) DECLSPEC_HIDDEN;
+extern ULONG cancel_client_io( HANDLE handle, IO_STATUS_BLOCK *io, BOOL only_thread, BOOL close ) DECLSPEC_HIDDEN;
 
 extern void *anon_mmap_fixed( void *start, size_t size, int prot, int flags ) DECLSPEC_HIDDEN;
 extern void *anon_mmap_alloc( size_t size, int prot ) DECLSPEC_HIDDEN;
@@ -3969,6 +3969,88 @@ static ULONG Storage32Impl_AddExtBlockDepot(StorageImpl* This)
   return index;
 }
 
+/************************************************************************
+ * StorageImpl_GetDepotCacheBlock
+ *
+ * Returns the decoded entries of the given big block depot sector, reading
+ * it the first time it is needed. Sectors stay cached until the storage is
+ * refreshed, so following a fragmented chain only reads each depot sector
+ * once instead of on every hop to a different one.
+ */
+static ULONG *StorageImpl_GetDepotCacheBlock(StorageImpl *This, ULONG depotBlockCount)
+{
+  ULONG blocksPerDepot = This->bigBlockSize / sizeof(ULONG);
+  BYTE depotBuffer[MAX_BIG_BLOCK_SIZE];
+  ULONG depotBlockIndexPos;
+  ULONG read, index;
+  ULONG *depotBlock;
+
+  if (depotBlockCount >= This->blockDepotCacheSize)
+  {
+    ULONG new_size = max(depotBlockCount + 1, This->bigBlockDepotCount) * 2;
+    ULONG **new_cache;
+
+    new_cache = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(ULONG*) * new_size);
+    if (!new_cache) return NULL;
+    if (This->blockDepotCache)
+      memcpy(new_cache, This->blockDepotCache, sizeof(ULONG*) * This->blockDepotCacheSize);
+
+    HeapFree(GetProcessHeap(), 0, This->blockDepotCache);
+    This->blockDepotCache = new_cache;
+    This->blockDepotCacheSize = new_size;
+  }
+
+  if (This->blockDepotCache[depotBlockCount])
+    return This->blockDepotCache[depotBlockCount];
+
+  if (depotBlockCount < COUNT_BBDEPOTINHEADER)
+  {
+    depotBlockIndexPos = This->bigBlockDepotStart[depotBlockCount];
+  }
+  else
+  {
+    /*
+     * We have to look in the extended depot.
+     */
+    depotBlockIndexPos = Storage32Impl_GetExtDepotBlock(This, depotBlockCount);
+  }
+
+  StorageImpl_ReadBigBlock(This, depotBlockIndexPos, depotBuffer, &read);
+
+  if (!read)
+    return NULL;
+
+  depotBlock = HeapAlloc(GetProcessHeap(), 0, sizeof(ULONG) * blocksPerDepot);
+  if (!depotBlock)
+    return NULL;
+
+  for (index = 0; index < blocksPerDepot; index++)
+    StorageUtl_ReadDWord(depotBuffer, index*sizeof(ULONG), &depotBlock[index]);
+
+  This->blockDepotCache[depotBlockCount] = depotBlock;
+  return depotBlock;
+}
+
+/************************************************************************
+ * StorageImpl_FreeDepotCaches
+ *
+ * Discards the cached big and small block depots.
+ */
+static void StorageImpl_FreeDepotCaches(StorageImpl *This)
+{
+  ULONG i;
+
+  for (i = 0; i < This->blockDepotCacheSize; i++)
+    HeapFree(GetProcessHeap(), 0, This->blockDepotCache[i]);
+  HeapFree(GetProcessHeap(), 0, This->blockDepotCache);
+  This->blockDepotCache = NULL;
+  This->blockDepotCacheSize = 0;
+
+  HeapFree(GetProcessHeap(), 0, This->smallBlockDepotCache);
+  This->smallBlockDepotCache = NULL;
+  This->smallBlockDepotCacheLen = 0;
+}
+
 /************************************************************************
  * StorageImpl_GetNextBlockInChain
  *
@@ -4001,10 +4083,7 @@ static HRESULT StorageImpl_GetNextBlockInChain(
   ULONG offsetInDepot    = blockIndex * sizeof (ULONG);
   ULONG depotBlockCount  = offsetInDepot / This->bigBlockSize;
   ULONG depotBlockOffset = offsetInDepot % This->bigBlockSize;
-  BYTE depotBuffer[MAX_BIG_BLOCK_SIZE];
-  ULONG read;
-  ULONG depotBlockIndexPos;
-  int index, num_blocks;
+  ULONG *depotBlock;
 
   *nextBlockIndex   = BLOCK_SPECIAL;
 
@@ -4015,40 +4094,11 @@ static HRESULT StorageImpl_GetNextBlockInChain(
     return STG_E_READFAULT;
   }
 
-  /*
-   * Cache the currently accessed depot block.
-   */
-  if (depotBlockCount != This->indexBlockDepotCached)
-  {
-    This->indexBlockDepotCached = depotBlockCount;
-
-    if (depotBlockCount < COUNT_BBDEPOTINHEADER)
-    {
-      depotBlockIndexPos = This->bigBlockDepotStart[depotBlockCount];
-    }
-    else
-    {
-      /*
-       * We have to look in the extended depot.
-       */
-      depotBlockIndexPos = Storage32Impl_GetExtDepotBlock(This, depotBlockCount);
-    }
-
-    StorageImpl_ReadBigBlock(This, depotBlockIndexPos, depotBuffer, &read);
-
-    if (!read)
-      return STG_E_READFAULT;
-
-    num_blocks = This->bigBlockSize / 4;
-
-    for (index = 0; index < num_blocks; index++)
-    {
-      StorageUtl_ReadDWord(depotBuffer, index*sizeof(ULONG), nextBlockIndex);
-      This->blockDepotCached[index] = *nextBlockIndex;
-    }
-  }
+  depotBlock = StorageImpl_GetDepotCacheBlock(This, depotBlockCount);
+  if (!depotBlock)
+    return STG_E_READFAULT;
 
-  *nextBlockIndex = This->blockDepotCached[depotBlockOffset/sizeof(ULONG)];
+  *nextBlockIndex = depotBlock[depotBlockOffset/sizeof(ULONG)];
 
   return S_OK;
 }
@@ -4130,9 +4180,9 @@ static void StorageImpl_SetNextBlockInChain(
   /*
    * Update the cached block depot, if necessary.
    */
-  if (depotBlockCount == This->indexBlockDepotCached)
+  if (depotBlockCount < This->blockDepotCacheSize && This->blockDepotCache[depotBlockCount])
   {
-    This->blockDepotCached[depotBlockOffset/sizeof(ULONG)] = nextBlock;
+    This->blockDepotCache[depotBlockCount][depotBlockOffset/sizeof(ULONG)] = nextBlock;
   }
 }
 
@@ -4667,7 +4717,7 @@ static HRESULT StorageImpl_Refresh(StorageImpl *This, BOOL new_object, BOOL crea
   /*
    * There is no block depot cached yet.
    */
-  This->indexBlockDepotCached = 0xFFFFFFFF;
+  StorageImpl_FreeDepotCaches(This);
   This->indexExtBlockDepotCached = 0xFFFFFFFF;
 
   /*
@@ -5168,6 +5218,7 @@ static void StorageImpl_Destroy(StorageBaseImpl* iface)
   StorageImpl_Invalidate(iface);
 
   HeapFree(GetProcessHeap(), 0, This->extBigBlockDepotLocations);
+  StorageImpl_FreeDepotCaches(This);
 
   BlockChainStream_Destroy(This->smallBlockRootChain);
   BlockChainStream_Destroy(This->rootBlockChain);
@@ -7154,15 +7205,12 @@ static HRESULT BlockChainStream_UpdateIndexCache(BlockChainStream* This)
   return S_OK;
 }
 
-/* Locate the nth block in this stream. */
-static ULONG BlockChainStream_GetSectorOfOffset(BlockChainStream *This, ULONG offset)
+/* Locate the run containing the nth block in this stream. */
+static const struct BlockChainRun *BlockChainStream_GetRunOfOffset(BlockChainStream *This, ULONG offset)
 {
   ULONG min_offset = 0, max_offset = This->numBlocks-1;
   ULONG min_run = 0, max_run = This->indexCacheLen-1;
 
-  if (offset >= This->numBlocks)
-    return BLOCK_END_OF_CHAIN;
-
   while (min_run < max_run)
   {
     ULONG run_to_check = min_run + (offset - min_offset) * (max_run - min_run) / (max_offset - min_offset);
@@ -7181,7 +7229,38 @@ static ULONG BlockChainStream_GetSectorOfOffset(BlockChainStream *This, ULONG of
       min_run = max_run = run_to_check;
   }
 
-  return This->indexCache[min_run].firstSector + offset - This->indexCache[min_run].firstOffset;
+  return &This->indexCache[min_run];
+}
+
+/* Locate the nth block in this stream. */
+static ULONG BlockChainStream_GetSectorOfOffset(BlockChainStream *This, ULONG offset)
+{
+  const struct BlockChainRun *run;
+
+  if (offset >= This->numBlocks)
+    return BLOCK_END_OF_CHAIN;
+
+  run = BlockChainStream_GetRunOfOffset(This, offset);
+  return run->firstSector + offset - run->firstOffset;
+}
+
+/* Count the blocks following the nth one that are stored in the sectors right
+ * after it and that a read of size more bytes covers entirely, leaving out
+ * the last block of the read and blocks in the cache. */
+static ULONG BlockChainStream_GetContiguousBlocks(BlockChainStream *This, ULONG offset, ULONG size)
+{
+  const struct BlockChainRun *run = BlockChainStream_GetRunOfOffset(This, offset);
+  ULONG count = 0;
+
+  while (offset + count < run->lastOffset && size > This->parentStorage->bigBlockSize &&
+         This->cachedBlocks[0].index != offset + count + 1 &&
+         This->cachedBlocks[1].index != offset + count + 1)
+  {
+    size -= This->parentStorage->bigBlockSize;
+    count++;
+  }
+
+  return count;
 }
 
 static HRESULT BlockChainStream_GetBlockAtOffset(BlockChainStream *This,
@@ -7614,6 +7693,7 @@ HRESULT BlockChainStream_ReadAt(BlockChainStream* This,
   {
     ULARGE_INTEGER ulOffset;
     DWORD bytesReadAt;
+    ULONG blockCount = 1;
 
     /*
      * Calculate how many bytes we can copy from this big block.
@@ -7628,7 +7708,12 @@ HRESULT BlockChainStream_ReadAt(BlockChainStream* This,
 
     if (!cachedBlock)
     {
-      /* Not in cache, and we're going to read past the end of the block. */
+      /* Not in cache, and we're going to read past the end of the block.
+       * Blocks in the following sectors are read directly along with it. */
+      blockCount += BlockChainStream_GetContiguousBlocks(This, blockNoInSequence,
+                                                         size - bytesToReadInBuffer);
+      bytesToReadInBuffer += (blockCount - 1) * This->parentStorage->bigBlockSize;
+
       ulOffset.QuadPart = StorageImpl_GetBigBlockOffset(This->parentStorage, blockIndex) +
                                offsetInBlock;
 
@@ -7653,7 +7738,7 @@ HRESULT BlockChainStream_ReadAt(BlockChainStream* This,
       bytesReadAt = bytesToReadInBuffer;
     }
 
-    blockNoInSequence++;
+    blockNoInSequence += blockCount;
     bufferWalker += bytesReadAt;
     size         -= bytesReadAt;
     *bytesRead   += bytesReadAt;
@@ -7805,6 +7890,41 @@ static ULONG SmallBlockChainStream_GetHeadOfChain(
   return BLOCK_END_OF_CHAIN;
 }
 
+/******************************************************************************
+ *      SmallBlockChainStream_LoadDepotCache
+ *
+ * Reads and decodes the whole small block depot, so that walking small block
+ * chains doesn't go through the depot chain for every block.
+ */
+static void SmallBlockChainStream_LoadDepotCache(StorageImpl *storage)
+{
+  ULARGE_INTEGER offset, size;
+  ULONG bytesRead, i;
+  ULONG *cache;
+
+  size = BlockChainStream_GetSize(storage->smallBlockDepotChain);
+  if (!size.QuadPart || size.u.HighPart)
+    return;
+
+  cache = HeapAlloc(GetProcessHeap(), 0, size.u.LowPart);
+  if (!cache)
+    return;
+
+  offset.QuadPart = 0;
+  if (FAILED(BlockChainStream_ReadAt(storage->smallBlockDepotChain, offset, size.u.LowPart, cache, &bytesRead)) ||
+      bytesRead != size.u.LowPart)
+  {
+    HeapFree(GetProcessHeap(), 0, cache);
+    return;
+  }
+
+  for (i = 0; i < size.u.LowPart / sizeof(ULONG); i++)
+    StorageUtl_ReadDWord((BYTE *)cache, i * sizeof(ULONG), &cache[i]);
+
+  storage->smallBlockDepotCache = cache;
+  storage->smallBlockDepotCacheLen = size.u.LowPart / sizeof(ULONG);
+}
+
 /******************************************************************************
  *      SmallBlockChainStream_GetNextBlockInChain
  *
@@ -7819,6 +7939,7 @@ static HRESULT SmallBlockChainStream_GetNextBlockInChain(
   ULONG                  blockIndex,
   ULONG*                 nextBlockInChain)
 {
+  StorageImpl *storage = This->parentStorage;
   ULARGE_INTEGER offsetOfBlockInDepot;
   DWORD  buffer;
   ULONG  bytesRead;
@@ -7826,6 +7947,15 @@ static HRESULT SmallBlockChainStream_GetNextBlockInChain(
 
   *nextBlockInChain = BLOCK_END_OF_CHAIN;
 
+  if (!storage->smallBlockDepotCache)
+    SmallBlockChainStream_LoadDepotCache(storage);
+
+  if (blockIndex < storage->smallBlockDepotCacheLen)
+  {
+    *nextBlockInChain = storage->smallBlockDepotCache[blockIndex];
+    return S_OK;
+  }
+
   offsetOfBlockInDepot.QuadPart  = (ULONGLONG)blockIndex * sizeof(ULONG);
 
   /*
@@ -7869,6 +7999,9 @@ static void SmallBlockChainStream_SetNextBlockInChain(
 
   offsetOfBlockInDepot.QuadPart  = (ULONGLONG)blockIndex * sizeof(ULONG);
 
+  if (blockIndex < This->parentStorage->smallBlockDepotCacheLen)
+    This->parentStorage->smallBlockDepotCache[blockIndex] = nextBlock;
+
   StorageUtl_WriteDWord(&buffer, 0, nextBlock);
 
   /*
@@ -7953,6 +8086,11 @@ static ULONG SmallBlockChainStream_GetNextFreeBlock(
       newSize.QuadPart = (ULONGLONG)(count + 1) * This->parentStorage->bigBlockSize;
       BlockChainStream_Enlarge(This->parentStorage->smallBlockDepotChain, newSize);
 
+      /* Reload the cached depot with the new entries on next use. */
+      HeapFree(GetProcessHeap(), 0, This->parentStorage->smallBlockDepotCache);
+      This->parentStorage->smallBlockDepotCache = NULL;
+      This->parentStorage->smallBlockDepotCacheLen = 0;
+
       /*
        * Initialize all the small blocks to free
        */
@@ -393,8 +393,13 @@ struct StorageImpl
   ULONG extBlockDepotCached[MAX_BIG_BLOCK_SIZE / 4];
   ULONG indexExtBlockDepotCached;
 
-  ULONG blockDepotCached[MAX_BIG_BLOCK_SIZE / 4];
-  ULONG indexBlockDepotCached;
+  /* Decoded sectors of the big block depot, read on first use. */
+  ULONG **blockDepotCache;
+  ULONG blockDepotCacheSize;
+
+  /* Decoded small block depot, read on first use. */
+  ULONG *smallBlockDepotCache;
+  ULONG smallBlockDepotCacheLen;
   ULONG prevFreeBlock;
 
   /* All small blocks before this one are known to be in use. */
@@ -3924,6 +3924,73 @@ static void test_custom_lockbytes(void)
     DeleteTestLockBytes(lockbytes);
 }
 
+static void test_large_file_read(void)
+{
+    static const WCHAR fmtW[] = {'S','t','r','e','a','m','%','u',0};
+    static const unsigned int stream_count = 16, chunk_size = 64 * 1024;
+    static const ULONGLONG total_size = (ULONGLONG)500 * 1024 * 1024;
+    IStream *streams[16];
+    IStorage *stg;
+    WCHAR name[32];
+    ULONGLONG done;
+    ULONG read;
+    DWORD start;
+    char *buffer;
+    unsigned int i;
+    HRESULT r;
+
+    buffer = HeapAlloc(GetProcessHeap(), 0, chunk_size);
+    memset(buffer, 'a', chunk_size);
+
+    DeleteFileA(filenameA);
+    r = StgCreateDocfile(filename, STGM_CREATE | STGM_READWRITE | STGM_SHARE_EXCLUSIVE, 0, &stg);
+    ok(r == S_OK, "StgCreateDocfile failed %x\n", r);
+
+    for (i = 0; i < stream_count; i++)
+    {
+        wsprintfW(name, fmtW, i);
+        r = IStorage_CreateStream(stg, name, STGM_SHARE_EXCLUSIVE | STGM_READWRITE, 0, 0, &streams[i]);
+        ok(r == S_OK, "IStorage->CreateStream failed %x\n", r);
+    }
+
+    /* Interleave the writes so that every stream ends up fragmented. */
+    start = GetTickCount();
+    for (done = 0; done < total_size; done += chunk_size)
+    {
+        r = IStream_Write(streams[(done / chunk_size) % stream_count], buffer, chunk_size, NULL);
+        ok(r == S_OK, "IStream->Write failed %x\n", r);
+        if (r != S_OK) break;
+    }
+    for (i = 0; i < stream_count; i++)
+        IStream_Release(streams[i]);
+    IStorage_Release(stg);
+    trace("wrote %u MB in %u ms\n", (unsigned int)(done >> 20), GetTickCount() - start);
+
+    r = StgOpenStorage(filename, NULL, STGM_READ | STGM_SHARE_EXCLUSIVE, NULL, 0, &stg);
+    ok(r == S_OK, "StgOpenStorage failed %x\n", r);
+
+    start = GetTickCount();
+    done = 0;
+    for (i = 0; i < stream_count; i++)
+    {
+        wsprintfW(name, fmtW, i);
+        r = IStorage_OpenStream(stg, name, NULL, STGM_SHARE_EXCLUSIVE | STGM_READ, 0, &streams[i]);
+        ok(r == S_OK, "IStorage->OpenStream failed %x\n", r);
+        if (r != S_OK) continue;
+
+        while (IStream_Read(streams[i], buffer, chunk_size, &read) == S_OK && read)
+            done += read;
+        IStream_Release(streams[i]);
+    }
+    ok(done == total_size, "read %s bytes\n", wine_dbgstr_longlong(done));
+    trace("read %u streams, %u MB in %u ms\n", stream_count, (unsigned int)(done >> 20),
+          GetTickCount() - start);
+
+    IStorage_Release(stg);
+    DeleteFileA(filenameA);
+    HeapFree(GetProcessHeap(), 0, buffer);
+}
+
 START_TEST(storage32)
 {
     CHAR temp[MAX_PATH];
@@ -3973,4 +4040,7 @@ START_TEST(storage32)
     test_transacted_shared();
     test_overwrite();
     test_custom_lockbytes();
+
+    if (winetest_interactive)
+        test_large_file_read();
 }
@@ -3744,6 +3744,48 @@ static void test_marshal_dispinterface(void)
     ok(!ref, "Got outstanding refcount %d.\n", ref);
 }
 
+/* Typelib proxies and stubs for different interfaces are created and freed
+ * repeatedly, so their heap-built descriptors end up at reused addresses. */
+static void test_proxy_lifetime(void)
+{
+    static const LARGE_INTEGER zero;
+    IKindaEnumWidget *kew;
+    IWidget *widget;
+    IStream *stream;
+    HANDLE thread;
+    DWORD tid;
+    HRESULT hr;
+    int i;
+
+    for (i = 0; i < 20; i++)
+    {
+        kew = KindaEnumWidget_Create();
+        hr = CreateStreamOnHGlobal(NULL, TRUE, &stream);
+        ok(hr == S_OK, "Got hr %#x.\n", hr);
+        tid = start_host_object(stream, &IID_IKindaEnumWidget, (IUnknown *)kew, MSHLFLAGS_NORMAL, &thread);
+        IKindaEnumWidget_Release(kew);
+
+        IStream_Seek(stream, zero, STREAM_SEEK_SET, NULL);
+        hr = CoUnmarshalInterface(stream, &IID_IKindaEnumWidget, (void **)&kew);
+        ok(hr == S_OK, "Got hr %#x.\n", hr);
+        IStream_Release(stream);
+
+        hr = IKindaEnumWidget_Next(kew, &widget);
+        ok(hr == S_OK, "Got hr %#x.\n", hr);
+
+        hr = IWidget_basetypes_in(widget, 5, -123, -100000, (LONGLONG)-100000 * 1000000, 0, 456,
+                0xdeadbeef, (ULONGLONG)1234567890 * 9876543210, M_PI, M_E, STATE_WIDGETIFIED);
+        ok(hr == S_OK, "Got hr %#x.\n", hr);
+
+        hr = IKindaEnumWidget_Reset(kew);
+        ok(hr == E_NOTIMPL, "Got hr %#x.\n", hr);
+
+        IWidget_Release(widget);
+        IKindaEnumWidget_Release(kew);
+        end_host_object(tid, thread);
+    }
+}
+
 START_TEST(tmarshal)
 {
     HRESULT hr;
@@ -3766,6 +3808,7 @@ START_TEST(tmarshal)
     test_libattr();
     test_external_connection();
     test_marshal_dispinterface();
+    test_proxy_lifetime();
 
     hr = UnRegisterTypeLib(&LIBID_TestTypelib, 2, 5, LOCALE_NEUTRAL,
                            sizeof(void*) == 8 ? SYS_WIN64 : SYS_WIN32);
@@ -36,6 +36,7 @@
 #include "oleauto.h"
 #include "ocidl.h"
 #include "shlwapi.h"
+#include "psapi.h"
 #include "tmarshal.h"
 #include "olectl.h"
 
@@ -1628,7 +1629,9 @@ static void test_inheritance(void)
     TYPEATTR *pTA;
     HREFTYPE href;
     FUNCDESC *pFD;
-    WCHAR path[MAX_PATH];
+    WCHAR path[MAX_PATH], fn5[] = L"fn5";
+    LPOLESTR name = fn5;
+    MEMBERID memid;
     CHAR pathA[MAX_PATH];
 
     GetModuleFileNameA(NULL, pathA, MAX_PATH);
@@ -1862,6 +1865,22 @@ static void test_inheritance(void)
     ITypeInfo_ReleaseFuncDesc(pTI, pFD);
     ITypeInfo_Release(pTI);
 
+    /* the dual interface of ItestIF12 is taken before any of its members is used */
+    hr = ITypeLib_GetTypeInfoOfGuid(pTL, &IID_ItestIF12, &pTI);
+    ok(hr == S_OK, "hr %08x\n", hr);
+    hr = ITypeInfo_GetRefTypeInfo(pTI, -2, &dual_ti);
+    ok(hr == S_OK, "hr %08x\n", hr);
+
+    hr = ITypeInfo_GetIDsOfNames(dual_ti, &name, 1, &memid);
+    ok(hr == S_OK, "hr %08x\n", hr);
+    ok(memid == 0x1235, "memid %08x\n", memid);
+    ITypeInfo_Release(dual_ti);
+
+    hr = ITypeInfo_GetIDsOfNames(pTI, &name, 1, &memid);
+    ok(hr == S_OK, "hr %08x\n", hr);
+    ok(memid == 0x1235, "memid %08x\n", memid);
+    ITypeInfo_Release(pTI);
+
     /* ItestIF13 is dual with inherited dual ifaces */
     hr = ITypeLib_GetTypeInfoOfGuid(pTL, &IID_ItestIF13, &pTI);
     ok(hr == S_OK, "hr %08x\n", hr);
@@ -7246,6 +7265,7 @@ static void test_FindName(void)
 {
     static const WCHAR invalidW[] = {'i','n','v','a','l','i','d',0};
     WCHAR buffW[100];
+    VARDESC *vardesc;
     MEMBERID memid;
     ITypeInfo *ti;
     ITypeLib *tl;
@@ -7311,6 +7331,23 @@ todo_wine {
     ok(c == 0, "got %d\n", c);
     ok(ti == (void*)0xdeadbeef, "got %p\n", ti);
 
+    /* variable names are matched case-insensitively */
+    c = 1;
+    memid = -1;
+    lstrcpyW(buffW, L"uNCHECKED");
+    ti = (void*)0xdeadbeef;
+    hr = ITypeLib_FindName(tl, buffW, 0, &ti, &memid, &c);
+    ok(hr == S_OK, "got 0x%08x\n", hr);
+    ok(c == 1, "got %d\n", c);
+    if (c == 1)
+    {
+        hr = ITypeInfo_GetVarDesc(ti, 0, &vardesc);
+        ok(hr == S_OK, "got 0x%08x\n", hr);
+        ok(memid == vardesc->memid, "got %d, expected %d\n", memid, vardesc->memid);
+        ITypeInfo_ReleaseVarDesc(ti, vardesc);
+        ITypeInfo_Release(ti);
+    }
+
     ITypeLib_Release(tl);
 }
 
@@ -8318,6 +8355,210 @@ static void test_DeleteFuncDesc(void)
     DeleteFileW(filenameW);
 }
 
+static SIZE_T get_private_usage(void)
+{
+    static BOOL (WINAPI *pK32GetProcessMemoryInfo)(HANDLE, PPROCESS_MEMORY_COUNTERS, DWORD);
+    PROCESS_MEMORY_COUNTERS counters;
+
+    if (!pK32GetProcessMemoryInfo)
+        pK32GetProcessMemoryInfo = (void *)GetProcAddress(GetModuleHandleA("kernel32.dll"), "K32GetProcessMemoryInfo");
+    if (!pK32GetProcessMemoryInfo || !pK32GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return 0;
+    return counters.PagefileUsage;
+}
+
+static void test_large_typelib_load(void)
+{
+    static const unsigned int interface_count = 2000, func_count = 30;
+    WCHAR filenameW[MAX_PATH], temp_path[MAX_PATH], name[64], arg1[] = L"first", arg2[] = L"second";
+    ICreateTypeInfo *createti;
+    ICreateTypeLib2 *createtl;
+    ELEMDESC params[2];
+    FUNCDESC funcdesc, *pfuncdesc;
+    ITypeInfo *ti;
+    ITypeLib *tl;
+    SIZE_T usage;
+    DWORD start;
+    unsigned int i, j;
+    HRESULT hr;
+
+    GetTempPathW(ARRAY_SIZE(temp_path), temp_path);
+    GetTempFileNameW(temp_path, L"tlb", 0, filenameW);
+
+    hr = CreateTypeLib2(SYS_WIN32, filenameW, &createtl);
+    ok(hr == S_OK, "Failed to create instance, hr %#x.\n", hr);
+
+    memset(params, 0, sizeof(params));
+    params[0].tdesc.vt = VT_BSTR;
+    params[1].tdesc.vt = VT_I4;
+
+    memset(&funcdesc, 0, sizeof(funcdesc));
+    funcdesc.funckind = FUNC_PUREVIRTUAL;
+    funcdesc.invkind = INVOKE_FUNC;
+    funcdesc.callconv = CC_STDCALL;
+    funcdesc.elemdescFunc.tdesc.vt = VT_HRESULT;
+    funcdesc.lprgelemdescParam = params;
+    funcdesc.cParams = ARRAY_SIZE(params);
+
+    for (i = 0; i < interface_count; i++)
+    {
+        wsprintfW(name, L"IGenerated%u", i);
+        hr = ICreateTypeLib2_CreateTypeInfo(createtl, name, TKIND_INTERFACE, &createti);
+        ok(hr == S_OK, "Failed to create typeinfo, hr %#x.\n", hr);
+
+        for (j = 0; j < func_count; j++)
+        {
+            LPOLESTR names[3] = {name, arg1, arg2};
+
+            funcdesc.memid = 0x60000000 + j;
+            hr = ICreateTypeInfo_AddFuncDesc(createti, j, &funcdesc);
+            ok(hr == S_OK, "Failed to add funcdesc, hr %#x.\n", hr);
+            wsprintfW(name, L"Generated%u_%u", i, j);
+            hr = ICreateTypeInfo_SetFuncAndParamNames(createti, j, names, ARRAY_SIZE(names));
+            ok(hr == S_OK, "Failed to set names, hr %#x.\n", hr);
+        }
+        ICreateTypeInfo_Release(createti);
+    }
+
+    hr = ICreateTypeLib2_SaveAllChanges(createtl);
+    ok(hr == S_OK, "Failed to save changes, hr %#x.\n", hr);
+    ICreateTypeLib2_Release(createtl);
+
+    usage = get_private_usage();
+    start = GetTickCount();
+    hr = LoadTypeLibEx(filenameW, REGKIND_NONE, &tl);
+    ok(hr == S_OK, "Failed to load typelib, hr %#x.\n", hr);
+    trace("loaded %u interfaces of %u methods in %u ms, %u KB\n", interface_count, func_count,
+          GetTickCount() - start, (unsigned int)((get_private_usage() - usage) / 1024));
+
+    start = GetTickCount();
+    hr = ITypeLib_GetTypeInfo(tl, interface_count / 2, &ti);
+    ok(hr == S_OK, "Failed to get typeinfo, hr %#x.\n", hr);
+    hr = ITypeInfo_GetFuncDesc(ti, 0, &pfuncdesc);
+    ok(hr == S_OK, "Failed to get funcdesc, hr %#x.\n", hr);
+    ok(pfuncdesc->cParams == 2, "Unexpected cParams %u.\n", pfuncdesc->cParams);
+    ITypeInfo_ReleaseFuncDesc(ti, pfuncdesc);
+    ITypeInfo_Release(ti);
+    trace("first method of one interface in %u ms\n", GetTickCount() - start);
+
+    start = GetTickCount();
+    for (i = 0; i < interface_count; i++)
+    {
+        hr = ITypeLib_GetTypeInfo(tl, i, &ti);
+        ok(hr == S_OK, "Failed to get typeinfo, hr %#x.\n", hr);
+        hr = ITypeInfo_GetFuncDesc(ti, func_count - 1, &pfuncdesc);
+        ok(hr == S_OK, "Failed to get funcdesc, hr %#x.\n", hr);
+        ITypeInfo_ReleaseFuncDesc(ti, pfuncdesc);
+        ITypeInfo_Release(ti);
+    }
+    trace("every interface in %u ms, %u KB\n", GetTickCount() - start,
+          (unsigned int)((get_private_usage() - usage) / 1024));
+
+    ITypeLib_Release(tl);
+    DeleteFileW(filenameW);
+}
+
+static HRESULT WINAPI late_bound_method(IUnknown *iface)
+{
+    return S_OK;
+}
+
+static void test_late_binding(unsigned int method_count, BOOL benchmark)
+{
+    static const unsigned int rounds = 100;
+    WCHAR name[32], lower[32];
+    LPOLESTR names[1] = {name};
+    DISPPARAMS dp = {NULL, NULL, 0, 0};
+    ICreateTypeInfo *createti;
+    ICreateTypeLib2 *createtl;
+    FUNCDESC funcdesc;
+    void **vtbl, *object = &vtbl;
+    ITypeInfo *ti;
+    MEMBERID memid;
+    VARIANT res;
+    DWORD start;
+    unsigned int i, j;
+    HRESULT hr;
+
+    hr = CreateTypeLib2(is_win64 ? SYS_WIN64 : SYS_WIN32, L"latebinding.tlb", &createtl);
+    ok(hr == S_OK, "Failed to create instance, hr %#x.\n", hr);
+    hr = ICreateTypeLib2_CreateTypeInfo(createtl, L"ILateBound", TKIND_INTERFACE, &createti);
+    ok(hr == S_OK, "Failed to create typeinfo, hr %#x.\n", hr);
+
+    memset(&funcdesc, 0, sizeof(funcdesc));
+    funcdesc.funckind = FUNC_PUREVIRTUAL;
+    funcdesc.invkind = INVOKE_FUNC;
+    funcdesc.callconv = CC_STDCALL;
+    funcdesc.elemdescFunc.tdesc.vt = VT_HRESULT;
+
+    vtbl = HeapAlloc(GetProcessHeap(), 0, method_count * sizeof(*vtbl));
+    for (i = 0; i < method_count; i++)
+    {
+        vtbl[i] = late_bound_method;
+        funcdesc.memid = 0x100 + i;
+        hr = ICreateTypeInfo_AddFuncDesc(createti, i, &funcdesc);
+        ok(hr == S_OK, "Failed to add funcdesc, hr %#x.\n", hr);
+        wsprintfW(name, L"Method%u", i);
+        hr = ICreateTypeInfo_SetFuncAndParamNames(createti, i, names, 1);
+        ok(hr == S_OK, "Failed to set names, hr %#x.\n", hr);
+    }
+    hr = ICreateTypeInfo_LayOut(createti);
+    ok(hr == S_OK, "Failed to lay out, hr %#x.\n", hr);
+    hr = ICreateTypeInfo_QueryInterface(createti, &IID_ITypeInfo, (void **)&ti);
+    ok(hr == S_OK, "Failed to get typeinfo, hr %#x.\n", hr);
+
+    /* names are case insensitive, and renamed members must be found under their new name */
+    wsprintfW(name, L"method%u", method_count - 1);
+    hr = ITypeInfo_GetIDsOfNames(ti, names, 1, &memid);
+    ok(hr == S_OK, "GetIDsOfNames failed, hr %#x.\n", hr);
+    ok(memid == 0x100 + method_count - 1, "Unexpected memid %#x.\n", memid);
+
+    lstrcpyW(name, L"Renamed");
+    hr = ICreateTypeInfo_SetFuncAndParamNames(createti, 0, names, 1);
+    ok(hr == S_OK, "Failed to set names, hr %#x.\n", hr);
+    hr = ITypeInfo_GetIDsOfNames(ti, names, 1, &memid);
+    ok(hr == S_OK, "GetIDsOfNames failed, hr %#x.\n", hr);
+    ok(memid == 0x100, "Unexpected memid %#x.\n", memid);
+    lstrcpyW(name, L"Method0");
+    hr = ITypeInfo_GetIDsOfNames(ti, names, 1, &memid);
+    ok(hr == DISP_E_UNKNOWNNAME, "Unexpected hr %#x.\n", hr);
+
+    V_VT(&res) = VT_EMPTY;
+    hr = ITypeInfo_Invoke(ti, object, 0x100 + method_count - 1, DISPATCH_METHOD, &dp, &res, NULL, NULL);
+    ok(hr == S_OK, "Invoke failed, hr %#x.\n", hr);
+
+    if (benchmark)
+    {
+        start = GetTickCount();
+        for (j = 0; j < rounds; j++)
+        {
+            for (i = 1; i < method_count; i++)
+            {
+                wsprintfW(lower, L"method%u", i);
+                names[0] = lower;
+                ITypeInfo_GetIDsOfNames(ti, names, 1, &memid);
+            }
+        }
+        names[0] = name;
+        trace("%u x GetIDsOfNames on %u methods in %u ms\n", rounds * (method_count - 1), method_count,
+              GetTickCount() - start);
+
+        start = GetTickCount();
+        for (j = 0; j < rounds; j++)
+        {
+            for (i = 0; i < method_count; i++)
+                ITypeInfo_Invoke(ti, object, 0x100 + i, DISPATCH_METHOD, &dp, &res, NULL, NULL);
+        }
+        trace("%u x Invoke on %u methods in %u ms\n", rounds * method_count, method_count,
+              GetTickCount() - start);
+    }
+
+    ITypeInfo_Release(ti);
+    ICreateTypeInfo_Release(createti);
+    ICreateTypeLib2_Release(createtl);
+    HeapFree(GetProcessHeap(), 0, vtbl);
+}
+
 START_TEST(typelib)
 {
     const WCHAR *filename;
@@ -8360,4 +8601,11 @@ START_TEST(typelib)
     test_dep();
     test_DeleteImplType();
     test_DeleteFuncDesc();
+    test_late_binding(64, FALSE);
+
+    if (winetest_interactive)
+    {
+        test_large_typelib_load();
+        test_late_binding(2000, TRUE);
+    }
 }
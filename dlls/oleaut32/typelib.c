@@ -1103,6 +1103,20 @@ typedef struct tagITypeLibImpl
     struct list ref_list;       /* list of ref types in this typelib */
     HREFTYPE dispatch_href;     /* reference to IDispatch, -1 if unused */
 
+    /* MSFT typelibs keep their image mapped, typeinfo members are only
+     * decoded from it on first use */
+    IUnknown *file;
+    void *image;
+    DWORD image_length;
+    MSFT_SegDir segdir;
+    /* name, string and guid table records, sorted by offset */
+    TLBString **name_index;
+    TLBString **string_index;
+    TLBGuid **guid_index;
+    UINT name_count;
+    UINT string_count;
+    UINT guid_count;
+
 
     /* typelibs are cached, keyed by path and index, so store the linked list info within them */
     struct list entry;
@@ -1135,7 +1149,7 @@ static inline ITypeLibImpl *impl_from_ICreateTypeLib2( ICreateTypeLib2 *iface )
 }
 
 /* ITypeLib methods */
-static ITypeLib2* ITypeLib2_Constructor_MSFT(LPVOID pLib, DWORD dwTLBLength);
+static ITypeLib2* ITypeLib2_Constructor_MSFT(LPVOID pLib, DWORD dwTLBLength, IUnknown *file);
 static ITypeLib2* ITypeLib2_Constructor_SLTG(LPVOID pLib, DWORD dwTLBLength);
 
 /*======================= ITypeInfo implementation =======================*/
@@ -1242,8 +1256,17 @@ typedef struct tagITypeInfoImpl
 
     struct list *pcustdata_list;
     struct list custdata_list;
+
+    /* functions and variables of MSFT typeinfos not decoded yet */
+    LONG members_pending;
+    int memoffset;
+
+    /* hashed member names and ids, built on first lookup */
+    struct member_index *member_index;
 } ITypeInfoImpl;
 
+static void TLB_load_members(ITypeInfoImpl *info);
+
 static inline ITypeInfoImpl *info_impl_from_ITypeComp( ITypeComp *iface )
 {
     return CONTAINING_RECORD(iface, ITypeInfoImpl, ITypeComp_iface);
@@ -1657,14 +1680,177 @@ static BSTR TLB_MultiByteToBSTR(const char *ptr)
     return ret;
 }
 
+/* Typeinfos with many members get hash tables of their member names and ids,
+ * so that late bound clients don't scan every function and variable on each
+ * GetIDsOfNames() and Invoke() call. Members are numbered with the functions
+ * first, followed by the variables, and are inserted in that order, so that
+ * lookups return the same first match as a linear scan. */
+#define MEMBER_INDEX_THRESHOLD 16
+
+struct member_index
+{
+    UINT mask;
+    UINT *names;    /* member number + 1, 0 for a free slot */
+    UINT *memids;
+    UINT slots[1];
+};
+
+static inline UINT member_count(const ITypeInfoImpl *info)
+{
+    return info->typeattr.cFuncs + info->typeattr.cVars;
+}
+
+static inline const TLBString *member_name(const ITypeInfoImpl *info, UINT member)
+{
+    if (member < info->typeattr.cFuncs)
+        return info->funcdescs[member].Name;
+    return info->vardescs[member - info->typeattr.cFuncs].Name;
+}
+
+static inline MEMBERID member_id(const ITypeInfoImpl *info, UINT member)
+{
+    if (member < info->typeattr.cFuncs)
+        return info->funcdescs[member].funcdesc.memid;
+    return info->vardescs[member - info->typeattr.cFuncs].vardesc.memid;
+}
+
+/* only ASCII letters and digits are hashed, comparing the other characters
+ * is left to lstrcmpiW() */
+static UINT member_name_hash(const WCHAR *name)
+{
+    UINT hash = 0;
+    WCHAR c;
+
+    while ((c = *name++))
+    {
+        if (c >= 'a' && c <= 'z') c -= 'a' - 'A';
+        else if ((c < 'A' || c > 'Z') && (c < '0' || c > '9')) continue;
+        hash = hash * 33 + c;
+    }
+    return hash;
+}
+
+static inline UINT member_id_hash(MEMBERID memid)
+{
+    UINT hash = memid * 0x9e3779b1;
+    return hash ^ (hash >> 16);
+}
+
+static struct member_index *member_index_create(const ITypeInfoImpl *info)
+{
+    UINT count = member_count(info), size = 32, member, slot;
+    struct member_index *index;
+    const WCHAR *name;
+
+    while (size < count * 2) size <<= 1;
+    if (!(index = heap_alloc_zero(FIELD_OFFSET(struct member_index, slots[size * 2]))))
+        return NULL;
+    index->mask = size - 1;
+    index->names = index->slots;
+    index->memids = index->slots + size;
+
+    for (member = 0; member < count; member++)
+    {
+        if ((name = TLB_get_bstr(member_name(info, member))))
+        {
+            slot = member_name_hash(name) & index->mask;
+            while (index->names[slot]) slot = (slot + 1) & index->mask;
+            index->names[slot] = member + 1;
+        }
+        slot = member_id_hash(member_id(info, member)) & index->mask;
+        while (index->memids[slot]) slot = (slot + 1) & index->mask;
+        index->memids[slot] = member + 1;
+    }
+    return index;
+}
+
+/* the members must have been loaded */
+static const struct member_index *TLB_get_member_index(ITypeInfoImpl *info)
+{
+    struct member_index *index;
+
+    if (member_count(info) < MEMBER_INDEX_THRESHOLD) return NULL;
+    if ((index = info->member_index)) return index;
+    if (!(index = member_index_create(info))) return NULL;
+    if (InterlockedCompareExchangePointer((void **)&info->member_index, index, NULL))
+    {
+        heap_free(index);
+        index = info->member_index;
+    }
+    return index;
+}
+
+/* must be called whenever members are added, removed, renamed or renumbered */
+static void TLB_reset_member_index(ITypeInfoImpl *info)
+{
+    heap_free(info->member_index);
+    info->member_index = NULL;
+}
+
+/* returns the first member numbered in [first, last) called name, or -1 */
+static int TLB_find_member_by_name(ITypeInfoImpl *info, const OLECHAR *name, UINT first, UINT last)
+{
+    const struct member_index *index;
+    UINT member, slot;
+
+    TLB_load_members(info);
+
+    if (name && (index = TLB_get_member_index(info)))
+    {
+        for (slot = member_name_hash(name) & index->mask; index->names[slot]; slot = (slot + 1) & index->mask)
+        {
+            member = index->names[slot] - 1;
+            if (member >= first && member < last && !lstrcmpiW(TLB_get_bstr(member_name(info, member)), name))
+                return member;
+        }
+        return -1;
+    }
+
+    for (member = first; member < last; member++)
+        if (!lstrcmpiW(TLB_get_bstr(member_name(info, member)), name))
+            return member;
+    return -1;
+}
+
+/* enumerates the members with the given id in order, *pos must be 0 on the
+ * first call and index the result of TLB_get_member_index(); returns -1 when
+ * there are no more */
+static int TLB_next_member_by_id(ITypeInfoImpl *info, const struct member_index *index,
+        MEMBERID memid, UINT *pos)
+{
+    UINT member, slot;
+
+    if (index)
+    {
+        for (slot = (member_id_hash(memid) + *pos) & index->mask; index->memids[slot]; slot = (slot + 1) & index->mask)
+        {
+            ++*pos;
+            member = index->memids[slot] - 1;
+            if (member_id(info, member) == memid)
+                return member;
+        }
+        return -1;
+    }
+
+    while ((member = (*pos)++) < member_count(info))
+        if (member_id(info, member) == memid)
+            return member;
+    return -1;
+}
+
 static inline TLBFuncDesc *TLB_get_funcdesc_by_memberid(ITypeInfoImpl *typeinfo, MEMBERID memid)
 {
-    int i;
+    const struct member_index *index;
+    UINT pos = 0;
+    int member;
 
-    for (i = 0; i < typeinfo->typeattr.cFuncs; ++i)
+    TLB_load_members(typeinfo);
+
+    index = TLB_get_member_index(typeinfo);
+    while ((member = TLB_next_member_by_id(typeinfo, index, memid, &pos)) != -1)
     {
-        if (typeinfo->funcdescs[i].funcdesc.memid == memid)
-            return &typeinfo->funcdescs[i];
+        if (member < typeinfo->typeattr.cFuncs)
+            return &typeinfo->funcdescs[member];
     }
 
     return NULL;
@@ -1672,12 +1858,17 @@ static inline TLBFuncDesc *TLB_get_funcdesc_by_memberid(ITypeInfoImpl *typeinfo,
 
 static inline TLBFuncDesc *TLB_get_funcdesc_by_memberid_invkind(ITypeInfoImpl *typeinfo, MEMBERID memid, INVOKEKIND invkind)
 {
-    int i;
+    const struct member_index *index;
+    UINT pos = 0;
+    int member;
+
+    TLB_load_members(typeinfo);
 
-    for (i = 0; i < typeinfo->typeattr.cFuncs; ++i)
+    index = TLB_get_member_index(typeinfo);
+    while ((member = TLB_next_member_by_id(typeinfo, index, memid, &pos)) != -1)
     {
-        if (typeinfo->funcdescs[i].funcdesc.memid == memid && typeinfo->funcdescs[i].funcdesc.invkind == invkind)
-            return &typeinfo->funcdescs[i];
+        if (member < typeinfo->typeattr.cFuncs && typeinfo->funcdescs[member].funcdesc.invkind == invkind)
+            return &typeinfo->funcdescs[member];
     }
 
     return NULL;
@@ -1685,12 +1876,17 @@ static inline TLBFuncDesc *TLB_get_funcdesc_by_memberid_invkind(ITypeInfoImpl *t
 
 static inline TLBVarDesc *TLB_get_vardesc_by_memberid(ITypeInfoImpl *typeinfo, MEMBERID memid)
 {
-    int i;
+    const struct member_index *index;
+    UINT pos = 0;
+    int member;
+
+    TLB_load_members(typeinfo);
 
-    for (i = 0; i < typeinfo->typeattr.cVars; ++i)
+    index = TLB_get_member_index(typeinfo);
+    while ((member = TLB_next_member_by_id(typeinfo, index, memid, &pos)) != -1)
     {
-        if (typeinfo->vardescs[i].vardesc.memid == memid)
-            return &typeinfo->vardescs[i];
+        if (member >= typeinfo->typeattr.cFuncs)
+            return &typeinfo->vardescs[member - typeinfo->typeattr.cFuncs];
     }
 
     return NULL;
@@ -1698,15 +1894,13 @@ static inline TLBVarDesc *TLB_get_vardesc_by_memberid(ITypeInfoImpl *typeinfo, M
 
 static inline TLBVarDesc *TLB_get_vardesc_by_name(ITypeInfoImpl *typeinfo, const OLECHAR *name)
 {
-    int i;
+    int member;
 
-    for (i = 0; i < typeinfo->typeattr.cVars; ++i)
-    {
-        if (!lstrcmpiW(TLB_get_bstr(typeinfo->vardescs[i].Name), name))
-            return &typeinfo->vardescs[i];
-    }
+    member = TLB_find_member_by_name(typeinfo, name, typeinfo->typeattr.cFuncs, member_count(typeinfo));
+    if (member == -1)
+        return NULL;
 
-    return NULL;
+    return &typeinfo->vardescs[member - typeinfo->typeattr.cFuncs];
 }
 
 static inline TLBCustData *TLB_get_custdata_by_guid(const struct list *custdata_list, REFGUID guid)
@@ -2101,13 +2295,20 @@ static HRESULT MSFT_ReadAllGuids(TLBContext *pcx)
 
 static TLBGuid *MSFT_ReadGuid( int offset, TLBContext *pcx)
 {
-    TLBGuid *ret;
+    TLBGuid **index = pcx->pLibInfo->guid_index;
+    UINT min = 0, max = pcx->pLibInfo->guid_count;
 
-    LIST_FOR_EACH_ENTRY(ret, &pcx->pLibInfo->guid_list, TLBGuid, entry){
-        if(ret->offset == offset){
-            TRACE_(typelib)("%s\n", debugstr_guid(&ret->guid));
-            return ret;
+    while (min < max)
+    {
+        UINT pos = (min + max) / 2;
+
+        if (index[pos]->offset == offset)
+        {
+            TRACE_(typelib)("%s\n", debugstr_guid(&index[pos]->guid));
+            return index[pos];
         }
+        if (index[pos]->offset < (UINT)offset) min = pos + 1;
+        else max = pos;
     }
 
     return NULL;
@@ -2176,34 +2377,54 @@ static HRESULT MSFT_ReadAllNames(TLBContext *pcx)
     }
 }
 
-static TLBString *MSFT_ReadName( TLBContext *pcx, int offset)
+/* builds an array of the strings read from a name or string table, which
+ * are stored in the list in increasing offset order */
+static TLBString **MSFT_IndexStrings(struct list *string_list, UINT *count)
 {
-    TLBString *tlbstr;
+    TLBString *tlbstr, **index;
+    UINT i = 0;
 
-    LIST_FOR_EACH_ENTRY(tlbstr, &pcx->pLibInfo->name_list, TLBString, entry) {
-        if (tlbstr->offset == offset) {
-            TRACE_(typelib)("%s\n", debugstr_w(tlbstr->str));
-            return tlbstr;
-        }
+    *count = list_count(string_list);
+    if (!(index = heap_alloc(*count * sizeof(*index))))
+    {
+        *count = 0;
+        return NULL;
     }
-
-    return NULL;
+    LIST_FOR_EACH_ENTRY(tlbstr, string_list, TLBString, entry)
+        index[i++] = tlbstr;
+    return index;
 }
 
-static TLBString *MSFT_ReadString( TLBContext *pcx, int offset)
+static TLBString *MSFT_FindString(TLBString **index, UINT count, int offset)
 {
-    TLBString *tlbstr;
+    UINT min = 0, max = count;
 
-    LIST_FOR_EACH_ENTRY(tlbstr, &pcx->pLibInfo->string_list, TLBString, entry) {
-        if (tlbstr->offset == offset) {
-            TRACE_(typelib)("%s\n", debugstr_w(tlbstr->str));
-            return tlbstr;
+    while (min < max)
+    {
+        UINT pos = (min + max) / 2;
+
+        if (index[pos]->offset == offset)
+        {
+            TRACE_(typelib)("%s\n", debugstr_w(index[pos]->str));
+            return index[pos];
         }
+        if (index[pos]->offset < (UINT)offset) min = pos + 1;
+        else max = pos;
     }
 
     return NULL;
 }
 
+static TLBString *MSFT_ReadName( TLBContext *pcx, int offset)
+{
+    return MSFT_FindString(pcx->pLibInfo->name_index, pcx->pLibInfo->name_count, offset);
+}
+
+static TLBString *MSFT_ReadString( TLBContext *pcx, int offset)
+{
+    return MSFT_FindString(pcx->pLibInfo->string_index, pcx->pLibInfo->string_count, offset);
+}
+
 /*
  * read a value and fill a VARIANT structure
  */
@@ -2714,16 +2935,10 @@ static ITypeInfoImpl * MSFT_DoTypeInfo(
 /* note: InfoType's Help file and HelpStringDll come from the containing
  * library. Further HelpString and Docstring appear to be the same thing :(
  */
-    /* functions */
-    if(ptiRet->typeattr.cFuncs >0 )
-        MSFT_DoFuncs(pcx, ptiRet, ptiRet->typeattr.cFuncs,
-		    ptiRet->typeattr.cVars,
-		    tiBase.memoffset, &ptiRet->funcdescs);
-    /* variables */
-    if(ptiRet->typeattr.cVars >0 )
-        MSFT_DoVars(pcx, ptiRet, ptiRet->typeattr.cFuncs,
-		   ptiRet->typeattr.cVars,
-		   tiBase.memoffset, &ptiRet->vardescs);
+    /* functions and variables are decoded by TLB_load_members() */
+    ptiRet->memoffset = tiBase.memoffset;
+    ptiRet->members_pending = ptiRet->typeattr.cFuncs > 0 || ptiRet->typeattr.cVars > 0;
+
     if(ptiRet->typeattr.cImplTypes >0 ) {
         switch(ptiRet->typeattr.typekind)
         {
@@ -2757,11 +2972,55 @@ static ITypeInfoImpl * MSFT_DoTypeInfo(
        debugstr_guid(TLB_get_guidref(ptiRet->guid)),
        typekind_desc[ptiRet->typeattr.typekind]);
     if (TRACE_ON(typelib))
+    {
+      TLB_load_members(ptiRet);
       dump_TypeInfo(ptiRet);
+    }
 
     return ptiRet;
 }
 
+static CRITICAL_SECTION members_section;
+static CRITICAL_SECTION_DEBUG members_section_debug =
+{
+    0, 0, &members_section,
+    { &members_section_debug.ProcessLocksList, &members_section_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": typeinfo members") }
+};
+static CRITICAL_SECTION members_section = { &members_section_debug, -1, 0, 0, 0, 0 };
+
+/* decodes the functions and variables of an MSFT typeinfo from the mapped
+ * typelib image, the first time they are needed */
+static void TLB_load_members(ITypeInfoImpl *info)
+{
+    ITypeLibImpl *lib = info->pTypeLib;
+    TLBContext cx;
+
+    if (!info->members_pending) return;
+
+    EnterCriticalSection(&members_section);
+    if (info->members_pending)
+    {
+        TRACE_(typelib)("loading members of %s\n", debugstr_w(TLB_get_bstr(info->Name)));
+
+        cx.oStart = 0;
+        cx.pos = 0;
+        cx.length = lib->image_length;
+        cx.mapping = lib->image;
+        cx.pTblDir = &lib->segdir;
+        cx.pLibInfo = lib;
+
+        if (info->typeattr.cFuncs > 0)
+            MSFT_DoFuncs(&cx, info, info->typeattr.cFuncs, info->typeattr.cVars,
+                         info->memoffset, &info->funcdescs);
+        if (info->typeattr.cVars > 0)
+            MSFT_DoVars(&cx, info, info->typeattr.cFuncs, info->typeattr.cVars,
+                        info->memoffset, &info->vardescs);
+        InterlockedExchange(&info->members_pending, FALSE);
+    }
+    LeaveCriticalSection(&members_section);
+}
+
 static HRESULT MSFT_ReadAllStrings(TLBContext *pcx)
 {
     char *string;
@@ -3365,7 +3624,7 @@ static HRESULT TLB_ReadTypeLib(LPCWSTR pszFileName, LPWSTR pszPath, UINT cchPath
         {
             DWORD dwSignature = FromLEDWord(*((DWORD*) pBase));
             if (dwSignature == MSFT_SIGNATURE)
-                *ppTypeLib = ITypeLib2_Constructor_MSFT(pBase, dwTLBLength);
+                *ppTypeLib = ITypeLib2_Constructor_MSFT(pBase, dwTLBLength, pFile);
             else if (dwSignature == SLTG_SIGNATURE)
                 *ppTypeLib = ITypeLib2_Constructor_SLTG(pBase, dwTLBLength);
             else
@@ -3388,8 +3647,21 @@ static HRESULT TLB_ReadTypeLib(LPCWSTR pszFileName, LPWSTR pszPath, UINT cchPath
 	/* We should really canonicalise the path here. */
         impl->index = index;
 
-        /* FIXME: check if it has added already in the meantime */
+        /* another thread may have loaded the same typelib in the meantime,
+         * share its copy rather than keeping two */
         EnterCriticalSection(&cache_section);
+        LIST_FOR_EACH_ENTRY(entry, &tlb_cache, ITypeLibImpl, entry)
+        {
+            if (!wcsicmp(entry->path, pszPath) && entry->index == index)
+            {
+                TRACE("lost the race, using cached copy\n");
+                ITypeLib2_AddRef(&entry->ITypeLib2_iface);
+                LeaveCriticalSection(&cache_section);
+                ITypeLib2_Release(*ppTypeLib);
+                *ppTypeLib = &entry->ITypeLib2_iface;
+                return S_OK;
+            }
+        }
         list_add_head(&tlb_cache, &impl->entry);
         LeaveCriticalSection(&cache_section);
         ret = S_OK;
@@ -3436,13 +3708,14 @@ static ITypeLibImpl* TypeLibImpl_Constructor(void)
  *
  * loading an MSFT typelib from an in-memory image
  */
-static ITypeLib2* ITypeLib2_Constructor_MSFT(LPVOID pLib, DWORD dwTLBLength)
+static ITypeLib2* ITypeLib2_Constructor_MSFT(LPVOID pLib, DWORD dwTLBLength, IUnknown *file)
 {
     TLBContext cx;
     LONG lPSegDir;
     MSFT_Header tlbHeader;
     MSFT_SegDir tlbSegDir;
     ITypeLibImpl * pTypeLibImpl;
+    TLBGuid *guid;
     int i;
 
     TRACE("%p, TLB length = %d\n", pLib, dwTLBLength);
@@ -3485,10 +3758,26 @@ static ITypeLib2* ITypeLib2_Constructor_MSFT(LPVOID pLib, DWORD dwTLBLength)
 	return NULL;
     }
 
+    /* keep the image around for TLB_load_members() */
+    pTypeLibImpl->file = file;
+    IUnknown_AddRef(file);
+    pTypeLibImpl->image = pLib;
+    pTypeLibImpl->image_length = dwTLBLength;
+    pTypeLibImpl->segdir = tlbSegDir;
+    cx.pTblDir = &pTypeLibImpl->segdir;
+
     MSFT_ReadAllNames(&cx);
     MSFT_ReadAllStrings(&cx);
     MSFT_ReadAllGuids(&cx);
 
+    pTypeLibImpl->name_index = MSFT_IndexStrings(&pTypeLibImpl->name_list, &pTypeLibImpl->name_count);
+    pTypeLibImpl->string_index = MSFT_IndexStrings(&pTypeLibImpl->string_list, &pTypeLibImpl->string_count);
+    if ((pTypeLibImpl->guid_index = heap_alloc(list_count(&pTypeLibImpl->guid_list) * sizeof(TLBGuid *))))
+    {
+        LIST_FOR_EACH_ENTRY(guid, &pTypeLibImpl->guid_list, TLBGuid, entry)
+            pTypeLibImpl->guid_index[pTypeLibImpl->guid_count++] = guid;
+    }
+
     /* now fill our internal data */
     /* TLIBATTR fields */
     pTypeLibImpl->guid = MSFT_ReadGuid(tlbHeader.posguid, &cx);
@@ -4758,6 +5047,10 @@ static ULONG WINAPI ITypeLib2_fnRelease( ITypeLib2 *iface)
           heap_free(tlbguid);
       }
 
+      heap_free(This->name_index);
+      heap_free(This->string_index);
+      heap_free(This->guid_index);
+
       TLB_FreeCustData(&This->custdata_list);
 
       for (i = 0; i < This->ctTypeDesc; i++)
@@ -4787,6 +5080,7 @@ static ULONG WINAPI ITypeLib2_fnRelease( ITypeLib2 *iface)
           ITypeInfoImpl_Destroy(This->typeinfos[i]);
       }
       heap_free(This->typeinfos);
+      if (This->file) IUnknown_Release(This->file);
       heap_free(This);
       return 0;
     }
@@ -5025,6 +5319,21 @@ memerr1:
  * described in the library.
  *
  */
+/* all member names of a loaded MSFT typelib come from its name table, looking
+ * there first avoids decoding every typeinfo for names it doesn't contain;
+ * variables are matched case-insensitively, so is the name table */
+static BOOL TLB_may_contain_name(ITypeLibImpl *This, LPOLESTR name)
+{
+    TLBString *tlbstr;
+
+    if (!This->image) return TRUE;
+
+    LIST_FOR_EACH_ENTRY(tlbstr, &This->name_list, TLBString, entry)
+        if (!lstrcmpiW(name, tlbstr->str)) return TRUE;
+
+    return FALSE;
+}
+
 static HRESULT WINAPI ITypeLib2_fnIsName(
 	ITypeLib2 *iface,
 	LPOLESTR szNameBuf,
@@ -5038,10 +5347,14 @@ static HRESULT WINAPI ITypeLib2_fnIsName(
     TRACE("(%p)->(%s,%08x,%p)\n", This, debugstr_w(szNameBuf), lHashVal,
 	  pfName);
 
+    *pfName=FALSE;
+    if (!TLB_may_contain_name(This, szNameBuf)) goto ITypeLib2_fnIsName_exit;
+
     *pfName=TRUE;
     for(tic = 0; tic < This->TypeInfoCount; ++tic){
         ITypeInfoImpl *pTInfo = This->typeinfos[tic];
         if(!TLB_str_memcmp(szNameBuf, pTInfo->Name, nNameBufLen)) goto ITypeLib2_fnIsName_exit;
+        TLB_load_members(pTInfo);
         for(fdc = 0; fdc < pTInfo->typeattr.cFuncs; ++fdc) {
             TLBFuncDesc *pFInfo = &pTInfo->funcdescs[fdc];
             int pc;
@@ -5091,6 +5404,12 @@ static HRESULT WINAPI ITypeLib2_fnFindName(
         return E_INVALIDARG;
 
     len = (lstrlenW(name) + 1)*sizeof(WCHAR);
+    if (name && !TLB_may_contain_name(This, name))
+    {
+        *found = 0;
+        return S_OK;
+    }
+
     for(tic = 0; count < *found && tic < This->TypeInfoCount; ++tic) {
         ITypeInfoImpl *pTInfo = This->typeinfos[tic];
         TLBVarDesc *var;
@@ -5101,6 +5420,8 @@ static HRESULT WINAPI ITypeLib2_fnFindName(
             goto ITypeLib2_fnFindName_exit;
         }
 
+        TLB_load_members(pTInfo);
+
         for(fdc = 0; fdc < pTInfo->typeattr.cFuncs; ++fdc) {
             TLBFuncDesc *func = &pTInfo->funcdescs[fdc];
 
@@ -5609,13 +5930,15 @@ static void ITypeInfoImpl_Destroy(ITypeInfoImpl *This)
 
     TRACE("destroying ITypeInfo(%p)\n",This);
 
-    for (i = 0; i < This->typeattr.cFuncs; ++i)
+    heap_free(This->member_index);
+
+    for (i = 0; This->funcdescs && i < This->typeattr.cFuncs; ++i)
     {
         typeinfo_release_funcdesc(&This->funcdescs[i]);
     }
     heap_free(This->funcdescs);
 
-    for(i = 0; i < This->typeattr.cVars; ++i)
+    for(i = 0; This->vardescs && i < This->typeattr.cVars; ++i)
     {
         TLBVarDesc *pVInfo = &This->vardescs[i];
         if (pVInfo->vardesc_create) {
@@ -5655,7 +5978,10 @@ static ULONG WINAPI ITypeInfo_fnRelease(ITypeInfo2 *iface)
         BOOL not_attached_to_typelib = This->not_attached_to_typelib;
         ITypeLib2_Release(&This->pTypeLib->ITypeLib2_iface);
         if (not_attached_to_typelib)
+        {
+            heap_free(This->member_index);
             heap_free(This);
+        }
         /* otherwise This will be freed when typelib is freed */
     }
 
@@ -5893,6 +6219,8 @@ static HRESULT ITypeInfoImpl_GetInternalDispatchFuncDesc( ITypeInfo *iface,
     HRESULT hr;
     UINT implemented_funcs = 0;
 
+    TLB_load_members(This);
+
     if (funcs)
         *funcs = 0;
     else
@@ -5938,6 +6266,8 @@ static HRESULT ITypeInfoImpl_GetInternalFuncDesc( ITypeInfo *iface, UINT index,
 {
     ITypeInfoImpl *This = impl_from_ITypeInfo(iface);
 
+    TLB_load_members(This);
+
     if (This->typeattr.typekind == TKIND_DISPATCH)
         return ITypeInfoImpl_GetInternalDispatchFuncDesc(iface, index, func_desc, NULL, hrefoffset);
 
@@ -6083,10 +6413,13 @@ static HRESULT WINAPI ITypeInfo_fnGetVarDesc( ITypeInfo2 *iface, UINT index,
         LPVARDESC  *ppVarDesc)
 {
     ITypeInfoImpl *This = impl_from_ITypeInfo2(iface);
-    const TLBVarDesc *pVDesc = &This->vardescs[index];
+    const TLBVarDesc *pVDesc;
 
     TRACE("(%p) index %d\n", This, index);
 
+    TLB_load_members(This);
+    pVDesc = &This->vardescs[index];
+
     if(index >= This->typeattr.cVars)
         return TYPE_E_ELEMENTNOTFOUND;
 
@@ -6288,32 +6621,34 @@ static HRESULT WINAPI ITypeInfo_fnGetIDsOfNames( ITypeInfo2 *iface,
     ITypeInfoImpl *This = impl_from_ITypeInfo2(iface);
     const TLBVarDesc *pVDesc;
     HRESULT ret=S_OK;
-    UINT i, fdc;
+    UINT i;
+    int fdc;
 
     TRACE("(%p) Name %s cNames %d\n", This, debugstr_w(*rgszNames),
             cNames);
 
+    TLB_load_members(This);
+
     /* init out parameters in case of failure */
     for (i = 0; i < cNames; i++)
         pMemId[i] = MEMBERID_NIL;
 
-    for (fdc = 0; fdc < This->typeattr.cFuncs; ++fdc) {
+    fdc = TLB_find_member_by_name(This, *rgszNames, 0, This->typeattr.cFuncs);
+    if (fdc != -1) {
         int j;
         const TLBFuncDesc *pFDesc = &This->funcdescs[fdc];
-        if(!lstrcmpiW(*rgszNames, TLB_get_bstr(pFDesc->Name))) {
-            if(cNames) *pMemId=pFDesc->funcdesc.memid;
-            for(i=1; i < cNames; i++){
-                for(j=0; j<pFDesc->funcdesc.cParams; j++)
-                    if(!lstrcmpiW(rgszNames[i],TLB_get_bstr(pFDesc->pParamDesc[j].Name)))
-                            break;
-                if( j<pFDesc->funcdesc.cParams)
-                    pMemId[i]=j;
-                else
-                   ret=DISP_E_UNKNOWNNAME;
-            };
-            TRACE("-- 0x%08x\n", ret);
-            return ret;
-        }
+        if(cNames) *pMemId=pFDesc->funcdesc.memid;
+        for(i=1; i < cNames; i++){
+            for(j=0; j<pFDesc->funcdesc.cParams; j++)
+                if(!lstrcmpiW(rgszNames[i],TLB_get_bstr(pFDesc->pParamDesc[j].Name)))
+                        break;
+            if( j<pFDesc->funcdesc.cParams)
+                pMemId[i]=j;
+            else
+               ret=DISP_E_UNKNOWNNAME;
+        };
+        TRACE("-- 0x%08x\n", ret);
+        return ret;
     }
     pVDesc = TLB_get_vardesc_by_name(This, *rgszNames);
     if(pVDesc){
@@ -7220,13 +7555,17 @@ static HRESULT WINAPI ITypeInfo_fnInvoke(
     unsigned int var_index;
     TYPEKIND type_kind;
     HRESULT hres;
-    const TLBFuncDesc *pFuncInfo;
-    UINT fdc;
+    const TLBFuncDesc *pFuncInfo = NULL;
+    const struct member_index *index;
+    UINT pos = 0;
+    int member;
 
     TRACE("(%p)(%p,id=%d,flags=0x%08x,%p,%p,%p,%p)\n",
       This,pIUnk,memid,wFlags,pDispParams,pVarResult,pExcepInfo,pArgErr
     );
 
+    TLB_load_members(This);
+
     if( This->typeattr.wTypeFlags & TYPEFLAG_FRESTRICTED )
         return DISP_E_MEMBERNOTFOUND;
 
@@ -7247,15 +7586,19 @@ static HRESULT WINAPI ITypeInfo_fnInvoke(
 
     /* we do this instead of using GetFuncDesc since it will return a fake
      * FUNCDESC for dispinterfaces and we want the real function description */
-    for (fdc = 0; fdc < This->typeattr.cFuncs; ++fdc){
-        pFuncInfo = &This->funcdescs[fdc];
-        if ((memid == pFuncInfo->funcdesc.memid) &&
-            (wFlags & pFuncInfo->funcdesc.invkind) &&
-            !func_restricted( &pFuncInfo->funcdesc ))
+    index = TLB_get_member_index(This);
+    while ((member = TLB_next_member_by_id(This, index, memid, &pos)) != -1)
+    {
+        if (member >= This->typeattr.cFuncs) continue;
+        if ((wFlags & This->funcdescs[member].funcdesc.invkind) &&
+            !func_restricted( &This->funcdescs[member].funcdesc ))
+        {
+            pFuncInfo = &This->funcdescs[member];
             break;
+        }
     }
 
-    if (fdc < This->typeattr.cFuncs) {
+    if (pFuncInfo) {
         const FUNCDESC *func_desc = &pFuncInfo->funcdesc;
 
         if (TRACE_ON(ole))
@@ -7953,9 +8296,14 @@ static HRESULT WINAPI ITypeInfo_fnGetRefTypeInfo(
         */
         pTypeInfoImpl = ITypeInfoImpl_Constructor();
 
+        /* the copy shares the members, so they must be decoded beforehand */
+        TLB_load_members(This);
+
         *pTypeInfoImpl = *This;
         pTypeInfoImpl->ref = 0;
         list_init(&pTypeInfoImpl->custdata_list);
+        /* the copy builds and frees its own member index */
+        pTypeInfoImpl->member_index = NULL;
 
         if (This->typeattr.typekind == TKIND_INTERFACE)
             pTypeInfoImpl->typeattr.typekind = TKIND_DISPATCH;
@@ -8338,15 +8686,20 @@ static HRESULT WINAPI ITypeInfo2_fnGetFuncIndexOfMemId( ITypeInfo2 * iface,
     MEMBERID memid, INVOKEKIND invKind, UINT *pFuncIndex)
 {
     ITypeInfoImpl *This = impl_from_ITypeInfo2(iface);
-    UINT fdc;
+    const struct member_index *index;
+    UINT pos = 0;
+    int fdc;
     HRESULT result;
 
-    for (fdc = 0; fdc < This->typeattr.cFuncs; ++fdc){
-        const TLBFuncDesc *pFuncInfo = &This->funcdescs[fdc];
-        if(memid == pFuncInfo->funcdesc.memid && (invKind & pFuncInfo->funcdesc.invkind))
+    TLB_load_members(This);
+
+    index = TLB_get_member_index(This);
+    while ((fdc = TLB_next_member_by_id(This, index, memid, &pos)) != -1)
+    {
+        if (fdc < This->typeattr.cFuncs && (invKind & This->funcdescs[fdc].funcdesc.invkind))
             break;
     }
-    if(fdc < This->typeattr.cFuncs) {
+    if(fdc != -1) {
         *pFuncIndex = fdc;
         result = S_OK;
     } else
@@ -8486,10 +8839,13 @@ static HRESULT WINAPI ITypeInfo2_fnGetVarCustData(
 {
     ITypeInfoImpl *This = impl_from_ITypeInfo2(iface);
     TLBCustData *pCData;
-    TLBVarDesc *pVDesc = &This->vardescs[index];
+    TLBVarDesc *pVDesc;
 
     TRACE("%p %s %p\n", This, debugstr_guid(guid), pVarVal);
 
+    TLB_load_members(This);
+    pVDesc = &This->vardescs[index];
+
     if(index >= This->typeattr.cVars)
         return TYPE_E_ELEMENTNOTFOUND;
 
@@ -8668,10 +9024,13 @@ static HRESULT WINAPI ITypeInfo2_fnGetAllVarCustData( ITypeInfo2 * iface,
     UINT index, CUSTDATA *pCustData)
 {
     ITypeInfoImpl *This = impl_from_ITypeInfo2(iface);
-    TLBVarDesc * pVDesc = &This->vardescs[index];
+    TLBVarDesc * pVDesc;
 
     TRACE("%p %u %p\n", This, index, pCustData);
 
+    TLB_load_members(This);
+    pVDesc = &This->vardescs[index];
+
     if(index >= This->typeattr.cVars)
         return TYPE_E_ELEMENTNOTFOUND;
 
@@ -8904,6 +9263,8 @@ static HRESULT WINAPI ITypeComp_fnBind(
 
     TRACE("(%p)->(%s, %x, 0x%x, %p, %p, %p)\n", This, debugstr_w(szName), lHash, wFlags, ppTInfo, pDescKind, pBindPtr);
 
+    TLB_load_members(This);
+
     *pDescKind = DESCKIND_NONE;
     pBindPtr->lpfuncdesc = NULL;
     *ppTInfo = NULL;
@@ -9682,6 +10043,8 @@ static DWORD WMSFT_compile_typeinfo_aux(ITypeInfoImpl *info,
     MEMBERID *memid;
     DWORD *name, *offsets, offs;
 
+    TLB_load_members(info);
+
     for(i = 0; i < info->typeattr.cFuncs; ++i){
         TLBFuncDesc *desc = &info->funcdescs[i];
 
@@ -10284,9 +10647,13 @@ static HRESULT WINAPI ICreateTypeLib2_fnSaveAllChanges(ICreateTypeLib2 *iface)
 
     TRACE("%p\n", This);
 
-    for(i = 0; i < This->TypeInfoCount; ++i)
+    /* compiling the names and strings below renumbers their offsets, so
+     * decode everything still pending while the old ones are valid */
+    for(i = 0; i < This->TypeInfoCount; ++i){
+        TLB_load_members(This->typeinfos[i]);
         if(This->typeinfos[i]->needs_layout)
             ICreateTypeInfo2_LayOut(&This->typeinfos[i]->ICreateTypeInfo2_iface);
+    }
 
     memset(&file, 0, sizeof(file));
 
@@ -10786,6 +11153,8 @@ static HRESULT WINAPI ICreateTypeInfo2_fnAddFuncDesc(ICreateTypeInfo2 *iface,
 
     TRACE("%p %u %p\n", This, index, funcDesc);
 
+    TLB_load_members(This);
+
     if (!funcDesc || funcDesc->oVft & 3)
         return E_INVALIDARG;
 
@@ -10891,6 +11260,7 @@ static HRESULT WINAPI ICreateTypeInfo2_fnAddFuncDesc(ICreateTypeInfo2 *iface,
     memcpy(func_desc, &tmp_func_desc, sizeof(tmp_func_desc));
     list_init(&func_desc->custdata_list);
 
+    TLB_reset_member_index(This);
     ++This->typeattr.cFuncs;
 
     This->needs_layout = TRUE;
@@ -11022,6 +11392,8 @@ static HRESULT WINAPI ICreateTypeInfo2_fnAddVarDesc(ICreateTypeInfo2 *iface,
 
     TRACE("%p %u %p\n", This, index, varDesc);
 
+    TLB_load_members(This);
+
     if (This->vardescs){
         UINT i;
 
@@ -11047,6 +11419,7 @@ static HRESULT WINAPI ICreateTypeInfo2_fnAddVarDesc(ICreateTypeInfo2 *iface,
     TLB_AllocAndInitVarDesc(varDesc, &var_desc->vardesc_create);
     var_desc->vardesc = *var_desc->vardesc_create;
 
+    TLB_reset_member_index(This);
     ++This->typeattr.cVars;
 
     This->needs_layout = TRUE;
@@ -11058,11 +11431,14 @@ static HRESULT WINAPI ICreateTypeInfo2_fnSetFuncAndParamNames(ICreateTypeInfo2 *
         UINT index, LPOLESTR *names, UINT numNames)
 {
     ITypeInfoImpl *This = info_impl_from_ICreateTypeInfo2(iface);
-    TLBFuncDesc *func_desc = &This->funcdescs[index];
+    TLBFuncDesc *func_desc;
     int i;
 
     TRACE("%p %u %p %u\n", This, index, names, numNames);
 
+    TLB_load_members(This);
+    func_desc = &This->funcdescs[index];
+
     if (!names)
         return E_INVALIDARG;
 
@@ -11087,6 +11463,7 @@ static HRESULT WINAPI ICreateTypeInfo2_fnSetFuncAndParamNames(ICreateTypeInfo2 *
         }
     }
 
+    TLB_reset_member_index(This);
     func_desc->Name = TLB_append_str(&This->pTypeLib->name_list, *names);
 
     for (i = 1; i < numNames; ++i) {
@@ -11104,12 +11481,15 @@ static HRESULT WINAPI ICreateTypeInfo2_fnSetVarName(ICreateTypeInfo2 *iface,
 
     TRACE("%p %u %s\n", This, index, wine_dbgstr_w(name));
 
+    TLB_load_members(This);
+
     if(!name)
         return E_INVALIDARG;
 
     if(index >= This->typeattr.cVars)
         return TYPE_E_ELEMENTNOTFOUND;
 
+    TLB_reset_member_index(This);
     This->vardescs[index].Name = TLB_append_str(&This->pTypeLib->name_list, name);
     return S_OK;
 }
@@ -11151,10 +11531,13 @@ static HRESULT WINAPI ICreateTypeInfo2_fnSetFuncDocString(ICreateTypeInfo2 *ifac
         UINT index, LPOLESTR docString)
 {
     ITypeInfoImpl *This = info_impl_from_ICreateTypeInfo2(iface);
-    TLBFuncDesc *func_desc = &This->funcdescs[index];
+    TLBFuncDesc *func_desc;
 
     TRACE("%p %u %s\n", This, index, wine_dbgstr_w(docString));
 
+    TLB_load_members(This);
+    func_desc = &This->funcdescs[index];
+
     if(!docString)
         return E_INVALIDARG;
 
@@ -11170,10 +11553,13 @@ static HRESULT WINAPI ICreateTypeInfo2_fnSetVarDocString(ICreateTypeInfo2 *iface
         UINT index, LPOLESTR docString)
 {
     ITypeInfoImpl *This = info_impl_from_ICreateTypeInfo2(iface);
-    TLBVarDesc *var_desc = &This->vardescs[index];
+    TLBVarDesc *var_desc;
 
     TRACE("%p %u %s\n", This, index, wine_dbgstr_w(docString));
 
+    TLB_load_members(This);
+    var_desc = &This->vardescs[index];
+
     if(!docString)
         return E_INVALIDARG;
 
@@ -11189,10 +11575,13 @@ static HRESULT WINAPI ICreateTypeInfo2_fnSetFuncHelpContext(ICreateTypeInfo2 *if
         UINT index, DWORD helpContext)
 {
     ITypeInfoImpl *This = info_impl_from_ICreateTypeInfo2(iface);
-    TLBFuncDesc *func_desc = &This->funcdescs[index];
+    TLBFuncDesc *func_desc;
 
     TRACE("%p %u %d\n", This, index, helpContext);
 
+    TLB_load_members(This);
+    func_desc = &This->funcdescs[index];
+
     if(index >= This->typeattr.cFuncs)
         return TYPE_E_ELEMENTNOTFOUND;
 
@@ -11205,10 +11594,13 @@ static HRESULT WINAPI ICreateTypeInfo2_fnSetVarHelpContext(ICreateTypeInfo2 *ifa
         UINT index, DWORD helpContext)
 {
     ITypeInfoImpl *This = info_impl_from_ICreateTypeInfo2(iface);
-    TLBVarDesc *var_desc = &This->vardescs[index];
+    TLBVarDesc *var_desc;
 
     TRACE("%p %u %d\n", This, index, helpContext);
 
+    TLB_load_members(This);
+    var_desc = &This->vardescs[index];
+
     if(index >= This->typeattr.cVars)
         return TYPE_E_ELEMENTNOTFOUND;
 
@@ -11251,6 +11643,8 @@ static HRESULT WINAPI ICreateTypeInfo2_fnLayOut(ICreateTypeInfo2 *iface)
 
     TRACE("%p\n", This);
 
+    TLB_load_members(This);
+
     This->needs_layout = FALSE;
 
     if (This->typeattr.typekind == TKIND_INTERFACE) {
@@ -11371,6 +11765,9 @@ static HRESULT WINAPI ICreateTypeInfo2_fnLayOut(ICreateTypeInfo2 *iface)
         }
     }
 
+    /* member ids may have been assigned */
+    TLB_reset_member_index(This);
+
     return hres;
 }
 
@@ -11382,11 +11779,14 @@ static HRESULT WINAPI ICreateTypeInfo2_fnDeleteFuncDesc(ICreateTypeInfo2 *iface,
 
     TRACE("%p %u\n", This, index);
 
+    TLB_load_members(This);
+
     if (index >= This->typeattr.cFuncs)
         return TYPE_E_ELEMENTNOTFOUND;
 
     typeinfo_release_funcdesc(&This->funcdescs[index]);
 
+    TLB_reset_member_index(This);
     --This->typeattr.cFuncs;
     if (index != This->typeattr.cFuncs)
     {
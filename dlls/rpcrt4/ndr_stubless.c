@@ -477,8 +477,290 @@ static size_t basetype_arg_size( unsigned char fc )
     }
 }
 
+/* Marshalling plans
+ *
+ * Walking the parameter descriptions on every call costs more than the data
+ * itself for methods with a handful of simple parameters. The first call of
+ * an -Oicf procedure resolves the type format and marshalling routines of
+ * each parameter, with fused paths for the base types and structures that are
+ * copied as is. Plans live until the stub descriptor they were built for is
+ * released. */
+
+enum param_plan_kind
+{
+    PARAM_PLAN_ROUTINES,  /* call the resolved marshalling routines */
+    PARAM_PLAN_BASETYPE,  /* base type with the same size on the wire and in memory */
+    PARAM_PLAN_STRUCT,    /* FC_STRUCT, copied as is */
+};
+
+struct param_plan
+{
+    enum param_plan_kind kind;
+    unsigned int size;
+    unsigned int alignment;
+    PFORMAT_STRING format;
+    NDR_BUFFERSIZE sizer;
+    NDR_MARSHALL marshaller;
+    NDR_UNMARSHALL unmarshaller;
+};
+
+struct proc_plan
+{
+    struct proc_plan *next;
+    const MIDL_STUB_DESC *stub_desc;
+    PFORMAT_STRING params;
+    PFORMAT_STRING types;
+    unsigned int number_of_params;
+    NDR_PARAM_OIF *params_copy; /* stored after param[] */
+    struct param_plan param[1];
+};
+
+#define PROC_PLAN_HASH_SIZE 256
+
+/* Plans are looked up by the addresses of the stub descriptor and of the
+ * format string, and the parameter descriptions are compared too, so that a
+ * format string built at a recycled address never picks up a stale plan.
+ * Those of MIDL-generated stubs live as long as the process, heap allocated
+ * ones must drop their plans with release_proc_plans() before they are
+ * freed. */
+static struct proc_plan *proc_plans[PROC_PLAN_HASH_SIZE];
+static SRWLOCK proc_plans_lock = SRWLOCK_INIT;
+
+static void init_param_plan(const MIDL_STUB_DESC *stub_desc, const NDR_PARAM_OIF *param,
+                            struct param_plan *plan)
+{
+    PFORMAT_STRING format;
+
+    if (param->attr.IsBasetype)
+        format = &param->u.type_format_char;
+    else
+        format = &stub_desc->pFormatTypes[param->u.type_offset];
+
+    plan->kind = PARAM_PLAN_ROUTINES;
+    plan->format = format;
+    plan->sizer = NdrBufferSizer[format[0] & NDR_TABLE_MASK];
+    plan->marshaller = NdrMarshaller[format[0] & NDR_TABLE_MASK];
+    plan->unmarshaller = NdrUnmarshaller[format[0] & NDR_TABLE_MASK];
+
+    switch (format[0])
+    {
+    case FC_BYTE:
+    case FC_CHAR:
+    case FC_SMALL:
+    case FC_USMALL:
+    case FC_WCHAR:
+    case FC_SHORT:
+    case FC_USHORT:
+    case FC_LONG:
+    case FC_ULONG:
+    case FC_ENUM32:
+    case FC_FLOAT:
+    case FC_DOUBLE:
+    case FC_HYPER:
+        if (!param->attr.IsBasetype) break;
+        plan->kind = PARAM_PLAN_BASETYPE;
+        plan->size = plan->alignment = basetype_arg_size(format[0]);
+        break;
+    case FC_STRUCT:
+        plan->kind = PARAM_PLAN_STRUCT;
+        plan->size = *(const WORD *)(format + 2);
+        plan->alignment = format[1] + 1;
+        break;
+    }
+}
+
+static struct proc_plan *find_proc_plan(struct proc_plan *plan, const MIDL_STUB_DESC *stub_desc,
+                                        PFORMAT_STRING params, unsigned int number_of_params)
+{
+    for (; plan; plan = plan->next)
+        if (plan->params == params && plan->stub_desc == stub_desc &&
+            plan->types == stub_desc->pFormatTypes &&
+            plan->number_of_params == number_of_params &&
+            !memcmp(plan->params_copy, params, number_of_params * sizeof(NDR_PARAM_OIF)))
+            break;
+    return plan;
+}
+
+/* returns the plan of the procedure with the given -Oicf parameters, creating
+ * it on first use; the plan stays valid as long as the call that uses it,
+ * since the stub descriptor can't be released meanwhile */
+static const struct proc_plan *get_proc_plan(const MIDL_STUB_DESC *stub_desc, PFORMAT_STRING params,
+                                             unsigned int number_of_params)
+{
+    struct proc_plan **bucket = &proc_plans[((ULONG_PTR)params >> 2) % PROC_PLAN_HASH_SIZE];
+    struct proc_plan *plan, *existing;
+    unsigned int i;
+
+    AcquireSRWLockShared(&proc_plans_lock);
+    plan = find_proc_plan(*bucket, stub_desc, params, number_of_params);
+    ReleaseSRWLockShared(&proc_plans_lock);
+    if (plan) return plan;
+
+    if (!(plan = HeapAlloc(GetProcessHeap(), 0, FIELD_OFFSET(struct proc_plan, param[number_of_params]) +
+                           number_of_params * sizeof(NDR_PARAM_OIF))))
+        return NULL;
+    plan->stub_desc = stub_desc;
+    plan->params = params;
+    plan->types = stub_desc->pFormatTypes;
+    plan->number_of_params = number_of_params;
+    plan->params_copy = (NDR_PARAM_OIF *)&plan->param[number_of_params];
+    memcpy(plan->params_copy, params, number_of_params * sizeof(NDR_PARAM_OIF));
+    for (i = 0; i < number_of_params; i++)
+        init_param_plan(stub_desc, (const NDR_PARAM_OIF *)params + i, &plan->param[i]);
+
+    AcquireSRWLockExclusive(&proc_plans_lock);
+    if ((existing = find_proc_plan(*bucket, stub_desc, params, number_of_params)))
+    {
+        /* another thread got there first */
+        HeapFree(GetProcessHeap(), 0, plan);
+        plan = existing;
+    }
+    else
+    {
+        plan->next = *bucket;
+        *bucket = plan;
+        TRACE("created plan %p for %u params at %p\n", plan, number_of_params, params);
+    }
+    ReleaseSRWLockExclusive(&proc_plans_lock);
+    return plan;
+}
+
+/* frees the plans built for a stub descriptor that is about to be freed */
+void release_proc_plans(const MIDL_STUB_DESC *stub_desc)
+{
+    struct proc_plan **entry, *plan;
+    unsigned int i;
+
+    AcquireSRWLockExclusive(&proc_plans_lock);
+    for (i = 0; i < PROC_PLAN_HASH_SIZE; i++)
+    {
+        entry = &proc_plans[i];
+        while ((plan = *entry))
+        {
+            if (plan->stub_desc == stub_desc)
+            {
+                *entry = plan->next;
+                HeapFree(GetProcessHeap(), 0, plan);
+            }
+            else entry = &plan->next;
+        }
+    }
+    ReleaseSRWLockExclusive(&proc_plans_lock);
+}
+
+static inline unsigned char *plan_param_memory(const NDR_PARAM_OIF *param, unsigned char *pMemory)
+{
+    if (param->attr.IsBasetype ? param->attr.IsSimpleRef : !param->attr.IsByValue)
+        return *(unsigned char **)pMemory;
+    return pMemory;
+}
+
+/* same as call_buffer_sizer(), i.e. NdrBaseTypeBufferSize or NdrSimpleStructBufferSize */
+static inline void plan_buffer_size(PMIDL_STUB_MESSAGE pStubMsg, unsigned char *pMemory,
+                                    const NDR_PARAM_OIF *param, const struct param_plan *plan)
+{
+    ULONG length;
+
+    switch (plan->kind)
+    {
+    case PARAM_PLAN_BASETYPE:
+    case PARAM_PLAN_STRUCT:
+        length = (pStubMsg->BufferLength + plan->alignment - 1) & ~(plan->alignment - 1);
+        if (length + plan->size < length)
+            RpcRaiseException(RPC_X_BAD_STUB_DATA);
+        pStubMsg->BufferLength = length + plan->size;
+        break;
+    default:
+        if (!plan->sizer) call_buffer_sizer(pStubMsg, pMemory, param);
+        else plan->sizer(pStubMsg, plan_param_memory(param, pMemory), plan->format);
+        break;
+    }
+}
+
+/* same as call_marshaller(), i.e. NdrBaseTypeMarshall or NdrSimpleStructMarshall */
+static inline void plan_marshall(PMIDL_STUB_MESSAGE pStubMsg, unsigned char *pMemory,
+                                 const NDR_PARAM_OIF *param, const struct param_plan *plan)
+{
+    ULONG_PTR mask = plan->alignment - 1;
+    unsigned char *buffer, *end;
+
+    switch (plan->kind)
+    {
+    case PARAM_PLAN_BASETYPE:
+    case PARAM_PLAN_STRUCT:
+        buffer = pStubMsg->Buffer;
+        memset(buffer, 0, (plan->alignment - (ULONG_PTR)buffer) & mask);
+        pStubMsg->Buffer = buffer = (unsigned char *)(((ULONG_PTR)buffer + mask) & ~mask);
+        end = (unsigned char *)pStubMsg->RpcMsg->Buffer + pStubMsg->BufferLength;
+        if (buffer + plan->size < buffer || buffer + plan->size > end)
+            RpcRaiseException(RPC_X_BAD_STUB_DATA);
+        if (plan->kind == PARAM_PLAN_STRUCT) pStubMsg->BufferMark = buffer;
+        memcpy(buffer, plan_param_memory(param, pMemory), plan->size);
+        pStubMsg->Buffer = buffer + plan->size;
+        break;
+    default:
+        if (!plan->marshaller) call_marshaller(pStubMsg, pMemory, param);
+        else plan->marshaller(pStubMsg, plan_param_memory(param, pMemory), plan->format);
+        break;
+    }
+}
+
+/* same as call_unmarshaller(), i.e. NdrBaseTypeUnmarshall or NdrSimpleStructUnmarshall */
+static inline void plan_unmarshall(PMIDL_STUB_MESSAGE pStubMsg, unsigned char **ppMemory,
+                                   const NDR_PARAM_OIF *param, const struct param_plan *plan,
+                                   unsigned char fMustAlloc)
+{
+    ULONG_PTR mask = plan->alignment - 1;
+    unsigned char *buffer, *end;
+
+    if (param->attr.IsBasetype ? param->attr.IsSimpleRef : !param->attr.IsByValue)
+        ppMemory = (unsigned char **)*ppMemory;
+
+    switch (plan->kind)
+    {
+    case PARAM_PLAN_BASETYPE:
+        pStubMsg->Buffer = buffer = (unsigned char *)(((ULONG_PTR)pStubMsg->Buffer + mask) & ~mask);
+        if (!fMustAlloc && !pStubMsg->IsClient && !*ppMemory)
+        {
+            *ppMemory = buffer;
+            end = (unsigned char *)pStubMsg->RpcMsg->Buffer + pStubMsg->BufferLength;
+        }
+        else
+        {
+            if (fMustAlloc) *ppMemory = NdrAllocate(pStubMsg, plan->size);
+            end = pStubMsg->BufferEnd;
+        }
+        if (buffer + plan->size < buffer || buffer + plan->size > end)
+            RpcRaiseException(RPC_X_BAD_STUB_DATA);
+        if (*ppMemory != buffer) memcpy(*ppMemory, buffer, plan->size);
+        pStubMsg->Buffer = buffer + plan->size;
+        break;
+    case PARAM_PLAN_STRUCT:
+        pStubMsg->Buffer = buffer = (unsigned char *)(((ULONG_PTR)pStubMsg->Buffer + mask) & ~mask);
+        if (fMustAlloc)
+        {
+            *ppMemory = NdrAllocate(pStubMsg, plan->size);
+            memset(*ppMemory, 0, plan->size);
+        }
+        else if (!pStubMsg->IsClient && !*ppMemory)
+            *ppMemory = buffer; /* for servers, we just point straight into the RPC buffer */
+        end = (unsigned char *)pStubMsg->RpcMsg->Buffer + pStubMsg->BufferLength;
+        if (buffer + plan->size < buffer || buffer + plan->size > end)
+            RpcRaiseException(RPC_X_BAD_STUB_DATA);
+        pStubMsg->BufferMark = buffer;
+        pStubMsg->Buffer = buffer + plan->size;
+        if (*ppMemory != buffer) memcpy(*ppMemory, buffer, plan->size);
+        break;
+    default:
+        if (!plan->unmarshaller) call_unmarshaller(pStubMsg, ppMemory, param, fMustAlloc);
+        else plan->unmarshaller(pStubMsg, ppMemory, plan->format, fMustAlloc);
+        break;
+    }
+}
+
 void client_do_args( PMIDL_STUB_MESSAGE pStubMsg, PFORMAT_STRING pFormat, enum stubless_phase phase,
-                     void **fpu_args, unsigned short number_of_params, unsigned char *pRetVal )
+                     void **fpu_args, unsigned short number_of_params, unsigned char *pRetVal,
+                     const struct proc_plan *plan )
 {
     const NDR_PARAM_OIF *params = (const NDR_PARAM_OIF *)pFormat;
     unsigned int i;
@@ -519,16 +801,21 @@ void client_do_args( PMIDL_STUB_MESSAGE pStubMsg, PFORMAT_STRING pFormat, enum s
         case STUBLESS_CALCSIZE:
             if (params[i].attr.IsSimpleRef && !*(unsigned char **)pArg)
                 RpcRaiseException(RPC_X_NULL_REF_POINTER);
-            if (params[i].attr.IsIn) call_buffer_sizer(pStubMsg, pArg, &params[i]);
+            if (!params[i].attr.IsIn) break;
+            if (plan) plan_buffer_size(pStubMsg, pArg, &params[i], &plan->param[i]);
+            else call_buffer_sizer(pStubMsg, pArg, &params[i]);
             break;
         case STUBLESS_MARSHAL:
-            if (params[i].attr.IsIn) call_marshaller(pStubMsg, pArg, &params[i]);
+            if (!params[i].attr.IsIn) break;
+            if (plan) plan_marshall(pStubMsg, pArg, &params[i], &plan->param[i]);
+            else call_marshaller(pStubMsg, pArg, &params[i]);
             break;
         case STUBLESS_UNMARSHAL:
             if (params[i].attr.IsOut)
             {
                 if (params[i].attr.IsReturn && pRetVal) pArg = pRetVal;
-                call_unmarshaller(pStubMsg, &pArg, &params[i], 0);
+                if (plan) plan_unmarshall(pStubMsg, &pArg, &params[i], &plan->param[i], 0);
+                else call_unmarshaller(pStubMsg, &pArg, &params[i], 0);
             }
             break;
         case STUBLESS_FREE:
@@ -703,7 +990,7 @@ static void CALLBACK ndr_client_call_finally(BOOL normal, void *arg)
 /* Helper for ndr_client_call, to factor out the part that may or may not be
  * guarded by a try/except block. */
 static LONG_PTR do_ndr_client_call( const MIDL_STUB_DESC *stub_desc, const PFORMAT_STRING format,
-        const PFORMAT_STRING handle_format, void **stack_top, void **fpu_stack, MIDL_STUB_MESSAGE *stub_msg,
+        const struct proc_plan *plan, const PFORMAT_STRING handle_format, void **stack_top, void **fpu_stack, MIDL_STUB_MESSAGE *stub_msg,
         unsigned short procedure_number, unsigned short stack_size, unsigned int number_of_params,
         INTERPRETER_OPT_FLAGS Oif_flags, INTERPRETER_OPT_FLAGS2 ext_flags, const NDR_PROC_HEADER *proc_header )
 {
@@ -790,13 +1077,13 @@ static LONG_PTR do_ndr_client_call( const MIDL_STUB_DESC *stub_desc, const PFORM
         {
             TRACE( "INITOUT\n" );
             client_do_args(stub_msg, format, STUBLESS_INITOUT, fpu_stack,
-                           number_of_params, (unsigned char *)&retval);
+                           number_of_params, (unsigned char *)&retval, plan);
         }
 
         /* 2. CALCSIZE */
         TRACE( "CALCSIZE\n" );
         client_do_args(stub_msg, format, STUBLESS_CALCSIZE, fpu_stack,
-                       number_of_params, (unsigned char *)&retval);
+                       number_of_params, (unsigned char *)&retval, plan);
 
         /* 3. GETBUFFER */
         TRACE( "GETBUFFER\n" );
@@ -816,7 +1103,7 @@ static LONG_PTR do_ndr_client_call( const MIDL_STUB_DESC *stub_desc, const PFORM
         /* 4. MARSHAL */
         TRACE( "MARSHAL\n" );
         client_do_args(stub_msg, format, STUBLESS_MARSHAL, fpu_stack,
-                       number_of_params, (unsigned char *)&retval);
+                       number_of_params, (unsigned char *)&retval, plan);
 
         /* 5. SENDRECEIVE */
         TRACE( "SENDRECEIVE\n" );
@@ -842,7 +1129,7 @@ static LONG_PTR do_ndr_client_call( const MIDL_STUB_DESC *stub_desc, const PFORM
         /* 6. UNMARSHAL */
         TRACE( "UNMARSHAL\n" );
         client_do_args(stub_msg, format, STUBLESS_UNMARSHAL, fpu_stack,
-                       number_of_params, (unsigned char *)&retval);
+                       number_of_params, (unsigned char *)&retval, plan);
     }
     __FINALLY_CTX(ndr_client_call_finally, &finally_ctx)
 
@@ -870,6 +1157,7 @@ LONG_PTR CDECL DECLSPEC_HIDDEN ndr_client_call( PMIDL_STUB_DESC pStubDesc, PFORM
     LONG_PTR RetVal = 0;
     PFORMAT_STRING pHandleFormat;
     NDR_PARAM_OIF old_args[256];
+    const struct proc_plan *plan = NULL;
 
     TRACE("pStubDesc %p, pFormat %p, ...\n", pStubDesc, pFormat);
 
@@ -930,6 +1218,8 @@ LONG_PTR CDECL DECLSPEC_HIDDEN ndr_client_call( PMIDL_STUB_DESC pStubDesc, PFORM
             }
 #endif
         }
+
+        plan = get_proc_plan(pStubDesc, pFormat, number_of_params);
     }
     else
     {
@@ -942,7 +1232,7 @@ LONG_PTR CDECL DECLSPEC_HIDDEN ndr_client_call( PMIDL_STUB_DESC pStubDesc, PFORM
     {
         __TRY
         {
-            RetVal = do_ndr_client_call(pStubDesc, pFormat, pHandleFormat,
+            RetVal = do_ndr_client_call(pStubDesc, pFormat, plan, pHandleFormat,
                     stack_top, fpu_stack, &stubMsg, procedure_number, stack_size,
                     number_of_params, Oif_flags, ext_flags, pProcHeader);
         }
@@ -951,7 +1241,7 @@ LONG_PTR CDECL DECLSPEC_HIDDEN ndr_client_call( PMIDL_STUB_DESC pStubDesc, PFORM
             /* 7. FREE */
             TRACE( "FREE\n" );
             client_do_args(&stubMsg, pFormat, STUBLESS_FREE, fpu_stack,
-                           number_of_params, (unsigned char *)&RetVal);
+                           number_of_params, (unsigned char *)&RetVal, plan);
             RetVal = NdrProxyErrorHandler(GetExceptionCode());
         }
         __ENDTRY
@@ -960,7 +1250,7 @@ LONG_PTR CDECL DECLSPEC_HIDDEN ndr_client_call( PMIDL_STUB_DESC pStubDesc, PFORM
     {
         __TRY
         {
-            RetVal = do_ndr_client_call(pStubDesc, pFormat, pHandleFormat,
+            RetVal = do_ndr_client_call(pStubDesc, pFormat, plan, pHandleFormat,
                     stack_top, fpu_stack, &stubMsg, procedure_number, stack_size,
                     number_of_params, Oif_flags, ext_flags, pProcHeader);
         }
@@ -993,7 +1283,7 @@ LONG_PTR CDECL DECLSPEC_HIDDEN ndr_client_call( PMIDL_STUB_DESC pStubDesc, PFORM
     }
     else
     {
-        RetVal = do_ndr_client_call(pStubDesc, pFormat, pHandleFormat,
+        RetVal = do_ndr_client_call(pStubDesc, pFormat, plan, pHandleFormat,
                 stack_top, fpu_stack, &stubMsg, procedure_number, stack_size,
                 number_of_params, Oif_flags, ext_flags, pProcHeader);
     }
@@ -1215,7 +1505,7 @@ LONG_PTR __cdecl call_server_func(SERVER_ROUTINE func, unsigned char * args, uns
 
 static LONG_PTR *stub_do_args(MIDL_STUB_MESSAGE *pStubMsg,
                               PFORMAT_STRING pFormat, enum stubless_phase phase,
-                              unsigned short number_of_params)
+                              unsigned short number_of_params, const struct proc_plan *plan)
 {
     const NDR_PARAM_OIF *params = (const NDR_PARAM_OIF *)pFormat;
     unsigned int i;
@@ -1234,8 +1524,9 @@ static LONG_PTR *stub_do_args(MIDL_STUB_MESSAGE *pStubMsg,
         switch (phase)
         {
         case STUBLESS_MARSHAL:
-            if (params[i].attr.IsOut || params[i].attr.IsReturn)
-                call_marshaller(pStubMsg, pArg, &params[i]);
+            if (!params[i].attr.IsOut && !params[i].attr.IsReturn) break;
+            if (plan) plan_marshall(pStubMsg, pArg, &params[i], &plan->param[i]);
+            else call_marshaller(pStubMsg, pArg, &params[i]);
             break;
         case STUBLESS_MUSTFREE:
             if (params[i].attr.MustFree)
@@ -1280,12 +1571,14 @@ static LONG_PTR *stub_do_args(MIDL_STUB_MESSAGE *pStubMsg,
                 *(void **)pArg = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY,
                                            params[i].attr.ServerAllocSize * 8);
 
-            if (params[i].attr.IsIn)
-                call_unmarshaller(pStubMsg, &pArg, &params[i], 0);
+            if (!params[i].attr.IsIn) break;
+            if (plan) plan_unmarshall(pStubMsg, &pArg, &params[i], &plan->param[i], 0);
+            else call_unmarshaller(pStubMsg, &pArg, &params[i], 0);
             break;
         case STUBLESS_CALCSIZE:
-            if (params[i].attr.IsOut || params[i].attr.IsReturn)
-                call_buffer_sizer(pStubMsg, pArg, &params[i]);
+            if (!params[i].attr.IsOut && !params[i].attr.IsReturn) break;
+            if (plan) plan_buffer_size(pStubMsg, pArg, &params[i], &plan->param[i]);
+            else call_buffer_sizer(pStubMsg, pArg, &params[i]);
             break;
         default:
             RpcRaiseException(RPC_S_INTERNAL_ERROR);
@@ -1332,6 +1625,8 @@ LONG WINAPI NdrStubCall2(
     LONG_PTR *retval_ptr = NULL;
     /* correlation cache */
     ULONG_PTR NdrCorrCache[256];
+    /* marshalling plan for -Oicf procedures */
+    const struct proc_plan *plan = NULL;
 
     TRACE("pThis %p, pChannel %p, pRpcMsg %p, pdwStubPhase %p\n", pThis, pChannel, pRpcMsg, pdwStubPhase);
 
@@ -1441,6 +1736,8 @@ LONG WINAPI NdrStubCall2(
             pFormat += pExtensions->Size;
         }
 
+        plan = get_proc_plan(pStubDesc, pFormat, number_of_params);
+
         if (Oif_flags.HasPipes)
         {
             FIXME("pipes not supported yet\n");
@@ -1528,7 +1825,7 @@ LONG WINAPI NdrStubCall2(
         case STUBLESS_MARSHAL:
         case STUBLESS_MUSTFREE:
         case STUBLESS_FREE:
-            retval_ptr = stub_do_args(&stubMsg, pFormat, phase, number_of_params);
+            retval_ptr = stub_do_args(&stubMsg, pFormat, phase, number_of_params, plan);
             break;
         default:
             ERR("shouldn't reach here. phase %d\n", phase);
@@ -1740,7 +2037,7 @@ static void do_ndr_async_client_call( const MIDL_STUB_DESC *pStubDesc, PFORMAT_S
 
     /* 1. CALCSIZE */
     TRACE( "CALCSIZE\n" );
-    client_do_args(pStubMsg, pFormat, STUBLESS_CALCSIZE, NULL, async_call_data->number_of_params, NULL);
+    client_do_args(pStubMsg, pFormat, STUBLESS_CALCSIZE, NULL, async_call_data->number_of_params, NULL, NULL);
 
     /* 2. GETBUFFER */
     TRACE( "GETBUFFER\n" );
@@ -1765,7 +2062,7 @@ static void do_ndr_async_client_call( const MIDL_STUB_DESC *pStubDesc, PFORMAT_S
 
     /* 3. MARSHAL */
     TRACE( "MARSHAL\n" );
-    client_do_args(pStubMsg, pFormat, STUBLESS_MARSHAL, NULL, async_call_data->number_of_params, NULL);
+    client_do_args(pStubMsg, pFormat, STUBLESS_MARSHAL, NULL, async_call_data->number_of_params, NULL, NULL);
 
     /* 4. SENDRECEIVE */
     TRACE( "SEND\n" );
@@ -1877,7 +2174,7 @@ RPC_STATUS NdrpCompleteAsyncClientCall(RPC_ASYNC_STATE *pAsync, void *Reply)
     /* 2. UNMARSHAL */
     TRACE( "UNMARSHAL\n" );
     client_do_args(pStubMsg, async_call_data->pParamFormat, STUBLESS_UNMARSHAL,
-                   NULL, async_call_data->number_of_params, Reply);
+                   NULL, async_call_data->number_of_params, Reply, NULL);
 
 cleanup:
     if (pStubMsg->fHasNewCorrDesc)
@@ -2110,11 +2407,11 @@ void RPC_ENTRY NdrAsyncServerCall(PRPC_MESSAGE pRpcMsg)
 
     /* 1. UNMARSHAL */
     TRACE("UNMARSHAL\n");
-    stub_do_args(async_call_data->pStubMsg, pFormat, STUBLESS_UNMARSHAL, async_call_data->number_of_params);
+    stub_do_args(async_call_data->pStubMsg, pFormat, STUBLESS_UNMARSHAL, async_call_data->number_of_params, NULL);
 
     /* 2. INITOUT */
     TRACE("INITOUT\n");
-    async_call_data->retval_ptr = stub_do_args(async_call_data->pStubMsg, pFormat, STUBLESS_INITOUT, async_call_data->number_of_params);
+    async_call_data->retval_ptr = stub_do_args(async_call_data->pStubMsg, pFormat, STUBLESS_INITOUT, async_call_data->number_of_params, NULL);
 
     /* 3. CALLSERVER */
     TRACE("CALLSERVER\n");
@@ -2178,7 +2475,7 @@ RPC_STATUS NdrpCompleteAsyncServerCall(RPC_ASYNC_STATE *pAsync, void *Reply)
         case STUBLESS_MARSHAL:
         case STUBLESS_MUSTFREE:
         case STUBLESS_FREE:
-            stub_do_args(pStubMsg, async_call_data->pHandleFormat, phase, async_call_data->number_of_params);
+            stub_do_args(pStubMsg, async_call_data->pHandleFormat, phase, async_call_data->number_of_params, NULL);
             break;
         default:
             ERR("shouldn't reach here. phase %d\n", phase);
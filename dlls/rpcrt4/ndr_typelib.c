@@ -1328,6 +1328,7 @@ static ULONG WINAPI typelib_proxy_Release(IRpcProxyBuffer *iface)
             IUnknown_Release(proxy->proxy.base_object);
         if (proxy->proxy.base_proxy)
             IRpcProxyBuffer_Release(proxy->proxy.base_proxy);
+        release_proc_plans(&proxy->stub_desc);
         heap_free((void *)proxy->stub_desc.pFormatTypes);
         heap_free((void *)proxy->proxy_info.ProcFormatString);
         heap_free(proxy->offset_table);
@@ -1470,6 +1471,7 @@ static ULONG WINAPI typelib_stub_Release(IRpcStubBuffer *iface)
             heap_free(stub->dispatch_table);
         }
 
+        release_proc_plans(&stub->stub_desc);
         heap_free((void *)stub->stub_desc.pFormatTypes);
         heap_free((void *)stub->server_info.ProcString);
         heap_free(stub->offset_table);
@@ -893,6 +893,477 @@ static RPC_STATUS rpcrt4_ncalrpc_inquire_auth_client(
     return RPC_S_OK;
 }
 
+/**** ncalrpc shared memory support ****/
+
+/* A client can ask for its ncalrpc connection to be moved from the named
+ * pipe to a pair of rings in a shared section by passing the
+ * "Transport=SharedMemory" network option. The request is sent as the first
+ * message on the pipe, which is kept open for impersonation. The section and
+ * events have no name: the server duplicates them from the client process,
+ * so nobody else can get at them. Each side only signals the other one's
+ * event when it found it waiting, so a busy connection doesn't need any
+ * server call at all. The peer can write anything to the rings, so their
+ * counters are checked before being used. */
+
+#define LRPC_SHM_MAGIC      0x4d48534c /* "LSHM", can't be mistaken for a PDU */
+#define LRPC_SHM_RING_SIZE  0x10000
+#define LRPC_SHM_SPIN_COUNT 4000
+
+struct lrpc_shm_ring
+{
+    volatile LONG head;           /* total bytes written by the producer */
+    volatile LONG tail;           /* total bytes consumed by the consumer */
+    volatile LONG reader_waiting; /* consumer is blocked on the data event */
+    volatile LONG writer_waiting; /* producer is blocked on the space event */
+    char data[LRPC_SHM_RING_SIZE];
+};
+
+struct lrpc_shm
+{
+    volatile LONG closed;
+    struct lrpc_shm_ring ring[2]; /* client to server, server to client */
+};
+
+struct lrpc_shm_request
+{
+    DWORD magic;
+    ULONG mapping;   /* handles in the client process */
+    ULONG events[4];
+};
+
+struct lrpc_shm_reply
+{
+    DWORD magic;
+    RPC_STATUS status;
+};
+
+typedef struct _RpcConnection_lrpc
+{
+    RpcConnection_np np;
+    BOOL shm_checked;
+    HANDLE mapping;
+    struct lrpc_shm *shm;
+    struct lrpc_shm_ring *send_ring;
+    struct lrpc_shm_ring *recv_ring;
+    HANDLE events[4]; /* data and space events of each ring */
+    HANDLE peer_process;
+    HANDLE cancel_event;
+} RpcConnection_lrpc;
+
+static RpcConnection *rpcrt4_conn_lrpc_alloc(void)
+{
+    RpcConnection_lrpc *lrpc = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, sizeof(*lrpc));
+    if (!lrpc)
+        return NULL;
+    if (!(lrpc->cancel_event = CreateEventW(NULL, FALSE, FALSE, NULL)))
+    {
+        HeapFree(GetProcessHeap(), 0, lrpc);
+        return NULL;
+    }
+    return &lrpc->np.common;
+}
+
+static void lrpc_shm_destroy(RpcConnection_lrpc *lrpc)
+{
+    unsigned int i;
+
+    if (lrpc->shm)
+    {
+        InterlockedExchange(&lrpc->shm->closed, TRUE);
+        for (i = 0; i < ARRAY_SIZE(lrpc->events); i++)
+            if (lrpc->events[i]) SetEvent(lrpc->events[i]);
+        UnmapViewOfFile(lrpc->shm);
+        lrpc->shm = NULL;
+    }
+    for (i = 0; i < ARRAY_SIZE(lrpc->events); i++)
+    {
+        if (lrpc->events[i]) CloseHandle(lrpc->events[i]);
+        lrpc->events[i] = NULL;
+    }
+    if (lrpc->mapping) CloseHandle(lrpc->mapping);
+    lrpc->mapping = NULL;
+    if (lrpc->peer_process) CloseHandle(lrpc->peer_process);
+    lrpc->peer_process = NULL;
+    lrpc->send_ring = lrpc->recv_ring = NULL;
+}
+
+static BOOL lrpc_shm_map(RpcConnection_lrpc *lrpc, DWORD peer_pid)
+{
+    BOOL server = lrpc->np.common.server;
+
+    if (!(lrpc->peer_process = OpenProcess(SYNCHRONIZE, FALSE, peer_pid)) ||
+        !(lrpc->shm = MapViewOfFile(lrpc->mapping, FILE_MAP_READ | FILE_MAP_WRITE, 0, 0, sizeof(struct lrpc_shm))))
+        return FALSE;
+
+    lrpc->send_ring = &lrpc->shm->ring[server ? 1 : 0];
+    lrpc->recv_ring = &lrpc->shm->ring[server ? 0 : 1];
+    return TRUE;
+}
+
+/* the client creates the section and events, and passes their handles in the request */
+static RPC_STATUS lrpc_shm_create(RpcConnection_lrpc *lrpc, DWORD server_pid, struct lrpc_shm_request *request)
+{
+    unsigned int i;
+
+    if (!lrpc->cancel_event)
+        return RPC_S_OUT_OF_RESOURCES;
+
+    if (!(lrpc->mapping = CreateFileMappingW(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+                                             0, sizeof(struct lrpc_shm), NULL)))
+        goto failed;
+    request->mapping = HandleToULong(lrpc->mapping);
+
+    for (i = 0; i < ARRAY_SIZE(lrpc->events); i++)
+    {
+        if (!(lrpc->events[i] = CreateEventW(NULL, FALSE, FALSE, NULL)))
+            goto failed;
+        request->events[i] = HandleToULong(lrpc->events[i]);
+    }
+
+    if (!lrpc_shm_map(lrpc, server_pid))
+        goto failed;
+    return RPC_S_OK;
+
+failed:
+    WARN("failed to set up shared memory connection, error %u\n", GetLastError());
+    lrpc_shm_destroy(lrpc);
+    return RPC_S_OUT_OF_RESOURCES;
+}
+
+/* the server duplicates the objects named in the request from the client
+ * process, which it found through the pipe */
+static RPC_STATUS lrpc_shm_open(RpcConnection_lrpc *lrpc, DWORD client_pid, const struct lrpc_shm_request *request)
+{
+    HANDLE client;
+    unsigned int i;
+
+    if (!lrpc->cancel_event)
+        return RPC_S_OUT_OF_RESOURCES;
+
+    if (!(client = OpenProcess(PROCESS_DUP_HANDLE, FALSE, client_pid)))
+        goto failed;
+
+    if (!DuplicateHandle(client, ULongToHandle(request->mapping), GetCurrentProcess(), &lrpc->mapping,
+                         FILE_MAP_READ | FILE_MAP_WRITE, FALSE, 0))
+        lrpc->mapping = NULL;
+    for (i = 0; lrpc->mapping && i < ARRAY_SIZE(lrpc->events); i++)
+    {
+        if (!DuplicateHandle(client, ULongToHandle(request->events[i]), GetCurrentProcess(), &lrpc->events[i],
+                             EVENT_MODIFY_STATE | SYNCHRONIZE, FALSE, 0))
+        {
+            lrpc->events[i] = NULL;
+            break;
+        }
+    }
+    CloseHandle(client);
+
+    if (i < ARRAY_SIZE(lrpc->events) || !lrpc_shm_map(lrpc, client_pid))
+        goto failed;
+    return RPC_S_OK;
+
+failed:
+    WARN("failed to set up shared memory connection, error %u\n", GetLastError());
+    lrpc_shm_destroy(lrpc);
+    return RPC_S_OUT_OF_RESOURCES;
+}
+
+static HANDLE lrpc_shm_event(RpcConnection_lrpc *lrpc, struct lrpc_shm_ring *ring, BOOL space)
+{
+    return lrpc->events[(ring - lrpc->shm->ring) * 2 + space];
+}
+
+static BOOL lrpc_shm_wait(RpcConnection_lrpc *lrpc, HANDLE event)
+{
+    HANDLE handles[3];
+    DWORD res;
+
+    handles[0] = event;
+    handles[1] = lrpc->cancel_event;
+    handles[2] = lrpc->peer_process;
+    res = WaitForMultipleObjects(3, handles, FALSE, INFINITE);
+    if (res == WAIT_FAILED)
+        ERR("WaitForMultipleObjects() failed with error %d\n", GetLastError());
+    return res == WAIT_OBJECT_0;
+}
+
+/* returns the number of bytes available in the receive ring, or 0 once the
+ * connection is closed or the wait was cancelled */
+static ULONG lrpc_shm_wait_data(RpcConnection_lrpc *lrpc)
+{
+    struct lrpc_shm_ring *ring = lrpc->recv_ring;
+    unsigned int spin;
+    ULONG avail;
+
+    for (;;)
+    {
+        for (spin = 0; spin < LRPC_SHM_SPIN_COUNT; spin++)
+        {
+            if ((avail = (ULONG)ring->head - (ULONG)ring->tail))
+            {
+                if (avail > LRPC_SHM_RING_SIZE)
+                    return 0;
+                MemoryBarrier();
+                return avail;
+            }
+            if (lrpc->shm->closed || lrpc->np.read_closed)
+                return 0;
+            YieldProcessor();
+        }
+
+        /* like CancelIoEx() on the pipe, a cancel only interrupts a pending
+         * wait, so drop one left from an earlier call; the checks below catch
+         * a close that happened before the reset */
+        ResetEvent(lrpc->cancel_event);
+        InterlockedExchange(&ring->reader_waiting, TRUE);
+        if ((avail = (ULONG)ring->head - (ULONG)ring->tail) || lrpc->shm->closed || lrpc->np.read_closed)
+        {
+            ring->reader_waiting = FALSE;
+            MemoryBarrier();
+            return avail > LRPC_SHM_RING_SIZE ? 0 : avail;
+        }
+        if (!lrpc_shm_wait(lrpc, lrpc_shm_event(lrpc, ring, FALSE)))
+            return 0;
+    }
+}
+
+/* returns the free space in the send ring, or 0 once the connection is closed */
+static ULONG lrpc_shm_wait_space(RpcConnection_lrpc *lrpc)
+{
+    struct lrpc_shm_ring *ring = lrpc->send_ring;
+    unsigned int spin;
+    ULONG used;
+
+    for (;;)
+    {
+        for (spin = 0; spin < LRPC_SHM_SPIN_COUNT; spin++)
+        {
+            if (lrpc->shm->closed)
+                return 0;
+            if ((used = (ULONG)ring->head - (ULONG)ring->tail) > LRPC_SHM_RING_SIZE)
+                return 0;
+            if (used < LRPC_SHM_RING_SIZE)
+                return LRPC_SHM_RING_SIZE - used;
+            YieldProcessor();
+        }
+
+        ResetEvent(lrpc->cancel_event);
+        InterlockedExchange(&ring->writer_waiting, TRUE);
+        used = (ULONG)ring->head - (ULONG)ring->tail;
+        if (lrpc->shm->closed || used != LRPC_SHM_RING_SIZE)
+        {
+            ring->writer_waiting = FALSE;
+            return lrpc->shm->closed || used > LRPC_SHM_RING_SIZE ? 0 : LRPC_SHM_RING_SIZE - used;
+        }
+        if (!lrpc_shm_wait(lrpc, lrpc_shm_event(lrpc, ring, TRUE)))
+            return 0;
+    }
+}
+
+static int lrpc_shm_read(RpcConnection_lrpc *lrpc, void *buffer, unsigned int count)
+{
+    struct lrpc_shm_ring *ring = lrpc->recv_ring;
+    unsigned int bytes_read = 0;
+
+    while (bytes_read < count)
+    {
+        ULONG tail = ring->tail, avail, offset, len, first;
+
+        if (!(avail = lrpc_shm_wait_data(lrpc)))
+            return -1;
+
+        len = min(avail, count - bytes_read);
+        offset = tail & (LRPC_SHM_RING_SIZE - 1);
+        first = min(len, LRPC_SHM_RING_SIZE - offset);
+        memcpy((char *)buffer + bytes_read, ring->data + offset, first);
+        memcpy((char *)buffer + bytes_read + first, ring->data, len - first);
+        bytes_read += len;
+
+        InterlockedExchange(&ring->tail, tail + len);
+        if (InterlockedCompareExchange(&ring->writer_waiting, FALSE, TRUE))
+            SetEvent(lrpc_shm_event(lrpc, ring, TRUE));
+    }
+    return bytes_read;
+}
+
+static int lrpc_shm_write(RpcConnection_lrpc *lrpc, const void *buffer, unsigned int count)
+{
+    struct lrpc_shm_ring *ring = lrpc->send_ring;
+    unsigned int bytes_written = 0;
+
+    while (bytes_written < count)
+    {
+        ULONG head = ring->head, space, offset, len, first;
+
+        if (!(space = lrpc_shm_wait_space(lrpc)))
+            return -1;
+
+        len = min(space, count - bytes_written);
+        offset = head & (LRPC_SHM_RING_SIZE - 1);
+        first = min(len, LRPC_SHM_RING_SIZE - offset);
+        memcpy(ring->data + offset, (const char *)buffer + bytes_written, first);
+        memcpy(ring->data, (const char *)buffer + bytes_written + first, len - first);
+        bytes_written += len;
+
+        InterlockedExchange(&ring->head, head + len);
+        if (InterlockedCompareExchange(&ring->reader_waiting, FALSE, TRUE))
+            SetEvent(lrpc_shm_event(lrpc, ring, FALSE));
+    }
+    return bytes_written;
+}
+
+static BOOL lrpc_shm_requested(const WCHAR *options)
+{
+    static const WCHAR shm_option[] = L"Transport=SharedMemory";
+    const unsigned int len = ARRAY_SIZE(shm_option) - 1;
+    const WCHAR *option;
+
+    for (option = options; option; option = (wcschr(option, ',') ? wcschr(option, ',')+1 : NULL))
+    {
+        if (!wcsnicmp(option, shm_option, len) && (!option[len] || option[len] == ','))
+            return TRUE;
+    }
+    return FALSE;
+}
+
+static RPC_STATUS rpcrt4_conn_lrpc_connect_shm(RpcConnection_lrpc *lrpc)
+{
+    struct lrpc_shm_request request;
+    struct lrpc_shm_reply reply;
+    ULONG server_pid;
+
+    if (!GetNamedPipeServerProcessId(lrpc->np.pipe, &server_pid))
+        return RPC_S_OK;
+
+    request.magic = LRPC_SHM_MAGIC;
+    if (lrpc_shm_create(lrpc, server_pid, &request) != RPC_S_OK)
+        return RPC_S_OK; /* keep using the pipe */
+
+    if (rpcrt4_conn_np_write(&lrpc->np.common, &request, sizeof(request)) != sizeof(request) ||
+        rpcrt4_conn_np_read(&lrpc->np.common, &reply, sizeof(reply)) != sizeof(reply) ||
+        reply.magic != LRPC_SHM_MAGIC)
+    {
+        lrpc_shm_destroy(lrpc);
+        return RPC_S_SERVER_UNAVAILABLE;
+    }
+
+    if (reply.status != RPC_S_OK)
+    {
+        WARN("server refused shared memory transport, status %u\n", reply.status);
+        lrpc_shm_destroy(lrpc);
+    }
+    TRACE("%p using %s\n", lrpc, lrpc->shm ? "shared memory" : "named pipe");
+    return RPC_S_OK;
+}
+
+/* the first message from the client tells whether it wants to switch to
+ * shared memory; returns FALSE if the pipe failed */
+static BOOL rpcrt4_conn_lrpc_accept_shm(RpcConnection_lrpc *lrpc)
+{
+    struct lrpc_shm_request request;
+    struct lrpc_shm_reply reply;
+    ULONG client_pid;
+    DWORD size = 0;
+
+    lrpc->shm_checked = TRUE;
+
+    if (rpcrt4_conn_np_read(&lrpc->np.common, NULL, 0) == -1)
+        return FALSE;
+    if (!PeekNamedPipe(lrpc->np.pipe, &request, sizeof(request), &size, NULL, NULL) ||
+        size != sizeof(request) || request.magic != LRPC_SHM_MAGIC)
+        return TRUE;
+
+    if (rpcrt4_conn_np_read(&lrpc->np.common, &request, sizeof(request)) != sizeof(request))
+        return FALSE;
+
+    reply.magic = LRPC_SHM_MAGIC;
+    if (!GetNamedPipeClientProcessId(lrpc->np.pipe, &client_pid))
+        reply.status = RPC_S_OUT_OF_RESOURCES;
+    else
+        reply.status = lrpc_shm_open(lrpc, client_pid, &request);
+
+    if (rpcrt4_conn_np_write(&lrpc->np.common, &reply, sizeof(reply)) != sizeof(reply))
+    {
+        lrpc_shm_destroy(lrpc);
+        return FALSE;
+    }
+    TRACE("%p using %s\n", lrpc, lrpc->shm ? "shared memory" : "named pipe");
+    return TRUE;
+}
+
+static RPC_STATUS rpcrt4_conn_lrpc_open(RpcConnection *conn)
+{
+    RpcConnection_lrpc *lrpc = (RpcConnection_lrpc *)conn;
+    RPC_STATUS status;
+
+    status = rpcrt4_ncalrpc_open(conn);
+    if (status != RPC_S_OK || lrpc->shm_checked)
+        return status;
+
+    lrpc->shm_checked = TRUE;
+    if (!lrpc_shm_requested(conn->NetworkOptions))
+        return RPC_S_OK;
+    return rpcrt4_conn_lrpc_connect_shm(lrpc);
+}
+
+static int rpcrt4_conn_lrpc_read(RpcConnection *conn, void *buffer, unsigned int count)
+{
+    RpcConnection_lrpc *lrpc = (RpcConnection_lrpc *)conn;
+
+    if (conn->server && !lrpc->shm_checked && !rpcrt4_conn_lrpc_accept_shm(lrpc))
+        return -1;
+    if (!lrpc->shm)
+        return rpcrt4_conn_np_read(conn, buffer, count);
+    return lrpc_shm_read(lrpc, buffer, count);
+}
+
+static int rpcrt4_conn_lrpc_write(RpcConnection *conn, const void *buffer, unsigned int count)
+{
+    RpcConnection_lrpc *lrpc = (RpcConnection_lrpc *)conn;
+
+    if (!lrpc->shm)
+        return rpcrt4_conn_np_write(conn, buffer, count);
+    return lrpc_shm_write(lrpc, buffer, count);
+}
+
+static int rpcrt4_conn_lrpc_close(RpcConnection *conn)
+{
+    RpcConnection_lrpc *lrpc = (RpcConnection_lrpc *)conn;
+
+    lrpc_shm_destroy(lrpc);
+    lrpc->shm_checked = FALSE;
+    if (lrpc->cancel_event)
+    {
+        CloseHandle(lrpc->cancel_event);
+        lrpc->cancel_event = NULL;
+    }
+    return rpcrt4_conn_np_close(conn);
+}
+
+static void rpcrt4_conn_lrpc_close_read(RpcConnection *conn)
+{
+    RpcConnection_lrpc *lrpc = (RpcConnection_lrpc *)conn;
+
+    rpcrt4_conn_np_close_read(conn);
+    if (lrpc->cancel_event) SetEvent(lrpc->cancel_event);
+}
+
+static void rpcrt4_conn_lrpc_cancel_call(RpcConnection *conn)
+{
+    RpcConnection_lrpc *lrpc = (RpcConnection_lrpc *)conn;
+
+    rpcrt4_conn_np_cancel_call(conn);
+    if (lrpc->cancel_event) SetEvent(lrpc->cancel_event);
+}
+
+static int rpcrt4_conn_lrpc_wait_for_incoming_data(RpcConnection *conn)
+{
+    RpcConnection_lrpc *lrpc = (RpcConnection_lrpc *)conn;
+
+    if (!lrpc->shm)
+        return rpcrt4_conn_np_wait_for_incoming_data(conn);
+    return lrpc_shm_wait_data(lrpc) ? 0 : -1;
+}
+
 /**** ncacn_ip_tcp support ****/
 
 static size_t rpcrt4_ip_tcp_get_top_of_tower(unsigned char *tower_data,
@@ -3138,16 +3609,16 @@ static const struct connection_ops conn_protseq_list[] = {
   },
   { "ncalrpc",
     { EPM_PROTOCOL_NCALRPC, EPM_PROTOCOL_PIPE },
-    rpcrt4_conn_np_alloc,
-    rpcrt4_ncalrpc_open,
+    rpcrt4_conn_lrpc_alloc,
+    rpcrt4_conn_lrpc_open,
     rpcrt4_ncalrpc_handoff,
-    rpcrt4_conn_np_read,
-    rpcrt4_conn_np_write,
-    rpcrt4_conn_np_close,
-    rpcrt4_conn_np_close_read,
-    rpcrt4_conn_np_cancel_call,
+    rpcrt4_conn_lrpc_read,
+    rpcrt4_conn_lrpc_write,
+    rpcrt4_conn_lrpc_close,
+    rpcrt4_conn_lrpc_close_read,
+    rpcrt4_conn_lrpc_cancel_call,
     rpcrt4_ncalrpc_np_is_server_listening,
-    rpcrt4_conn_np_wait_for_incoming_data,
+    rpcrt4_conn_lrpc_wait_for_incoming_data,
     rpcrt4_ncalrpc_get_top_of_tower,
     rpcrt4_ncalrpc_parse_top_of_tower,
     NULL,
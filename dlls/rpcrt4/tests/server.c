@@ -1943,6 +1943,98 @@ static void _test_is_server_listening2(unsigned line, RPC_BINDING_HANDLE binding
                        status, expected_status, expected_status2);
 }
 
+static unsigned int count_mapped_views(void)
+{
+  MEMORY_BASIC_INFORMATION info;
+  unsigned int count = 0;
+  char *addr = NULL;
+
+  while (VirtualQuery(addr, &info, sizeof(info)))
+  {
+    if (info.Type == MEM_MAPPED && info.BaseAddress == info.AllocationBase)
+      count++;
+    addr = (char *)info.BaseAddress + info.RegionSize;
+  }
+  return count;
+}
+
+static void
+benchmark_ncalrpc(unsigned char *guid, unsigned char *options, const char *name)
+{
+  static unsigned char ncalrpc[] = "ncalrpc";
+  unsigned char *binding;
+  int data[0x4000], sum = 0, ret = 0;
+  DWORD start, elapsed, i;
+
+  for (i = 0; i < ARRAY_SIZE(data); i++)
+    sum += data[i] = i;
+
+  ok(RPC_S_OK == RpcStringBindingComposeA(NULL, ncalrpc, NULL, guid, options, &binding), "RpcStringBindingCompose\n");
+  ok(RPC_S_OK == RpcBindingFromStringBindingA(binding, &IMixedServer_IfHandle), "RpcBindingFromStringBinding\n");
+
+  start = GetTickCount();
+  for (i = 0; i < 10000; i++)
+    ret = int_return();
+  elapsed = GetTickCount() - start;
+  ok(ret == INT_CODE, "RPC int_return\n");
+  trace("%s: 10000 round trips in %u ms\n", name, elapsed);
+
+  start = GetTickCount();
+  for (i = 0; i < 1000; i++)
+    ret = sum_conf_array(data, ARRAY_SIZE(data));
+  elapsed = GetTickCount() - start;
+  ok(ret == sum, "RPC sum_conf_array\n");
+  trace("%s: %u KB sent in %u ms\n", name, (unsigned int)(1000 * sizeof(data) / 1024), elapsed);
+
+  ok(RPC_S_OK == RpcStringFreeA(&binding), "RpcStringFree\n");
+  ok(RPC_S_OK == RpcBindingFree(&IMixedServer_IfHandle), "RpcBindingFree\n");
+}
+
+static void
+benchmark_stubless(unsigned char *guid, unsigned char *options)
+{
+  static unsigned char ncalrpc[] = "ncalrpc";
+  unsigned char *binding;
+  vector_t v = {1, 2, 3};
+  int data[16], sum = 0, ret = 0;
+  hyper hret = 0;
+  DWORD start, elapsed, i;
+
+  for (i = 0; i < ARRAY_SIZE(data); i++)
+    sum += data[i] = i;
+
+  set_interp_interface();
+
+  ok(RPC_S_OK == RpcStringBindingComposeA(NULL, ncalrpc, NULL, guid, options, &binding), "RpcStringBindingCompose\n");
+  ok(RPC_S_OK == RpcBindingFromStringBindingA(binding, &IInterpServer_IfHandle), "RpcBindingFromStringBinding\n");
+
+  start = GetTickCount();
+  for (i = 0; i < 10000; i++)
+    hret = sum_hyper(0x12345678, 0x87654321);
+  elapsed = GetTickCount() - start;
+  ok(hret == (hyper)0x12345678 + 0x87654321, "RPC sum_hyper\n");
+  trace("stubless: 10000 sum_hyper calls in %u ms\n", elapsed);
+
+  start = GetTickCount();
+  for (i = 0; i < 10000; i++)
+    ret = dot_self(&v);
+  elapsed = GetTickCount() - start;
+  ok(ret == 14, "RPC dot_self\n");
+  trace("stubless: 10000 dot_self calls in %u ms\n", elapsed);
+
+  start = GetTickCount();
+  for (i = 0; i < 10000; i++)
+    ret = sum_conf_array(data, ARRAY_SIZE(data));
+  elapsed = GetTickCount() - start;
+  ok(ret == sum, "RPC sum_conf_array\n");
+  trace("stubless: 10000 sum_conf_array calls in %u ms\n", elapsed);
+
+  ok(RPC_S_OK == RpcStringFreeA(&binding), "RpcStringFree\n");
+  ok(RPC_S_OK == RpcBindingFree(&IInterpServer_IfHandle), "RpcBindingFree\n");
+
+  set_mixed_interface();
+}
+
 static void
 client(const char *test)
 {
@@ -1954,6 +2046,7 @@ client(const char *test)
   static unsigned char port[] = PORT;
   static unsigned char pipe[] = PIPE;
   static unsigned char guid[] = "00000000-4114-0704-2301-000000000000";
+  static unsigned char shm_options[] = "Transport=SharedMemory";
 
   unsigned char *binding;
 
@@ -2021,6 +2114,33 @@ todo_wine
     ok(RPC_S_OK == RpcStringFreeA(&binding), "RpcStringFree\n");
     ok(RPC_S_OK == RpcBindingFree(&IMixedServer_IfHandle), "RpcBindingFree\n");
   }
+  else if (strcmp(test, "ncalrpc_shm") == 0)
+  {
+    unsigned int views;
+
+    ok(RPC_S_OK == RpcStringBindingComposeA(NULL, ncalrpc, NULL, guid, shm_options, &binding), "RpcStringBindingCompose\n");
+    ok(RPC_S_OK == RpcBindingFromStringBindingA(binding, &IMixedServer_IfHandle), "RpcBindingFromStringBinding\n");
+
+    /* the connection is made by the first call, the client then maps the rings */
+    views = count_mapped_views();
+    ok(int_return() == INT_CODE, "RPC int_return\n");
+    if (!strcmp(winetest_platform, "wine"))
+      ok(count_mapped_views() == views + 1, "shared memory isn't used, got %u views, expected %u\n",
+         count_mapped_views(), views + 1);
+
+    run_tests();
+    authinfo_test(RPC_PROTSEQ_LRPC, 0);
+    test_is_server_listening(IMixedServer_IfHandle, RPC_S_OK);
+
+    ok(RPC_S_OK == RpcStringFreeA(&binding), "RpcStringFree\n");
+    ok(RPC_S_OK == RpcBindingFree(&IMixedServer_IfHandle), "RpcBindingFree\n");
+  }
+  else if (strcmp(test, "ncalrpc_benchmark") == 0)
+  {
+    benchmark_ncalrpc(guid, NULL, "named pipe");
+    benchmark_ncalrpc(guid, shm_options, "shared memory");
+    benchmark_stubless(guid, shm_options);
+  }
   else if (strcmp(test, "np_basic") == 0)
   {
     ok(RPC_S_OK == RpcStringBindingComposeA(NULL, np, address_np, pipe, NULL, &binding), "RpcStringBindingCompose\n");
@@ -2117,6 +2237,10 @@ server(void)
 
     /* we don't need to register RPC_C_AUTHN_WINNT for ncalrpc */
     run_client("ncalrpc_secure");
+
+    run_client("ncalrpc_shm");
+    if (winetest_interactive)
+      run_client("ncalrpc_benchmark");
   }
   else
     skip("lrpc tests skipped due to earlier failure\n");
@@ -30,6 +30,10 @@
 
 #include "tomcrypt.h"
 
+#if defined(__i386__) || defined(__x86_64__)
+#include <intrin.h>
+#endif
+
 static const ulong32 TE0[256] = {
     0xc66363a5UL, 0xf87c7c84UL, 0xee777799UL, 0xf67b7b8dUL,
     0xfff2f20dUL, 0xd66b6bbdUL, 0xde6f6fb1UL, 0x91c5c554UL,
@@ -934,6 +938,51 @@ static ulong32 setup_mix(ulong32 temp)
           (Te4_0[byte(temp, 3)]);
 }
 
+#if defined(__i386__) || defined(__x86_64__)
+
+static int have_aes_ni(void)
+{
+    static int supported = -1;
+    int regs[4];
+
+    if (supported == -1) {
+        __cpuid(regs, 1);
+        supported = !!(regs[2] & (1 << 25));
+    }
+    return supported;
+}
+
+/* The eK schedule is the AES key expansion and dK the equivalent inverse
+ * cipher schedule, which is what aesenc and aesdec expect, only stored as
+ * big-endian words. */
+static void __attribute__((target("aes,sse2"))) aes_ni_encrypt(const unsigned char *in, unsigned char *out, const unsigned char *keys, int Nr)
+{
+    const __m128i *rk = (const __m128i *)keys;
+    __m128i s;
+    int r;
+
+    s = _mm_xor_si128(_mm_loadu_si128((const __m128i *)in), _mm_loadu_si128(rk));
+    for (r = 1; r < Nr; r++)
+        s = _mm_aesenc_si128(s, _mm_loadu_si128(rk + r));
+    s = _mm_aesenclast_si128(s, _mm_loadu_si128(rk + Nr));
+    _mm_storeu_si128((__m128i *)out, s);
+}
+
+static void __attribute__((target("aes,sse2"))) aes_ni_decrypt(const unsigned char *in, unsigned char *out, const unsigned char *keys, int Nr)
+{
+    const __m128i *rk = (const __m128i *)keys;
+    __m128i s;
+    int r;
+
+    s = _mm_xor_si128(_mm_loadu_si128((const __m128i *)in), _mm_loadu_si128(rk));
+    for (r = 1; r < Nr; r++)
+        s = _mm_aesdec_si128(s, _mm_loadu_si128(rk + r));
+    s = _mm_aesdeclast_si128(s, _mm_loadu_si128(rk + Nr));
+    _mm_storeu_si128((__m128i *)out, s);
+}
+
+#endif
+
 int aes_setup(const unsigned char *key, int keylen, int rounds, aes_key *skey)
 {
     int i, j;
@@ -1058,6 +1107,11 @@ int aes_setup(const unsigned char *key, int keylen, int rounds, aes_key *skey)
     *rk++ = *rrk++;
     *rk   = *rrk;
 
+    for (i = 0; i < 4 * (skey->Nr + 1); i++) {
+        STORE32H(skey->eK[i], skey->eKb + 4 * i);
+        STORE32H(skey->dK[i], skey->dKb + 4 * i);
+    }
+
     return CRYPT_OK;
 }
 
@@ -1066,6 +1120,13 @@ void aes_ecb_encrypt(const unsigned char *pt, unsigned char *ct, aes_key *skey)
     ulong32 s0, s1, s2, s3, t0, t1, t2, t3, *rk;
     int Nr, r;
 
+#if defined(__i386__) || defined(__x86_64__)
+    if (have_aes_ni()) {
+        aes_ni_encrypt(pt, ct, skey->eKb, skey->Nr);
+        return;
+    }
+#endif
+
     Nr = skey->Nr;
     rk = skey->eK;
 
@@ -1167,6 +1228,13 @@ void aes_ecb_decrypt(const unsigned char *ct, unsigned char *pt, aes_key *skey)
     ulong32 s0, s1, s2, s3, t0, t1, t2, t3, *rk;
     int Nr, r;
 
+#if defined(__i386__) || defined(__x86_64__)
+    if (have_aes_ni()) {
+        aes_ni_decrypt(ct, pt, skey->dKb, skey->Nr);
+        return;
+    }
+#endif
+
     Nr = skey->Nr;
     rk = skey->dK;
 
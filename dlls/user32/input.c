@@ -448,6 +448,7 @@ SHORT WINAPI DECLSPEC_HOTPATCH GetAsyncKeyState( INT key )
  */
 DWORD WINAPI GetQueueStatus( UINT flags )
 {
+    const volatile struct queue_shared_memory *shared = get_user_thread_info()->queue_shared;
     DWORD ret;
 
     if (flags & ~(QS_ALLINPUT | QS_ALLPOSTMESSAGE | QS_SMRESULT))
@@ -458,6 +459,13 @@ DWORD WINAPI GetQueueStatus( UINT flags )
 
     check_for_events( flags );
 
+    if (shared)
+    {
+        ret = shared->wake_bits & flags;
+        /* nothing to clear, no need to ask the server */
+        if (!(shared->changed_bits & flags)) return MAKELONG( 0, ret );
+    }
+
     SERVER_START_REQ( get_queue_status )
     {
         req->clear_bits = flags;
@@ -474,10 +482,13 @@ DWORD WINAPI GetQueueStatus( UINT flags )
  */
 BOOL WINAPI GetInputState(void)
 {
+    const volatile struct queue_shared_memory *shared = get_user_thread_info()->queue_shared;
     DWORD ret;
 
     check_for_events( QS_INPUT );
 
+    if (shared) return shared->wake_bits & (QS_KEY | QS_MOUSEBUTTON);
+
     SERVER_START_REQ( get_queue_status )
     {
         req->clear_bits = 0;
@@ -2643,6 +2643,77 @@ static inline void call_sendmsg_callback( SENDASYNCPROC callback, HWND hwnd, UIN
 }
 
 
+/***********************************************************************
+ *           get_server_queue_handle
+ *
+ * Get a handle to the server message queue for the current thread.
+ */
+static HANDLE get_server_queue_handle(void)
+{
+    struct user_thread_info *thread_info = get_user_thread_info();
+    HANDLE ret, shared = 0;
+
+    if (!(ret = thread_info->server_queue))
+    {
+        SERVER_START_REQ( get_msg_queue )
+        {
+            wine_server_call( req );
+            ret = wine_server_ptr_handle( reply->handle );
+            shared = wine_server_ptr_handle( reply->shared );
+        }
+        SERVER_END_REQ;
+        thread_info->server_queue = ret;
+        if (!ret) ERR( "Cannot get server thread queue\n" );
+
+        if (shared)
+        {
+            void *ptr = NULL;
+            SIZE_T size = 0;
+
+            if (!NtMapViewOfSection( shared, GetCurrentProcess(), &ptr, 0, 0, NULL, &size,
+                                     ViewUnmap, 0, PAGE_READONLY ))
+                thread_info->queue_shared = ptr;
+            else
+                WARN( "Cannot map the queue shared memory\n" );
+            NtClose( shared );
+        }
+    }
+    return ret;
+}
+
+
+/***********************************************************************
+ *           is_queue_idle
+ *
+ * Check the queue bits that the server mirrors in shared memory to find out,
+ * without a server round trip, that a get_message request with these
+ * parameters would only return STATUS_PENDING and leave the queue unchanged.
+ */
+static BOOL is_queue_idle( HWND hwnd, UINT flags, UINT changed_mask )
+{
+    struct user_thread_info *thread_info = get_user_thread_info();
+    const volatile struct queue_shared_memory *shared;
+    UINT filter = HIWORD(flags) ? HIWORD(flags) : QS_ALLINPUT;
+    UINT mask = filter | QS_SENDMESSAGE;
+
+    /* the server validates the window and signals the idle event for us */
+    if (hwnd) return FALSE;
+    /* the server would change the wait masks */
+    if (thread_info->wake_mask != (changed_mask & (QS_SENDMESSAGE | QS_SMRESULT)) ||
+        thread_info->changed_mask != changed_mask) return FALSE;
+    /* still call the server regularly, it keeps track of hung queues for us and
+     * returns the active hooks */
+    if (GetTickCount() - thread_info->last_get_msg >= 50) return FALSE;
+
+    if (!thread_info->server_queue) get_server_queue_handle();
+    if (!(shared = thread_info->queue_shared)) return FALSE;
+
+    /* the server would clear these changed bits */
+    if (filter & QS_POSTMESSAGE) mask |= QS_ALLPOSTMESSAGE | QS_HOTKEY | QS_TIMER;
+    return !((shared->wake_bits | shared->changed_bits) & mask);
+}
+
+
 /***********************************************************************
  *           peek_message
  *
@@ -2660,11 +2731,12 @@ static int peek_message( MSG *msg, HWND hwnd, UINT first, UINT last, UINT flags,
     void *buffer;
     size_t buffer_size = 256;
 
-    if (!(buffer = HeapAlloc( GetProcessHeap(), 0, buffer_size ))) return -1;
-
     if (!first && !last) last = ~0;
     if (hwnd == HWND_BROADCAST) hwnd = HWND_TOPMOST;
 
+    if (is_queue_idle( hwnd, flags, changed_mask )) return 0;
+    if (!(buffer = HeapAlloc( GetProcessHeap(), 0, buffer_size ))) return -1;
+
     for (;;)
     {
         NTSTATUS res;
@@ -2683,7 +2755,9 @@ static int peek_message( MSG *msg, HWND hwnd, UINT first, UINT last, UINT flags,
             req->wake_mask = changed_mask & (QS_SENDMESSAGE | QS_SMRESULT);
             req->changed_mask = changed_mask;
             wine_server_set_reply( req, buffer, buffer_size );
-            if (!(res = wine_server_call( req )))
+            res = wine_server_call( req );
+            thread_info->last_get_msg = GetTickCount();
+            if (!res)
             {
                 size = wine_server_reply_size( reply );
                 info.type        = reply->type;
@@ -2906,31 +2980,6 @@ static inline void process_sent_messages(void)
 }
 
 
-/***********************************************************************
- *           get_server_queue_handle
- *
- * Get a handle to the server message queue for the current thread.
- */
-static HANDLE get_server_queue_handle(void)
-{
-    struct user_thread_info *thread_info = get_user_thread_info();
-    HANDLE ret;
-
-    if (!(ret = thread_info->server_queue))
-    {
-        SERVER_START_REQ( get_msg_queue )
-        {
-            wine_server_call( req );
-            ret = wine_server_ptr_handle( reply->handle );
-        }
-        SERVER_END_REQ;
-        thread_info->server_queue = ret;
-        if (!ret) ERR( "Cannot get server thread queue\n" );
-    }
-    return ret;
-}
-
-
 /***********************************************************************
  *           wait_message_reply
  *
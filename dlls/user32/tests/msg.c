@@ -12747,6 +12747,74 @@ static void test_PeekMessage3(void)
     flush_events();
 }
 
+static DWORD WINAPI post_message_thread(void *arg)
+{
+    Sleep(50);
+    PostThreadMessageA(PtrToUlong(arg), WM_USER, 0, 0);
+    return 0;
+}
+
+static void test_PeekMessage_idle(void)
+{
+    HANDLE thread;
+    DWORD status, start;
+    BOOL ret;
+    MSG msg;
+
+    flush_events();
+    ret = PeekMessageA(&msg, NULL, 0, 0, PM_REMOVE);
+    ok(!ret, "expected PeekMessage to return FALSE, got %u\n", ret);
+    status = GetQueueStatus(QS_POSTMESSAGE);
+    ok(!status, "GetQueueStatus returned %08x\n", status);
+
+    /* messages posted by another thread show up while we keep polling the empty queue */
+    thread = CreateThread(NULL, 0, post_message_thread, ULongToPtr(GetCurrentThreadId()), 0, NULL);
+    ok(thread != NULL, "CreateThread failed, error %d\n", GetLastError());
+    start = GetTickCount();
+    while (!(ret = PeekMessageA(&msg, NULL, 0, 0, PM_REMOVE)) && GetTickCount() - start < 5000);
+    ok(ret && msg.message == WM_USER, "msg.message = %u instead of WM_USER\n", msg.message);
+    WaitForSingleObject(thread, INFINITE);
+    CloseHandle(thread);
+
+    thread = CreateThread(NULL, 0, post_message_thread, ULongToPtr(GetCurrentThreadId()), 0, NULL);
+    ok(thread != NULL, "CreateThread failed, error %d\n", GetLastError());
+    WaitForSingleObject(thread, INFINITE);
+    CloseHandle(thread);
+
+    status = GetQueueStatus(QS_POSTMESSAGE);
+    ok(status == MAKELONG(QS_POSTMESSAGE, QS_POSTMESSAGE), "GetQueueStatus returned %08x\n", status);
+    status = GetQueueStatus(QS_POSTMESSAGE);
+    ok(status == MAKELONG(0, QS_POSTMESSAGE), "GetQueueStatus returned %08x\n", status);
+    ret = PeekMessageA(&msg, NULL, 0, 0, PM_REMOVE);
+    ok(ret && msg.message == WM_USER, "msg.message = %u instead of WM_USER\n", msg.message);
+    ret = PeekMessageA(&msg, NULL, 0, 0, PM_REMOVE);
+    ok(!ret, "expected PeekMessage to return FALSE, got %u\n", ret);
+    status = GetQueueStatus(QS_POSTMESSAGE);
+    ok(!status, "GetQueueStatus returned %08x\n", status);
+}
+
+static void test_PeekMessage_benchmark(void)
+{
+    unsigned int i, count = 200000;
+    DWORD start, elapsed;
+    MSG msg;
+
+    flush_events();
+
+    start = GetTickCount();
+    for (i = 0; i < count; i++)
+        if (PeekMessageA(&msg, NULL, 0, 0, PM_REMOVE)) DispatchMessageA(&msg);
+    elapsed = GetTickCount() - start;
+    trace("%u idle PeekMessage calls in %u ms, %u calls per second\n",
+          count, elapsed, elapsed ? (unsigned int)((ULONGLONG)count * 1000 / elapsed) : ~0u);
+
+    start = GetTickCount();
+    for (i = 0; i < count; i++) GetQueueStatus(QS_ALLINPUT);
+    elapsed = GetTickCount() - start;
+    trace("%u idle GetQueueStatus calls in %u ms, %u calls per second\n",
+          count, elapsed, elapsed ? (unsigned int)((ULONGLONG)count * 1000 / elapsed) : ~0u);
+}
+
 static INT_PTR CALLBACK wm_quit_dlg_proc(HWND hwnd, UINT message, WPARAM wp, LPARAM lp)
 {
     struct recvd_message msg;
@@ -18303,6 +18371,8 @@ START_TEST(msg)
     test_PeekMessage();
     test_PeekMessage2();
     test_PeekMessage3();
+    test_PeekMessage_idle();
+    if (winetest_interactive) test_PeekMessage_benchmark();
     test_WaitForInputIdle( test_argv[0] );
     test_scrollwindowex();
     test_messages();
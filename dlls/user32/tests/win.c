@@ -11758,7 +11758,9 @@ static void other_process_proc(HWND hwnd)
 {
     HANDLE window_ready_event, test_done_event;
     WINDOWPLACEMENT wp;
-    DWORD ret;
+    DWORD ret, pid;
+    LONG style;
+    RECT rect;
 
     window_ready_event = OpenEventA(EVENT_ALL_ACCESS, FALSE, "test_opw_window");
     ok(!!window_ready_event, "OpenEvent failed.\n");
@@ -11772,6 +11774,18 @@ static void other_process_proc(HWND hwnd)
     ok(ret, "Unexpected ret %#x.\n", ret);
     ok(wp.showCmd == SW_SHOWNORMAL, "Unexpected showCmd %#x.\n", wp.showCmd);
     ok(!wp.flags, "Unexpected flags %#x.\n", wp.flags);
+    ok(IsWindow(hwnd), "Expected a valid window.\n");
+    ok(IsWindowVisible(hwnd), "Expected a visible window.\n");
+    style = GetWindowLongA(hwnd, GWL_STYLE);
+    ok((style & (WS_POPUP | WS_VISIBLE | WS_MINIMIZE | WS_MAXIMIZE)) == (WS_POPUP | WS_VISIBLE),
+       "Unexpected style %#x.\n", style);
+    ret = GetWindowThreadProcessId(hwnd, &pid);
+    ok(ret && pid != GetCurrentProcessId(), "Unexpected thread %#x, process %#x.\n", ret, pid);
+    ok(!GetParent(hwnd), "Unexpected parent %p.\n", GetParent(hwnd));
+    ok(GetAncestor(hwnd, GA_PARENT) == GetDesktopWindow(), "Unexpected parent %p.\n", GetAncestor(hwnd, GA_PARENT));
+    GetWindowRect(hwnd, &rect);
+    ok(rect.left == 100 && rect.top == 100 && rect.right == 200 && rect.bottom == 200,
+       "Unexpected rect %s.\n", wine_dbgstr_rect(&rect));
     SetEvent(test_done_event);
 
     /* SW_SHOWMAXIMIZED */
@@ -11781,6 +11795,9 @@ static void other_process_proc(HWND hwnd)
     ok(ret, "Unexpected ret %#x.\n", ret);
     ok(wp.showCmd == SW_SHOWMAXIMIZED, "Unexpected showCmd %#x.\n", wp.showCmd);
     todo_wine ok(wp.flags == WPF_RESTORETOMAXIMIZED, "Unexpected flags %#x.\n", wp.flags);
+    style = GetWindowLongA(hwnd, GWL_STYLE);
+    ok((style & (WS_MINIMIZE | WS_MAXIMIZE)) == WS_MAXIMIZE, "Unexpected style %#x.\n", style);
+    ok(IsZoomed(hwnd), "Expected a maximized window.\n");
     SetEvent(test_done_event);
 
     /* SW_SHOWMINIMIZED */
@@ -11790,6 +11807,9 @@ static void other_process_proc(HWND hwnd)
     ok(ret, "Unexpected ret %#x.\n", ret);
     ok(wp.showCmd == SW_SHOWMINIMIZED, "Unexpected showCmd %#x.\n", wp.showCmd);
     todo_wine ok(wp.flags == WPF_RESTORETOMAXIMIZED, "Unexpected flags %#x.\n", wp.flags);
+    style = GetWindowLongA(hwnd, GWL_STYLE);
+    ok((style & (WS_MINIMIZE | WS_MAXIMIZE)) == WS_MINIMIZE, "Unexpected style %#x.\n", style);
+    ok(IsIconic(hwnd), "Expected a minimized window.\n");
     SetEvent(test_done_event);
 
     /* SW_RESTORE */
@@ -11901,6 +11921,101 @@ static void test_other_process_window(const char *argv0)
     DestroyWindow(hwnd);
 }
 
+static void window_state_benchmark_proc(void)
+{
+    HANDLE ready_event, done_event;
+    HWND hwnd;
+    int i;
+
+    ready_event = OpenEventA(EVENT_ALL_ACCESS, FALSE, "test_wsb_ready");
+    ok(!!ready_event, "OpenEvent failed.\n");
+    done_event = OpenEventA(EVENT_ALL_ACCESS, FALSE, "test_wsb_done");
+    ok(!!done_event, "OpenEvent failed.\n");
+
+    hwnd = CreateWindowExA(0, "static", "window_state_benchmark", WS_POPUP | WS_VISIBLE,
+                           0, 0, 1000, 1000, 0, 0, NULL, NULL);
+    ok(!!hwnd, "CreateWindowEx failed.\n");
+    for (i = 0; i < 4999; i++)
+        CreateWindowExA(0, "static", NULL, WS_CHILD | (i % 2 ? WS_VISIBLE : 0),
+                        (i % 100) * 10, (i / 100) * 10, 10, 10, hwnd, 0, NULL, NULL);
+
+    SetEvent(ready_event);
+    WaitForSingleObject(done_event, INFINITE);
+    DestroyWindow(hwnd);
+    CloseHandle(ready_event);
+    CloseHandle(done_event);
+}
+
+static BOOL CALLBACK add_window_proc(HWND hwnd, LPARAM lparam)
+{
+    HWND *list = (HWND *)lparam;
+    UINT_PTR count = (UINT_PTR)list[0];
+
+    if (count < 5000) list[++count] = hwnd;
+    list[0] = (HWND)count;
+    return TRUE;
+}
+
+static void test_window_state_benchmark(const char *argv0)
+{
+    HANDLE ready_event, done_event;
+    PROCESS_INFORMATION info;
+    STARTUPINFOA startup;
+    char cmd[MAX_PATH];
+    HWND hwnd, *list;
+    DWORD start, elapsed, pid, ret;
+    unsigned int i, count, visible = 0, pass;
+    RECT rect;
+
+    ready_event = CreateEventA(NULL, FALSE, FALSE, "test_wsb_ready");
+    ok(!!ready_event, "CreateEvent failed.\n");
+    done_event = CreateEventA(NULL, FALSE, FALSE, "test_wsb_done");
+    ok(!!done_event, "CreateEvent failed.\n");
+
+    sprintf(cmd, "%s win window_state_benchmark", argv0);
+    memset(&startup, 0, sizeof(startup));
+    startup.cb = sizeof(startup);
+    ok(CreateProcessA(NULL, cmd, NULL, NULL, FALSE, 0, NULL, NULL,
+                      &startup, &info), "CreateProcess failed.\n");
+    ret = WaitForSingleObject(ready_event, 60000);
+    ok(ret == WAIT_OBJECT_0, "Unexpected ret %x.\n", ret);
+
+    hwnd = FindWindowA("static", "window_state_benchmark");
+    ok(!!hwnd, "window not found\n");
+    list = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, 5001 * sizeof(*list));
+    list[0] = (HWND)0;
+    add_window_proc(hwnd, (LPARAM)list);
+    EnumChildWindows(hwnd, add_window_proc, (LPARAM)list);
+    count = (UINT_PTR)list[0];
+    ok(count == 5000, "got %u windows\n", count);
+
+    start = GetTickCount();
+    for (pass = 0; pass < 10; pass++)
+    {
+        for (i = 1; i <= count; i++)
+        {
+            GetWindowLongW(list[i], GWL_STYLE);
+            GetWindowLongW(list[i], GWL_EXSTYLE);
+            GetWindowRect(list[i], &rect);
+            GetClientRect(list[i], &rect);
+            GetParent(list[i]);
+            GetWindowThreadProcessId(list[i], &pid);
+            if (IsWindowVisible(list[i])) visible++;
+        }
+    }
+    elapsed = GetTickCount() - start;
+    ok(visible == 10 * 2500, "got %u visible windows\n", visible);
+    trace("queried %u windows of another process 10 times in %u ms\n", count, elapsed);
+
+    HeapFree(GetProcessHeap(), 0, list);
+    SetEvent(done_event);
+    wait_child_process(info.hProcess);
+    CloseHandle(ready_event);
+    CloseHandle(done_event);
+    CloseHandle(info.hProcess);
+    CloseHandle(info.hThread);
+}
+
 static void test_cancel_mode(void)
 {
     HWND hwnd1, hwnd2, child;
@@ -11992,6 +12107,12 @@ START_TEST(win)
         return;
     }
 
+    if (argc == 3 && !strcmp(argv[2], "window_state_benchmark"))
+    {
+        window_state_benchmark_proc();
+        return;
+    }
+
     if (!RegisterWindowClasses()) assert(0);
 
     hwndMain = CreateWindowExA(/*WS_EX_TOOLWINDOW*/ 0, "MainWindowClass", "Main window",
@@ -12110,6 +12231,7 @@ START_TEST(win)
     test_window_placement();
     test_arrange_iconic_windows();
     test_other_process_window(argv[0]);
+    if (winetest_interactive) test_window_state_benchmark(argv[0]);
     test_SC_SIZE();
     test_cancel_mode();
 
@@ -202,6 +202,8 @@ struct user_thread_info
     HWND                          top_window;             /* Desktop window */
     HWND                          msg_window;             /* HWND_MESSAGE parent window */
     struct rawinput_thread_data  *rawinput;               /* RawInput thread local data / buffer */
+    const volatile struct queue_shared_memory *queue_shared; /* Queue state shared with the server */
+    DWORD                         last_get_msg;           /* Time of last get_message request */
 };
 
 C_ASSERT( sizeof(struct user_thread_info) <= sizeof(((TEB *)0)->Win32ClientInfo) );
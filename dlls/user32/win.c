@@ -351,6 +351,78 @@ static HWND *list_window_children( HDESK desktop, HWND hwnd, LPCWSTR class, DWOR
 }
 
 
+/***********************************************************************
+ *           get_shared_windows
+ *
+ * Map the memory where the server publishes the state of all the windows.
+ */
+static const volatile struct window_shared_memory *get_shared_windows(void)
+{
+    static const volatile struct window_shared_memory *shared_windows;
+    static BOOL failed;
+    HANDLE handle = 0;
+    SIZE_T size = 0;
+    void *ptr = NULL;
+
+    if (shared_windows || failed) return shared_windows;
+
+    SERVER_START_REQ( get_window_shared_memory )
+    {
+        if (!wine_server_call( req )) handle = wine_server_ptr_handle( reply->handle );
+    }
+    SERVER_END_REQ;
+
+    if (!handle || NtMapViewOfSection( handle, GetCurrentProcess(), &ptr, 0, 0, NULL, &size,
+                                       ViewUnmap, 0, PAGE_READONLY ))
+    {
+        WARN( "cannot map the shared window state\n" );
+        failed = TRUE;
+    }
+    else if (InterlockedCompareExchangePointer( (void **)&shared_windows, ptr, NULL ))
+        UnmapViewOfFile( ptr );  /* another thread got there first */
+    if (handle) NtClose( handle );
+    return shared_windows;
+}
+
+
+/***********************************************************************
+ *           get_shared_window
+ *
+ * Get a consistent copy of the state that the server publishes for a
+ * window, so that windows of other processes can be queried without a
+ * server round trip.
+ */
+static BOOL get_shared_window( HWND hwnd, struct window_shared_memory *info )
+{
+    const volatile struct window_shared_memory *shared;
+    UINT index = USER_HANDLE_TO_INDEX( hwnd ), seq;
+
+    if (index >= NB_USER_HANDLES || !(shared = get_shared_windows())) return FALSE;
+    shared += index;
+
+    do
+    {
+        while ((seq = shared->seq) & 1) YieldProcessor();
+        MemoryBarrier();
+        info->handle      = shared->handle;
+        info->parent      = shared->parent;
+        info->owner       = shared->owner;
+        info->tid         = shared->tid;
+        info->pid         = shared->pid;
+        info->style       = shared->style;
+        info->ex_style    = shared->ex_style;
+        info->dpi         = shared->dpi;
+        info->window_rect = shared->window_rect;
+        info->client_rect = shared->client_rect;
+        MemoryBarrier();
+    } while (shared->seq != seq);
+
+    if (!info->handle) return FALSE;
+    /* same generation check as for local handles */
+    return !HIWORD(hwnd) || HIWORD(hwnd) == 0xffff || HIWORD(hwnd) == HIWORD(info->handle);
+}
+
+
 /*******************************************************************
  *           list_window_parents
  *
@@ -369,15 +441,24 @@ static HWND *list_window_parents( HWND hwnd )
     for (;;)
     {
         if (!(win = WIN_GetPtr( current ))) goto empty;
-        if (win == WND_OTHER_PROCESS) break;  /* need to do it the hard way */
-        if (win == WND_DESKTOP)
+        if (win == WND_OTHER_PROCESS)
+        {
+            struct window_shared_memory info;
+
+            if (!get_shared_window( current, &info )) break;  /* need to do it the hard way */
+            list[pos] = current = wine_server_ptr_handle( info.parent );
+        }
+        else if (win == WND_DESKTOP)
         {
             if (!pos) goto empty;
             list[pos] = 0;
             return list;
         }
-        list[pos] = current = win->parent;
-        WIN_ReleasePtr( win );
+        else
+        {
+            list[pos] = current = win->parent;
+            WIN_ReleasePtr( win );
+        }
         if (!current) return list;
         if (++pos == size - 1)
         {
@@ -828,6 +909,70 @@ ULONG WIN_SetStyle( HWND hwnd, ULONG set_bits, ULONG clear_bits )
 }
 
 
+/***********************************************************************
+ *           get_shared_window_rects
+ *
+ * Compute the rectangles of a window of another process from the shared
+ * window state, the same way the server does for get_window_rectangles.
+ */
+static BOOL get_shared_window_rects( HWND hwnd, enum coords_relative relative,
+                                     RECT *rectWindow, RECT *rectClient )
+{
+    struct window_shared_memory info, parent;
+    RECT window_rect, client_rect, rect;
+    HWND next;
+
+    if (!get_shared_window( hwnd, &info )) return FALSE;
+    if (info.dpi != get_thread_dpi()) return FALSE;  /* let the server scale them */
+
+    SetRect( &window_rect, info.window_rect.left, info.window_rect.top,
+             info.window_rect.right, info.window_rect.bottom );
+    SetRect( &client_rect, info.client_rect.left, info.client_rect.top,
+             info.client_rect.right, info.client_rect.bottom );
+
+    switch (relative)
+    {
+    case COORDS_CLIENT:
+        rect = client_rect;
+        OffsetRect( &window_rect, -rect.left, -rect.top );
+        OffsetRect( &client_rect, -rect.left, -rect.top );
+        if (info.ex_style & WS_EX_LAYOUTRTL) mirror_rect( &rect, &window_rect );
+        break;
+    case COORDS_WINDOW:
+        rect = window_rect;
+        OffsetRect( &window_rect, -rect.left, -rect.top );
+        OffsetRect( &client_rect, -rect.left, -rect.top );
+        if (info.ex_style & WS_EX_LAYOUTRTL) mirror_rect( &rect, &client_rect );
+        break;
+    case COORDS_PARENT:
+        if (!info.parent) break;
+        if (!get_shared_window( wine_server_ptr_handle( info.parent ), &parent )) return FALSE;
+        if (parent.ex_style & WS_EX_LAYOUTRTL)
+        {
+            SetRect( &rect, parent.client_rect.left, parent.client_rect.top,
+                     parent.client_rect.right, parent.client_rect.bottom );
+            mirror_rect( &rect, &window_rect );
+            mirror_rect( &rect, &client_rect );
+        }
+        break;
+    case COORDS_SCREEN:
+        for (next = wine_server_ptr_handle( info.parent ); next; next = wine_server_ptr_handle( parent.parent ))
+        {
+            if (!get_shared_window( next, &parent )) return FALSE;
+            if (!parent.parent) break;  /* desktop window */
+            OffsetRect( &window_rect, parent.client_rect.left, parent.client_rect.top );
+            OffsetRect( &client_rect, parent.client_rect.left, parent.client_rect.top );
+        }
+        break;
+    default:
+        return FALSE;
+    }
+    if (rectWindow) *rectWindow = window_rect;
+    if (rectClient) *rectClient = client_rect;
+    return TRUE;
+}
+
+
 /***********************************************************************
  *           WIN_GetRectangles
  *
@@ -936,6 +1081,8 @@ BOOL WIN_GetRectangles( HWND hwnd, enum coords_relative relative, RECT *rectWind
     }
 
 other_process:
+    if (get_shared_window_rects( hwnd, relative, rectWindow, rectClient )) return TRUE;
+
     SERVER_START_REQ( get_window_rectangles )
     {
         req->handle = wine_server_user_handle( hwnd );
@@ -2347,11 +2494,16 @@ static LONG_PTR WIN_GetWindowLong( HWND hwnd, INT offset, UINT size, BOOL unicod
 
     if (wndPtr == WND_OTHER_PROCESS)
     {
+        struct window_shared_memory info;
+
         if (offset == GWLP_WNDPROC)
         {
             SetLastError( ERROR_ACCESS_DENIED );
             return 0;
         }
+        if ((offset == GWL_STYLE || offset == GWL_EXSTYLE) && get_shared_window( hwnd, &info ))
+            return offset == GWL_STYLE ? info.style : info.ex_style;
+
         SERVER_START_REQ( set_window_info )
         {
             req->handle = wine_server_user_handle( hwnd );
@@ -2996,6 +3148,7 @@ INT WINAPI GetWindowTextLengthW( HWND hwnd )
  */
 BOOL WINAPI IsWindow( HWND hwnd )
 {
+    struct window_shared_memory info;
     WND *ptr;
     BOOL ret;
 
@@ -3009,6 +3162,8 @@ BOOL WINAPI IsWindow( HWND hwnd )
     }
 
     /* check other processes */
+    if (get_shared_window( hwnd, &info )) return TRUE;
+
     SERVER_START_REQ( get_window_info )
     {
         req->handle = wine_server_user_handle( hwnd );
@@ -3024,6 +3179,7 @@ BOOL WINAPI IsWindow( HWND hwnd )
  */
 DWORD WINAPI GetWindowThreadProcessId( HWND hwnd, LPDWORD process )
 {
+    struct window_shared_memory info;
     WND *ptr;
     DWORD tid = 0;
 
@@ -3043,6 +3199,12 @@ DWORD WINAPI GetWindowThreadProcessId( HWND hwnd, LPDWORD process )
     }
 
     /* check other processes */
+    if (get_shared_window( hwnd, &info ))
+    {
+        if (process) *process = info.pid;
+        return info.tid;
+    }
+
     SERVER_START_REQ( get_window_info )
     {
         req->handle = wine_server_user_handle( hwnd );
@@ -3062,6 +3224,7 @@ DWORD WINAPI GetWindowThreadProcessId( HWND hwnd, LPDWORD process )
  */
 HWND WINAPI GetParent( HWND hwnd )
 {
+    struct window_shared_memory info;
     WND *wndPtr;
     HWND retvalue = 0;
 
@@ -3071,7 +3234,12 @@ HWND WINAPI GetParent( HWND hwnd )
         return 0;
     }
     if (wndPtr == WND_DESKTOP) return 0;
-    if (wndPtr == WND_OTHER_PROCESS)
+    if (wndPtr == WND_OTHER_PROCESS && get_shared_window( hwnd, &info ))
+    {
+        if (info.style & WS_POPUP) retvalue = wine_server_ptr_handle( info.owner );
+        else if (info.style & WS_CHILD) retvalue = wine_server_ptr_handle( info.parent );
+    }
+    else if (wndPtr == WND_OTHER_PROCESS)
     {
         LONG style = GetWindowLongW( hwnd, GWL_STYLE );
         if (style & (WS_POPUP | WS_CHILD))
@@ -3103,6 +3271,7 @@ HWND WINAPI GetParent( HWND hwnd )
  */
 HWND WINAPI GetAncestor( HWND hwnd, UINT type )
 {
+    struct window_shared_memory info;
     WND *win;
     HWND *list, ret = 0;
 
@@ -3120,6 +3289,10 @@ HWND WINAPI GetAncestor( HWND hwnd, UINT type )
             ret = win->parent;
             WIN_ReleasePtr( win );
         }
+        else if (get_shared_window( hwnd, &info ))
+        {
+            ret = wine_server_ptr_handle( info.parent );
+        }
         else /* need to query the server */
         {
             SERVER_START_REQ( get_window_tree )
@@ -3354,6 +3527,7 @@ HWND WINAPI GetTopWindow( HWND hwnd )
  */
 HWND WINAPI GetWindow( HWND hwnd, UINT rel )
 {
+    struct window_shared_memory info;
     HWND retval = 0;
 
     if (rel == GW_OWNER)  /* this one may be available locally */
@@ -3371,6 +3545,7 @@ HWND WINAPI GetWindow( HWND hwnd, UINT rel )
             WIN_ReleasePtr( wndPtr );
             return retval;
         }
+        if (get_shared_window( hwnd, &info )) return wine_server_ptr_handle( info.owner );
         /* else fall through to server call */
     }
 
@@ -298,6 +298,19 @@ static HRESULT push_instr_bstr_uint(compile_ctx_t *ctx, vbsop_t op, const WCHAR
     return S_OK;
 }
 
+static HRESULT push_instr_int_uint(compile_ctx_t *ctx, vbsop_t op, LONG arg1, unsigned arg2)
+{
+    unsigned instr;
+
+    instr = push_instr(ctx, op);
+    if(!instr)
+        return E_OUTOFMEMORY;
+
+    instr_ptr(ctx, instr)->arg1.lng = arg1;
+    instr_ptr(ctx, instr)->arg2.uint = arg2;
+    return S_OK;
+}
+
 static HRESULT push_instr_uint_bstr(compile_ctx_t *ctx, vbsop_t op, unsigned arg1, const WCHAR *arg2)
 {
     unsigned instr;
@@ -406,6 +419,41 @@ static expression_t *lookup_const_decls(compile_ctx_t *ctx, const WCHAR *name, B
     return NULL;
 }
 
+/*
+ * Binds a name to a local variable or argument slot. Dim declarations are hoisted
+ * to the whole procedure, so only variables declared before the current statement
+ * are bound here; any other name is still looked up at run time.
+ */
+static BOOL lookup_local_slot(compile_ctx_t *ctx, const WCHAR *name, int *ret)
+{
+    dim_decl_t *dim_decl;
+    unsigned i;
+
+    if(!ctx->func || ctx->func->type == FUNC_GLOBAL)
+        return FALSE;
+
+    /* function name refers to its return value and takes precedence over locals */
+    if((ctx->func->type == FUNC_FUNCTION || ctx->func->type == FUNC_PROPGET)
+       && !wcsicmp(name, ctx->func->name))
+        return FALSE;
+
+    for(dim_decl = ctx->dim_decls, i = 0; dim_decl; dim_decl = dim_decl->next, i++) {
+        if(!wcsicmp(dim_decl->name, name)) {
+            *ret = i;
+            return TRUE;
+        }
+    }
+
+    for(i = 0; i < ctx->func->arg_cnt; i++) {
+        if(!wcsicmp(ctx->func->args[i].name, name)) {
+            *ret = local_arg_slot(i);
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
 static HRESULT compile_args(compile_ctx_t *ctx, expression_t *args, unsigned *ret)
 {
     unsigned arg_cnt = 0;
@@ -430,6 +478,7 @@ static HRESULT compile_args(compile_ctx_t *ctx, expression_t *args, unsigned *re
 static HRESULT compile_member_expression(compile_ctx_t *ctx, member_expression_t *expr, unsigned arg_cnt, BOOL ret_val)
 {
     HRESULT hres;
+    int slot;
 
     if(ret_val && !arg_cnt) {
         expression_t *const_expr;
@@ -445,6 +494,8 @@ static HRESULT compile_member_expression(compile_ctx_t *ctx, member_expression_t
             return hres;
 
         hres = push_instr_bstr_uint(ctx, ret_val ? OP_mcall : OP_mcallv, expr->identifier, arg_cnt);
+    }else if(ret_val && lookup_local_slot(ctx, expr->identifier, &slot)) {
+        hres = push_instr_int_uint(ctx, OP_local, slot, arg_cnt);
     }else {
         hres = push_instr_bstr_uint(ctx, ret_val ? OP_icall : OP_icallv, expr->identifier, arg_cnt);
     }
@@ -489,9 +540,88 @@ static HRESULT compile_dot_expression(compile_ctx_t *ctx)
     return push_instr_uint(ctx, OP_stack, ~0);
 }
 
+/*
+ * Folds integer arithmetic on literals. Only expressions whose operands and
+ * results all fit in VT_I2 are folded, so that OP_int produces the same variant
+ * type as evaluating the expression at run time.
+ */
+static BOOL fold_int_expression(expression_t *expr, LONG *ret)
+{
+    LONG left, right;
+
+    switch(expr->type) {
+    case EXPR_INT:
+        *ret = ((int_expression_t*)expr)->value;
+        break;
+    case EXPR_BRACKETS:
+        return fold_int_expression(((unary_expression_t*)expr)->subexpr, ret);
+    case EXPR_NEG:
+        if(!fold_int_expression(((unary_expression_t*)expr)->subexpr, &left))
+            return FALSE;
+        *ret = -left;
+        break;
+    case EXPR_ADD:
+    case EXPR_SUB:
+    case EXPR_MUL:
+        if(!fold_int_expression(((binary_expression_t*)expr)->left, &left)
+           || !fold_int_expression(((binary_expression_t*)expr)->right, &right))
+            return FALSE;
+        if(expr->type == EXPR_ADD)
+            *ret = left + right;
+        else if(expr->type == EXPR_SUB)
+            *ret = left - right;
+        else
+            *ret = left * right;
+        break;
+    default:
+        return FALSE;
+    }
+
+    return *ret == (INT16)*ret;
+}
+
+/* Concatenates string literals, returns NULL if expr is not constant. */
+static WCHAR *fold_concat_expression(expression_t *expr)
+{
+    WCHAR *left, *right, *ret;
+    size_t left_len, right_len;
+
+    switch(expr->type) {
+    case EXPR_STRING:
+        return heap_strdupW(((string_expression_t*)expr)->value);
+    case EXPR_BRACKETS:
+        return fold_concat_expression(((unary_expression_t*)expr)->subexpr);
+    case EXPR_CONCAT:
+        break;
+    default:
+        return NULL;
+    }
+
+    if(!(left = fold_concat_expression(((binary_expression_t*)expr)->left)))
+        return NULL;
+    if(!(right = fold_concat_expression(((binary_expression_t*)expr)->right))) {
+        heap_free(left);
+        return NULL;
+    }
+
+    left_len = lstrlenW(left);
+    right_len = lstrlenW(right);
+    if((ret = heap_alloc((left_len + right_len + 1) * sizeof(WCHAR)))) {
+        memcpy(ret, left, left_len * sizeof(WCHAR));
+        memcpy(ret + left_len, right, (right_len + 1) * sizeof(WCHAR));
+    }
+    heap_free(left);
+    heap_free(right);
+    return ret;
+}
+
 static HRESULT compile_unary_expression(compile_ctx_t *ctx, unary_expression_t *expr, vbsop_t op)
 {
     HRESULT hres;
+    LONG value;
+
+    if(fold_int_expression(&expr->expr, &value))
+        return push_instr_int(ctx, OP_int, value);
 
     hres = compile_expression(ctx, expr->subexpr);
     if(FAILED(hres))
@@ -503,6 +633,17 @@ static HRESULT compile_unary_expression(compile_ctx_t *ctx, unary_expression_t *
 static HRESULT compile_binary_expression(compile_ctx_t *ctx, binary_expression_t *expr, vbsop_t op)
 {
     HRESULT hres;
+    WCHAR *str;
+    LONG value;
+
+    if(fold_int_expression(&expr->expr, &value))
+        return push_instr_int(ctx, OP_int, value);
+
+    if(expr->expr.type == EXPR_CONCAT && (str = fold_concat_expression(&expr->expr))) {
+        hres = push_instr_str(ctx, OP_string, str);
+        heap_free(str);
+        return hres;
+    }
 
     hres = compile_expression(ctx, expr->left);
     if(FAILED(hres))
@@ -800,22 +941,30 @@ static HRESULT compile_forto_statement(compile_ctx_t *ctx, forto_statement_t *st
 {
     statement_ctx_t loop_ctx = {2};
     unsigned step_instr, instr;
-    BSTR identifier;
+    BSTR identifier = NULL;
+    BOOL is_local;
     HRESULT hres;
+    int slot;
 
-    identifier = alloc_bstr_arg(ctx, stat->identifier);
-    if(!identifier)
-        return E_OUTOFMEMORY;
+    is_local = lookup_local_slot(ctx, stat->identifier, &slot);
+    if(!is_local) {
+        identifier = alloc_bstr_arg(ctx, stat->identifier);
+        if(!identifier)
+            return E_OUTOFMEMORY;
+    }
 
     hres = compile_expression(ctx, stat->from_expr);
     if(FAILED(hres))
         return hres;
 
     /* FIXME: Assign should happen after both expressions evaluation. */
-    instr = push_instr(ctx, OP_assign_ident);
+    instr = push_instr(ctx, is_local ? OP_assign_local : OP_assign_ident);
     if(!instr)
         return E_OUTOFMEMORY;
-    instr_ptr(ctx, instr)->arg1.bstr = identifier;
+    if(is_local)
+        instr_ptr(ctx, instr)->arg1.lng = slot;
+    else
+        instr_ptr(ctx, instr)->arg1.bstr = identifier;
     instr_ptr(ctx, instr)->arg2.uint = 0;
 
     hres = compile_expression(ctx, stat->to_expr);
@@ -842,10 +991,13 @@ static HRESULT compile_forto_statement(compile_ctx_t *ctx, forto_statement_t *st
     if(!loop_ctx.for_end_label)
         return E_OUTOFMEMORY;
 
-    step_instr = push_instr(ctx, OP_step);
+    step_instr = push_instr(ctx, is_local ? OP_step_local : OP_step);
     if(!step_instr)
         return E_OUTOFMEMORY;
-    instr_ptr(ctx, step_instr)->arg2.bstr = identifier;
+    if(is_local)
+        instr_ptr(ctx, step_instr)->arg2.lng = slot;
+    else
+        instr_ptr(ctx, step_instr)->arg2.bstr = identifier;
     instr_ptr(ctx, step_instr)->arg1.uint = loop_ctx.for_end_label;
 
     if(!emit_catch(ctx, 2))
@@ -856,10 +1008,13 @@ static HRESULT compile_forto_statement(compile_ctx_t *ctx, forto_statement_t *st
         return hres;
 
     /* FIXME: Error handling can't be done compatible with native using OP_incc here. */
-    instr = push_instr(ctx, OP_incc);
+    instr = push_instr(ctx, is_local ? OP_incc_local : OP_incc);
     if(!instr)
         return E_OUTOFMEMORY;
-    instr_ptr(ctx, instr)->arg1.bstr = identifier;
+    if(is_local)
+        instr_ptr(ctx, instr)->arg1.lng = slot;
+    else
+        instr_ptr(ctx, instr)->arg1.bstr = identifier;
 
     hres = push_instr_addr(ctx, OP_jmp, step_instr);
     if(FAILED(hres))
@@ -998,7 +1153,9 @@ static HRESULT compile_assignment(compile_ctx_t *ctx, expression_t *left, expres
     call_expression_t *call_expr = NULL;
     member_expression_t *member_expr;
     unsigned args_cnt = 0;
+    BOOL is_local = FALSE;
     vbsop_t op;
+    int slot;
     HRESULT hres;
 
     switch(left->type) {
@@ -1021,6 +1178,9 @@ static HRESULT compile_assignment(compile_ctx_t *ctx, expression_t *left, expres
             return hres;
 
         op = is_set ? OP_set_member : OP_assign_member;
+    }else if(lookup_local_slot(ctx, member_expr->identifier, &slot)) {
+        op = is_set ? OP_set_local : OP_assign_local;
+        is_local = TRUE;
     }else {
         op = is_set ? OP_set_ident : OP_assign_ident;
     }
@@ -1035,7 +1195,10 @@ static HRESULT compile_assignment(compile_ctx_t *ctx, expression_t *left, expres
             return hres;
     }
 
-    hres = push_instr_bstr_uint(ctx, op, member_expr->identifier, args_cnt);
+    if(is_local)
+        hres = push_instr_int_uint(ctx, op, slot, args_cnt);
+    else
+        hres = push_instr_bstr_uint(ctx, op, member_expr->identifier, args_cnt);
     if(FAILED(hres))
         return hres;
 
@@ -2012,6 +2175,7 @@ HRESULT compile_script(script_ctx_t *script, const WCHAR *src, const WCHAR *item
     }
 
     code->is_persistent = (flags & SCRIPTTEXT_ISPERSISTENT) != 0;
+    bind_instr_funcs(code->instrs + 1, ctx.instr_cnt - 1);
 
     if(TRACE_ON(vbscript_disas))
         dump_code(&ctx);
@@ -2906,16 +2906,12 @@ static void run_from_file(const char *filename)
     ok(hres == S_OK, "parse_script failed: %08x\n", hres);
 }
 
-static void run_from_res(const char *name)
+static BSTR load_res(const char *name)
 {
     const char *data;
     DWORD size, len;
     BSTR str;
     HRSRC src;
-    HRESULT hres;
-
-    strict_dispid_check = FALSE;
-    test_name = name;
 
     src = FindResourceA(NULL, name, (LPCSTR)40);
     ok(src != NULL, "Could not find resource %s\n", name);
@@ -2927,6 +2923,19 @@ static void run_from_res(const char *name)
     str = SysAllocStringLen(NULL, len);
     MultiByteToWideChar(CP_ACP, 0, data, size, str, len);
 
+    return str;
+}
+
+static void run_from_res(const char *name)
+{
+    BSTR str;
+    HRESULT hres;
+
+    strict_dispid_check = FALSE;
+    test_name = name;
+
+    str = load_res(name);
+
     SET_EXPECT(global_success_d);
     SET_EXPECT(global_success_i);
     hres = parse_script(SCRIPTITEM_GLOBALMEMBERS, str, NULL);
@@ -2938,6 +2947,48 @@ static void run_from_res(const char *name)
     test_name = "";
 }
 
+static void run_benchmark(const char *script_name)
+{
+    IActiveScriptParse *parser;
+    IActiveScript *engine;
+    ULONG start, end;
+    BSTR src;
+    HRESULT hres;
+
+    engine = create_and_init_script(0, TRUE);
+    if(!engine)
+        return;
+
+    hres = IActiveScript_QueryInterface(engine, &IID_IActiveScriptParse, (void**)&parser);
+    ok(hres == S_OK, "Could not get IActiveScriptParse: %08x\n", hres);
+    if(FAILED(hres)) {
+        IActiveScript_Release(engine);
+        return;
+    }
+
+    src = load_res(script_name);
+
+    start = GetTickCount();
+    hres = IActiveScriptParse_ParseScriptText(parser, src, NULL, NULL, NULL, 0, 0, 0, NULL, NULL);
+    end = GetTickCount();
+    ok(hres == S_OK, "%s: ParseScriptText failed: %08x\n", script_name, hres);
+
+    trace("%s ran in %u ms\n", script_name, end-start);
+
+    IActiveScriptParse_Release(parser);
+    close_script(engine);
+    SysFreeString(src);
+}
+
+static void run_benchmarks(void)
+{
+    trace("Running benchmarks...\n");
+
+    run_benchmark("bench_arith.vbs");
+    run_benchmark("bench_string.vbs");
+    run_benchmark("bench_class.vbs");
+}
+
 static void run_tests(void)
 {
     HRESULT hres;
@@ -3251,6 +3302,8 @@ START_TEST(run)
         run_from_file(argv[2]);
     }else {
         run_tests();
+        if(winetest_interactive)
+            run_benchmarks();
     }
 
     CoUninitialize();
@@ -18,6 +18,7 @@
  */
 
 #include <stdarg.h>
+#include <math.h>
 
 #define COBJMACROS
 
@@ -31,6 +32,19 @@
 
 WINE_DEFAULT_DEBUG_CHANNEL(wincodecs);
 
+#define FILTER_BITS 14
+#define FILTER_ONE (1 << FILTER_BITS)
+/* fractional bits kept between the vertical and the horizontal pass */
+#define FILTER_INTERMEDIATE_BITS 6
+
+/* precomputed weights of a separable filter along one axis */
+struct scaler_filter
+{
+    UINT taps;          /* number of weights for each destination pixel */
+    UINT *start;        /* first source pixel used by each destination pixel */
+    short *weights;     /* taps weights for each destination pixel, summing to FILTER_ONE */
+};
+
 typedef struct BitmapScaler {
     IWICBitmapScaler IWICBitmapScaler_iface;
     LONG ref;
@@ -40,8 +54,9 @@ typedef struct BitmapScaler {
     UINT src_width, src_height;
     WICBitmapInterpolationMode mode;
     UINT bpp;
+    struct scaler_filter *filter_x, *filter_y;
     void (*fn_get_required_source_rect)(struct BitmapScaler*,UINT,UINT,WICRect*);
-    void (*fn_copy_scanline)(struct BitmapScaler*,UINT,UINT,UINT,BYTE**,UINT,UINT,BYTE*);
+    void (*fn_copy_scanline)(struct BitmapScaler*,UINT,UINT,UINT,BYTE**,UINT,UINT,BYTE*,int*);
     CRITICAL_SECTION lock; /* must be held when initialized */
 } BitmapScaler;
 
@@ -106,6 +121,8 @@ static ULONG WINAPI BitmapScaler_Release(IWICBitmapScaler *iface)
         This->lock.DebugInfo->Spare[0] = 0;
         DeleteCriticalSection(&This->lock);
         if (This->source) IWICBitmapSource_Release(This->source);
+        HeapFree(GetProcessHeap(), 0, This->filter_x);
+        HeapFree(GetProcessHeap(), 0, This->filter_y);
         HeapFree(GetProcessHeap(), 0, This);
     }
 
@@ -188,7 +205,7 @@ static void NearestNeighbor_GetRequiredSourceRect(BitmapScaler *This,
 
 static void NearestNeighbor_CopyScanline(BitmapScaler *This,
     UINT dst_x, UINT dst_y, UINT dst_width,
-    BYTE **src_data, UINT src_data_x, UINT src_data_y, BYTE *pbBuffer)
+    BYTE **src_data, UINT src_data_x, UINT src_data_y, BYTE *pbBuffer, int *tmp)
 {
     UINT i;
     UINT bytesperpixel = This->bpp/8;
@@ -203,6 +220,293 @@ static void NearestNeighbor_CopyScanline(BitmapScaler *This,
     }
 }
 
+static double filter_linear(double x)
+{
+    x = fabs(x);
+    return x < 1.0 ? 1.0 - x : 0.0;
+}
+
+/* Keys cubic convolution with a = -0.5 */
+static double filter_cubic(double x)
+{
+    x = fabs(x);
+    if (x < 1.0) return (1.5 * x - 2.5) * x * x + 1.0;
+    if (x < 2.0) return ((-0.5 * x + 2.5) * x - 4.0) * x + 2.0;
+    return 0.0;
+}
+
+static struct scaler_filter *create_filter(WICBitmapInterpolationMode mode, UINT src_size, UINT dst_size)
+{
+    double scale = (double)src_size / dst_size, support, filter_scale, center, left, right, sum;
+    double (*kernel)(double) = NULL;
+    struct scaler_filter *filter;
+    double *values;
+    UINT window, taps, i, j, largest;
+    int first, pos, total;
+    short *weights;
+
+    switch (mode)
+    {
+    case WICBitmapInterpolationModeLinear:
+        kernel = filter_linear;
+        filter_scale = 1.0;
+        support = 1.0;
+        break;
+    case WICBitmapInterpolationModeCubic:
+        kernel = filter_cubic;
+        filter_scale = 1.0;
+        support = 2.0;
+        break;
+    case WICBitmapInterpolationModeHighQualityCubic:
+        /* widen the kernel when shrinking so that every source pixel contributes */
+        kernel = filter_cubic;
+        filter_scale = max(scale, 1.0);
+        support = 2.0 * filter_scale;
+        break;
+    default:
+        /* Fant: average the source area covered by each destination pixel */
+        filter_scale = 1.0;
+        support = scale / 2.0;
+        break;
+    }
+
+    /* number of source pixels that may contribute to a destination pixel */
+    window = kernel ? (UINT)ceil(2.0 * support) : (UINT)ceil(scale) + 1;
+    taps = min(window, src_size);
+
+    filter = HeapAlloc(GetProcessHeap(), 0, sizeof(*filter) + dst_size * sizeof(UINT) +
+                       dst_size * taps * sizeof(short));
+    values = HeapAlloc(GetProcessHeap(), 0, taps * sizeof(double));
+    if (!filter || !values)
+    {
+        HeapFree(GetProcessHeap(), 0, filter);
+        HeapFree(GetProcessHeap(), 0, values);
+        return NULL;
+    }
+    filter->taps = taps;
+    filter->start = (UINT *)(filter + 1);
+    filter->weights = (short *)(filter->start + dst_size);
+
+    for (i = 0; i < dst_size; i++)
+    {
+        left = i * scale;
+        right = left + scale;
+        center = left + scale / 2.0 - 0.5;
+        if (kernel)
+            first = (int)floor(center - support) + 1;
+        else
+            first = (int)floor(left);
+
+        filter->start[i] = min(max(first, 0), (int)(src_size - taps));
+        memset(values, 0, taps * sizeof(double));
+
+        /* samples outside of the source are replaced by the closest edge pixel */
+        for (pos = first; pos < first + (int)window; pos++)
+        {
+            double value;
+
+            if (kernel)
+                value = kernel((pos - center) / filter_scale);
+            else
+                value = max(min(right, pos + 1.0) - max(left, (double)pos), 0.0);
+            j = min(max(pos, 0), (int)src_size - 1) - filter->start[i];
+            if (j < taps) values[j] += value;
+        }
+
+        for (j = 0, sum = 0.0; j < taps; j++) sum += values[j];
+        weights = filter->weights + i * taps;
+        for (j = 0, total = 0, largest = 0; j < taps; j++)
+        {
+            weights[j] = sum ? floor(values[j] * FILTER_ONE / sum + 0.5) : (j ? 0 : FILTER_ONE);
+            total += weights[j];
+            if (weights[j] > weights[largest]) largest = j;
+        }
+        /* make sure that flat areas keep their exact value */
+        weights[largest] += FILTER_ONE - total;
+    }
+
+    HeapFree(GetProcessHeap(), 0, values);
+    return filter;
+}
+
+static BOOL is_filter_supported(const WICPixelFormatGUID *format)
+{
+    static const WICPixelFormatGUID *formats[] =
+    {
+        &GUID_WICPixelFormat8bppGray,
+        &GUID_WICPixelFormat24bppBGR,
+        &GUID_WICPixelFormat24bppRGB,
+        &GUID_WICPixelFormat32bppBGR,
+        &GUID_WICPixelFormat32bppBGRA,
+        &GUID_WICPixelFormat32bppPBGRA,
+        &GUID_WICPixelFormat32bppRGBA,
+        &GUID_WICPixelFormat32bppPRGBA,
+    };
+    UINT i;
+
+    for (i = 0; i < ARRAY_SIZE(formats); i++)
+        if (IsEqualGUID(format, formats[i])) return TRUE;
+    return FALSE;
+}
+
+static void Filter_GetRequiredSourceRect(BitmapScaler *This,
+    UINT x, UINT y, WICRect *src_rect)
+{
+    src_rect->X = This->filter_x->start[x];
+    src_rect->Y = This->filter_y->start[y];
+    src_rect->Width = This->filter_x->taps;
+    src_rect->Height = This->filter_y->taps;
+}
+
+/* The source rows are first combined into tmp, then each destination pixel
+ * is computed from tmp. Both inner loops work on contiguous data with integer
+ * weights so that the compiler can vectorize them. */
+static void Filter_CopyScanline(BitmapScaler *This,
+    UINT dst_x, UINT dst_y, UINT dst_width,
+    BYTE **src_data, UINT src_data_x, UINT src_data_y, BYTE *pbBuffer, int *tmp)
+{
+    const struct scaler_filter *fx = This->filter_x, *fy = This->filter_y;
+    const short *wy = fy->weights + dst_y * fy->taps;
+    UINT channels = This->bpp / 8, first = fx->start[dst_x];
+    UINT count = (fx->start[dst_x + dst_width - 1] + fx->taps - first) * channels;
+    UINT i, j, n, c;
+
+    memset(tmp, 0, count * sizeof(int));
+    for (j = 0; j < fy->taps; j++)
+    {
+        const BYTE *src = src_data[fy->start[dst_y] + j - src_data_y] + (first - src_data_x) * channels;
+        int w = wy[j];
+
+        if (!w) continue;
+        for (n = 0; n < count; n++)
+            tmp[n] += src[n] * w;
+    }
+    for (n = 0; n < count; n++)
+        tmp[n] = (tmp[n] + (1 << (FILTER_BITS - FILTER_INTERMEDIATE_BITS - 1))) >> (FILTER_BITS - FILTER_INTERMEDIATE_BITS);
+
+    for (i = 0; i < dst_width; i++)
+    {
+        const short *wx = fx->weights + (dst_x + i) * fx->taps;
+        const int *src = tmp + (fx->start[dst_x + i] - first) * channels;
+        int sum[4] = {0};
+
+        for (j = 0; j < fx->taps; j++, src += channels)
+            for (c = 0; c < channels; c++)
+                sum[c] += src[c] * wx[j];
+
+        for (c = 0; c < channels; c++)
+        {
+            int value = (sum[c] + (1 << (FILTER_BITS + FILTER_INTERMEDIATE_BITS - 1))) >> (FILTER_BITS + FILTER_INTERMEDIATE_BITS);
+            pbBuffer[i * channels + c] = min(max(value, 0), 255);
+        }
+    }
+}
+
+/* outputs with fewer source pixels are scaled on the calling thread only */
+#define PARALLEL_MIN_SOURCE_PIXELS (1024 * 1024)
+#define PARALLEL_MIN_BAND_ROWS 8
+
+struct scale_job
+{
+    BitmapScaler *scaler;
+    const WICRect *dst_rect;
+    const WICRect *src_rect;
+    BYTE **src_rows;
+    UINT stride;
+    BYTE *buffer;
+    UINT band_height;
+    UINT band_count;
+    LONG next;      /* next band to be picked by a thread */
+    LONG pending;   /* threads that are still running */
+    HANDLE event;   /* signaled when the last worker is done */
+    HRESULT hr;
+};
+
+static void scale_bands(struct scale_job *job)
+{
+    BitmapScaler *This = job->scaler;
+    const WICRect *dst = job->dst_rect, *src = job->src_rect;
+    int *tmp = NULL;
+    UINT y, end;
+    LONG band;
+
+    if (This->filter_x &&
+        !(tmp = HeapAlloc(GetProcessHeap(), 0, src->Width * (This->bpp / 8) * sizeof(int))))
+    {
+        job->hr = E_OUTOFMEMORY;
+        return;
+    }
+
+    while ((band = InterlockedIncrement(&job->next) - 1) < (LONG)job->band_count)
+    {
+        end = min((band + 1) * job->band_height, dst->Height);
+        for (y = band * job->band_height; y < end; y++)
+            This->fn_copy_scanline(This, dst->X, dst->Y + y, dst->Width,
+                job->src_rows, src->X, src->Y, job->buffer + job->stride * y, tmp);
+    }
+
+    HeapFree(GetProcessHeap(), 0, tmp);
+}
+
+static void CALLBACK scale_bands_callback(TP_CALLBACK_INSTANCE *instance, void *context)
+{
+    struct scale_job *job = context;
+    HANDLE event = job->event;
+
+    scale_bands(job);
+    if (!InterlockedDecrement(&job->pending)) SetEvent(event);
+}
+
+/* scale the destination rows, splitting large outputs in bands handled by the thread pool */
+static HRESULT scale_rows(BitmapScaler *This, const WICRect *dst_rect, BYTE **src_rows,
+    const WICRect *src_rect, UINT stride, BYTE *buffer)
+{
+    struct scale_job job;
+    SYSTEM_INFO info;
+    UINT i, threads = 1;
+
+    job.scaler = This;
+    job.dst_rect = dst_rect;
+    job.src_rect = src_rect;
+    job.src_rows = src_rows;
+    job.stride = stride;
+    job.buffer = buffer;
+    job.band_height = max(dst_rect->Height, 1);
+    job.next = 0;
+    job.pending = 1;
+    job.event = NULL;
+    job.hr = S_OK;
+
+    if (This->filter_x && (ULONGLONG)src_rect->Width * src_rect->Height >= PARALLEL_MIN_SOURCE_PIXELS)
+    {
+        GetSystemInfo(&info);
+        threads = info.dwNumberOfProcessors;
+        if (threads > 1)
+            job.band_height = max((dst_rect->Height + threads * 2 - 1) / (threads * 2), PARALLEL_MIN_BAND_ROWS);
+    }
+    job.band_count = (dst_rect->Height + job.band_height - 1) / job.band_height;
+    threads = min(threads, job.band_count);
+
+    if (threads > 1 && (job.event = CreateEventW(NULL, FALSE, FALSE, NULL)))
+    {
+        for (i = 1; i < threads; i++)
+        {
+            InterlockedIncrement(&job.pending);
+            if (!TrySubmitThreadpoolCallback(scale_bands_callback, &job, NULL))
+            {
+                InterlockedDecrement(&job.pending);
+                break;
+            }
+        }
+    }
+
+    scale_bands(&job);
+    if (InterlockedDecrement(&job.pending)) WaitForSingleObject(job.event, INFINITE);
+    if (job.event) CloseHandle(job.event);
+
+    return job.hr;
+}
+
 static HRESULT WINAPI BitmapScaler_CopyPixels(IWICBitmapScaler *iface,
     const WICRect *prc, UINT cbStride, UINT cbBufferSize, BYTE *pbBuffer)
 {
@@ -257,6 +561,12 @@ static HRESULT WINAPI BitmapScaler_CopyPixels(IWICBitmapScaler *iface,
         goto end;
     }
 
+    if (!dest_rect.Width || !dest_rect.Height)
+    {
+        hr = S_OK;
+        goto end;
+    }
+
     /* MSDN recommends calling CopyPixels once for each scanline from top to
      * bottom, and claims codecs optimize for this. Ideally, when called in this
      * way, we should avoid requesting a scanline from the source more than
@@ -295,13 +605,7 @@ static HRESULT WINAPI BitmapScaler_CopyPixels(IWICBitmapScaler *iface,
         buffer_size, src_bits);
 
     if (SUCCEEDED(hr))
-    {
-        for (y=0; y < dest_rect.Height; y++)
-        {
-            This->fn_copy_scanline(This, dest_rect.X, dest_rect.Y+y, dest_rect.Width,
-                src_rows, src_rect.X, src_rect.Y, pbBuffer + cbStride * y);
-        }
-    }
+        hr = scale_rows(This, &dest_rect, src_rows, &src_rect, cbStride, pbBuffer);
 
     HeapFree(GetProcessHeap(), 0, src_rows);
     HeapFree(GetProcessHeap(), 0, src_bits);
@@ -351,8 +655,36 @@ static HRESULT WINAPI BitmapScaler_Initialize(IWICBitmapScaler *iface,
     {
         switch (mode)
         {
+        case WICBitmapInterpolationModeLinear:
+        case WICBitmapInterpolationModeCubic:
+        case WICBitmapInterpolationModeFant:
+        case WICBitmapInterpolationModeHighQualityCubic:
+            if (!This->src_width || !This->src_height)
+                TRACE("empty source, using nearest neighbor\n");
+            else if (is_filter_supported(&src_pixelformat))
+            {
+                This->filter_x = create_filter(mode, This->src_width, This->width);
+                This->filter_y = create_filter(mode, This->src_height, This->height);
+                if (!This->filter_x || !This->filter_y)
+                {
+                    HeapFree(GetProcessHeap(), 0, This->filter_x);
+                    HeapFree(GetProcessHeap(), 0, This->filter_y);
+                    This->filter_x = This->filter_y = NULL;
+                    hr = E_OUTOFMEMORY;
+                    break;
+                }
+                IWICBitmapSource_AddRef(pISource);
+                This->source = pISource;
+                This->fn_get_required_source_rect = Filter_GetRequiredSourceRect;
+                This->fn_copy_scanline = Filter_CopyScanline;
+                break;
+            }
+            else
+                FIXME("mode %i is not supported for format %s\n", mode, debugstr_guid(&src_pixelformat));
+            /* fall-through */
         default:
-            FIXME("unsupported mode %i\n", mode);
+            if (mode > WICBitmapInterpolationModeHighQualityCubic)
+                FIXME("unsupported mode %i\n", mode);
             /* fall-through */
         case WICBitmapInterpolationModeNearestNeighbor:
             if ((This->bpp % 8) == 0)
@@ -527,6 +859,8 @@ HRESULT BitmapScaler_Create(IWICBitmapScaler **scaler)
     This->src_height = 0;
     This->mode = 0;
     This->bpp = 0;
+    This->filter_x = NULL;
+    This->filter_y = NULL;
     InitializeCriticalSection(&This->lock);
     This->lock.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": BitmapScaler.lock");
 
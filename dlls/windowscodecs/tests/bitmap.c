@@ -1312,6 +1312,142 @@ static void test_bitmap_scaler(void)
     IWICBitmap_Release(bitmap);
 }
 
+static void test_bitmap_scaler_modes(void)
+{
+    static const WICBitmapInterpolationMode modes[] =
+    {
+        WICBitmapInterpolationModeLinear,
+        WICBitmapInterpolationModeCubic,
+        WICBitmapInterpolationModeFant,
+        WICBitmapInterpolationModeHighQualityCubic,
+    };
+    static const struct
+    {
+        UINT width, height;
+    }
+    sizes[] = {{3, 2}, {5, 3}, {12, 8}};
+    static const BYTE checker[] =
+    {
+        0x00, 0xff, 0x00, 0xff,
+        0xff, 0x00, 0xff, 0x00,
+        0x00, 0xff, 0x00, 0xff,
+        0xff, 0x00, 0xff, 0x00,
+    };
+    WICPixelFormatGUID pixel_format;
+    IWICBitmapScaler *scaler;
+    IWICBitmap *bitmap, *gray;
+    BYTE src[6 * 4 * 3], buf[12 * 8 * 3];
+    unsigned int i, j, k;
+    HRESULT hr;
+
+    for (i = 0; i < sizeof(src); i += 3)
+    {
+        src[i] = 0x10;
+        src[i + 1] = 0x80;
+        src[i + 2] = 0xf0;
+    }
+    hr = IWICImagingFactory_CreateBitmapFromMemory(factory, 6, 4, &GUID_WICPixelFormat24bppBGR,
+        6 * 3, sizeof(src), src, &bitmap);
+    ok(hr == S_OK, "Failed to create a bitmap, hr %#x.\n", hr);
+
+    hr = IWICImagingFactory_CreateBitmapFromMemory(factory, 4, 4, &GUID_WICPixelFormat8bppGray,
+        4, sizeof(checker), (BYTE *)checker, &gray);
+    ok(hr == S_OK, "Failed to create a bitmap, hr %#x.\n", hr);
+
+    for (i = 0; i < ARRAY_SIZE(modes); i++)
+    {
+        for (j = 0; j < ARRAY_SIZE(sizes); j++)
+        {
+            hr = IWICImagingFactory_CreateBitmapScaler(factory, &scaler);
+            ok(hr == S_OK, "Failed to create bitmap scaler, hr %#x.\n", hr);
+
+            hr = IWICBitmapScaler_Initialize(scaler, (IWICBitmapSource *)bitmap,
+                sizes[j].width, sizes[j].height, modes[i]);
+            ok(hr == S_OK, "mode %u: Failed to initialize bitmap scaler, hr %#x.\n", modes[i], hr);
+
+            hr = IWICBitmapScaler_GetPixelFormat(scaler, &pixel_format);
+            ok(hr == S_OK, "Failed to get pixel format, hr %#x.\n", hr);
+            ok(IsEqualGUID(&pixel_format, &GUID_WICPixelFormat24bppBGR), "mode %u: Unexpected pixel format %s.\n",
+                modes[i], wine_dbgstr_guid(&pixel_format));
+
+            /* a flat image stays flat whatever the filter */
+            memset(buf, 0xcc, sizeof(buf));
+            hr = IWICBitmapScaler_CopyPixels(scaler, NULL, sizes[j].width * 3, sizeof(buf), buf);
+            ok(hr == S_OK, "mode %u: Failed to copy pixels, hr %#x.\n", modes[i], hr);
+            for (k = 0; k < sizes[j].width * sizes[j].height * 3; k += 3)
+            {
+                ok(abs(buf[k] - 0x10) <= 1 && abs(buf[k + 1] - 0x80) <= 1 && abs(buf[k + 2] - 0xf0) <= 1,
+                    "mode %u, %ux%u: got %02x%02x%02x at %u.\n", modes[i], sizes[j].width, sizes[j].height,
+                    buf[k + 2], buf[k + 1], buf[k], k / 3);
+            }
+
+            IWICBitmapScaler_Release(scaler);
+        }
+    }
+
+    /* Fant averages the covered area when shrinking */
+    hr = IWICImagingFactory_CreateBitmapScaler(factory, &scaler);
+    ok(hr == S_OK, "Failed to create bitmap scaler, hr %#x.\n", hr);
+    hr = IWICBitmapScaler_Initialize(scaler, (IWICBitmapSource *)gray, 2, 2, WICBitmapInterpolationModeFant);
+    ok(hr == S_OK, "Failed to initialize bitmap scaler, hr %#x.\n", hr);
+    hr = IWICBitmapScaler_CopyPixels(scaler, NULL, 2, 4, buf);
+    ok(hr == S_OK, "Failed to copy pixels, hr %#x.\n", hr);
+    for (k = 0; k < 4; k++)
+        ok(buf[k] == 0x7f || buf[k] == 0x80, "Unexpected value %#x at %u.\n", buf[k], k);
+    IWICBitmapScaler_Release(scaler);
+
+    IWICBitmap_Release(gray);
+    IWICBitmap_Release(bitmap);
+}
+
+static void test_bitmap_scaler_benchmark(void)
+{
+    static const WICBitmapInterpolationMode modes[] =
+    {
+        WICBitmapInterpolationModeNearestNeighbor,
+        WICBitmapInterpolationModeLinear,
+        WICBitmapInterpolationModeCubic,
+        WICBitmapInterpolationModeFant,
+        WICBitmapInterpolationModeHighQualityCubic,
+    };
+    static const UINT width = 6000, height = 4000, thumb_width = 256, thumb_height = 171;
+    IWICBitmapScaler *scaler;
+    IWICBitmap *bitmap;
+    BYTE *src, *buf;
+    unsigned int i;
+    DWORD start;
+    HRESULT hr;
+
+    src = HeapAlloc(GetProcessHeap(), 0, width * height * 4);
+    buf = HeapAlloc(GetProcessHeap(), 0, thumb_width * thumb_height * 4);
+    for (i = 0; i < width * height * 4; i++)
+        src[i] = (i * 7 + i / (width * 4) * 13) & 0xff;
+
+    hr = IWICImagingFactory_CreateBitmapFromMemory(factory, width, height, &GUID_WICPixelFormat32bppPBGRA,
+        width * 4, width * height * 4, src, &bitmap);
+    ok(hr == S_OK, "Failed to create a bitmap, hr %#x.\n", hr);
+
+    for (i = 0; i < ARRAY_SIZE(modes); i++)
+    {
+        hr = IWICImagingFactory_CreateBitmapScaler(factory, &scaler);
+        ok(hr == S_OK, "Failed to create bitmap scaler, hr %#x.\n", hr);
+
+        start = GetTickCount();
+        hr = IWICBitmapScaler_Initialize(scaler, (IWICBitmapSource *)bitmap, thumb_width, thumb_height, modes[i]);
+        ok(hr == S_OK, "Failed to initialize bitmap scaler, hr %#x.\n", hr);
+        hr = IWICBitmapScaler_CopyPixels(scaler, NULL, thumb_width * 4, thumb_width * thumb_height * 4, buf);
+        ok(hr == S_OK, "Failed to copy pixels, hr %#x.\n", hr);
+        trace("mode %u: scaled %ux%u to %ux%u in %u ms\n", modes[i], width, height,
+            thumb_width, thumb_height, GetTickCount() - start);
+
+        IWICBitmapScaler_Release(scaler);
+    }
+
+    IWICBitmap_Release(bitmap);
+    HeapFree(GetProcessHeap(), 0, buf);
+    HeapFree(GetProcessHeap(), 0, src);
+}
+
 static LONG obj_refcount(void *obj)
 {
     IUnknown_AddRef((IUnknown *)obj);
@@ -1482,6 +1618,9 @@ START_TEST(bitmap)
     test_CreateBitmapFromHBITMAP();
     test_clipper();
     test_bitmap_scaler();
+    test_bitmap_scaler_modes();
+    if (winetest_interactive)
+        test_bitmap_scaler_benchmark();
 
     IWICImagingFactory_Release(factory);
 
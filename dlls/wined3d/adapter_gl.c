@@ -102,6 +102,7 @@ static const struct wined3d_extension_map gl_extension_map[] =
     {"GL_ARB_multisample",                  ARB_MULTISAMPLE               },
     {"GL_ARB_multitexture",                 ARB_MULTITEXTURE              },
     {"GL_ARB_occlusion_query",              ARB_OCCLUSION_QUERY           },
+    {"GL_ARB_parallel_shader_compile",      ARB_PARALLEL_SHADER_COMPILE   },
     {"GL_ARB_pipeline_statistics_query",    ARB_PIPELINE_STATISTICS_QUERY },
     {"GL_ARB_pixel_buffer_object",          ARB_PIXEL_BUFFER_OBJECT       },
     {"GL_ARB_point_parameters",             ARB_POINT_PARAMETERS          },
@@ -214,6 +215,9 @@ static const struct wined3d_extension_map gl_extension_map[] =
     {"GL_EXT_texture_swizzle",              ARB_TEXTURE_SWIZZLE           },
     {"GL_EXT_vertex_array_bgra",            ARB_VERTEX_ARRAY_BGRA         },
 
+    /* KHR */
+    {"GL_KHR_parallel_shader_compile",      ARB_PARALLEL_SHADER_COMPILE   },
+
     /* NV */
     {"GL_NV_fence",                         NV_FENCE                      },
     {"GL_NV_fog_distance",                  NV_FOG_DISTANCE               },
@@ -2219,6 +2223,8 @@ static void load_gl_funcs(struct wined3d_gl_info *gl_info)
     USE_GL_FUNC(glGetQueryObjectivARB)
     USE_GL_FUNC(glGetQueryObjectuivARB)
     USE_GL_FUNC(glIsQueryARB)
+    /* GL_ARB_parallel_shader_compile */
+    USE_GL_FUNC(glMaxShaderCompilerThreadsARB)
     /* GL_ARB_point_parameters */
     USE_GL_FUNC(glPointParameterfARB)
     USE_GL_FUNC(glPointParameterfvARB)
@@ -2550,6 +2556,8 @@ static void load_gl_funcs(struct wined3d_gl_info *gl_info)
     USE_GL_FUNC(glTexImage3DEXT)
     USE_GL_FUNC(glTexSubImage3D)
     USE_GL_FUNC(glTexSubImage3DEXT)
+    /* GL_KHR_parallel_shader_compile */
+    USE_GL_FUNC(glMaxShaderCompilerThreadsKHR)
     /* GL_NV_fence */
     USE_GL_FUNC(glDeleteFencesNV)
     USE_GL_FUNC(glFinishFenceNV)
@@ -2837,6 +2845,7 @@ static void load_gl_funcs(struct wined3d_gl_info *gl_info)
     MAP_GL_FUNCTION(glIsEnabledi, glIsEnabledIndexedEXT);
     MAP_GL_FUNCTION(glLinkProgram, glLinkProgramARB);
     MAP_GL_FUNCTION(glMapBuffer, glMapBufferARB);
+    MAP_GL_FUNCTION(glMaxShaderCompilerThreadsKHR, glMaxShaderCompilerThreadsARB);
     MAP_GL_FUNCTION(glMinSampleShading, glMinSampleShadingARB);
     MAP_GL_FUNCTION(glPolygonOffsetClamp, glPolygonOffsetClampEXT);
     MAP_GL_FUNCTION_CAST(glShaderSource, glShaderSourceARB);
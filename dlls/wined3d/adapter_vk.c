@@ -484,6 +484,9 @@ static HRESULT adapter_vk_create_device(struct wined3d *wined3d, const struct wi
     VK_CALL(vkGetDeviceQueue(vk_device, queue_family_index, 0, &device_vk->vk_queue));
     device_vk->vk_queue_family_index = queue_family_index;
     device_vk->timestamp_bits = timestamp_bits;
+    device_vk->enabled_features = features2->features;
+    device_vk->transform_feedback = xfb_features->transformFeedback;
+    device_vk->geometry_streams = xfb_features->geometryStreams;
 
     device_vk->vk_info = *vk_info;
 #define VK_DEVICE_PFN(name) \
@@ -1626,7 +1629,8 @@ static void adapter_vk_draw_primitive(struct wined3d_device *device,
     if (!(vk_command_buffer = wined3d_context_vk_apply_draw_state(context_vk,
             state, indirect_vk, parameters->indexed)))
     {
-        ERR("Failed to apply draw state.\n");
+        if (!context_vk->shaders_pending)
+            ERR("Failed to apply draw state.\n");
         context_release(&context_vk->c);
         return;
     }
@@ -29,10 +29,6 @@
 
 WINE_DEFAULT_DEBUG_CHANNEL(d3d);
 
-#define WINED3D_BUFFER_HASDESC      0x01    /* A vertex description has been found. */
-#define WINED3D_BUFFER_USE_BO       0x02    /* Use a buffer object for this buffer. */
-#define WINED3D_BUFFER_PIN_SYSMEM   0x04    /* Keep a system memory copy for this buffer. */
-
 #define VB_MAXDECLCHANGES     100     /* After that number of decl changes we stop converting */
 #define VB_RESETDECLCHANGE    1000    /* Reset the decl changecount after that number of draws */
 #define VB_MAXFULLCONVERSIONS 5       /* Number of full conversions before we stop converting */
@@ -682,6 +678,15 @@ static void wined3d_buffer_destroy_object(void *object)
 
 void wined3d_buffer_cleanup(struct wined3d_buffer *buffer)
 {
+    unsigned int i;
+
+    if (buffer->upload_memory)
+        wined3d_upload_memory_decref(buffer->upload_memory);
+    for (i = 0; i < ARRAY_SIZE(buffer->upload_pool); ++i)
+    {
+        if (buffer->upload_pool[i])
+            wined3d_upload_memory_decref(buffer->upload_pool[i]);
+    }
     wined3d_cs_destroy_object(buffer->resource.device->cs, wined3d_buffer_destroy_object, buffer);
     resource_cleanup(&buffer->resource);
 }
@@ -694,8 +699,10 @@ ULONG CDECL wined3d_buffer_decref(struct wined3d_buffer *buffer)
 
     if (!refcount)
     {
+        wined3d_mutex_lock();
         buffer->resource.parent_ops->wined3d_object_destroyed(buffer->resource.parent);
         buffer->resource.device->adapter->adapter_ops->adapter_destroy_buffer(buffer);
+        wined3d_mutex_unlock();
     }
 
     return refcount;
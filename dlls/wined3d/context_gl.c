@@ -2281,6 +2281,8 @@ HRESULT wined3d_context_gl_init(struct wined3d_context_gl *context_gl, struct wi
     }
     if (gl_info->supported[ARB_CLIP_CONTROL])
         GL_EXTCALL(glPointParameteri(GL_POINT_SPRITE_COORD_ORIGIN, GL_LOWER_LEFT));
+    if (wined3d_settings.async_shader_compile && gl_info->supported[ARB_PARALLEL_SHADER_COMPILE])
+        GL_EXTCALL(glMaxShaderCompilerThreadsKHR(~0u));
 
     /* If this happens to be the first context for the device, dummy textures
      * are not created yet. In that case, they will be created (and bound) by
@@ -3963,6 +3965,11 @@ static BOOL context_apply_draw_state(struct wined3d_context *context,
     if (context->shader_update_mask & ~(1u << WINED3D_SHADER_TYPE_COMPUTE))
     {
         device->shader_backend->shader_select(device->shader_priv, context, state);
+        if (context_gl->shaders_pending)
+        {
+            TRACE("Shaders are still being linked, skipping draw.\n");
+            return FALSE;
+        }
         context->shader_update_mask &= 1u << WINED3D_SHADER_TYPE_COMPUTE;
     }
 
@@ -3042,6 +3042,11 @@ VkCommandBuffer wined3d_context_vk_apply_draw_state(struct wined3d_context_vk *c
     if (context_vk->c.shader_update_mask & ~(1u << WINED3D_SHADER_TYPE_COMPUTE))
     {
         device_vk->d.shader_backend->shader_select(device_vk->d.shader_priv, &context_vk->c, state);
+        if (context_vk->shaders_pending)
+        {
+            TRACE("Shaders are still being compiled, skipping draw.\n");
+            return VK_NULL_HANDLE;
+        }
         if (!context_vk->graphics.vk_pipeline_layout)
         {
             ERR("No pipeline layout set.\n");
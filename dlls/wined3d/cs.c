@@ -21,6 +21,7 @@
 #include "wined3d_private.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(d3d);
+WINE_DECLARE_DEBUG_CHANNEL(d3d_perf);
 WINE_DECLARE_DEBUG_CHANNEL(d3d_sync);
 WINE_DECLARE_DEBUG_CHANNEL(fps);
 
@@ -77,6 +78,8 @@ enum wined3d_cs_op
     WINED3D_CS_OP_CLEAR_UNORDERED_ACCESS_VIEW,
     WINED3D_CS_OP_COPY_UAV_COUNTER,
     WINED3D_CS_OP_GENERATE_MIPMAPS,
+    WINED3D_CS_OP_UPLOAD_BUFFER,
+    WINED3D_CS_OP_EXECUTE_COMMAND_LIST,
     WINED3D_CS_OP_STOP,
 };
 
@@ -86,6 +89,29 @@ struct wined3d_cs_packet
     BYTE data[1];
 };
 
+struct wined3d_command_list
+{
+    LONG refcount;
+
+    struct wined3d_device *device;
+
+    SIZE_T data_size;
+    void *data;
+
+    SIZE_T resource_count;
+    struct wined3d_resource **resources;
+
+    SIZE_T upload_count;
+    void **uploads;
+
+    /* List of command lists queued for execution on this command list. We
+     * might be the only thing holding a pointer to another command list, so
+     * we need to hold a reference here (and in wined3d_deferred_context) as
+     * well. */
+    SIZE_T command_list_count;
+    struct wined3d_command_list **command_lists;
+};
+
 struct wined3d_cs_nop
 {
     enum wined3d_cs_op opcode;
@@ -359,6 +385,7 @@ struct wined3d_cs_push_constants
 struct wined3d_cs_reset_state
 {
     enum wined3d_cs_op opcode;
+    bool invalidate;
 };
 
 struct wined3d_cs_callback
@@ -457,6 +484,20 @@ struct wined3d_cs_generate_mipmaps
     struct wined3d_shader_resource_view *view;
 };
 
+struct wined3d_cs_upload_buffer
+{
+    enum wined3d_cs_op opcode;
+    struct wined3d_buffer *buffer;
+    struct wined3d_upload_memory *memory;
+    unsigned int offset, size;
+};
+
+struct wined3d_cs_execute_command_list
+{
+    enum wined3d_cs_op opcode;
+    struct wined3d_command_list *list;
+};
+
 struct wined3d_cs_stop
 {
     enum wined3d_cs_op opcode;
@@ -480,6 +521,12 @@ static inline void wined3d_device_context_finish(struct wined3d_device_context *
     context->ops->finish(context, queue_id);
 }
 
+static inline void wined3d_device_context_acquire_resource(struct wined3d_device_context *context,
+        struct wined3d_resource *resource)
+{
+    context->ops->acquire_resource(context, resource);
+}
+
 static const char *debug_cs_op(enum wined3d_cs_op op)
 {
     switch (op)
@@ -534,6 +581,8 @@ static const char *debug_cs_op(enum wined3d_cs_op op)
         WINED3D_TO_STR(WINED3D_CS_OP_CLEAR_UNORDERED_ACCESS_VIEW);
         WINED3D_TO_STR(WINED3D_CS_OP_COPY_UAV_COUNTER);
         WINED3D_TO_STR(WINED3D_CS_OP_GENERATE_MIPMAPS);
+        WINED3D_TO_STR(WINED3D_CS_OP_UPLOAD_BUFFER);
+        WINED3D_TO_STR(WINED3D_CS_OP_EXECUTE_COMMAND_LIST);
         WINED3D_TO_STR(WINED3D_CS_OP_STOP);
 #undef WINED3D_TO_STR
     }
@@ -544,6 +593,23 @@ static void wined3d_cs_exec_nop(struct wined3d_cs *cs, const void *data)
 {
 }
 
+static void wined3d_cs_report_stats(struct wined3d_cs *cs)
+{
+    struct wined3d_cs_stats *stats = &cs->stats;
+    LARGE_INTEGER frequency;
+
+    QueryPerformanceFrequency(&frequency);
+
+    TRACE_(d3d_perf)("%p: %s bytes queued, %u stalls (%.3f ms), %u waits (%.3f ms), "
+            "%u chunk allocations, %u upload maps.\n", cs, wine_dbgstr_longlong(stats->bytes_queued),
+            stats->stall_count, stats->stall_time * 1000.0 / frequency.QuadPart,
+            stats->finish_count, stats->finish_time * 1000.0 / frequency.QuadPart,
+            stats->chunk_allocations, stats->upload_maps);
+
+    memset(stats, 0, FIELD_OFFSET(struct wined3d_cs_stats, report_time));
+    stats->report_time = GetTickCount();
+}
+
 static void wined3d_cs_exec_present(struct wined3d_cs *cs, const void *data)
 {
     struct wined3d_texture *logo_texture, *cursor_texture, *back_buffer;
@@ -665,6 +731,10 @@ void wined3d_cs_emit_present(struct wined3d_cs *cs, struct wined3d_swapchain *sw
         YieldProcessor();
         pending = InterlockedCompareExchange(&cs->pending_presents, 0, 0);
     }
+
+    /* every 1.5 seconds */
+    if (cs->thread && TRACE_ON(d3d_perf) && GetTickCount() - cs->stats.report_time > 1500)
+        wined3d_cs_report_stats(cs);
 }
 
 static void wined3d_cs_exec_clear(struct wined3d_cs *cs, const void *data)
@@ -760,15 +830,16 @@ void wined3d_device_context_emit_clear_rendertarget_view(struct wined3d_device_c
     op->rect_count = 1;
     op->rects[0] = *rect;
 
-    wined3d_resource_acquire(view->resource);
+    wined3d_device_context_acquire_resource(context, view->resource);
 
     wined3d_device_context_submit(context, WINED3D_CS_QUEUE_DEFAULT);
     if (flags & WINED3DCLEAR_SYNCHRONOUS)
         wined3d_device_context_finish(context, WINED3D_CS_QUEUE_DEFAULT);
 }
 
-static void acquire_shader_resources(const struct wined3d_state *state, unsigned int shader_mask)
+static void acquire_shader_resources(struct wined3d_device_context *context, unsigned int shader_mask)
 {
+    const struct wined3d_state *state = context->state;
     struct wined3d_shader_sampler_map_entry *entry;
     struct wined3d_shader_resource_view *view;
     struct wined3d_shader *shader;
@@ -785,7 +856,7 @@ static void acquire_shader_resources(const struct wined3d_state *state, unsigned
         for (j = 0; j < WINED3D_MAX_CBS; ++j)
         {
             if (state->cb[i][j])
-                wined3d_resource_acquire(&state->cb[i][j]->resource);
+                wined3d_device_context_acquire_resource(context, &state->cb[i][j]->resource);
         }
 
         for (j = 0; j < shader->reg_maps.sampler_map.count; ++j)
@@ -795,7 +866,7 @@ static void acquire_shader_resources(const struct wined3d_state *state, unsigned
             if (!(view = state->shader_resource_view[i][entry->resource_idx]))
                 continue;
 
-            wined3d_resource_acquire(view->resource);
+            wined3d_device_context_acquire_resource(context, view->resource);
         }
     }
 }
@@ -833,8 +904,8 @@ static void release_shader_resources(const struct wined3d_state *state, unsigned
     }
 }
 
-static void acquire_unordered_access_resources(const struct wined3d_shader *shader,
-        struct wined3d_unordered_access_view * const *views)
+static void acquire_unordered_access_resources(struct wined3d_device_context *context,
+        const struct wined3d_shader *shader, struct wined3d_unordered_access_view * const *views)
 {
     unsigned int i;
 
@@ -849,7 +920,7 @@ static void acquire_unordered_access_resources(const struct wined3d_shader *shad
         if (!views[i])
             continue;
 
-        wined3d_resource_acquire(views[i]->resource);
+        wined3d_device_context_acquire_resource(context, views[i]->resource);
     }
 }
 
@@ -891,10 +962,12 @@ static void wined3d_cs_exec_dispatch(struct wined3d_cs *cs, const void *data)
             state->unordered_access_view[WINED3D_PIPELINE_COMPUTE]);
 }
 
-static void acquire_compute_pipeline_resources(const struct wined3d_state *state)
+static void acquire_compute_pipeline_resources(struct wined3d_device_context *context)
 {
-    acquire_shader_resources(state, 1u << WINED3D_SHADER_TYPE_COMPUTE);
-    acquire_unordered_access_resources(state->shader[WINED3D_SHADER_TYPE_COMPUTE],
+    const struct wined3d_state *state = context->state;
+
+    acquire_shader_resources(context, 1u << WINED3D_SHADER_TYPE_COMPUTE);
+    acquire_unordered_access_resources(context, state->shader[WINED3D_SHADER_TYPE_COMPUTE],
             state->unordered_access_view[WINED3D_PIPELINE_COMPUTE]);
 }
 
@@ -910,7 +983,7 @@ void CDECL wined3d_device_context_dispatch(struct wined3d_device_context *contex
     op->parameters.u.direct.group_count_y = group_count_y;
     op->parameters.u.direct.group_count_z = group_count_z;
 
-    acquire_compute_pipeline_resources(context->state);
+    acquire_compute_pipeline_resources(context);
 
     wined3d_device_context_submit(context, WINED3D_CS_QUEUE_DEFAULT);
 }
@@ -926,8 +999,8 @@ void CDECL wined3d_device_context_dispatch_indirect(struct wined3d_device_contex
     op->parameters.u.indirect.buffer = buffer;
     op->parameters.u.indirect.offset = offset;
 
-    acquire_compute_pipeline_resources(context->state);
-    wined3d_resource_acquire(&buffer->resource);
+    acquire_compute_pipeline_resources(context);
+    wined3d_device_context_acquire_resource(context, &buffer->resource);
 
     wined3d_device_context_submit(context, WINED3D_CS_QUEUE_DEFAULT);
 }
@@ -1019,37 +1092,38 @@ static void wined3d_cs_exec_draw(struct wined3d_cs *cs, const void *data)
             state->unordered_access_view[WINED3D_PIPELINE_GRAPHICS]);
 }
 
-static void acquire_graphics_pipeline_resources(const struct wined3d_state *state,
+static void acquire_graphics_pipeline_resources(struct wined3d_device_context *context,
         BOOL indexed, const struct wined3d_d3d_info *d3d_info)
 {
+    const struct wined3d_state *state = context->state;
     unsigned int i;
 
     if (indexed)
-        wined3d_resource_acquire(&state->index_buffer->resource);
+        wined3d_device_context_acquire_resource(context, &state->index_buffer->resource);
     for (i = 0; i < ARRAY_SIZE(state->streams); ++i)
     {
         if (state->streams[i].buffer)
-            wined3d_resource_acquire(&state->streams[i].buffer->resource);
+            wined3d_device_context_acquire_resource(context, &state->streams[i].buffer->resource);
     }
     for (i = 0; i < ARRAY_SIZE(state->stream_output); ++i)
     {
         if (state->stream_output[i].buffer)
-            wined3d_resource_acquire(&state->stream_output[i].buffer->resource);
+            wined3d_device_context_acquire_resource(context, &state->stream_output[i].buffer->resource);
     }
     for (i = 0; i < ARRAY_SIZE(state->textures); ++i)
     {
         if (state->textures[i])
-            wined3d_resource_acquire(&state->textures[i]->resource);
+            wined3d_device_context_acquire_resource(context, &state->textures[i]->resource);
     }
     for (i = 0; i < d3d_info->limits.max_rt_count; ++i)
     {
         if (state->fb.render_targets[i])
-            wined3d_resource_acquire(state->fb.render_targets[i]->resource);
+            wined3d_device_context_acquire_resource(context, state->fb.render_targets[i]->resource);
     }
     if (state->fb.depth_stencil)
-        wined3d_resource_acquire(state->fb.depth_stencil->resource);
-    acquire_shader_resources(state, ~(1u << WINED3D_SHADER_TYPE_COMPUTE));
-    acquire_unordered_access_resources(state->shader[WINED3D_SHADER_TYPE_PIXEL],
+        wined3d_device_context_acquire_resource(context, state->fb.depth_stencil->resource);
+    acquire_shader_resources(context, ~(1u << WINED3D_SHADER_TYPE_COMPUTE));
+    acquire_unordered_access_resources(context, state->shader[WINED3D_SHADER_TYPE_PIXEL],
             state->unordered_access_view[WINED3D_PIPELINE_GRAPHICS]);
 }
 
@@ -1059,7 +1133,6 @@ void wined3d_device_context_emit_draw(struct wined3d_device_context *context,
         bool indexed)
 {
     const struct wined3d_d3d_info *d3d_info = &context->device->adapter->d3d_info;
-    const struct wined3d_state *state = context->state;
     struct wined3d_cs_draw *op;
 
     op = wined3d_device_context_require_space(context, sizeof(*op), WINED3D_CS_QUEUE_DEFAULT);
@@ -1074,7 +1147,7 @@ void wined3d_device_context_emit_draw(struct wined3d_device_context *context,
     op->parameters.u.direct.instance_count = instance_count;
     op->parameters.indexed = indexed;
 
-    acquire_graphics_pipeline_resources(state, indexed, d3d_info);
+    acquire_graphics_pipeline_resources(context, indexed, d3d_info);
 
     wined3d_device_context_submit(context, WINED3D_CS_QUEUE_DEFAULT);
 }
@@ -1095,8 +1168,8 @@ void CDECL wined3d_device_context_draw_indirect(struct wined3d_device_context *c
     op->parameters.u.indirect.offset = offset;
     op->parameters.indexed = indexed;
 
-    acquire_graphics_pipeline_resources(state, indexed, d3d_info);
-    wined3d_resource_acquire(&buffer->resource);
+    acquire_graphics_pipeline_resources(context, indexed, d3d_info);
+    wined3d_device_context_acquire_resource(context, &buffer->resource);
 
     wined3d_device_context_submit(context, WINED3D_CS_QUEUE_DEFAULT);
 }
@@ -1751,16 +1824,17 @@ static void wined3d_cs_exec_set_render_state(struct wined3d_cs *cs, const void *
     device_invalidate_state(cs->c.device, STATE_RENDER(op->state));
 }
 
-void wined3d_cs_emit_set_render_state(struct wined3d_cs *cs, enum wined3d_render_state state, DWORD value)
+void wined3d_device_context_emit_set_render_state(struct wined3d_device_context *context,
+        enum wined3d_render_state state, DWORD value)
 {
     struct wined3d_cs_set_render_state *op;
 
-    op = wined3d_device_context_require_space(&cs->c, sizeof(*op), WINED3D_CS_QUEUE_DEFAULT);
+    op = wined3d_device_context_require_space(context, sizeof(*op), WINED3D_CS_QUEUE_DEFAULT);
     op->opcode = WINED3D_CS_OP_SET_RENDER_STATE;
     op->state = state;
     op->value = value;
 
-    wined3d_device_context_submit(&cs->c, WINED3D_CS_QUEUE_DEFAULT);
+    wined3d_device_context_submit(context, WINED3D_CS_QUEUE_DEFAULT);
 }
 
 static void wined3d_cs_exec_set_texture_state(struct wined3d_cs *cs, const void *data)
@@ -2107,15 +2181,14 @@ static void wined3d_cs_exec_push_constants(struct wined3d_cs *cs, const void *da
     wined3d_cs_st_push_constants(&cs->c, op->type, op->start_idx, op->count, op->constants);
 }
 
-static void wined3d_cs_mt_push_constants(struct wined3d_device_context *context, enum wined3d_push_constants p,
-        unsigned int start_idx, unsigned int count, const void *constants)
+static void wined3d_device_context_emit_push_constants(struct wined3d_device_context *context,
+        enum wined3d_push_constants p, unsigned int start_idx, unsigned int count, const void *constants)
 {
-    struct wined3d_cs *cs = wined3d_cs_from_context(context);
     struct wined3d_cs_push_constants *op;
     size_t size;
 
     size = count * wined3d_cs_push_constant_info[p].size;
-    op = wined3d_device_context_require_space(&cs->c, FIELD_OFFSET(struct wined3d_cs_push_constants, constants[size]),
+    op = wined3d_device_context_require_space(context, FIELD_OFFSET(struct wined3d_cs_push_constants, constants[size]),
             WINED3D_CS_QUEUE_DEFAULT);
     op->opcode = WINED3D_CS_OP_PUSH_CONSTANTS;
     op->type = p;
@@ -2123,23 +2196,32 @@ static void wined3d_cs_mt_push_constants(struct wined3d_device_context *context,
     op->count = count;
     memcpy(op->constants, constants, size);
 
-    wined3d_device_context_submit(&cs->c, WINED3D_CS_QUEUE_DEFAULT);
+    wined3d_device_context_submit(context, WINED3D_CS_QUEUE_DEFAULT);
 }
 
 static void wined3d_cs_exec_reset_state(struct wined3d_cs *cs, const void *data)
 {
+    const struct wined3d_cs_reset_state *op = data;
+    unsigned int state;
+
     state_cleanup(&cs->state);
     wined3d_state_reset(&cs->state, &cs->c.device->adapter->d3d_info);
+    if (op->invalidate)
+    {
+        for (state = 0; state <= STATE_HIGHEST; ++state)
+            device_invalidate_state(cs->c.device, state);
+    }
 }
 
-void wined3d_cs_emit_reset_state(struct wined3d_cs *cs)
+void wined3d_device_context_emit_reset_state(struct wined3d_device_context *context, bool invalidate)
 {
     struct wined3d_cs_reset_state *op;
 
-    op = wined3d_device_context_require_space(&cs->c, sizeof(*op), WINED3D_CS_QUEUE_DEFAULT);
+    op = wined3d_device_context_require_space(context, sizeof(*op), WINED3D_CS_QUEUE_DEFAULT);
     op->opcode = WINED3D_CS_OP_RESET_STATE;
+    op->invalidate = invalidate;
 
-    wined3d_device_context_submit(&cs->c, WINED3D_CS_QUEUE_DEFAULT);
+    wined3d_device_context_submit(context, WINED3D_CS_QUEUE_DEFAULT);
 }
 
 static void wined3d_cs_exec_callback(struct wined3d_cs *cs, const void *data)
@@ -2331,6 +2413,267 @@ HRESULT wined3d_cs_unmap(struct wined3d_cs *cs, struct wined3d_resource *resourc
     return hr;
 }
 
+static BOOL wined3d_upload_memory_is_idle(struct wined3d_upload_memory *memory)
+{
+    return InterlockedCompareExchange(&memory->refcount, 0, 0) == 1;
+}
+
+/* Keeps memory that is no longer current around for later DISCARD maps, so
+ * that they don't have to allocate new memory while uploads from the
+ * previous memory are in flight. */
+static void wined3d_buffer_retire_upload_memory(struct wined3d_buffer *buffer,
+        struct wined3d_upload_memory *memory)
+{
+    unsigned int i;
+
+    for (i = 0; i < ARRAY_SIZE(buffer->upload_pool); ++i)
+    {
+        if (!buffer->upload_pool[i])
+        {
+            buffer->upload_pool[i] = memory;
+            return;
+        }
+    }
+
+    wined3d_upload_memory_decref(memory);
+}
+
+static struct wined3d_upload_memory *wined3d_cs_get_upload_memory(struct wined3d_cs *cs,
+        struct wined3d_buffer *buffer)
+{
+    struct wined3d_upload_memory *memory = buffer->upload_memory;
+    unsigned int size = buffer->resource.size;
+    ULONG_PTR page_count;
+    unsigned int i;
+
+    /* Memory can be reused once all uploads from it have been executed, i.e.
+     * once we hold the only reference. */
+    if (memory && wined3d_upload_memory_is_idle(memory))
+        return memory;
+
+    for (i = 0; i < ARRAY_SIZE(buffer->upload_pool); ++i)
+    {
+        if ((memory = buffer->upload_pool[i]) && wined3d_upload_memory_is_idle(memory))
+        {
+            buffer->upload_pool[i] = NULL;
+            goto done;
+        }
+    }
+
+    page_count = (size + 0xfff) >> 12;
+    if (!(memory = heap_alloc(FIELD_OFFSET(struct wined3d_upload_memory, pages[page_count]))))
+        return NULL;
+    memory->write_watch = TRUE;
+    if (!(memory->data = VirtualAlloc(NULL, size, MEM_RESERVE | MEM_COMMIT | MEM_WRITE_WATCH, PAGE_READWRITE)))
+    {
+        WARN("Failed to allocate write watched memory, error %u.\n", GetLastError());
+        memory->write_watch = FALSE;
+        if (!(memory->data = VirtualAlloc(NULL, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE)))
+        {
+            heap_free(memory);
+            return NULL;
+        }
+    }
+    memory->refcount = 1;
+    memory->size = size;
+    memory->page_count = page_count;
+
+done:
+    if (buffer->upload_memory)
+        wined3d_buffer_retire_upload_memory(buffer, buffer->upload_memory);
+    buffer->upload_memory = memory;
+
+    return memory;
+}
+
+/* Called from the application thread when a buffer is about to be written
+ * by something other than an upload from its client memory, including
+ * regular maps. The client memory would no longer match the buffer contents
+ * around the written range, so the next NOOVERWRITE map has to go through
+ * the regular path. */
+void wined3d_device_context_invalidate_upload_memory(struct wined3d_device_context *context,
+        struct wined3d_resource *resource)
+{
+    struct wined3d_buffer *buffer;
+
+    if (resource->type != WINED3D_RTYPE_BUFFER || context != &context->device->cs->c)
+        return;
+
+    buffer = buffer_from_resource(resource);
+    if (buffer->upload_memory && !buffer->upload_map_count)
+    {
+        wined3d_buffer_retire_upload_memory(buffer, buffer->upload_memory);
+        buffer->upload_memory = NULL;
+    }
+}
+
+/* DISCARD maps of dynamic buffers, and NOOVERWRITE maps following them, are
+ * served from client memory without synchronising with the command stream.
+ * Only the range written by the application is uploaded on unmap, in order
+ * with the other commands. Buffers the GPU can write to itself never take
+ * this path, and other writes drop the client memory, so the bytes around
+ * the written range are never stale. */
+BOOL wined3d_cs_map_upload_memory(struct wined3d_cs *cs, struct wined3d_resource *resource,
+        unsigned int sub_resource_idx, struct wined3d_map_desc *map_desc,
+        const struct wined3d_box *box, unsigned int flags)
+{
+    struct wined3d_upload_memory *memory;
+    struct wined3d_buffer *buffer;
+    unsigned int start;
+
+    if (!cs->thread || cs->thread_id == GetCurrentThreadId()
+            || resource->type != WINED3D_RTYPE_BUFFER || sub_resource_idx)
+        return FALSE;
+
+    buffer = buffer_from_resource(resource);
+    if (!buffer->upload_map_count)
+    {
+        if (resource->map_count || !(buffer->flags & WINED3D_BUFFER_USE_BO)
+                || (resource->bind_flags & (WINED3D_BIND_STREAM_OUTPUT | WINED3D_BIND_UNORDERED_ACCESS)))
+            return FALSE;
+
+        if (flags & WINED3D_MAP_DISCARD)
+        {
+            if (!wined3d_cs_get_upload_memory(cs, buffer))
+                return FALSE;
+        }
+        else if (!(flags & WINED3D_MAP_NOOVERWRITE) || !buffer->upload_memory)
+        {
+            return FALSE;
+        }
+
+        buffer->upload_start = resource->size;
+        buffer->upload_end = 0;
+        buffer->upload_watched = FALSE;
+    }
+    memory = buffer->upload_memory;
+
+    if (box)
+    {
+        start = box->left;
+        buffer->upload_start = min(buffer->upload_start, box->left);
+        buffer->upload_end = max(buffer->upload_end, box->right);
+    }
+    else
+    {
+        start = 0;
+        if (!memory->write_watch)
+        {
+            buffer->upload_start = 0;
+            buffer->upload_end = resource->size;
+        }
+        else if (!buffer->upload_watched)
+        {
+            ResetWriteWatch(memory->data, memory->size);
+            buffer->upload_watched = TRUE;
+        }
+    }
+
+    map_desc->row_pitch = map_desc->slice_pitch = resource->size;
+    map_desc->data = memory->data + start;
+
+    ++buffer->upload_map_count;
+    ++resource->map_count;
+    ++cs->stats.upload_maps;
+
+    TRACE("Returning upload memory at %p for buffer %p.\n", map_desc->data, buffer);
+
+    return TRUE;
+}
+
+static void wined3d_cs_exec_upload_buffer(struct wined3d_cs *cs, const void *data)
+{
+    const struct wined3d_cs_upload_buffer *op = data;
+    struct wined3d_buffer *buffer = op->buffer;
+    struct wined3d_context *context;
+    struct wined3d_box box;
+    BYTE *sysmem;
+
+    context = context_acquire(cs->c.device, NULL, 0);
+
+    if (buffer->flags & WINED3D_BUFFER_USE_BO)
+    {
+        if (wined3d_buffer_load_location(buffer, context, WINED3D_LOCATION_BUFFER))
+        {
+            wined3d_box_set(&box, op->offset, 0, op->offset + op->size, 1, 0, 1);
+            wined3d_buffer_upload_data(buffer, context, &box, op->memory->data + op->offset);
+            wined3d_buffer_invalidate_location(buffer, ~WINED3D_LOCATION_BUFFER);
+        }
+        else
+        {
+            ERR("Failed to load buffer location.\n");
+        }
+    }
+    else if ((sysmem = wined3d_buffer_load_sysmem(buffer, context)))
+    {
+        /* The buffer object was dropped after the upload was queued. */
+        memcpy(sysmem + op->offset, op->memory->data + op->offset, op->size);
+        wined3d_buffer_invalidate_location(buffer, ~WINED3D_LOCATION_SYSMEM);
+    }
+
+    context_release(context);
+
+    wined3d_upload_memory_decref(op->memory);
+    wined3d_resource_release(&buffer->resource);
+}
+
+BOOL wined3d_cs_unmap_upload_memory(struct wined3d_cs *cs, struct wined3d_resource *resource,
+        unsigned int sub_resource_idx)
+{
+    struct wined3d_upload_memory *memory;
+    struct wined3d_cs_upload_buffer *op;
+    struct wined3d_buffer *buffer;
+    ULONG_PTR count;
+    ULONG granularity;
+    unsigned int end;
+
+    if (resource->type != WINED3D_RTYPE_BUFFER || sub_resource_idx)
+        return FALSE;
+
+    buffer = buffer_from_resource(resource);
+    if (!buffer->upload_map_count)
+        return FALSE;
+
+    --resource->map_count;
+    if (--buffer->upload_map_count)
+        return TRUE;
+
+    memory = buffer->upload_memory;
+    if (buffer->upload_watched)
+    {
+        count = memory->page_count;
+        if (GetWriteWatch(WRITE_WATCH_FLAG_RESET, memory->data, memory->size, memory->pages, &count, &granularity))
+        {
+            WARN("Failed to get written pages, uploading the entire buffer.\n");
+            buffer->upload_start = 0;
+            buffer->upload_end = resource->size;
+        }
+        else if (count)
+        {
+            end = min((BYTE *)memory->pages[count - 1] + granularity - memory->data, resource->size);
+            buffer->upload_start = min(buffer->upload_start, (BYTE *)memory->pages[0] - memory->data);
+            buffer->upload_end = max(buffer->upload_end, end);
+        }
+    }
+
+    if (buffer->upload_start >= buffer->upload_end)
+        return TRUE;
+
+    op = wined3d_device_context_require_space(&cs->c, sizeof(*op), WINED3D_CS_QUEUE_DEFAULT);
+    op->opcode = WINED3D_CS_OP_UPLOAD_BUFFER;
+    op->buffer = buffer;
+    op->memory = memory;
+    op->offset = buffer->upload_start;
+    op->size = buffer->upload_end - buffer->upload_start;
+
+    InterlockedIncrement(&op->memory->refcount);
+    wined3d_resource_acquire(resource);
+
+    wined3d_device_context_submit(&cs->c, WINED3D_CS_QUEUE_DEFAULT);
+
+    return TRUE;
+}
+
 static void wined3d_cs_exec_blt_sub_resource(struct wined3d_cs *cs, const void *data)
 {
     const struct wined3d_cs_blt_sub_resource *op = data;
@@ -2454,9 +2797,10 @@ void wined3d_device_context_emit_blt_sub_resource(struct wined3d_device_context
         memset(&op->fx, 0, sizeof(op->fx));
     op->filter = filter;
 
-    wined3d_resource_acquire(dst_resource);
+    wined3d_device_context_invalidate_upload_memory(context, dst_resource);
+    wined3d_device_context_acquire_resource(context, dst_resource);
     if (src_resource)
-        wined3d_resource_acquire(src_resource);
+        wined3d_device_context_acquire_resource(context, src_resource);
 
     wined3d_device_context_submit(context, WINED3D_CS_QUEUE_DEFAULT);
     if (flags & WINED3D_BLT_SYNCHRONOUS)
@@ -2525,9 +2869,19 @@ done:
 void wined3d_device_context_emit_update_sub_resource(struct wined3d_device_context *context,
         struct wined3d_resource *resource, unsigned int sub_resource_idx, const struct wined3d_box *box,
         const void *data, unsigned int row_pitch, unsigned int slice_pitch)
+{
+    context->ops->update_sub_resource(context, resource, sub_resource_idx, box, data, row_pitch, slice_pitch);
+}
+
+static void wined3d_cs_update_sub_resource(struct wined3d_device_context *context,
+        struct wined3d_resource *resource, unsigned int sub_resource_idx, const struct wined3d_box *box,
+        const void *data, unsigned int row_pitch, unsigned int slice_pitch)
 {
     struct wined3d_cs_update_sub_resource *op;
 
+    wined3d_device_context_invalidate_upload_memory(context, resource);
+    wined3d_resource_wait_idle(resource);
+
     op = wined3d_device_context_require_space(context, sizeof(*op), WINED3D_CS_QUEUE_MAP);
     op->opcode = WINED3D_CS_OP_UPDATE_SUB_RESOURCE;
     op->resource = resource;
@@ -2604,7 +2958,7 @@ void wined3d_device_context_emit_clear_uav_uint(struct wined3d_device_context *c
     op->view = view;
     op->clear_value = *clear_value;
 
-    wined3d_resource_acquire(view->resource);
+    wined3d_device_context_acquire_resource(context, view->resource);
 
     wined3d_device_context_submit(context, WINED3D_CS_QUEUE_DEFAULT);
 }
@@ -2633,7 +2987,8 @@ void wined3d_device_context_emit_copy_uav_counter(struct wined3d_device_context
     op->offset = offset;
     op->view = uav;
 
-    wined3d_resource_acquire(&dst_buffer->resource);
+    wined3d_device_context_invalidate_upload_memory(context, &dst_buffer->resource);
+    wined3d_device_context_acquire_resource(context, &dst_buffer->resource);
 
     wined3d_device_context_submit(context, WINED3D_CS_QUEUE_DEFAULT);
 }
@@ -2660,7 +3015,7 @@ void wined3d_device_context_emit_generate_mipmaps(struct wined3d_device_context
     op->opcode = WINED3D_CS_OP_GENERATE_MIPMAPS;
     op->view = view;
 
-    wined3d_resource_acquire(view->resource);
+    wined3d_device_context_acquire_resource(context, view->resource);
 
     wined3d_device_context_submit(context, WINED3D_CS_QUEUE_DEFAULT);
 }
@@ -2676,6 +3031,8 @@ static void wined3d_cs_emit_stop(struct wined3d_cs *cs)
     wined3d_cs_finish(cs, WINED3D_CS_QUEUE_DEFAULT);
 }
 
+static void wined3d_cs_exec_execute_command_list(struct wined3d_cs *cs, const void *data);
+
 static void (* const wined3d_cs_op_handlers[])(struct wined3d_cs *cs, const void *data) =
 {
     /* WINED3D_CS_OP_NOP                         */ wined3d_cs_exec_nop,
@@ -2727,8 +3084,57 @@ static void (* const wined3d_cs_op_handlers[])(struct wined3d_cs *cs, const void
     /* WINED3D_CS_OP_CLEAR_UNORDERED_ACCESS_VIEW */ wined3d_cs_exec_clear_unordered_access_view,
     /* WINED3D_CS_OP_COPY_UAV_COUNTER            */ wined3d_cs_exec_copy_uav_counter,
     /* WINED3D_CS_OP_GENERATE_MIPMAPS            */ wined3d_cs_exec_generate_mipmaps,
+    /* WINED3D_CS_OP_UPLOAD_BUFFER               */ wined3d_cs_exec_upload_buffer,
+    /* WINED3D_CS_OP_EXECUTE_COMMAND_LIST        */ wined3d_cs_exec_execute_command_list,
 };
 
+static void wined3d_cs_exec_execute_command_list(struct wined3d_cs *cs, const void *data)
+{
+    const struct wined3d_cs_execute_command_list *op = data;
+    const struct wined3d_command_list *list = op->list;
+    const struct wined3d_cs_packet *packet;
+    enum wined3d_cs_op opcode;
+    size_t start = 0;
+
+    TRACE("Executing command list %p, size %lu.\n", list, (unsigned long)list->data_size);
+
+    while (start < list->data_size)
+    {
+        packet = (const struct wined3d_cs_packet *)((const BYTE *)list->data + start);
+        opcode = *(const enum wined3d_cs_op *)packet->data;
+
+        if (opcode >= WINED3D_CS_OP_STOP)
+            ERR("Invalid opcode %#x.\n", opcode);
+        else
+            wined3d_cs_op_handlers[opcode](cs, packet->data);
+
+        start += FIELD_OFFSET(struct wined3d_cs_packet, data[packet->size]);
+    }
+}
+
+void wined3d_device_context_emit_execute_command_list(struct wined3d_device_context *context,
+        struct wined3d_command_list *list)
+{
+    struct wined3d_cs_execute_command_list *op;
+    SIZE_T i;
+
+    op = wined3d_device_context_require_space(context, sizeof(*op), WINED3D_CS_QUEUE_DEFAULT);
+    op->opcode = WINED3D_CS_OP_EXECUTE_COMMAND_LIST;
+    op->list = list;
+
+    /* Every packet in the list releases the resources it was recorded
+     * against; acquire them once more on behalf of this execution. */
+    for (i = 0; i < list->resource_count; ++i)
+    {
+        wined3d_device_context_invalidate_upload_memory(context, list->resources[i]);
+        wined3d_device_context_acquire_resource(context, list->resources[i]);
+    }
+
+    context->ops->acquire_command_list(context, list);
+
+    wined3d_device_context_submit(context, WINED3D_CS_QUEUE_DEFAULT);
+}
+
 static void *wined3d_cs_st_require_space(struct wined3d_device_context *context,
         size_t size, enum wined3d_cs_queue_id queue_id)
 {
@@ -2784,28 +3190,62 @@ static void wined3d_cs_st_finish(struct wined3d_device_context *context, enum wi
 {
 }
 
+static void wined3d_cs_acquire_resource(struct wined3d_device_context *context, struct wined3d_resource *resource)
+{
+    wined3d_resource_acquire(resource);
+}
+
+static void wined3d_cs_acquire_command_list(struct wined3d_device_context *context, struct wined3d_command_list *list)
+{
+    /* Nothing to do; wined3d_command_list_decref() frees the list through
+     * the command stream, i.e. after any execution queued here. */
+}
+
+static HRESULT wined3d_cs_map_resource(struct wined3d_device_context *context, struct wined3d_resource *resource,
+        unsigned int sub_resource_idx, struct wined3d_map_desc *map_desc, const struct wined3d_box *box,
+        unsigned int flags)
+{
+    return wined3d_resource_map(resource, sub_resource_idx, map_desc, box, flags);
+}
+
+static HRESULT wined3d_cs_unmap_resource(struct wined3d_device_context *context, struct wined3d_resource *resource,
+        unsigned int sub_resource_idx)
+{
+    return wined3d_resource_unmap(resource, sub_resource_idx);
+}
+
 static const struct wined3d_device_context_ops wined3d_cs_st_ops =
 {
     wined3d_cs_st_require_space,
     wined3d_cs_st_submit,
     wined3d_cs_st_finish,
     wined3d_cs_st_push_constants,
+    wined3d_cs_acquire_resource,
+    wined3d_cs_update_sub_resource,
+    wined3d_cs_acquire_command_list,
+    wined3d_cs_map_resource,
+    wined3d_cs_unmap_resource,
 };
 
 static BOOL wined3d_cs_queue_is_empty(const struct wined3d_cs *cs, const struct wined3d_cs_queue *queue)
 {
+    const struct wined3d_cs_queue_chunk *chunk = queue->tail_chunk;
+
     wined3d_from_cs(cs);
-    return *(volatile LONG *)&queue->head == queue->tail;
+    return *(volatile LONG *)&chunk->head == chunk->tail
+            && !*(struct wined3d_cs_queue_chunk * volatile *)&chunk->next;
 }
 
 static void wined3d_cs_queue_submit(struct wined3d_cs_queue *queue, struct wined3d_cs *cs)
 {
+    struct wined3d_cs_queue_chunk *chunk = queue->head_chunk;
     struct wined3d_cs_packet *packet;
     size_t packet_size;
 
-    packet = (struct wined3d_cs_packet *)&queue->data[queue->head];
+    packet = (struct wined3d_cs_packet *)&chunk->data[chunk->head];
     packet_size = FIELD_OFFSET(struct wined3d_cs_packet, data[packet->size]);
-    InterlockedExchange(&queue->head, (queue->head + packet_size) & (WINED3D_CS_QUEUE_SIZE - 1));
+    InterlockedExchange(&chunk->head, chunk->head + packet_size);
+    cs->stats.bytes_queued += packet_size;
 
     if (InterlockedCompareExchange(&cs->waiting_for_event, FALSE, TRUE))
         SetEvent(cs->event);
@@ -2821,64 +3261,83 @@ static void wined3d_cs_mt_submit(struct wined3d_device_context *context, enum wi
     wined3d_cs_queue_submit(&cs->queue[queue_id], cs);
 }
 
-static void *wined3d_cs_queue_require_space(struct wined3d_cs_queue *queue, size_t size, struct wined3d_cs *cs)
+static struct wined3d_cs_queue_chunk *wined3d_cs_queue_add_chunk(struct wined3d_cs_queue *queue,
+        size_t packet_size, struct wined3d_cs *cs)
 {
-    size_t queue_size = ARRAY_SIZE(queue->data);
-    size_t header_size, packet_size, remaining;
-    struct wined3d_cs_packet *packet;
+    size_t chunk_size = max(packet_size, WINED3D_CS_QUEUE_SIZE);
+    struct wined3d_cs_queue_chunk *chunk = NULL;
+    LARGE_INTEGER start, end;
 
-    header_size = FIELD_OFFSET(struct wined3d_cs_packet, data[0]);
-    packet_size = FIELD_OFFSET(struct wined3d_cs_packet, data[size]);
-    packet_size = (packet_size + header_size - 1) & ~(header_size - 1);
-    size = packet_size - header_size;
-    if (packet_size >= WINED3D_CS_QUEUE_SIZE)
+    if (chunk_size == WINED3D_CS_QUEUE_SIZE)
+        chunk = InterlockedExchangePointer((void **)&queue->free_chunk, NULL);
+
+    if (!chunk && *(volatile LONG *)&queue->chunk_count >= WINED3D_CS_QUEUE_MAX_CHUNKS)
     {
-        ERR("Packet size %lu >= queue size %u.\n",
-                (unsigned long)packet_size, WINED3D_CS_QUEUE_SIZE);
-        return NULL;
+        TRACE("Waiting for free space, %u chunks queued.\n", WINED3D_CS_QUEUE_MAX_CHUNKS);
+
+        QueryPerformanceCounter(&start);
+        while (*(volatile LONG *)&queue->chunk_count >= WINED3D_CS_QUEUE_MAX_CHUNKS)
+            YieldProcessor();
+        QueryPerformanceCounter(&end);
+        ++cs->stats.stall_count;
+        cs->stats.stall_time += end.QuadPart - start.QuadPart;
+
+        if (chunk_size == WINED3D_CS_QUEUE_SIZE)
+            chunk = InterlockedExchangePointer((void **)&queue->free_chunk, NULL);
     }
 
-    remaining = queue_size - queue->head;
-    if (remaining < packet_size)
+    if (!chunk)
     {
-        size_t nop_size = remaining - header_size;
-        struct wined3d_cs_nop *nop;
+        if (!(chunk = heap_alloc(FIELD_OFFSET(struct wined3d_cs_queue_chunk, data[chunk_size]))))
+        {
+            ERR("Failed to allocate %lu bytes for the command stream.\n", (unsigned long)chunk_size);
+            return NULL;
+        }
+        chunk->size = chunk_size;
+        ++cs->stats.chunk_allocations;
+    }
 
-        TRACE("Inserting a nop for %lu + %lu bytes.\n",
-                (unsigned long)header_size, (unsigned long)nop_size);
+    chunk->next = NULL;
+    chunk->head = chunk->tail = 0;
 
-        nop = wined3d_cs_queue_require_space(queue, nop_size, cs);
-        if (nop_size)
-            nop->opcode = WINED3D_CS_OP_NOP;
+    InterlockedIncrement(&queue->chunk_count);
+    InterlockedExchangePointer((void **)&queue->head_chunk->next, chunk);
+    queue->head_chunk = chunk;
 
-        wined3d_cs_queue_submit(queue, cs);
-        assert(!queue->head);
-    }
+    return chunk;
+}
 
-    for (;;)
-    {
-        LONG tail = *(volatile LONG *)&queue->tail;
-        LONG head = queue->head;
-        LONG new_pos;
+static void wined3d_cs_queue_retire_chunk(struct wined3d_cs_queue *queue)
+{
+    struct wined3d_cs_queue_chunk *chunk = queue->tail_chunk;
 
-        /* Empty. */
-        if (head == tail)
-            break;
-        new_pos = (head + packet_size) & (WINED3D_CS_QUEUE_SIZE - 1);
-        /* Head ahead of tail. We checked the remaining size above, so we only
-         * need to make sure we don't make head equal to tail. */
-        if (head > tail && (new_pos != tail))
-            break;
-        /* Tail ahead of head. Make sure the new head is before the tail as
-         * well. Note that new_pos is 0 when it's at the end of the queue. */
-        if (new_pos < tail && new_pos)
-            break;
+    queue->tail_chunk = chunk->next;
 
-        TRACE("Waiting for free space. Head %u, tail %u, packet size %lu.\n",
-                head, tail, (unsigned long)packet_size);
-    }
+    if (chunk->size == WINED3D_CS_QUEUE_SIZE)
+        chunk = InterlockedExchangePointer((void **)&queue->free_chunk, chunk);
+    heap_free(chunk);
+
+    InterlockedDecrement(&queue->chunk_count);
+}
+
+static void *wined3d_cs_queue_require_space(struct wined3d_cs_queue *queue, size_t size, struct wined3d_cs *cs)
+{
+    struct wined3d_cs_queue_chunk *chunk = queue->head_chunk;
+    size_t header_size, packet_size;
+    struct wined3d_cs_packet *packet;
+
+    header_size = FIELD_OFFSET(struct wined3d_cs_packet, data[0]);
+    packet_size = FIELD_OFFSET(struct wined3d_cs_packet, data[size]);
+    packet_size = (packet_size + header_size - 1) & ~(header_size - 1);
+    size = packet_size - header_size;
+
+    /* Packets that don't fit in the current chunk start a new one. Packets
+     * larger than the default chunk size get a chunk of their own. */
+    if (chunk->size - chunk->head < packet_size
+            && !(chunk = wined3d_cs_queue_add_chunk(queue, packet_size, cs)))
+        return NULL;
 
-    packet = (struct wined3d_cs_packet *)&queue->data[queue->head];
+    packet = (struct wined3d_cs_packet *)&chunk->data[chunk->head];
     packet->size = size;
     return packet->data;
 }
@@ -2894,15 +3353,62 @@ static void *wined3d_cs_mt_require_space(struct wined3d_device_context *context,
     return wined3d_cs_queue_require_space(&cs->queue[queue_id], size, cs);
 }
 
+static BOOL wined3d_cs_queue_is_idle(const struct wined3d_cs_queue *queue)
+{
+    const struct wined3d_cs_queue_chunk *chunk = queue->head_chunk;
+
+    return *(struct wined3d_cs_queue_chunk * volatile *)&queue->tail_chunk == chunk
+            && chunk->head == *(volatile LONG *)&chunk->tail;
+}
+
 static void wined3d_cs_mt_finish(struct wined3d_device_context *context, enum wined3d_cs_queue_id queue_id)
 {
     struct wined3d_cs *cs = wined3d_cs_from_context(context);
+    struct wined3d_cs_queue *queue = &cs->queue[queue_id];
+    LARGE_INTEGER start, end;
 
     if (cs->thread_id == GetCurrentThreadId())
         return wined3d_cs_st_finish(context, queue_id);
 
-    while (cs->queue[queue_id].head != *(volatile LONG *)&cs->queue[queue_id].tail)
+    if (wined3d_cs_queue_is_idle(queue))
+        return;
+
+    QueryPerformanceCounter(&start);
+    while (!wined3d_cs_queue_is_idle(queue))
         YieldProcessor();
+    QueryPerformanceCounter(&end);
+    ++cs->stats.finish_count;
+    cs->stats.finish_time += end.QuadPart - start.QuadPart;
+}
+
+static BOOL wined3d_cs_queue_init(struct wined3d_cs_queue *queue)
+{
+    struct wined3d_cs_queue_chunk *chunk;
+
+    if (!(chunk = heap_alloc(FIELD_OFFSET(struct wined3d_cs_queue_chunk, data[WINED3D_CS_QUEUE_SIZE]))))
+        return FALSE;
+
+    chunk->next = NULL;
+    chunk->size = WINED3D_CS_QUEUE_SIZE;
+    chunk->head = chunk->tail = 0;
+
+    queue->head_chunk = queue->tail_chunk = chunk;
+    queue->free_chunk = NULL;
+    queue->chunk_count = 1;
+
+    return TRUE;
+}
+
+static void wined3d_cs_queue_cleanup(struct wined3d_cs_queue *queue)
+{
+    struct wined3d_cs_queue_chunk *chunk, *next;
+
+    for (chunk = queue->tail_chunk; chunk; chunk = next)
+    {
+        next = chunk->next;
+        heap_free(chunk);
+    }
+    heap_free(queue->free_chunk);
 }
 
 static const struct wined3d_device_context_ops wined3d_cs_mt_ops =
@@ -2910,7 +3416,12 @@ static const struct wined3d_device_context_ops wined3d_cs_mt_ops =
     wined3d_cs_mt_require_space,
     wined3d_cs_mt_submit,
     wined3d_cs_mt_finish,
-    wined3d_cs_mt_push_constants,
+    wined3d_device_context_emit_push_constants,
+    wined3d_cs_acquire_resource,
+    wined3d_cs_update_sub_resource,
+    wined3d_cs_acquire_command_list,
+    wined3d_cs_map_resource,
+    wined3d_cs_unmap_resource,
 };
 
 static void poll_queries(struct wined3d_cs *cs)
@@ -2961,6 +3472,7 @@ static void wined3d_cs_command_unlock(const struct wined3d_cs *cs)
 
 static DWORD WINAPI wined3d_cs_run(void *ctx)
 {
+    struct wined3d_cs_queue_chunk *chunk;
     struct wined3d_cs_packet *packet;
     struct wined3d_cs_queue *queue;
     unsigned int spin_count = 0;
@@ -3001,8 +3513,16 @@ static DWORD WINAPI wined3d_cs_run(void *ctx)
         }
         spin_count = 0;
 
-        tail = queue->tail;
-        packet = (struct wined3d_cs_packet *)&queue->data[tail];
+        chunk = queue->tail_chunk;
+        tail = chunk->tail;
+        if (tail == *(volatile LONG *)&chunk->head)
+        {
+            /* The queue isn't empty, so the producer moved on to the next chunk. */
+            wined3d_cs_queue_retire_chunk(queue);
+            continue;
+        }
+
+        packet = (struct wined3d_cs_packet *)&chunk->data[tail];
         if (packet->size)
         {
             opcode = *(const enum wined3d_cs_op *)packet->data;
@@ -3022,12 +3542,13 @@ static DWORD WINAPI wined3d_cs_run(void *ctx)
         }
 
         tail += FIELD_OFFSET(struct wined3d_cs_packet, data[packet->size]);
-        tail &= (WINED3D_CS_QUEUE_SIZE - 1);
-        InterlockedExchange(&queue->tail, tail);
+        InterlockedExchange(&chunk->tail, tail);
     }
 
-    cs->queue[WINED3D_CS_QUEUE_MAP].tail = cs->queue[WINED3D_CS_QUEUE_MAP].head;
-    cs->queue[WINED3D_CS_QUEUE_DEFAULT].tail = cs->queue[WINED3D_CS_QUEUE_DEFAULT].head;
+    chunk = cs->queue[WINED3D_CS_QUEUE_MAP].tail_chunk;
+    chunk->tail = chunk->head;
+    chunk = cs->queue[WINED3D_CS_QUEUE_DEFAULT].tail_chunk;
+    chunk->tail = chunk->head;
     TRACE("Stopped.\n");
     FreeLibraryAndExitThread(wined3d_module, 0);
 }
@@ -3062,9 +3583,26 @@ struct wined3d_cs *wined3d_cs_create(struct wined3d_device *device,
     {
         cs->c.ops = &wined3d_cs_mt_ops;
 
+        if (!wined3d_cs_queue_init(&cs->queue[WINED3D_CS_QUEUE_DEFAULT]))
+        {
+            ERR("Failed to initialise command stream queue.\n");
+            heap_free(cs->data);
+            goto fail;
+        }
+
+        if (!wined3d_cs_queue_init(&cs->queue[WINED3D_CS_QUEUE_MAP]))
+        {
+            ERR("Failed to initialise command stream queue.\n");
+            wined3d_cs_queue_cleanup(&cs->queue[WINED3D_CS_QUEUE_DEFAULT]);
+            heap_free(cs->data);
+            goto fail;
+        }
+
         if (!(cs->event = CreateEventW(NULL, FALSE, FALSE, NULL)))
         {
             ERR("Failed to create command stream event.\n");
+            wined3d_cs_queue_cleanup(&cs->queue[WINED3D_CS_QUEUE_MAP]);
+            wined3d_cs_queue_cleanup(&cs->queue[WINED3D_CS_QUEUE_DEFAULT]);
             heap_free(cs->data);
             goto fail;
         }
@@ -3074,6 +3612,8 @@ struct wined3d_cs *wined3d_cs_create(struct wined3d_device *device,
         {
             ERR("Failed to get wined3d module handle.\n");
             CloseHandle(cs->event);
+            wined3d_cs_queue_cleanup(&cs->queue[WINED3D_CS_QUEUE_MAP]);
+            wined3d_cs_queue_cleanup(&cs->queue[WINED3D_CS_QUEUE_DEFAULT]);
             heap_free(cs->data);
             goto fail;
         }
@@ -3083,6 +3623,8 @@ struct wined3d_cs *wined3d_cs_create(struct wined3d_device *device,
             ERR("Failed to create wined3d command stream thread.\n");
             FreeLibrary(cs->wined3d_module);
             CloseHandle(cs->event);
+            wined3d_cs_queue_cleanup(&cs->queue[WINED3D_CS_QUEUE_MAP]);
+            wined3d_cs_queue_cleanup(&cs->queue[WINED3D_CS_QUEUE_DEFAULT]);
             heap_free(cs->data);
             goto fail;
         }
@@ -3105,6 +3647,11 @@ void wined3d_cs_destroy(struct wined3d_cs *cs)
         CloseHandle(cs->thread);
         if (!CloseHandle(cs->event))
             ERR("Closing event failed.\n");
+
+        if (TRACE_ON(d3d_perf))
+            wined3d_cs_report_stats(cs);
+        wined3d_cs_queue_cleanup(&cs->queue[WINED3D_CS_QUEUE_MAP]);
+        wined3d_cs_queue_cleanup(&cs->queue[WINED3D_CS_QUEUE_DEFAULT]);
     }
 
     wined3d_state_destroy(cs->c.state);
@@ -3112,3 +3659,467 @@ void wined3d_cs_destroy(struct wined3d_cs *cs)
     heap_free(cs->data);
     heap_free(cs);
 }
+
+struct wined3d_deferred_map
+{
+    struct wined3d_resource *resource;
+    unsigned int sub_resource_idx;
+    unsigned int row_pitch, slice_pitch;
+    BYTE *data;
+    /* The box of the current map, uploaded on unmap. */
+    struct wined3d_box box;
+};
+
+struct wined3d_deferred_context
+{
+    struct wined3d_device_context c;
+
+    SIZE_T data_size, data_capacity;
+    void *data;
+
+    SIZE_T resource_count, resources_capacity;
+    struct wined3d_resource **resources;
+
+    SIZE_T upload_count, uploads_capacity;
+    void **uploads;
+
+    SIZE_T command_list_count, command_lists_capacity;
+    struct wined3d_command_list **command_lists;
+
+    /* The most recent DISCARD map of each resource in the list being
+     * recorded; the memory itself is owned by "uploads". */
+    SIZE_T map_count, maps_capacity;
+    struct wined3d_deferred_map *maps;
+};
+
+static struct wined3d_deferred_context *wined3d_deferred_context_from_context(struct wined3d_device_context *context)
+{
+    return CONTAINING_RECORD(context, struct wined3d_deferred_context, c);
+}
+
+static void *wined3d_deferred_context_require_space(struct wined3d_device_context *context,
+        size_t size, enum wined3d_cs_queue_id queue_id)
+{
+    struct wined3d_deferred_context *deferred = wined3d_deferred_context_from_context(context);
+    struct wined3d_cs_packet *packet;
+    size_t header_size, packet_size;
+
+    header_size = offsetof(struct wined3d_cs_packet, data[0]);
+    packet_size = offsetof(struct wined3d_cs_packet, data[size]);
+    packet_size = (packet_size + header_size - 1) & ~(header_size - 1);
+
+    if (!wined3d_array_reserve(&deferred->data, &deferred->data_capacity, deferred->data_size + packet_size, 1))
+        return NULL;
+
+    packet = (struct wined3d_cs_packet *)((BYTE *)deferred->data + deferred->data_size);
+    TRACE("size was %lu, adding %lu.\n", (unsigned long)deferred->data_size, (unsigned long)packet_size);
+    packet->size = packet_size - header_size;
+    return &packet->data;
+}
+
+static void wined3d_deferred_context_submit(struct wined3d_device_context *context, enum wined3d_cs_queue_id queue_id)
+{
+    struct wined3d_deferred_context *deferred = wined3d_deferred_context_from_context(context);
+    struct wined3d_cs_packet *packet;
+
+    assert(queue_id == WINED3D_CS_QUEUE_DEFAULT);
+    packet = (struct wined3d_cs_packet *)((BYTE *)deferred->data + deferred->data_size);
+    deferred->data_size += packet->size + offsetof(struct wined3d_cs_packet, data[0]);
+}
+
+static void wined3d_deferred_context_finish(struct wined3d_device_context *context, enum wined3d_cs_queue_id queue_id)
+{
+    /* This should not happen; we cannot meaningfully finish a deferred context. */
+    ERR("Ignoring finish() on a deferred context.\n");
+}
+
+static void wined3d_deferred_context_acquire_resource(struct wined3d_device_context *context,
+        struct wined3d_resource *resource)
+{
+    struct wined3d_deferred_context *deferred = wined3d_deferred_context_from_context(context);
+
+    if (!wined3d_array_reserve((void **)&deferred->resources, &deferred->resources_capacity,
+            deferred->resource_count + 1, sizeof(*deferred->resources)))
+        return;
+
+    deferred->resources[deferred->resource_count++] = resource;
+    wined3d_resource_incref(resource);
+}
+
+static void wined3d_deferred_context_update_sub_resource(struct wined3d_device_context *context,
+        struct wined3d_resource *resource, unsigned int sub_resource_idx, const struct wined3d_box *box,
+        const void *data, unsigned int row_pitch, unsigned int slice_pitch)
+{
+    struct wined3d_deferred_context *deferred = wined3d_deferred_context_from_context(context);
+    struct wined3d_cs_update_sub_resource *op;
+    size_t size;
+    void *copy;
+
+    if (resource->type == WINED3D_RTYPE_BUFFER)
+    {
+        size = box->right - box->left;
+    }
+    else
+    {
+        const struct wined3d_format *format = resource->format;
+        unsigned int row_block_count, row_size, slice_size;
+
+        /* The application's pitches are kept, so copy everything up to the
+         * end of the last row of the last slice. */
+        wined3d_format_calculate_pitch(format, 1, box->right - box->left,
+                box->bottom - box->top, &row_size, &slice_size);
+        row_block_count = (box->bottom - box->top + format->block_height - 1) / format->block_height;
+        size = (box->back - box->front - 1) * slice_pitch + (row_block_count - 1) * row_pitch + row_size;
+    }
+
+    if (!wined3d_array_reserve((void **)&deferred->uploads, &deferred->uploads_capacity,
+            deferred->upload_count + 1, sizeof(*deferred->uploads)))
+        return;
+
+    if (!(copy = heap_alloc(size)))
+        return;
+    memcpy(copy, data, size);
+    deferred->uploads[deferred->upload_count++] = copy;
+
+    op = wined3d_device_context_require_space(context, sizeof(*op), WINED3D_CS_QUEUE_DEFAULT);
+    op->opcode = WINED3D_CS_OP_UPDATE_SUB_RESOURCE;
+    op->resource = resource;
+    op->sub_resource_idx = sub_resource_idx;
+    op->box = *box;
+    op->data.row_pitch = row_pitch;
+    op->data.slice_pitch = slice_pitch;
+    op->data.data = copy;
+
+    wined3d_device_context_acquire_resource(context, resource);
+
+    wined3d_device_context_submit(context, WINED3D_CS_QUEUE_DEFAULT);
+}
+
+static void wined3d_deferred_context_acquire_command_list(struct wined3d_device_context *context,
+        struct wined3d_command_list *list)
+{
+    struct wined3d_deferred_context *deferred = wined3d_deferred_context_from_context(context);
+
+    if (!wined3d_array_reserve((void **)&deferred->command_lists, &deferred->command_lists_capacity,
+            deferred->command_list_count + 1, sizeof(*deferred->command_lists)))
+        return;
+
+    deferred->command_lists[deferred->command_list_count++] = list;
+    wined3d_command_list_incref(list);
+}
+
+static struct wined3d_deferred_map *wined3d_deferred_context_find_map(struct wined3d_deferred_context *deferred,
+        struct wined3d_resource *resource, unsigned int sub_resource_idx)
+{
+    SIZE_T i;
+
+    for (i = 0; i < deferred->map_count; ++i)
+    {
+        if (deferred->maps[i].resource == resource && deferred->maps[i].sub_resource_idx == sub_resource_idx)
+            return &deferred->maps[i];
+    }
+
+    return NULL;
+}
+
+static BYTE *wined3d_deferred_map_get_data(const struct wined3d_deferred_map *map,
+        const struct wined3d_box *box)
+{
+    const struct wined3d_format *format = map->resource->format;
+
+    if (map->resource->type == WINED3D_RTYPE_BUFFER)
+        return map->data + box->left;
+
+    return map->data + box->front * map->slice_pitch
+            + (box->top / format->block_height) * map->row_pitch
+            + (box->left / format->block_width) * format->block_byte_count;
+}
+
+static HRESULT wined3d_deferred_context_map(struct wined3d_device_context *context,
+        struct wined3d_resource *resource, unsigned int sub_resource_idx, struct wined3d_map_desc *map_desc,
+        const struct wined3d_box *box, unsigned int flags)
+{
+    struct wined3d_deferred_context *deferred = wined3d_deferred_context_from_context(context);
+    unsigned int row_pitch, slice_pitch, size;
+    struct wined3d_deferred_map *map;
+    struct wined3d_box full_box;
+    void *data;
+
+    if (resource->type == WINED3D_RTYPE_BUFFER)
+    {
+        if (sub_resource_idx)
+        {
+            WARN("Invalid sub-resource index %u.\n", sub_resource_idx);
+            return E_INVALIDARG;
+        }
+        if (box && (box->left >= box->right || box->right > resource->size))
+        {
+            WARN("Invalid box %s.\n", debug_box(box));
+            return E_INVALIDARG;
+        }
+
+        wined3d_box_set(&full_box, 0, 0, resource->size, 1, 0, 1);
+        row_pitch = slice_pitch = size = resource->size;
+    }
+    else
+    {
+        struct wined3d_texture *texture = texture_from_resource(resource);
+        unsigned int level;
+
+        if (sub_resource_idx >= texture->level_count * texture->layer_count)
+        {
+            WARN("Invalid sub-resource index %u.\n", sub_resource_idx);
+            return E_INVALIDARG;
+        }
+        level = sub_resource_idx % texture->level_count;
+        if (box && FAILED(wined3d_texture_check_box_dimensions(texture, level, box)))
+        {
+            WARN("Invalid box %s.\n", debug_box(box));
+            return E_INVALIDARG;
+        }
+
+        wined3d_texture_get_level_box(texture, level, &full_box);
+        wined3d_texture_get_pitch(texture, level, &row_pitch, &slice_pitch);
+        size = slice_pitch * full_box.back;
+    }
+
+    map = wined3d_deferred_context_find_map(deferred, resource, sub_resource_idx);
+
+    if (flags & WINED3D_MAP_DISCARD)
+    {
+        if (!wined3d_array_reserve((void **)&deferred->uploads, &deferred->uploads_capacity,
+                deferred->upload_count + 1, sizeof(*deferred->uploads)))
+            return E_OUTOFMEMORY;
+
+        if (!map)
+        {
+            if (!wined3d_array_reserve((void **)&deferred->maps, &deferred->maps_capacity,
+                    deferred->map_count + 1, sizeof(*deferred->maps)))
+                return E_OUTOFMEMORY;
+            map = &deferred->maps[deferred->map_count++];
+            map->resource = resource;
+            map->sub_resource_idx = sub_resource_idx;
+            map->data = NULL;
+        }
+
+        if (!(data = heap_alloc(size)))
+            return E_OUTOFMEMORY;
+        deferred->uploads[deferred->upload_count++] = data;
+        map->data = data;
+        map->row_pitch = row_pitch;
+        map->slice_pitch = slice_pitch;
+    }
+    else if (!(flags & WINED3D_MAP_NOOVERWRITE) || !map)
+    {
+        /* NOOVERWRITE keeps writing to the memory of the previous DISCARD
+         * map, which has to be part of the same command list. */
+        WARN("Invalid map flags %#x on deferred context.\n", flags);
+        return E_INVALIDARG;
+    }
+
+    map->box = box ? *box : full_box;
+
+    map_desc->row_pitch = map->row_pitch;
+    map_desc->slice_pitch = map->slice_pitch;
+    map_desc->data = wined3d_deferred_map_get_data(map, &map->box);
+
+    return WINED3D_OK;
+}
+
+static HRESULT wined3d_deferred_context_unmap(struct wined3d_device_context *context,
+        struct wined3d_resource *resource, unsigned int sub_resource_idx)
+{
+    struct wined3d_deferred_context *deferred = wined3d_deferred_context_from_context(context);
+    struct wined3d_cs_update_sub_resource *op;
+    struct wined3d_deferred_map *map;
+
+    if (!(map = wined3d_deferred_context_find_map(deferred, resource, sub_resource_idx)))
+    {
+        WARN("Resource %p, sub-resource %u is not mapped.\n", resource, sub_resource_idx);
+        return WINED3DERR_INVALIDCALL;
+    }
+
+    /* Only the mapped box is uploaded, so that the rest of the resource
+     * keeps the contents written by earlier NOOVERWRITE maps and commands. */
+    op = wined3d_device_context_require_space(context, sizeof(*op), WINED3D_CS_QUEUE_DEFAULT);
+    op->opcode = WINED3D_CS_OP_UPDATE_SUB_RESOURCE;
+    op->resource = resource;
+    op->sub_resource_idx = sub_resource_idx;
+    op->box = map->box;
+    op->data.row_pitch = map->row_pitch;
+    op->data.slice_pitch = map->slice_pitch;
+    op->data.data = wined3d_deferred_map_get_data(map, &map->box);
+
+    wined3d_device_context_acquire_resource(context, resource);
+
+    wined3d_device_context_submit(context, WINED3D_CS_QUEUE_DEFAULT);
+
+    return WINED3D_OK;
+}
+
+static const struct wined3d_device_context_ops wined3d_deferred_context_ops =
+{
+    wined3d_deferred_context_require_space,
+    wined3d_deferred_context_submit,
+    wined3d_deferred_context_finish,
+    wined3d_device_context_emit_push_constants,
+    wined3d_deferred_context_acquire_resource,
+    wined3d_deferred_context_update_sub_resource,
+    wined3d_deferred_context_acquire_command_list,
+    wined3d_deferred_context_map,
+    wined3d_deferred_context_unmap,
+};
+
+HRESULT CDECL wined3d_deferred_context_create(struct wined3d_device *device, struct wined3d_device_context **context)
+{
+    struct wined3d_deferred_context *object;
+    HRESULT hr;
+
+    TRACE("device %p, context %p.\n", device, context);
+
+    if (!(object = heap_alloc_zero(sizeof(*object))))
+        return E_OUTOFMEMORY;
+
+    if (FAILED(hr = wined3d_state_create(device, &device->cs->c.state->feature_level, 1, &object->c.state)))
+    {
+        heap_free(object);
+        return hr;
+    }
+
+    object->c.ops = &wined3d_deferred_context_ops;
+    object->c.device = device;
+
+    /* Command lists are executed against a cleared state. */
+    wined3d_device_context_emit_reset_state(&object->c, true);
+
+    TRACE("Created deferred context %p.\n", object);
+    *context = &object->c;
+
+    return S_OK;
+}
+
+void CDECL wined3d_deferred_context_destroy(struct wined3d_device_context *context)
+{
+    struct wined3d_deferred_context *deferred = wined3d_deferred_context_from_context(context);
+    SIZE_T i;
+
+    TRACE("context %p.\n", context);
+
+    for (i = 0; i < deferred->resource_count; ++i)
+        wined3d_resource_decref(deferred->resources[i]);
+    heap_free(deferred->resources);
+
+    for (i = 0; i < deferred->upload_count; ++i)
+        heap_free(deferred->uploads[i]);
+    heap_free(deferred->uploads);
+
+    for (i = 0; i < deferred->command_list_count; ++i)
+        wined3d_command_list_decref(deferred->command_lists[i]);
+    heap_free(deferred->command_lists);
+
+    heap_free(deferred->maps);
+
+    wined3d_state_destroy(deferred->c.state);
+    heap_free(deferred->data);
+    heap_free(deferred);
+}
+
+HRESULT CDECL wined3d_deferred_context_record_command_list(struct wined3d_device_context *context,
+        bool restore, struct wined3d_command_list **list)
+{
+    struct wined3d_deferred_context *deferred = wined3d_deferred_context_from_context(context);
+    struct wined3d_command_list *object;
+
+    TRACE("context %p, list %p.\n", context, list);
+
+    if (!(object = heap_alloc_zero(sizeof(*object))))
+        return E_OUTOFMEMORY;
+
+    object->refcount = 1;
+    object->device = deferred->c.device;
+
+    /* The recorded data, and the references it holds, move to the list. */
+    object->data = deferred->data;
+    object->data_size = deferred->data_size;
+    object->resources = deferred->resources;
+    object->resource_count = deferred->resource_count;
+    object->uploads = deferred->uploads;
+    object->upload_count = deferred->upload_count;
+    object->command_lists = deferred->command_lists;
+    object->command_list_count = deferred->command_list_count;
+
+    deferred->data = NULL;
+    deferred->data_size = deferred->data_capacity = 0;
+    deferred->resources = NULL;
+    deferred->resource_count = deferred->resources_capacity = 0;
+    deferred->uploads = NULL;
+    deferred->upload_count = deferred->uploads_capacity = 0;
+    deferred->command_lists = NULL;
+    deferred->command_list_count = deferred->command_lists_capacity = 0;
+    deferred->map_count = 0;
+
+    /* Start the next list. With "restore" the context keeps its state, so
+     * the next list has to establish it again after the reset. */
+    if (restore)
+    {
+        wined3d_device_context_emit_reset_state(context, true);
+        wined3d_device_context_set_state(context, context->state);
+    }
+    else
+    {
+        wined3d_device_context_reset_state(context);
+    }
+
+    TRACE("Created command list %p.\n", object);
+    *list = object;
+
+    return S_OK;
+}
+
+static void wined3d_command_list_destroy_object(void *object)
+{
+    struct wined3d_command_list *list = object;
+    SIZE_T i;
+
+    TRACE("list %p.\n", list);
+
+    for (i = 0; i < list->upload_count; ++i)
+        heap_free(list->uploads[i]);
+    heap_free(list->uploads);
+    heap_free(list->resources);
+    heap_free(list->command_lists);
+    heap_free(list->data);
+    heap_free(list);
+}
+
+ULONG CDECL wined3d_command_list_incref(struct wined3d_command_list *list)
+{
+    ULONG refcount = InterlockedIncrement(&list->refcount);
+
+    TRACE("%p increasing refcount to %u.\n", list, refcount);
+
+    return refcount;
+}
+
+ULONG CDECL wined3d_command_list_decref(struct wined3d_command_list *list)
+{
+    ULONG refcount = InterlockedDecrement(&list->refcount);
+    struct wined3d_device *device = list->device;
+    SIZE_T i;
+
+    TRACE("%p decreasing refcount to %u.\n", list, refcount);
+
+    if (!refcount)
+    {
+        wined3d_mutex_lock();
+        for (i = 0; i < list->command_list_count; ++i)
+            wined3d_command_list_decref(list->command_lists[i]);
+        for (i = 0; i < list->resource_count; ++i)
+            wined3d_resource_decref(list->resources[i]);
+
+        wined3d_cs_destroy_object(device->cs, wined3d_command_list_destroy_object, list);
+        wined3d_mutex_unlock();
+    }
+
+    return refcount;
+}
@@ -1155,7 +1155,7 @@ void wined3d_device_uninit_3d(struct wined3d_device *device)
         wined3d_texture_decref(texture);
     }
 
-    wined3d_cs_emit_reset_state(device->cs);
+    wined3d_device_context_emit_reset_state(&device->cs->c, false);
     state_cleanup(state);
 
     wine_rb_clear(&device->samplers, device_free_sampler, NULL);
@@ -1234,15 +1234,7 @@ struct wined3d_buffer * CDECL wined3d_device_get_stream_output(struct wined3d_de
 {
     TRACE("device %p, idx %u, offset %p.\n", device, idx, offset);
 
-    if (idx >= WINED3D_MAX_STREAM_OUTPUT_BUFFERS)
-    {
-        WARN("Invalid stream output %u.\n", idx);
-        return NULL;
-    }
-
-    if (offset)
-        *offset = device->cs->c.state->stream_output[idx].offset;
-    return device->cs->c.state->stream_output[idx].buffer;
+    return wined3d_device_context_get_stream_output(&device->cs->c, idx, offset);
 }
 
 HRESULT CDECL wined3d_device_set_stream_source(struct wined3d_device *device, UINT stream_idx,
@@ -1257,24 +1249,10 @@ HRESULT CDECL wined3d_device_set_stream_source(struct wined3d_device *device, UI
 HRESULT CDECL wined3d_device_get_stream_source(const struct wined3d_device *device,
         UINT stream_idx, struct wined3d_buffer **buffer, UINT *offset, UINT *stride)
 {
-    const struct wined3d_stream_state *stream;
-
     TRACE("device %p, stream_idx %u, buffer %p, offset %p, stride %p.\n",
             device, stream_idx, buffer, offset, stride);
 
-    if (stream_idx >= WINED3D_MAX_STREAMS)
-    {
-        WARN("Stream index %u out of range.\n", stream_idx);
-        return WINED3DERR_INVALIDCALL;
-    }
-
-    stream = &device->cs->c.state->streams[stream_idx];
-    *buffer = stream->buffer;
-    if (offset)
-        *offset = stream->offset;
-    *stride = stream->stride;
-
-    return WINED3D_OK;
+    return wined3d_device_context_get_stream_source(&device->cs->c, stream_idx, buffer, offset, stride);
 }
 
 static void wined3d_device_set_stream_source_freq(struct wined3d_device *device, UINT stream_idx, UINT divider)
@@ -1527,14 +1505,9 @@ void CDECL wined3d_device_set_index_buffer(struct wined3d_device *device,
 struct wined3d_buffer * CDECL wined3d_device_get_index_buffer(const struct wined3d_device *device,
         enum wined3d_format_id *format, unsigned int *offset)
 {
-    const struct wined3d_state *state = device->cs->c.state;
-
     TRACE("device %p, format %p, offset %p.\n", device, format, offset);
 
-    *format = state->index_format;
-    if (offset)
-        *offset = state->index_offset;
-    return state->index_buffer;
+    return wined3d_device_context_get_index_buffer(&device->cs->c, format, offset);
 }
 
 void CDECL wined3d_device_set_base_vertex_index(struct wined3d_device *device, INT base_index)
@@ -1563,16 +1536,9 @@ void CDECL wined3d_device_set_viewports(struct wined3d_device *device, unsigned
 void CDECL wined3d_device_get_viewports(const struct wined3d_device *device, unsigned int *viewport_count,
         struct wined3d_viewport *viewports)
 {
-    const struct wined3d_state *state = device->cs->c.state;
-    unsigned int count;
-
     TRACE("device %p, viewport_count %p, viewports %p.\n", device, viewport_count, viewports);
 
-    count = viewport_count ? min(*viewport_count, state->viewport_count) : 1;
-    if (count && viewports)
-        memcpy(viewports, state->viewports, count * sizeof(*viewports));
-    if (viewport_count)
-        *viewport_count = state->viewport_count;
+    wined3d_device_context_get_viewports(&device->cs->c, viewport_count, viewports);
 }
 
 static void resolve_depth_buffer(struct wined3d_device *device)
@@ -1606,13 +1572,9 @@ void CDECL wined3d_device_set_blend_state(struct wined3d_device *device,
 struct wined3d_blend_state * CDECL wined3d_device_get_blend_state(const struct wined3d_device *device,
         struct wined3d_color *blend_factor, unsigned int *sample_mask)
 {
-    const struct wined3d_state *state = device->cs->c.state;
-
     TRACE("device %p, blend_factor %p, sample_mask %p.\n", device, blend_factor, sample_mask);
 
-    *blend_factor = state->blend_factor;
-    *sample_mask = state->sample_mask;
-    return state->blend_state;
+    return wined3d_device_context_get_blend_state(&device->cs->c, blend_factor, sample_mask);
 }
 
 void CDECL wined3d_device_set_depth_stencil_state(struct wined3d_device *device,
@@ -1626,12 +1588,9 @@ void CDECL wined3d_device_set_depth_stencil_state(struct wined3d_device *device,
 struct wined3d_depth_stencil_state * CDECL wined3d_device_get_depth_stencil_state(const struct wined3d_device *device,
         unsigned int *stencil_ref)
 {
-    const struct wined3d_state *state = device->cs->c.state;
-
     TRACE("device %p, stencil_ref %p.\n", device, stencil_ref);
 
-    *stencil_ref = state->stencil_ref;
-    return state->depth_stencil_state;
+    return wined3d_device_context_get_depth_stencil_state(&device->cs->c, stencil_ref);
 }
 
 void CDECL wined3d_device_set_rasterizer_state(struct wined3d_device *device,
@@ -1646,7 +1605,7 @@ struct wined3d_rasterizer_state * CDECL wined3d_device_get_rasterizer_state(stru
 {
     TRACE("device %p.\n", device);
 
-    return device->cs->c.state->rasterizer_state;
+    return wined3d_device_context_get_rasterizer_state(&device->cs->c);
 }
 
 void CDECL wined3d_device_set_render_state(struct wined3d_device *device,
@@ -1654,19 +1613,7 @@ void CDECL wined3d_device_set_render_state(struct wined3d_device *device,
 {
     TRACE("device %p, state %s (%#x), value %#x.\n", device, debug_d3drenderstate(state), state, value);
 
-    if (state > WINEHIGHEST_RENDER_STATE)
-    {
-        WARN("Unhandled render state %#x.\n", state);
-        return;
-    }
-
-    if (value == device->cs->c.state->render_states[state])
-        TRACE("Application is setting the old value over, nothing to do.\n");
-    else
-    {
-        device->cs->c.state->render_states[state] = value;
-        wined3d_cs_emit_set_render_state(device->cs, state, value);
-    }
+    wined3d_device_context_set_render_state(&device->cs->c, state, value);
 
     if (state == WINED3D_RS_POINTSIZE && value == WINED3D_RESZ_CODE)
     {
@@ -1715,77 +1662,20 @@ void CDECL wined3d_device_set_scissor_rects(struct wined3d_device *device, unsig
 
 void CDECL wined3d_device_get_scissor_rects(const struct wined3d_device *device, unsigned int *rect_count, RECT *rects)
 {
-    const struct wined3d_state *state = device->cs->c.state;
-    unsigned int count;
-
     TRACE("device %p, rect_count %p, rects %p.\n", device, rect_count, rects);
 
-    count = rect_count ? min(*rect_count, state->scissor_rect_count) : 1;
-    if (count && rects)
-        memcpy(rects, state->scissor_rects, count * sizeof(*rects));
-    if (rect_count)
-        *rect_count = state->scissor_rect_count;
+    wined3d_device_context_get_scissor_rects(&device->cs->c, rect_count, rects);
 }
 
 void CDECL wined3d_device_set_state(struct wined3d_device *device, struct wined3d_state *state)
 {
-    struct wined3d_device_context *context = &device->cs->c;
     const struct wined3d_light_info *light;
     unsigned int i, j;
 
     TRACE("device %p, state %p.\n", device, state);
 
-    device->cs->c.state = state;
     wined3d_cs_emit_set_feature_level(device->cs, state->feature_level);
-
-    for (i = 0; i < WINED3D_MAX_RENDER_TARGETS; ++i)
-    {
-        wined3d_device_context_emit_set_rendertarget_view(context, i, state->fb.render_targets[i]);
-    }
-
-    wined3d_device_context_emit_set_depth_stencil_view(context, state->fb.depth_stencil);
-    wined3d_device_context_emit_set_vertex_declaration(context, state->vertex_declaration);
-
-    for (i = 0; i < WINED3D_MAX_STREAM_OUTPUT_BUFFERS; ++i)
-    {
-        wined3d_device_context_emit_set_stream_output(context, i,
-                state->stream_output[i].buffer, state->stream_output[i].offset);
-    }
-
-    for (i = 0; i < WINED3D_MAX_STREAMS; ++i)
-    {
-        wined3d_device_context_emit_set_stream_source(context, i, state->streams[i].buffer,
-                state->streams[i].offset, state->streams[i].stride);
-    }
-
-    wined3d_device_context_emit_set_index_buffer(context, state->index_buffer,
-            state->index_format, state->index_offset);
-
-    wined3d_device_context_emit_set_predication(context, state->predicate, state->predicate_value);
-
-    for (i = 0; i < WINED3D_SHADER_TYPE_COUNT; ++i)
-    {
-        wined3d_device_context_emit_set_shader(context, i, state->shader[i]);
-        for (j = 0; j < MAX_CONSTANT_BUFFERS; ++j)
-            wined3d_device_context_emit_set_constant_buffer(context, i, j, state->cb[i][j]);
-        for (j = 0; j < MAX_SAMPLER_OBJECTS; ++j)
-        {
-            wined3d_device_context_emit_set_sampler(context, i, j, state->sampler[i][j]);
-        }
-        for (j = 0; j < MAX_SHADER_RESOURCE_VIEWS; ++j)
-        {
-            wined3d_device_context_emit_set_shader_resource_view(context, i, j, state->shader_resource_view[i][j]);
-        }
-    }
-
-    for (i = 0; i < WINED3D_PIPELINE_COUNT; ++i)
-    {
-        for (j = 0; j < MAX_UNORDERED_ACCESS_VIEWS; ++j)
-        {
-            wined3d_device_context_emit_set_unordered_access_view(context, i, j,
-                    state->unordered_access_view[i][j], ~0);
-        }
-    }
+    wined3d_device_context_set_state(&device->cs->c, state);
 
     wined3d_cs_push_constants(device->cs, WINED3D_PUSH_CONSTANTS_VS_F,
             0, WINED3D_MAX_VS_CONSTS_F, state->vs_consts_f);
@@ -1830,9 +1720,6 @@ void CDECL wined3d_device_set_state(struct wined3d_device *device, struct wined3
 
     wined3d_cs_emit_set_material(device->cs, &state->material);
 
-    wined3d_device_context_emit_set_viewports(context, state->viewport_count, state->viewports);
-    wined3d_device_context_emit_set_scissor_rects(context, state->scissor_rect_count, state->scissor_rects);
-
     for (i = 0; i < LIGHTMAP_SIZE; ++i)
     {
         LIST_FOR_EACH_ENTRY(light, &state->light_state.light_map[i], struct wined3d_light_info, entry)
@@ -1841,15 +1728,6 @@ void CDECL wined3d_device_set_state(struct wined3d_device *device, struct wined3
             wined3d_cs_emit_set_light_enable(device->cs, light->OriginalIndex, light->glIndex != -1);
         }
     }
-
-    for (i = 0; i < WINEHIGHEST_RENDER_STATE + 1; ++i)
-    {
-        wined3d_cs_emit_set_render_state(device->cs, i, state->render_states[i]);
-    }
-
-    wined3d_device_context_emit_set_blend_state(context, state->blend_state, &state->blend_factor, state->sample_mask);
-    wined3d_device_context_emit_set_depth_stencil_state(context, state->depth_stencil_state, state->stencil_ref);
-    wined3d_device_context_emit_set_rasterizer_state(context, state->rasterizer_state);
 }
 
 struct wined3d_state * CDECL wined3d_device_get_state(struct wined3d_device *device)
@@ -1878,7 +1756,7 @@ struct wined3d_vertex_declaration * CDECL wined3d_device_get_vertex_declaration(
 {
     TRACE("device %p.\n", device);
 
-    return device->cs->c.state->vertex_declaration;
+    return wined3d_device_context_get_vertex_declaration(&device->cs->c);
 }
 
 void CDECL wined3d_device_context_set_shader(struct wined3d_device_context *context,
@@ -2397,6 +2275,370 @@ void CDECL wined3d_device_context_set_stream_output(struct wined3d_device_contex
         wined3d_buffer_decref(prev_buffer);
 }
 
+void CDECL wined3d_device_context_set_render_state(struct wined3d_device_context *context,
+        enum wined3d_render_state state, DWORD value)
+{
+    TRACE("context %p, state %s (%#x), value %#x.\n", context, debug_d3drenderstate(state), state, value);
+
+    if (state > WINEHIGHEST_RENDER_STATE)
+    {
+        WARN("Unhandled render state %#x.\n", state);
+        return;
+    }
+
+    if (value == context->state->render_states[state])
+    {
+        TRACE("Application is setting the old value over, nothing to do.\n");
+        return;
+    }
+
+    context->state->render_states[state] = value;
+    wined3d_device_context_emit_set_render_state(context, state, value);
+}
+
+void CDECL wined3d_device_context_set_primitive_type(struct wined3d_device_context *context,
+        enum wined3d_primitive_type primitive_type, unsigned int patch_vertex_count)
+{
+    struct wined3d_state *state = context->state;
+
+    TRACE("context %p, primitive_type %s, patch_vertex_count %u.\n",
+            context, debug_d3dprimitivetype(primitive_type), patch_vertex_count);
+
+    state->primitive_type = primitive_type;
+    state->patch_vertex_count = patch_vertex_count;
+}
+
+void CDECL wined3d_device_context_set_state(struct wined3d_device_context *context, struct wined3d_state *state)
+{
+    unsigned int i, j;
+
+    TRACE("context %p, state %p.\n", context, state);
+
+    context->state = state;
+
+    for (i = 0; i < WINED3D_MAX_RENDER_TARGETS; ++i)
+    {
+        wined3d_device_context_emit_set_rendertarget_view(context, i, state->fb.render_targets[i]);
+    }
+
+    wined3d_device_context_emit_set_depth_stencil_view(context, state->fb.depth_stencil);
+    wined3d_device_context_emit_set_vertex_declaration(context, state->vertex_declaration);
+
+    for (i = 0; i < WINED3D_MAX_STREAM_OUTPUT_BUFFERS; ++i)
+    {
+        wined3d_device_context_emit_set_stream_output(context, i,
+                state->stream_output[i].buffer, state->stream_output[i].offset);
+    }
+
+    for (i = 0; i < WINED3D_MAX_STREAMS; ++i)
+    {
+        wined3d_device_context_emit_set_stream_source(context, i, state->streams[i].buffer,
+                state->streams[i].offset, state->streams[i].stride);
+    }
+
+    wined3d_device_context_emit_set_index_buffer(context, state->index_buffer,
+            state->index_format, state->index_offset);
+
+    wined3d_device_context_emit_set_predication(context, state->predicate, state->predicate_value);
+
+    for (i = 0; i < WINED3D_SHADER_TYPE_COUNT; ++i)
+    {
+        wined3d_device_context_emit_set_shader(context, i, state->shader[i]);
+        for (j = 0; j < MAX_CONSTANT_BUFFERS; ++j)
+            wined3d_device_context_emit_set_constant_buffer(context, i, j, state->cb[i][j]);
+        for (j = 0; j < MAX_SAMPLER_OBJECTS; ++j)
+        {
+            wined3d_device_context_emit_set_sampler(context, i, j, state->sampler[i][j]);
+        }
+        for (j = 0; j < MAX_SHADER_RESOURCE_VIEWS; ++j)
+        {
+            wined3d_device_context_emit_set_shader_resource_view(context, i, j, state->shader_resource_view[i][j]);
+        }
+    }
+
+    for (i = 0; i < WINED3D_PIPELINE_COUNT; ++i)
+    {
+        for (j = 0; j < MAX_UNORDERED_ACCESS_VIEWS; ++j)
+        {
+            wined3d_device_context_emit_set_unordered_access_view(context, i, j,
+                    state->unordered_access_view[i][j], ~0);
+        }
+    }
+
+    wined3d_device_context_emit_set_viewports(context, state->viewport_count, state->viewports);
+    wined3d_device_context_emit_set_scissor_rects(context, state->scissor_rect_count, state->scissor_rects);
+
+    for (i = 0; i < WINEHIGHEST_RENDER_STATE + 1; ++i)
+    {
+        wined3d_device_context_emit_set_render_state(context, i, state->render_states[i]);
+    }
+
+    wined3d_device_context_emit_set_blend_state(context, state->blend_state, &state->blend_factor, state->sample_mask);
+    wined3d_device_context_emit_set_depth_stencil_state(context, state->depth_stencil_state, state->stencil_ref);
+    wined3d_device_context_emit_set_rasterizer_state(context, state->rasterizer_state);
+}
+
+void CDECL wined3d_device_context_reset_state(struct wined3d_device_context *context)
+{
+    TRACE("context %p.\n", context);
+
+    state_cleanup(context->state);
+    wined3d_state_reset(context->state, &context->device->adapter->d3d_info);
+    wined3d_device_context_emit_reset_state(context, true);
+}
+
+void CDECL wined3d_device_context_execute_command_list(struct wined3d_device_context *context,
+        struct wined3d_command_list *list, bool restore_state)
+{
+    TRACE("context %p, list %p, restore_state %d.\n", context, list, restore_state);
+
+    wined3d_device_context_emit_execute_command_list(context, list);
+
+    /* The command list leaves the command stream with whatever state it
+     * was recorded with; either reapply ours, or clear it. */
+    if (restore_state)
+        wined3d_device_context_set_state(context, context->state);
+    else
+        wined3d_device_context_reset_state(context);
+}
+
+struct wined3d_shader * CDECL wined3d_device_context_get_shader(const struct wined3d_device_context *context,
+        enum wined3d_shader_type type)
+{
+    TRACE("context %p, type %#x.\n", context, type);
+
+    return context->state->shader[type];
+}
+
+struct wined3d_buffer * CDECL wined3d_device_context_get_constant_buffer(const struct wined3d_device_context *context,
+        enum wined3d_shader_type shader_type, unsigned int idx)
+{
+    TRACE("context %p, shader_type %#x, idx %u.\n", context, shader_type, idx);
+
+    if (idx >= MAX_CONSTANT_BUFFERS)
+    {
+        WARN("Invalid constant buffer index %u.\n", idx);
+        return NULL;
+    }
+
+    return context->state->cb[shader_type][idx];
+}
+
+struct wined3d_shader_resource_view * CDECL wined3d_device_context_get_shader_resource_view(
+        const struct wined3d_device_context *context, enum wined3d_shader_type shader_type, unsigned int idx)
+{
+    TRACE("context %p, shader_type %#x, idx %u.\n", context, shader_type, idx);
+
+    if (idx >= MAX_SHADER_RESOURCE_VIEWS)
+    {
+        WARN("Invalid view index %u.\n", idx);
+        return NULL;
+    }
+
+    return context->state->shader_resource_view[shader_type][idx];
+}
+
+struct wined3d_sampler * CDECL wined3d_device_context_get_sampler(const struct wined3d_device_context *context,
+        enum wined3d_shader_type shader_type, unsigned int idx)
+{
+    TRACE("context %p, shader_type %#x, idx %u.\n", context, shader_type, idx);
+
+    if (idx >= MAX_SAMPLER_OBJECTS)
+    {
+        WARN("Invalid sampler index %u.\n", idx);
+        return NULL;
+    }
+
+    return context->state->sampler[shader_type][idx];
+}
+
+struct wined3d_unordered_access_view * CDECL wined3d_device_context_get_unordered_access_view(
+        const struct wined3d_device_context *context, enum wined3d_pipeline pipeline, unsigned int idx)
+{
+    TRACE("context %p, pipeline %#x, idx %u.\n", context, pipeline, idx);
+
+    if (idx >= MAX_UNORDERED_ACCESS_VIEWS)
+    {
+        WARN("Invalid UAV index %u.\n", idx);
+        return NULL;
+    }
+
+    return context->state->unordered_access_view[pipeline][idx];
+}
+
+struct wined3d_blend_state * CDECL wined3d_device_context_get_blend_state(const struct wined3d_device_context *context,
+        struct wined3d_color *blend_factor, unsigned int *sample_mask)
+{
+    const struct wined3d_state *state = context->state;
+
+    TRACE("context %p, blend_factor %p, sample_mask %p.\n", context, blend_factor, sample_mask);
+
+    *blend_factor = state->blend_factor;
+    *sample_mask = state->sample_mask;
+    return state->blend_state;
+}
+
+struct wined3d_depth_stencil_state * CDECL wined3d_device_context_get_depth_stencil_state(
+        const struct wined3d_device_context *context, unsigned int *stencil_ref)
+{
+    const struct wined3d_state *state = context->state;
+
+    TRACE("context %p, stencil_ref %p.\n", context, stencil_ref);
+
+    *stencil_ref = state->stencil_ref;
+    return state->depth_stencil_state;
+}
+
+struct wined3d_rasterizer_state * CDECL wined3d_device_context_get_rasterizer_state(
+        const struct wined3d_device_context *context)
+{
+    TRACE("context %p.\n", context);
+
+    return context->state->rasterizer_state;
+}
+
+void CDECL wined3d_device_context_get_viewports(const struct wined3d_device_context *context,
+        unsigned int *viewport_count, struct wined3d_viewport *viewports)
+{
+    const struct wined3d_state *state = context->state;
+    unsigned int count;
+
+    TRACE("context %p, viewport_count %p, viewports %p.\n", context, viewport_count, viewports);
+
+    count = viewport_count ? min(*viewport_count, state->viewport_count) : 1;
+    if (count && viewports)
+        memcpy(viewports, state->viewports, count * sizeof(*viewports));
+    if (viewport_count)
+        *viewport_count = state->viewport_count;
+}
+
+void CDECL wined3d_device_context_get_scissor_rects(const struct wined3d_device_context *context,
+        unsigned int *rect_count, RECT *rects)
+{
+    const struct wined3d_state *state = context->state;
+    unsigned int count;
+
+    TRACE("context %p, rect_count %p, rects %p.\n", context, rect_count, rects);
+
+    count = rect_count ? min(*rect_count, state->scissor_rect_count) : 1;
+    if (count && rects)
+        memcpy(rects, state->scissor_rects, count * sizeof(*rects));
+    if (rect_count)
+        *rect_count = state->scissor_rect_count;
+}
+
+struct wined3d_rendertarget_view * CDECL wined3d_device_context_get_rendertarget_view(
+        const struct wined3d_device_context *context, unsigned int view_idx)
+{
+    unsigned int max_rt_count;
+
+    TRACE("context %p, view_idx %u.\n", context, view_idx);
+
+    max_rt_count = context->device->adapter->d3d_info.limits.max_rt_count;
+    if (view_idx >= max_rt_count)
+    {
+        WARN("Only %u render targets are supported.\n", max_rt_count);
+        return NULL;
+    }
+
+    return context->state->fb.render_targets[view_idx];
+}
+
+struct wined3d_rendertarget_view * CDECL wined3d_device_context_get_depth_stencil_view(
+        const struct wined3d_device_context *context)
+{
+    TRACE("context %p.\n", context);
+
+    return context->state->fb.depth_stencil;
+}
+
+struct wined3d_query * CDECL wined3d_device_context_get_predication(const struct wined3d_device_context *context,
+        BOOL *value)
+{
+    const struct wined3d_state *state = context->state;
+
+    TRACE("context %p, value %p.\n", context, value);
+
+    if (value)
+        *value = state->predicate_value;
+    return state->predicate;
+}
+
+HRESULT CDECL wined3d_device_context_get_stream_source(const struct wined3d_device_context *context,
+        unsigned int stream_idx, struct wined3d_buffer **buffer, unsigned int *offset, unsigned int *stride)
+{
+    const struct wined3d_stream_state *stream;
+
+    TRACE("context %p, stream_idx %u, buffer %p, offset %p, stride %p.\n",
+            context, stream_idx, buffer, offset, stride);
+
+    if (stream_idx >= WINED3D_MAX_STREAMS)
+    {
+        WARN("Stream index %u out of range.\n", stream_idx);
+        return WINED3DERR_INVALIDCALL;
+    }
+
+    stream = &context->state->streams[stream_idx];
+    *buffer = stream->buffer;
+    if (offset)
+        *offset = stream->offset;
+    *stride = stream->stride;
+
+    return WINED3D_OK;
+}
+
+struct wined3d_buffer * CDECL wined3d_device_context_get_index_buffer(const struct wined3d_device_context *context,
+        enum wined3d_format_id *format, unsigned int *offset)
+{
+    const struct wined3d_state *state = context->state;
+
+    TRACE("context %p, format %p, offset %p.\n", context, format, offset);
+
+    *format = state->index_format;
+    if (offset)
+        *offset = state->index_offset;
+    return state->index_buffer;
+}
+
+struct wined3d_vertex_declaration * CDECL wined3d_device_context_get_vertex_declaration(
+        const struct wined3d_device_context *context)
+{
+    TRACE("context %p.\n", context);
+
+    return context->state->vertex_declaration;
+}
+
+struct wined3d_buffer * CDECL wined3d_device_context_get_stream_output(const struct wined3d_device_context *context,
+        unsigned int idx, unsigned int *offset)
+{
+    TRACE("context %p, idx %u, offset %p.\n", context, idx, offset);
+
+    if (idx >= WINED3D_MAX_STREAM_OUTPUT_BUFFERS)
+    {
+        WARN("Invalid stream output %u.\n", idx);
+        return NULL;
+    }
+
+    if (offset)
+        *offset = context->state->stream_output[idx].offset;
+    return context->state->stream_output[idx].buffer;
+}
+
+void CDECL wined3d_device_context_get_primitive_type(const struct wined3d_device_context *context,
+        enum wined3d_primitive_type *primitive_type, unsigned int *patch_vertex_count)
+{
+    const struct wined3d_state *state = context->state;
+
+    TRACE("context %p, primitive_type %p, patch_vertex_count %p.\n",
+            context, primitive_type, patch_vertex_count);
+
+    *primitive_type = state->primitive_type;
+    if (patch_vertex_count)
+        *patch_vertex_count = state->patch_vertex_count;
+
+    TRACE("Returning %s.\n", debug_d3dprimitivetype(*primitive_type));
+}
+
 void CDECL wined3d_device_context_draw(struct wined3d_device_context *context, unsigned int start_vertex,
         unsigned int vertex_count, unsigned int start_instance, unsigned int instance_count)
 {
@@ -2448,13 +2690,7 @@ struct wined3d_buffer * CDECL wined3d_device_get_constant_buffer(const struct wi
 {
     TRACE("device %p, shader_type %#x, idx %u.\n", device, shader_type, idx);
 
-    if (idx >= MAX_CONSTANT_BUFFERS)
-    {
-        WARN("Invalid constant buffer index %u.\n", idx);
-        return NULL;
-    }
-
-    return device->cs->c.state->cb[shader_type][idx];
+    return wined3d_device_context_get_constant_buffer(&device->cs->c, shader_type, idx);
 }
 
 void CDECL wined3d_device_set_vs_resource_view(struct wined3d_device *device,
@@ -2468,13 +2704,7 @@ void CDECL wined3d_device_set_vs_resource_view(struct wined3d_device *device,
 static struct wined3d_shader_resource_view *wined3d_device_get_shader_resource_view(
         const struct wined3d_device *device, enum wined3d_shader_type shader_type, unsigned int idx)
 {
-    if (idx >= MAX_SHADER_RESOURCE_VIEWS)
-    {
-        WARN("Invalid view index %u.\n", idx);
-        return NULL;
-    }
-
-    return device->cs->c.state->shader_resource_view[shader_type][idx];
+    return wined3d_device_context_get_shader_resource_view(&device->cs->c, shader_type, idx);
 }
 
 struct wined3d_shader_resource_view * CDECL wined3d_device_get_vs_resource_view(const struct wined3d_device *device,
@@ -2495,13 +2725,7 @@ void CDECL wined3d_device_set_vs_sampler(struct wined3d_device *device, UINT idx
 static struct wined3d_sampler *wined3d_device_get_sampler(const struct wined3d_device *device,
         enum wined3d_shader_type shader_type, unsigned int idx)
 {
-    if (idx >= MAX_SAMPLER_OBJECTS)
-    {
-        WARN("Invalid sampler index %u.\n", idx);
-        return NULL;
-    }
-
-    return device->cs->c.state->sampler[shader_type][idx];
+    return wined3d_device_context_get_sampler(&device->cs->c, shader_type, idx);
 }
 
 struct wined3d_sampler * CDECL wined3d_device_get_vs_sampler(const struct wined3d_device *device, UINT idx)
@@ -2845,13 +3069,7 @@ struct wined3d_sampler * CDECL wined3d_device_get_cs_sampler(const struct wined3
 static struct wined3d_unordered_access_view *wined3d_device_get_pipeline_unordered_access_view(
         const struct wined3d_device *device, enum wined3d_pipeline pipeline, unsigned int idx)
 {
-    if (idx >= MAX_UNORDERED_ACCESS_VIEWS)
-    {
-        WARN("Invalid UAV index %u.\n", idx);
-        return NULL;
-    }
-
-    return device->cs->c.state->unordered_access_view[pipeline][idx];
+    return wined3d_device_context_get_unordered_access_view(&device->cs->c, pipeline, idx);
 }
 
 void CDECL wined3d_device_set_cs_uav(struct wined3d_device *device, unsigned int idx,
@@ -4410,13 +4628,9 @@ void CDECL wined3d_device_set_predication(struct wined3d_device *device,
 
 struct wined3d_query * CDECL wined3d_device_get_predication(struct wined3d_device *device, BOOL *value)
 {
-    struct wined3d_state *state = device->cs->c.state;
-
     TRACE("device %p, value %p.\n", device, value);
 
-    if (value)
-        *value = state->predicate_value;
-    return state->predicate;
+    return wined3d_device_context_get_predication(&device->cs->c, value);
 }
 
 void CDECL wined3d_device_dispatch_compute(struct wined3d_device *device,
@@ -4439,28 +4653,19 @@ void CDECL wined3d_device_dispatch_compute_indirect(struct wined3d_device *devic
 void CDECL wined3d_device_set_primitive_type(struct wined3d_device *device,
         enum wined3d_primitive_type primitive_type, unsigned int patch_vertex_count)
 {
-    struct wined3d_state *state = device->cs->c.state;
-
     TRACE("device %p, primitive_type %s, patch_vertex_count %u.\n",
             device, debug_d3dprimitivetype(primitive_type), patch_vertex_count);
 
-    state->primitive_type = primitive_type;
-    state->patch_vertex_count = patch_vertex_count;
+    wined3d_device_context_set_primitive_type(&device->cs->c, primitive_type, patch_vertex_count);
 }
 
 void CDECL wined3d_device_get_primitive_type(const struct wined3d_device *device,
         enum wined3d_primitive_type *primitive_type, unsigned int *patch_vertex_count)
 {
-    const struct wined3d_state *state = device->cs->c.state;
-
     TRACE("device %p, primitive_type %p, patch_vertex_count %p.\n",
             device, primitive_type, patch_vertex_count);
 
-    *primitive_type = state->primitive_type;
-    if (patch_vertex_count)
-        *patch_vertex_count = state->patch_vertex_count;
-
-    TRACE("Returning %s.\n", debug_d3dprimitivetype(*primitive_type));
+    wined3d_device_context_get_primitive_type(&device->cs->c, primitive_type, patch_vertex_count);
 }
 
 HRESULT CDECL wined3d_device_draw_primitive(struct wined3d_device *device, UINT start_vertex, UINT vertex_count)
@@ -5085,6 +5290,24 @@ HRESULT CDECL wined3d_device_context_copy_sub_resource_region(struct wined3d_dev
     return WINED3D_OK;
 }
 
+HRESULT CDECL wined3d_device_context_map(struct wined3d_device_context *context,
+        struct wined3d_resource *resource, unsigned int sub_resource_idx,
+        struct wined3d_map_desc *map_desc, const struct wined3d_box *box, unsigned int flags)
+{
+    TRACE("context %p, resource %p, sub_resource_idx %u, map_desc %p, box %s, flags %#x.\n",
+            context, resource, sub_resource_idx, map_desc, debug_box(box), flags);
+
+    return context->ops->map(context, resource, sub_resource_idx, map_desc, box, flags);
+}
+
+HRESULT CDECL wined3d_device_context_unmap(struct wined3d_device_context *context,
+        struct wined3d_resource *resource, unsigned int sub_resource_idx)
+{
+    TRACE("context %p, resource %p, sub_resource_idx %u.\n", context, resource, sub_resource_idx);
+
+    return context->ops->unmap(context, resource, sub_resource_idx);
+}
+
 void CDECL wined3d_device_context_update_sub_resource(struct wined3d_device_context *context,
         struct wined3d_resource *resource, unsigned int sub_resource_idx, const struct wined3d_box *box,
         const void *data, unsigned int row_pitch, unsigned int depth_pitch, unsigned int flags)
@@ -5146,8 +5369,6 @@ void CDECL wined3d_device_context_update_sub_resource(struct wined3d_device_cont
         return;
     }
 
-    wined3d_resource_wait_idle(resource);
-
     wined3d_device_context_emit_update_sub_resource(context, resource,
             sub_resource_idx, box, data, row_pitch, depth_pitch);
 }
@@ -5253,25 +5474,16 @@ void CDECL wined3d_device_context_clear_uav_uint(struct wined3d_device_context *
 struct wined3d_rendertarget_view * CDECL wined3d_device_get_rendertarget_view(const struct wined3d_device *device,
         unsigned int view_idx)
 {
-    unsigned int max_rt_count;
-
     TRACE("device %p, view_idx %u.\n", device, view_idx);
 
-    max_rt_count = device->adapter->d3d_info.limits.max_rt_count;
-    if (view_idx >= max_rt_count)
-    {
-        WARN("Only %u render targets are supported.\n", max_rt_count);
-        return NULL;
-    }
-
-    return device->cs->c.state->fb.render_targets[view_idx];
+    return wined3d_device_context_get_rendertarget_view(&device->cs->c, view_idx);
 }
 
 struct wined3d_rendertarget_view * CDECL wined3d_device_get_depth_stencil_view(const struct wined3d_device *device)
 {
     TRACE("device %p.\n", device);
 
-    return device->cs->c.state->fb.depth_stencil;
+    return wined3d_device_context_get_depth_stencil_view(&device->cs->c);
 }
 
 HRESULT CDECL wined3d_device_set_rendertarget_view(struct wined3d_device *device,
@@ -5803,7 +6015,7 @@ HRESULT CDECL wined3d_device_reset(struct wined3d_device *device,
     if (reset_state)
     {
         TRACE("Resetting state.\n");
-        wined3d_cs_emit_reset_state(device->cs);
+        wined3d_device_context_emit_reset_state(&device->cs->c, false);
         state_cleanup(state);
 
         LIST_FOR_EACH_ENTRY_SAFE(resource, cursor, &device->resources, struct wined3d_resource, resource_list_entry)
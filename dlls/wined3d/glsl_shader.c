@@ -141,6 +141,8 @@ struct shader_glsl_priv
     struct wine_rb_tree ffp_fragment_shaders;
     BOOL ffp_proj_control;
     BOOL legacy_lighting;
+
+    struct wined3d_shader_cache *cache;
 };
 
 struct glsl_vs_program
@@ -255,7 +257,9 @@ struct glsl_shader_prog_link
     unsigned int constant_version;
     DWORD shader_controlled_clip_distances : 1;
     DWORD clip_distance_mask : 8; /* WINED3D_MAX_CLIP_DISTANCES, 8 */
-    DWORD padding : 23;
+    DWORD link_pending : 1;
+    DWORD padding : 22;
+    struct wined3d_shader *link_shaders[WINED3D_SHADER_TYPE_GRAPHICS_COUNT];
 };
 
 struct glsl_program_key
@@ -8493,13 +8497,66 @@ static GLuint shader_glsl_generate_compute_shader(const struct wined3d_context_g
     return shader_id;
 }
 
+static void shader_glsl_get_cache_key(const struct shader_glsl_priv *priv, struct wined3d_shader_cache_key *key,
+        const struct wined3d_shader *shader, const void *args, size_t args_size)
+{
+    if (!priv->cache)
+        return;
+
+    wined3d_shader_cache_key_init(key);
+    wined3d_shader_cache_key_update_shader(key, shader);
+    wined3d_shader_cache_key_update(key, args, args_size);
+}
+
+/* Cache entries consist of "extra_size" bytes of backend data, followed by
+ * the null-terminated GLSL source.
+ *
+ * Context activation is done by the caller. */
+static BOOL shader_glsl_compile_from_cache(const struct wined3d_gl_info *gl_info, struct shader_glsl_priv *priv,
+        const struct wined3d_shader_cache_key *key, GLenum shader_type, void *extra, SIZE_T extra_size,
+        GLuint *shader_id)
+{
+    const char *data;
+    SIZE_T size;
+
+    if (!priv->cache || !(data = wined3d_shader_cache_get(priv->cache, key, &size)))
+        return FALSE;
+
+    if (size <= extra_size || data[size - 1])
+    {
+        WARN("Ignoring invalid shader cache entry.\n");
+        return FALSE;
+    }
+
+    memcpy(extra, data, extra_size);
+
+    *shader_id = GL_EXTCALL(glCreateShader(shader_type));
+    TRACE("Compiling cached shader object %u.\n", *shader_id);
+    shader_glsl_compile(gl_info, *shader_id, data + extra_size);
+
+    return TRUE;
+}
+
+static void shader_glsl_store_in_cache(struct shader_glsl_priv *priv, const struct wined3d_shader_cache_key *key,
+        const void *extra, SIZE_T extra_size)
+{
+    const struct wined3d_string_buffer *buffer = &priv->shader_buffer;
+    char *data;
+
+    if (!priv->cache || !(data = wined3d_shader_cache_put(priv->cache, key, extra_size + buffer->content_size + 1)))
+        return;
+
+    memcpy(data, extra, extra_size);
+    memcpy(data + extra_size, buffer->buffer, buffer->content_size + 1);
+}
+
 static GLuint find_glsl_fragment_shader(const struct wined3d_context_gl *context_gl,
-        struct wined3d_string_buffer *buffer, struct wined3d_string_buffer_list *string_buffers,
-        struct wined3d_shader *shader,
+        struct shader_glsl_priv *priv, struct wined3d_shader *shader,
         const struct ps_compile_args *args, const struct ps_np2fixup_info **np2fixup_info)
 {
     struct glsl_ps_compiled_shader *gl_shaders, *new_array;
     struct glsl_shader_private *shader_data;
+    struct wined3d_shader_cache_key key;
     struct ps_np2fixup_info *np2fixup;
     UINT i;
     DWORD new_size;
@@ -8559,8 +8616,15 @@ static GLuint find_glsl_fragment_shader(const struct wined3d_context_gl *context
     memset(np2fixup, 0, sizeof(*np2fixup));
     *np2fixup_info = args->np2_fixup ? np2fixup : NULL;
 
-    string_buffer_clear(buffer);
-    ret = shader_glsl_generate_fragment_shader(context_gl, buffer, string_buffers, shader, args, np2fixup);
+    shader_glsl_get_cache_key(priv, &key, shader, args, sizeof(*args));
+    if (!shader_glsl_compile_from_cache(context_gl->gl_info, priv, &key,
+            GL_FRAGMENT_SHADER, np2fixup, sizeof(*np2fixup), &ret))
+    {
+        string_buffer_clear(&priv->shader_buffer);
+        ret = shader_glsl_generate_fragment_shader(context_gl, &priv->shader_buffer,
+                &priv->string_buffers, shader, args, np2fixup);
+        shader_glsl_store_in_cache(priv, &key, np2fixup, sizeof(*np2fixup));
+    }
     gl_shaders[shader_data->num_gl_shaders++].id = ret;
 
     return ret;
@@ -8594,6 +8658,7 @@ static GLuint find_glsl_vertex_shader(const struct wined3d_context_gl *context_g
     struct glsl_vs_compiled_shader *gl_shaders, *new_array;
     uint32_t use_map = context_gl->c.stream_info.use_map;
     struct glsl_shader_private *shader_data;
+    struct wined3d_shader_cache_key key;
     unsigned int i, new_size;
     GLuint ret;
 
@@ -8644,8 +8709,13 @@ static GLuint find_glsl_vertex_shader(const struct wined3d_context_gl *context_g
 
     gl_shaders[shader_data->num_gl_shaders].args = *args;
 
-    string_buffer_clear(&priv->shader_buffer);
-    ret = shader_glsl_generate_vertex_shader(context_gl, priv, shader, args);
+    shader_glsl_get_cache_key(priv, &key, shader, args, sizeof(*args));
+    if (!shader_glsl_compile_from_cache(context_gl->gl_info, priv, &key, GL_VERTEX_SHADER, NULL, 0, &ret))
+    {
+        string_buffer_clear(&priv->shader_buffer);
+        ret = shader_glsl_generate_vertex_shader(context_gl, priv, shader, args);
+        shader_glsl_store_in_cache(priv, &key, NULL, 0);
+    }
     gl_shaders[shader_data->num_gl_shaders++].id = ret;
 
     return ret;
@@ -8656,6 +8726,7 @@ static GLuint find_glsl_hull_shader(const struct wined3d_context_gl *context_gl,
 {
     struct glsl_hs_compiled_shader *gl_shaders, *new_array;
     struct glsl_shader_private *shader_data;
+    struct wined3d_shader_cache_key key;
     unsigned int new_size;
     GLuint ret;
 
@@ -8689,8 +8760,13 @@ static GLuint find_glsl_hull_shader(const struct wined3d_context_gl *context_gl,
     shader_data->shader_array_size = new_size;
     gl_shaders = new_array;
 
-    string_buffer_clear(&priv->shader_buffer);
-    ret = shader_glsl_generate_hull_shader(context_gl, priv, shader);
+    shader_glsl_get_cache_key(priv, &key, shader, NULL, 0);
+    if (!shader_glsl_compile_from_cache(context_gl->gl_info, priv, &key, GL_TESS_CONTROL_SHADER, NULL, 0, &ret))
+    {
+        string_buffer_clear(&priv->shader_buffer);
+        ret = shader_glsl_generate_hull_shader(context_gl, priv, shader);
+        shader_glsl_store_in_cache(priv, &key, NULL, 0);
+    }
     gl_shaders[shader_data->num_gl_shaders++].id = ret;
 
     return ret;
@@ -8701,6 +8777,7 @@ static GLuint find_glsl_domain_shader(const struct wined3d_context_gl *context_g
 {
     struct glsl_ds_compiled_shader *gl_shaders, *new_array;
     struct glsl_shader_private *shader_data;
+    struct wined3d_shader_cache_key key;
     unsigned int i, new_size;
     GLuint ret;
 
@@ -8743,8 +8820,13 @@ static GLuint find_glsl_domain_shader(const struct wined3d_context_gl *context_g
     shader_data->shader_array_size = new_size;
     gl_shaders = new_array;
 
-    string_buffer_clear(&priv->shader_buffer);
-    ret = shader_glsl_generate_domain_shader(context_gl, priv, shader, args);
+    shader_glsl_get_cache_key(priv, &key, shader, args, sizeof(*args));
+    if (!shader_glsl_compile_from_cache(context_gl->gl_info, priv, &key, GL_TESS_EVALUATION_SHADER, NULL, 0, &ret))
+    {
+        string_buffer_clear(&priv->shader_buffer);
+        ret = shader_glsl_generate_domain_shader(context_gl, priv, shader, args);
+        shader_glsl_store_in_cache(priv, &key, NULL, 0);
+    }
     gl_shaders[shader_data->num_gl_shaders].args = *args;
     gl_shaders[shader_data->num_gl_shaders++].id = ret;
 
@@ -8756,6 +8838,7 @@ static GLuint find_glsl_geometry_shader(const struct wined3d_context_gl *context
 {
     struct glsl_gs_compiled_shader *gl_shaders, *new_array;
     struct glsl_shader_private *shader_data;
+    struct wined3d_shader_cache_key key;
     unsigned int i, new_size;
     GLuint ret;
 
@@ -8798,8 +8881,13 @@ static GLuint find_glsl_geometry_shader(const struct wined3d_context_gl *context
     shader_data->shader_array_size = new_size;
     gl_shaders = new_array;
 
-    string_buffer_clear(&priv->shader_buffer);
-    ret = shader_glsl_generate_geometry_shader(context_gl, priv, shader, args);
+    shader_glsl_get_cache_key(priv, &key, shader, args, sizeof(*args));
+    if (!shader_glsl_compile_from_cache(context_gl->gl_info, priv, &key, GL_GEOMETRY_SHADER, NULL, 0, &ret))
+    {
+        string_buffer_clear(&priv->shader_buffer);
+        ret = shader_glsl_generate_geometry_shader(context_gl, priv, shader, args);
+        shader_glsl_store_in_cache(priv, &key, NULL, 0);
+    }
     gl_shaders[shader_data->num_gl_shaders].args = *args;
     gl_shaders[shader_data->num_gl_shaders++].id = ret;
 
@@ -10090,6 +10178,7 @@ static HRESULT shader_glsl_compile_compute_shader(struct shader_glsl_priv *priv,
     struct glsl_cs_compiled_shader *gl_shaders;
     struct glsl_shader_private *shader_data;
     struct glsl_shader_prog_link *entry;
+    struct wined3d_shader_cache_key key;
     GLuint shader_id, program_id;
 
     if (!(entry = heap_alloc(sizeof(*entry))))
@@ -10119,8 +10208,13 @@ static HRESULT shader_glsl_compile_compute_shader(struct shader_glsl_priv *priv,
 
     TRACE("Compiling compute shader %p.\n", shader);
 
-    string_buffer_clear(buffer);
-    shader_id = shader_glsl_generate_compute_shader(context_gl, buffer, &priv->string_buffers, shader);
+    shader_glsl_get_cache_key(priv, &key, shader, NULL, 0);
+    if (!shader_glsl_compile_from_cache(gl_info, priv, &key, GL_COMPUTE_SHADER, NULL, 0, &shader_id))
+    {
+        string_buffer_clear(buffer);
+        shader_id = shader_glsl_generate_compute_shader(context_gl, buffer, &priv->string_buffers, shader);
+        shader_glsl_store_in_cache(priv, &key, NULL, 0);
+    }
     gl_shaders[shader_data->num_gl_shaders++].id = shader_id;
 
     program_id = GL_EXTCALL(glCreateProgram());
@@ -10135,6 +10229,7 @@ static HRESULT shader_glsl_compile_compute_shader(struct shader_glsl_priv *priv,
     entry->cs.id = shader_id;
     entry->constant_version = 0;
     entry->shader_controlled_clip_distances = 0;
+    entry->link_pending = 0;
     entry->ps.np2_fixup_info = NULL;
     add_glsl_program_entry(priv, entry);
 
@@ -10205,13 +10300,181 @@ static void set_glsl_compute_shader_program(const struct wined3d_context_gl *con
     ctx_data->glsl_program = entry;
 }
 
+/* Context activation is done by the caller. */
+static void shader_glsl_init_program(const struct wined3d_context_gl *context_gl,
+        struct shader_glsl_priv *priv, struct glsl_shader_prog_link *entry)
+{
+    struct wined3d_shader *vshader = entry->link_shaders[WINED3D_SHADER_TYPE_VERTEX];
+    struct wined3d_shader *hshader = entry->link_shaders[WINED3D_SHADER_TYPE_HULL];
+    struct wined3d_shader *dshader = entry->link_shaders[WINED3D_SHADER_TYPE_DOMAIN];
+    struct wined3d_shader *gshader = entry->link_shaders[WINED3D_SHADER_TYPE_GEOMETRY];
+    struct wined3d_shader *pshader = entry->link_shaders[WINED3D_SHADER_TYPE_PIXEL];
+    const struct wined3d_gl_info *gl_info = context_gl->gl_info;
+    const struct wined3d_shader *pre_rasterization_shader;
+    GLuint program_id = entry->id;
+    unsigned int i;
+
+    entry->link_pending = 0;
+    shader_glsl_validate_link(gl_info, program_id);
+
+    shader_glsl_init_vs_uniform_locations(gl_info, priv, program_id, &entry->vs,
+            vshader ? vshader->limits->constant_float : 0);
+    shader_glsl_init_ds_uniform_locations(gl_info, priv, program_id, &entry->ds);
+    shader_glsl_init_gs_uniform_locations(gl_info, priv, program_id, &entry->gs);
+    shader_glsl_init_ps_uniform_locations(gl_info, priv, program_id, &entry->ps,
+            pshader ? pshader->limits->constant_float : 0);
+    checkGLcall("find glsl program uniform locations");
+
+    pre_rasterization_shader = gshader ? gshader : dshader ? dshader : vshader;
+    if (pre_rasterization_shader && pre_rasterization_shader->reg_maps.shader_version.major >= 4)
+    {
+        unsigned int clip_distance_count = wined3d_popcount(pre_rasterization_shader->reg_maps.clip_distance_mask);
+        entry->shader_controlled_clip_distances = 1;
+        entry->clip_distance_mask = (1u << clip_distance_count) - 1;
+    }
+
+    if (needs_legacy_glsl_syntax(gl_info))
+    {
+        if (pshader && pshader->reg_maps.shader_version.major >= 3
+                && pshader->u.ps.declared_in_count > vec4_varyings(3, gl_info))
+        {
+            TRACE("Shader %d needs vertex color clamping disabled.\n", program_id);
+            entry->vs.vertex_color_clamp = GL_FALSE;
+        }
+        else
+        {
+            entry->vs.vertex_color_clamp = GL_FIXED_ONLY_ARB;
+        }
+    }
+    else
+    {
+        /* With core profile we never change vertex_color_clamp from
+         * GL_FIXED_ONLY_MODE (which is also the initial value) so we never call
+         * glClampColorARB(). */
+        entry->vs.vertex_color_clamp = GL_FIXED_ONLY_ARB;
+    }
+
+    /* Set the shader to allow uniform loading on it */
+    GL_EXTCALL(glUseProgram(program_id));
+    checkGLcall("glUseProgram");
+
+    entry->constant_update_mask = 0;
+    if (vshader)
+    {
+        entry->constant_update_mask |= WINED3D_SHADER_CONST_VS_F;
+        if (vshader->reg_maps.integer_constants)
+            entry->constant_update_mask |= WINED3D_SHADER_CONST_VS_I;
+        if (vshader->reg_maps.boolean_constants)
+            entry->constant_update_mask |= WINED3D_SHADER_CONST_VS_B;
+        if (entry->vs.pos_fixup_location != -1)
+            entry->constant_update_mask |= WINED3D_SHADER_CONST_POS_FIXUP;
+        if (entry->vs.base_vertex_id_location != -1)
+            entry->constant_update_mask |= WINED3D_SHADER_CONST_BASE_VERTEX_ID;
+
+        shader_glsl_load_program_resources(context_gl, priv, program_id, vshader);
+    }
+    else
+    {
+        entry->constant_update_mask |= WINED3D_SHADER_CONST_FFP_MODELVIEW
+                | WINED3D_SHADER_CONST_FFP_PROJ;
+
+        for (i = 1; i < MAX_VERTEX_BLENDS; ++i)
+        {
+            if (entry->vs.modelview_matrix_location[i] != -1)
+            {
+                entry->constant_update_mask |= WINED3D_SHADER_CONST_FFP_VERTEXBLEND;
+                break;
+            }
+        }
+
+        for (i = 0; i < WINED3D_MAX_TEXTURES; ++i)
+        {
+            if (entry->vs.texture_matrix_location[i] != -1)
+            {
+                entry->constant_update_mask |= WINED3D_SHADER_CONST_FFP_TEXMATRIX;
+                break;
+            }
+        }
+        if (entry->vs.material_ambient_location != -1 || entry->vs.material_diffuse_location != -1
+                || entry->vs.material_specular_location != -1
+                || entry->vs.material_emissive_location != -1
+                || entry->vs.material_shininess_location != -1)
+            entry->constant_update_mask |= WINED3D_SHADER_CONST_FFP_MATERIAL;
+        if (entry->vs.light_ambient_location != -1)
+            entry->constant_update_mask |= WINED3D_SHADER_CONST_FFP_LIGHTS;
+    }
+    if (entry->vs.clip_planes_location != -1)
+        entry->constant_update_mask |= WINED3D_SHADER_CONST_VS_CLIP_PLANES;
+    if (entry->vs.pointsize_min_location != -1)
+        entry->constant_update_mask |= WINED3D_SHADER_CONST_VS_POINTSIZE;
+
+    if (hshader)
+        shader_glsl_load_program_resources(context_gl, priv, program_id, hshader);
+
+    if (dshader)
+    {
+        if (entry->ds.pos_fixup_location != -1)
+            entry->constant_update_mask |= WINED3D_SHADER_CONST_POS_FIXUP;
+
+        shader_glsl_load_program_resources(context_gl, priv, program_id, dshader);
+    }
+
+    if (gshader)
+    {
+        if (entry->gs.pos_fixup_location != -1)
+            entry->constant_update_mask |= WINED3D_SHADER_CONST_POS_FIXUP;
+
+        shader_glsl_load_program_resources(context_gl, priv, program_id, gshader);
+    }
+
+    if (entry->ps.id)
+    {
+        if (pshader)
+        {
+            entry->constant_update_mask |= WINED3D_SHADER_CONST_PS_F;
+            if (pshader->reg_maps.integer_constants)
+                entry->constant_update_mask |= WINED3D_SHADER_CONST_PS_I;
+            if (pshader->reg_maps.boolean_constants)
+                entry->constant_update_mask |= WINED3D_SHADER_CONST_PS_B;
+            if (entry->ps.ycorrection_location != -1)
+                entry->constant_update_mask |= WINED3D_SHADER_CONST_PS_Y_CORR;
+
+            shader_glsl_load_program_resources(context_gl, priv, program_id, pshader);
+            shader_glsl_load_images(gl_info, priv, program_id, &pshader->reg_maps);
+        }
+        else
+        {
+            entry->constant_update_mask |= WINED3D_SHADER_CONST_FFP_PS;
+
+            shader_glsl_load_samplers(&context_gl->c, priv, program_id, NULL);
+        }
+
+        for (i = 0; i < WINED3D_MAX_TEXTURES; ++i)
+        {
+            if (entry->ps.bumpenv_mat_location[i] != -1)
+            {
+                entry->constant_update_mask |= WINED3D_SHADER_CONST_PS_BUMP_ENV;
+                break;
+            }
+        }
+
+        if (entry->ps.fog_color_location != -1)
+            entry->constant_update_mask |= WINED3D_SHADER_CONST_PS_FOG;
+        if (entry->ps.alpha_test_ref_location != -1)
+            entry->constant_update_mask |= WINED3D_SHADER_CONST_PS_ALPHA_TEST;
+        if (entry->ps.np2_fixup_location != -1)
+            entry->constant_update_mask |= WINED3D_SHADER_CONST_PS_NP2_FIXUP;
+        if (entry->ps.color_key_location != -1)
+            entry->constant_update_mask |= WINED3D_SHADER_CONST_FFP_COLOR_KEY;
+    }
+}
+
 /* Context activation is done by the caller. */
 static void set_glsl_shader_program(const struct wined3d_context_gl *context_gl, const struct wined3d_state *state,
         struct shader_glsl_priv *priv, struct glsl_context_data *ctx_data)
 {
     const struct wined3d_d3d_info *d3d_info = context_gl->c.d3d_info;
     const struct wined3d_gl_info *gl_info = context_gl->gl_info;
-    const struct wined3d_shader *pre_rasterization_shader;
     const struct ps_np2fixup_info *np2fixup_info = NULL;
     struct wined3d_shader *hshader, *dshader, *gshader;
     struct glsl_shader_prog_link *entry = NULL;
@@ -10311,8 +10574,7 @@ static void set_glsl_shader_program(const struct wined3d_context_gl *context_gl,
         pshader = state->shader[WINED3D_SHADER_TYPE_PIXEL];
         find_ps_compile_args(state, pshader, context_gl->c.stream_info.position_transformed,
                 &ps_compile_args, &context_gl->c);
-        ps_id = find_glsl_fragment_shader(context_gl, &priv->shader_buffer, &priv->string_buffers,
-                pshader, &ps_compile_args, &np2fixup_info);
+        ps_id = find_glsl_fragment_shader(context_gl, priv, pshader, &ps_compile_args, &np2fixup_info);
         ps_list = &pshader->linked_programs;
     }
     else if (priv->fragment_pipe == &glsl_fragment_pipe
@@ -10354,6 +10616,7 @@ static void set_glsl_shader_program(const struct wined3d_context_gl *context_gl,
     entry->cs.id = 0;
     entry->constant_version = 0;
     entry->shader_controlled_clip_distances = 0;
+    entry->link_pending = 0;
     entry->ps.np2_fixup_info = np2fixup_info;
     /* Add the hash table entry */
     add_glsl_program_entry(priv, entry);
@@ -10479,158 +10742,23 @@ static void set_glsl_shader_program(const struct wined3d_context_gl *context_gl,
     /* Link the program */
     TRACE("Linking GLSL shader program %u.\n", program_id);
     GL_EXTCALL(glLinkProgram(program_id));
-    shader_glsl_validate_link(gl_info, program_id);
-
-    shader_glsl_init_vs_uniform_locations(gl_info, priv, program_id, &entry->vs,
-            vshader ? vshader->limits->constant_float : 0);
-    shader_glsl_init_ds_uniform_locations(gl_info, priv, program_id, &entry->ds);
-    shader_glsl_init_gs_uniform_locations(gl_info, priv, program_id, &entry->gs);
-    shader_glsl_init_ps_uniform_locations(gl_info, priv, program_id, &entry->ps,
-            pshader ? pshader->limits->constant_float : 0);
-    checkGLcall("find glsl program uniform locations");
 
-    pre_rasterization_shader = gshader ? gshader : dshader ? dshader : vshader;
-    if (pre_rasterization_shader && pre_rasterization_shader->reg_maps.shader_version.major >= 4)
-    {
-        unsigned int clip_distance_count = wined3d_popcount(pre_rasterization_shader->reg_maps.clip_distance_mask);
-        entry->shader_controlled_clip_distances = 1;
-        entry->clip_distance_mask = (1u << clip_distance_count) - 1;
-    }
+    entry->link_shaders[WINED3D_SHADER_TYPE_VERTEX] = vshader;
+    entry->link_shaders[WINED3D_SHADER_TYPE_HULL] = hshader;
+    entry->link_shaders[WINED3D_SHADER_TYPE_DOMAIN] = dshader;
+    entry->link_shaders[WINED3D_SHADER_TYPE_GEOMETRY] = gshader;
+    entry->link_shaders[WINED3D_SHADER_TYPE_PIXEL] = pshader;
 
-    if (needs_legacy_glsl_syntax(gl_info))
+    /* With parallel shader compilation the driver links the program on its
+     * own threads. Querying uniform locations would wait for it, so finish
+     * setting up the program in shader_glsl_select() once the link is done. */
+    if (wined3d_settings.async_shader_compile && gl_info->supported[ARB_PARALLEL_SHADER_COMPILE])
     {
-        if (pshader && pshader->reg_maps.shader_version.major >= 3
-                && pshader->u.ps.declared_in_count > vec4_varyings(3, gl_info))
-        {
-            TRACE("Shader %d needs vertex color clamping disabled.\n", program_id);
-            entry->vs.vertex_color_clamp = GL_FALSE;
-        }
-        else
-        {
-            entry->vs.vertex_color_clamp = GL_FIXED_ONLY_ARB;
-        }
-    }
-    else
-    {
-        /* With core profile we never change vertex_color_clamp from
-         * GL_FIXED_ONLY_MODE (which is also the initial value) so we never call
-         * glClampColorARB(). */
-        entry->vs.vertex_color_clamp = GL_FIXED_ONLY_ARB;
-    }
-
-    /* Set the shader to allow uniform loading on it */
-    GL_EXTCALL(glUseProgram(program_id));
-    checkGLcall("glUseProgram");
-
-    entry->constant_update_mask = 0;
-    if (vshader)
-    {
-        entry->constant_update_mask |= WINED3D_SHADER_CONST_VS_F;
-        if (vshader->reg_maps.integer_constants)
-            entry->constant_update_mask |= WINED3D_SHADER_CONST_VS_I;
-        if (vshader->reg_maps.boolean_constants)
-            entry->constant_update_mask |= WINED3D_SHADER_CONST_VS_B;
-        if (entry->vs.pos_fixup_location != -1)
-            entry->constant_update_mask |= WINED3D_SHADER_CONST_POS_FIXUP;
-        if (entry->vs.base_vertex_id_location != -1)
-            entry->constant_update_mask |= WINED3D_SHADER_CONST_BASE_VERTEX_ID;
-
-        shader_glsl_load_program_resources(context_gl, priv, program_id, vshader);
-    }
-    else
-    {
-        entry->constant_update_mask |= WINED3D_SHADER_CONST_FFP_MODELVIEW
-                | WINED3D_SHADER_CONST_FFP_PROJ;
-
-        for (i = 1; i < MAX_VERTEX_BLENDS; ++i)
-        {
-            if (entry->vs.modelview_matrix_location[i] != -1)
-            {
-                entry->constant_update_mask |= WINED3D_SHADER_CONST_FFP_VERTEXBLEND;
-                break;
-            }
-        }
-
-        for (i = 0; i < WINED3D_MAX_TEXTURES; ++i)
-        {
-            if (entry->vs.texture_matrix_location[i] != -1)
-            {
-                entry->constant_update_mask |= WINED3D_SHADER_CONST_FFP_TEXMATRIX;
-                break;
-            }
-        }
-        if (entry->vs.material_ambient_location != -1 || entry->vs.material_diffuse_location != -1
-                || entry->vs.material_specular_location != -1
-                || entry->vs.material_emissive_location != -1
-                || entry->vs.material_shininess_location != -1)
-            entry->constant_update_mask |= WINED3D_SHADER_CONST_FFP_MATERIAL;
-        if (entry->vs.light_ambient_location != -1)
-            entry->constant_update_mask |= WINED3D_SHADER_CONST_FFP_LIGHTS;
-    }
-    if (entry->vs.clip_planes_location != -1)
-        entry->constant_update_mask |= WINED3D_SHADER_CONST_VS_CLIP_PLANES;
-    if (entry->vs.pointsize_min_location != -1)
-        entry->constant_update_mask |= WINED3D_SHADER_CONST_VS_POINTSIZE;
-
-    if (hshader)
-        shader_glsl_load_program_resources(context_gl, priv, program_id, hshader);
-
-    if (dshader)
-    {
-        if (entry->ds.pos_fixup_location != -1)
-            entry->constant_update_mask |= WINED3D_SHADER_CONST_POS_FIXUP;
-
-        shader_glsl_load_program_resources(context_gl, priv, program_id, dshader);
-    }
-
-    if (gshader)
-    {
-        if (entry->gs.pos_fixup_location != -1)
-            entry->constant_update_mask |= WINED3D_SHADER_CONST_POS_FIXUP;
-
-        shader_glsl_load_program_resources(context_gl, priv, program_id, gshader);
+        entry->link_pending = 1;
+        return;
     }
 
-    if (ps_id)
-    {
-        if (pshader)
-        {
-            entry->constant_update_mask |= WINED3D_SHADER_CONST_PS_F;
-            if (pshader->reg_maps.integer_constants)
-                entry->constant_update_mask |= WINED3D_SHADER_CONST_PS_I;
-            if (pshader->reg_maps.boolean_constants)
-                entry->constant_update_mask |= WINED3D_SHADER_CONST_PS_B;
-            if (entry->ps.ycorrection_location != -1)
-                entry->constant_update_mask |= WINED3D_SHADER_CONST_PS_Y_CORR;
-
-            shader_glsl_load_program_resources(context_gl, priv, program_id, pshader);
-            shader_glsl_load_images(gl_info, priv, program_id, &pshader->reg_maps);
-        }
-        else
-        {
-            entry->constant_update_mask |= WINED3D_SHADER_CONST_FFP_PS;
-
-            shader_glsl_load_samplers(&context_gl->c, priv, program_id, NULL);
-        }
-
-        for (i = 0; i < WINED3D_MAX_TEXTURES; ++i)
-        {
-            if (entry->ps.bumpenv_mat_location[i] != -1)
-            {
-                entry->constant_update_mask |= WINED3D_SHADER_CONST_PS_BUMP_ENV;
-                break;
-            }
-        }
-
-        if (entry->ps.fog_color_location != -1)
-            entry->constant_update_mask |= WINED3D_SHADER_CONST_PS_FOG;
-        if (entry->ps.alpha_test_ref_location != -1)
-            entry->constant_update_mask |= WINED3D_SHADER_CONST_PS_ALPHA_TEST;
-        if (entry->ps.np2_fixup_location != -1)
-            entry->constant_update_mask |= WINED3D_SHADER_CONST_PS_NP2_FIXUP;
-        if (entry->ps.color_key_location != -1)
-            entry->constant_update_mask |= WINED3D_SHADER_CONST_FFP_COLOR_KEY;
-    }
+    shader_glsl_init_program(context_gl, priv, entry);
 }
 
 static void shader_glsl_precompile(void *shader_priv, struct wined3d_shader *shader)
@@ -10665,6 +10793,24 @@ static void shader_glsl_select(void *shader_priv, struct wined3d_context *contex
     set_glsl_shader_program(context_gl, state, priv, ctx_data);
     glsl_program = ctx_data->glsl_program;
 
+    context_gl->shaders_pending = 0;
+    if (glsl_program && glsl_program->link_pending)
+    {
+        GLint complete;
+
+        GL_EXTCALL(glGetProgramiv(glsl_program->id, GL_COMPLETION_STATUS_KHR, &complete));
+        if (complete)
+        {
+            shader_glsl_init_program(context_gl, priv, glsl_program);
+        }
+        else
+        {
+            TRACE("GLSL program %u is still being linked.\n", glsl_program->id);
+            context_gl->shaders_pending = 1;
+            ctx_data->glsl_program = glsl_program = NULL;
+        }
+    }
+
     if (glsl_program)
     {
         program_id = glsl_program->id;
@@ -11016,6 +11162,40 @@ static void constant_heap_free(struct constant_heap *heap)
     heap_free(heap->entries);
 }
 
+static struct wined3d_shader_cache *shader_glsl_create_cache(const struct wined3d_adapter *adapter)
+{
+    const struct wined3d_driver_info *driver_info = &adapter->driver_info;
+    const struct wined3d_d3d_info *d3d_info = &adapter->d3d_info;
+    const struct wined3d_gl_info *gl_info = &adapter->gl_info;
+    struct wined3d_shader_cache_key environment;
+
+    /* Everything the generated GLSL depends on, apart from the shader and
+     * its compile arguments. */
+    wined3d_shader_cache_key_init(&environment);
+    wined3d_shader_cache_key_update_string(&environment, PACKAGE_VERSION);
+    wined3d_shader_cache_key_update(&environment, &driver_info->vendor, sizeof(driver_info->vendor));
+    wined3d_shader_cache_key_update(&environment, &driver_info->device, sizeof(driver_info->device));
+    wined3d_shader_cache_key_update_string(&environment, driver_info->description);
+    wined3d_shader_cache_key_update(&environment, &driver_info->version_high, sizeof(driver_info->version_high));
+    wined3d_shader_cache_key_update(&environment, &driver_info->version_low, sizeof(driver_info->version_low));
+    wined3d_shader_cache_key_update(&environment, &gl_info->selected_gl_version, sizeof(gl_info->selected_gl_version));
+    wined3d_shader_cache_key_update(&environment, &gl_info->glsl_version, sizeof(gl_info->glsl_version));
+    wined3d_shader_cache_key_update(&environment, &gl_info->limits, sizeof(gl_info->limits));
+    wined3d_shader_cache_key_update(&environment, &gl_info->reserved_glsl_constants,
+            sizeof(gl_info->reserved_glsl_constants));
+    wined3d_shader_cache_key_update(&environment, &gl_info->quirks, sizeof(gl_info->quirks));
+    wined3d_shader_cache_key_update(&environment, gl_info->supported, sizeof(gl_info->supported));
+    wined3d_shader_cache_key_update(&environment, &d3d_info->limits, sizeof(d3d_info->limits));
+    wined3d_shader_cache_key_update(&environment, &d3d_info->wined3d_creation_flags,
+            sizeof(d3d_info->wined3d_creation_flags));
+    wined3d_shader_cache_key_update(&environment, &wined3d_settings.check_float_constants,
+            sizeof(wined3d_settings.check_float_constants));
+    wined3d_shader_cache_key_update(&environment, &wined3d_settings.strict_shader_math,
+            sizeof(wined3d_settings.strict_shader_math));
+
+    return wined3d_shader_cache_create("glsl", &environment);
+}
+
 static HRESULT shader_glsl_alloc(struct wined3d_device *device, const struct wined3d_vertex_pipe_ops *vertex_pipe,
         const struct wined3d_fragment_pipe_ops *fragment_pipe)
 {
@@ -11076,6 +11256,7 @@ static HRESULT shader_glsl_alloc(struct wined3d_device *device, const struct win
     fragment_pipe->get_caps(device->adapter, &fragment_caps);
     priv->ffp_proj_control = fragment_caps.wined3d_caps & WINED3D_FRAGMENT_CAP_PROJ_CONTROL;
     priv->legacy_lighting = device->wined3d->flags & WINED3D_LEGACY_FFP_LIGHTING;
+    priv->cache = shader_glsl_create_cache(device->adapter);
 
     device->vertex_priv = vertex_priv;
     device->fragment_priv = fragment_priv;
@@ -11099,6 +11280,7 @@ static void shader_glsl_free(struct wined3d_device *device, struct wined3d_conte
 {
     struct shader_glsl_priv *priv = device->shader_priv;
 
+    wined3d_shader_cache_destroy(priv->cache);
     wine_rb_destroy(&priv->program_lookup, NULL, NULL);
     constant_heap_free(&priv->pconst_heap);
     constant_heap_free(&priv->vconst_heap);
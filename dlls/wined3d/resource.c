@@ -374,6 +374,9 @@ HRESULT CDECL wined3d_resource_map(struct wined3d_resource *resource, unsigned i
     }
 
     flags = wined3d_resource_sanitise_map_flags(resource, flags);
+    if (wined3d_cs_map_upload_memory(resource->device->cs, resource, sub_resource_idx, map_desc, box, flags))
+        return WINED3D_OK;
+    wined3d_device_context_invalidate_upload_memory(&resource->device->cs->c, resource);
     wined3d_resource_wait_idle(resource);
 
     return wined3d_cs_map(resource->device->cs, resource, sub_resource_idx, map_desc, box, flags);
@@ -383,6 +386,10 @@ HRESULT CDECL wined3d_resource_unmap(struct wined3d_resource *resource, unsigned
 {
     TRACE("resource %p, sub_resource_idx %u.\n", resource, sub_resource_idx);
 
+    if (wined3d_cs_unmap_upload_memory(resource->device->cs, resource, sub_resource_idx))
+        return WINED3D_OK;
+    wined3d_device_context_invalidate_upload_memory(&resource->device->cs->c, resource);
+
     return wined3d_cs_unmap(resource->device->cs, resource, sub_resource_idx);
 }
 
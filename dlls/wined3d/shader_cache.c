@@ -0,0 +1,459 @@
+/*
+ * Copyright 2021 the Wine project
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "config.h"
+#include "wine/port.h"
+
+#include "wined3d_private.h"
+
+WINE_DEFAULT_DEBUG_CHANNEL(d3d_shader);
+
+#define WINED3D_SHADER_CACHE_MAGIC          0x43533357u /* "W3SC" */
+#define WINED3D_SHADER_CACHE_VERSION        2
+#define WINED3D_SHADER_CACHE_MAX_ENTRY_SIZE (16u * 1024 * 1024)
+
+struct wined3d_shader_cache_file_key
+{
+    uint64_t hash[2];
+    uint64_t size;
+};
+
+struct wined3d_shader_cache_file_header
+{
+    uint32_t magic;
+    uint32_t version;
+    struct wined3d_shader_cache_file_key environment;
+};
+
+/* Followed by "byte_code_size" bytes of shader bytecode, and "size" bytes of
+ * data. */
+struct wined3d_shader_cache_file_entry
+{
+    struct wined3d_shader_cache_file_key key;
+    uint32_t byte_code_size;
+    uint32_t size;
+};
+
+struct wined3d_shader_cache_entry
+{
+    struct wine_rb_entry entry;
+    struct wined3d_shader_cache_file_key key;
+    SIZE_T byte_code_size;
+    SIZE_T size;
+    BYTE *data;
+    BYTE byte_code[1];
+};
+
+struct wined3d_shader_cache
+{
+    struct wine_rb_tree entries;
+    struct wined3d_shader_cache_file_key environment;
+    char *path;
+
+    /* The cache file is read on a separate thread, so that device creation
+     * doesn't have to wait for it. The first lookup waits for the load to
+     * finish. */
+    HANDLE load_thread;
+
+    unsigned int entry_count;
+    unsigned int hit_count, miss_count;
+    BOOL dirty;
+};
+
+void wined3d_shader_cache_key_init(struct wined3d_shader_cache_key *key)
+{
+    key->hash[0] = 0xcbf29ce484222325ull;
+    key->hash[1] = 0x84222325cbf29ce4ull;
+    key->size = 0;
+    key->byte_code = NULL;
+    key->byte_code_size = 0;
+}
+
+static void wined3d_shader_cache_file_key_init(struct wined3d_shader_cache_file_key *file_key,
+        const struct wined3d_shader_cache_key *key)
+{
+    file_key->hash[0] = key->hash[0];
+    file_key->hash[1] = key->hash[1];
+    file_key->size = key->size;
+}
+
+/* Two independent 64-bit hashes: FNV-1a, and a multiply-xorshift mix. */
+void wined3d_shader_cache_key_update(struct wined3d_shader_cache_key *key, const void *data, size_t size)
+{
+    uint64_t h0 = key->hash[0], h1 = key->hash[1];
+    const BYTE *ptr = data;
+    size_t i;
+
+    for (i = 0; i < size; ++i)
+    {
+        h0 = (h0 ^ ptr[i]) * 0x100000001b3ull;
+        h1 = (h1 + ptr[i] + 1) * 0xff51afd7ed558ccdull;
+        h1 ^= h1 >> 32;
+    }
+
+    key->hash[0] = h0;
+    key->hash[1] = h1;
+    key->size += size;
+}
+
+void wined3d_shader_cache_key_update_string(struct wined3d_shader_cache_key *key, const char *str)
+{
+    if (!str)
+        str = "";
+    wined3d_shader_cache_key_update(key, str, strlen(str) + 1);
+}
+
+void wined3d_shader_cache_key_update_stream_output(struct wined3d_shader_cache_key *key,
+        const struct wined3d_stream_output_desc *so_desc)
+{
+    const struct wined3d_stream_output_element *e;
+    unsigned int i;
+
+    if (!so_desc)
+    {
+        wined3d_shader_cache_key_update(key, &so_desc, sizeof(so_desc));
+        return;
+    }
+
+    wined3d_shader_cache_key_update(key, &so_desc->element_count, sizeof(so_desc->element_count));
+    for (i = 0; i < so_desc->element_count; ++i)
+    {
+        e = &so_desc->elements[i];
+        wined3d_shader_cache_key_update(key, &e->stream_idx, sizeof(e->stream_idx));
+        wined3d_shader_cache_key_update_string(key, e->semantic_name);
+        wined3d_shader_cache_key_update(key, &e->semantic_idx, sizeof(e->semantic_idx));
+        wined3d_shader_cache_key_update(key, &e->component_idx, sizeof(e->component_idx));
+        wined3d_shader_cache_key_update(key, &e->component_count, sizeof(e->component_count));
+        wined3d_shader_cache_key_update(key, &e->output_slot, sizeof(e->output_slot));
+    }
+    wined3d_shader_cache_key_update(key, &so_desc->buffer_stride_count, sizeof(so_desc->buffer_stride_count));
+    wined3d_shader_cache_key_update(key, so_desc->buffer_strides,
+            so_desc->buffer_stride_count * sizeof(*so_desc->buffer_strides));
+    wined3d_shader_cache_key_update(key, &so_desc->rasterizer_stream_idx, sizeof(so_desc->rasterizer_stream_idx));
+}
+
+void wined3d_shader_cache_key_update_shader(struct wined3d_shader_cache_key *key,
+        const struct wined3d_shader *shader)
+{
+    enum wined3d_shader_type type = shader->reg_maps.shader_version.type;
+
+    wined3d_shader_cache_key_update(key, &type, sizeof(type));
+    wined3d_shader_cache_key_update(key, &shader->byte_code_size, sizeof(shader->byte_code_size));
+    wined3d_shader_cache_key_update(key, shader->byte_code, shader->byte_code_size);
+    key->byte_code = shader->byte_code;
+    key->byte_code_size = shader->byte_code_size;
+    if (type == WINED3D_SHADER_TYPE_GEOMETRY)
+        wined3d_shader_cache_key_update_stream_output(key, shader->u.gs.so_desc);
+}
+
+static int wined3d_shader_cache_key_compare(const void *key, const struct wine_rb_entry *entry)
+{
+    const struct wined3d_shader_cache_entry *e = WINE_RB_ENTRY_VALUE(entry, struct wined3d_shader_cache_entry, entry);
+
+    return memcmp(key, &e->key, sizeof(e->key));
+}
+
+/* Returns an entry with room for "byte_code_size" bytes of bytecode and "size"
+ * bytes of data, for the caller to fill in. */
+static struct wined3d_shader_cache_entry *wined3d_shader_cache_add_entry(struct wined3d_shader_cache *cache,
+        const struct wined3d_shader_cache_file_key *key, SIZE_T byte_code_size, SIZE_T size)
+{
+    struct wined3d_shader_cache_entry *entry;
+
+    if (!(entry = heap_alloc(FIELD_OFFSET(struct wined3d_shader_cache_entry, byte_code[byte_code_size + size]))))
+        return NULL;
+    entry->key = *key;
+    entry->byte_code_size = byte_code_size;
+    entry->size = size;
+    entry->data = entry->byte_code + byte_code_size;
+
+    if (wine_rb_put(&cache->entries, &entry->key, &entry->entry) == -1)
+    {
+        heap_free(entry);
+        return NULL;
+    }
+    ++cache->entry_count;
+
+    return entry;
+}
+
+static BOOL wined3d_shader_cache_read(HANDLE file, void *data, DWORD size)
+{
+    DWORD read;
+
+    return ReadFile(file, data, size, &read, NULL) && read == size;
+}
+
+static BOOL wined3d_shader_cache_write(HANDLE file, const void *data, DWORD size)
+{
+    DWORD written;
+
+    return WriteFile(file, data, size, &written, NULL) && written == size;
+}
+
+static void wined3d_shader_cache_load(struct wined3d_shader_cache *cache)
+{
+    struct wined3d_shader_cache_file_header header;
+    struct wined3d_shader_cache_file_entry record;
+    struct wined3d_shader_cache_entry *entry;
+    HANDLE file;
+
+    if ((file = CreateFileA(cache->path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+            FILE_FLAG_SEQUENTIAL_SCAN, NULL)) == INVALID_HANDLE_VALUE)
+    {
+        TRACE("No shader cache file %s.\n", debugstr_a(cache->path));
+        return;
+    }
+
+    if (!wined3d_shader_cache_read(file, &header, sizeof(header))
+            || header.magic != WINED3D_SHADER_CACHE_MAGIC || header.version != WINED3D_SHADER_CACHE_VERSION)
+    {
+        WARN("Ignoring invalid shader cache file %s.\n", debugstr_a(cache->path));
+        CloseHandle(file);
+        return;
+    }
+
+    if (memcmp(&header.environment, &cache->environment, sizeof(header.environment)))
+    {
+        TRACE("Shader cache file %s was created for a different configuration.\n", debugstr_a(cache->path));
+        CloseHandle(file);
+        /* Overwrite the stale file on destruction. */
+        cache->dirty = TRUE;
+        return;
+    }
+
+    while (wined3d_shader_cache_read(file, &record, sizeof(record)))
+    {
+        if (record.size > WINED3D_SHADER_CACHE_MAX_ENTRY_SIZE
+                || record.byte_code_size > WINED3D_SHADER_CACHE_MAX_ENTRY_SIZE)
+        {
+            WARN("Invalid entry size %u/%u in shader cache file %s.\n",
+                    record.byte_code_size, record.size, debugstr_a(cache->path));
+            break;
+        }
+
+        if (!(entry = wined3d_shader_cache_add_entry(cache, &record.key, record.byte_code_size, record.size)))
+        {
+            if (SetFilePointer(file, record.byte_code_size + record.size, NULL, FILE_CURRENT)
+                    == INVALID_SET_FILE_POINTER)
+                break;
+            continue;
+        }
+
+        if (!wined3d_shader_cache_read(file, entry->byte_code, record.byte_code_size + record.size))
+        {
+            WARN("Truncated shader cache file %s.\n", debugstr_a(cache->path));
+            wine_rb_remove(&cache->entries, &entry->entry);
+            --cache->entry_count;
+            heap_free(entry);
+            break;
+        }
+    }
+
+    CloseHandle(file);
+
+    TRACE("Loaded %u entries from shader cache file %s.\n", cache->entry_count, debugstr_a(cache->path));
+}
+
+static DWORD WINAPI wined3d_shader_cache_load_thread(void *ctx)
+{
+    wined3d_shader_cache_load(ctx);
+
+    return 0;
+}
+
+static void wined3d_shader_cache_wait_for_load(struct wined3d_shader_cache *cache)
+{
+    if (!cache->load_thread)
+        return;
+
+    WaitForSingleObject(cache->load_thread, INFINITE);
+    CloseHandle(cache->load_thread);
+    cache->load_thread = NULL;
+}
+
+static void wined3d_shader_cache_save(struct wined3d_shader_cache *cache)
+{
+    struct wined3d_shader_cache_file_header header;
+    struct wined3d_shader_cache_file_entry record;
+    struct wined3d_shader_cache_entry *entry;
+    char *tmp_path;
+    HANDLE file;
+    size_t len;
+    BOOL ret;
+
+    len = strlen(cache->path);
+    if (!(tmp_path = heap_alloc(len + 5)))
+        return;
+    memcpy(tmp_path, cache->path, len);
+    memcpy(tmp_path + len, ".tmp", 5);
+
+    if ((file = CreateFileA(tmp_path, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS,
+            FILE_ATTRIBUTE_NORMAL, NULL)) == INVALID_HANDLE_VALUE)
+    {
+        WARN("Failed to create shader cache file %s, error %u.\n", debugstr_a(tmp_path), GetLastError());
+        heap_free(tmp_path);
+        return;
+    }
+
+    header.magic = WINED3D_SHADER_CACHE_MAGIC;
+    header.version = WINED3D_SHADER_CACHE_VERSION;
+    header.environment = cache->environment;
+    ret = wined3d_shader_cache_write(file, &header, sizeof(header));
+
+    WINE_RB_FOR_EACH_ENTRY(entry, &cache->entries, struct wined3d_shader_cache_entry, entry)
+    {
+        if (!ret)
+            break;
+
+        record.key = entry->key;
+        record.byte_code_size = entry->byte_code_size;
+        record.size = entry->size;
+        ret = wined3d_shader_cache_write(file, &record, sizeof(record))
+                && wined3d_shader_cache_write(file, entry->byte_code, entry->byte_code_size + entry->size);
+    }
+
+    CloseHandle(file);
+
+    if (!ret || !MoveFileExA(tmp_path, cache->path, MOVEFILE_REPLACE_EXISTING))
+    {
+        WARN("Failed to write shader cache file %s, error %u.\n", debugstr_a(cache->path), GetLastError());
+        DeleteFileA(tmp_path);
+    }
+    else
+    {
+        TRACE("Wrote %u entries to shader cache file %s.\n", cache->entry_count, debugstr_a(cache->path));
+    }
+
+    heap_free(tmp_path);
+}
+
+struct wined3d_shader_cache *wined3d_shader_cache_create(const char *name,
+        const struct wined3d_shader_cache_key *environment)
+{
+    const char *dir = wined3d_settings.shader_cache_path;
+    struct wined3d_shader_cache *cache;
+    size_t dir_len, name_len;
+
+    if (!dir)
+        return NULL;
+
+    if (!(cache = heap_alloc_zero(sizeof(*cache))))
+        return NULL;
+
+    dir_len = strlen(dir);
+    name_len = strlen(name);
+    if (!(cache->path = heap_alloc(dir_len + name_len + sizeof("\\.cache"))))
+    {
+        heap_free(cache);
+        return NULL;
+    }
+    sprintf(cache->path, "%s\\%s.cache", dir, name);
+
+    wine_rb_init(&cache->entries, wined3d_shader_cache_key_compare);
+    wined3d_shader_cache_file_key_init(&cache->environment, environment);
+
+    if (!(cache->load_thread = CreateThread(NULL, 0, wined3d_shader_cache_load_thread, cache, 0, NULL)))
+    {
+        WARN("Failed to create shader cache load thread, error %u.\n", GetLastError());
+        wined3d_shader_cache_load(cache);
+    }
+
+    TRACE("Created shader cache %p for %s.\n", cache, debugstr_a(cache->path));
+
+    return cache;
+}
+
+static void wined3d_shader_cache_free_entry(struct wine_rb_entry *entry, void *ctx)
+{
+    heap_free(WINE_RB_ENTRY_VALUE(entry, struct wined3d_shader_cache_entry, entry));
+}
+
+void wined3d_shader_cache_destroy(struct wined3d_shader_cache *cache)
+{
+    if (!cache)
+        return;
+
+    wined3d_shader_cache_wait_for_load(cache);
+
+    TRACE("Destroying shader cache %p, %u hits, %u misses.\n", cache, cache->hit_count, cache->miss_count);
+
+    if (cache->dirty)
+        wined3d_shader_cache_save(cache);
+
+    wine_rb_destroy(&cache->entries, wined3d_shader_cache_free_entry, NULL);
+    heap_free(cache->path);
+    heap_free(cache);
+}
+
+const void *wined3d_shader_cache_get(struct wined3d_shader_cache *cache,
+        const struct wined3d_shader_cache_key *key, SIZE_T *size)
+{
+    struct wined3d_shader_cache_file_key file_key;
+    struct wined3d_shader_cache_entry *entry;
+    struct wine_rb_entry *e;
+
+    if (!cache)
+        return NULL;
+
+    wined3d_shader_cache_wait_for_load(cache);
+
+    wined3d_shader_cache_file_key_init(&file_key, key);
+    if (!(e = wine_rb_get(&cache->entries, &file_key)))
+    {
+        ++cache->miss_count;
+        return NULL;
+    }
+
+    entry = WINE_RB_ENTRY_VALUE(e, struct wined3d_shader_cache_entry, entry);
+    if (entry->byte_code_size != key->byte_code_size
+            || memcmp(entry->byte_code, key->byte_code, key->byte_code_size))
+    {
+        WARN("Shader cache key collision.\n");
+        ++cache->miss_count;
+        return NULL;
+    }
+
+    ++cache->hit_count;
+    *size = entry->size;
+
+    return entry->data;
+}
+
+/* Returns a buffer of "size" bytes for the caller to fill in, or NULL if the
+ * entry can't be added. */
+void *wined3d_shader_cache_put(struct wined3d_shader_cache *cache,
+        const struct wined3d_shader_cache_key *key, SIZE_T size)
+{
+    struct wined3d_shader_cache_file_key file_key;
+    struct wined3d_shader_cache_entry *entry;
+
+    if (!cache || size > WINED3D_SHADER_CACHE_MAX_ENTRY_SIZE
+            || key->byte_code_size > WINED3D_SHADER_CACHE_MAX_ENTRY_SIZE)
+        return NULL;
+
+    wined3d_shader_cache_wait_for_load(cache);
+
+    wined3d_shader_cache_file_key_init(&file_key, key);
+    if (!(entry = wined3d_shader_cache_add_entry(cache, &file_key, key->byte_code_size, size)))
+        return NULL;
+    memcpy(entry->byte_code, key->byte_code, key->byte_code_size);
+    cache->dirty = TRUE;
+
+    return entry->data;
+}
@@ -64,6 +64,11 @@ struct shader_spirv_priv
     bool ffp_proj_control;
 
     struct shader_spirv_resource_bindings bindings;
+    struct wined3d_shader_cache *cache;
+
+    CRITICAL_SECTION job_cs;
+    CONDITION_VARIABLE job_cv;
+    unsigned int pending_job_count;
 };
 
 struct shader_spirv_compile_arguments
@@ -78,6 +83,21 @@ struct shader_spirv_compile_arguments
     } u;
 };
 
+struct shader_spirv_compile_job
+{
+    struct shader_spirv_priv *priv;
+    struct wined3d_device_vk *device_vk;
+    const struct wined3d_shader *shader;
+    struct shader_spirv_compile_arguments args;
+    struct shader_spirv_resource_bindings bindings;
+    const struct wined3d_stream_output_desc *so_desc;
+    struct wined3d_shader_cache_key key;
+
+    struct vkd3d_shader_code spirv;
+    VkShaderModule vk_module;
+    bool done;
+};
+
 struct shader_spirv_graphics_program_variant_vk
 {
     struct shader_spirv_compile_arguments compile_args;
@@ -85,6 +105,7 @@ struct shader_spirv_graphics_program_variant_vk
     size_t binding_base;
 
     VkShaderModule vk_module;
+    struct shader_spirv_compile_job *job;
 };
 
 struct shader_spirv_graphics_program_vk
@@ -278,7 +299,7 @@ static const char *get_line(const char **ptr)
 }
 
 static void shader_spirv_init_shader_interface_vk(struct wined3d_shader_spirv_shader_interface *iface,
-        struct wined3d_shader *shader, const struct shader_spirv_resource_bindings *b,
+        const struct wined3d_shader *shader, const struct shader_spirv_resource_bindings *b,
         const struct wined3d_stream_output_desc *so_desc)
 {
     memset(iface, 0, sizeof(*iface));
@@ -304,21 +325,55 @@ static void shader_spirv_init_shader_interface_vk(struct wined3d_shader_spirv_sh
     iface->vkd3d_interface.uav_counter_count = b->uav_counter_count;
 }
 
-static VkShaderModule shader_spirv_compile(struct wined3d_context_vk *context_vk,
-        struct wined3d_shader *shader, const struct shader_spirv_compile_arguments *args,
-        const struct shader_spirv_resource_bindings *bindings, const struct wined3d_stream_output_desc *so_desc)
+static void shader_spirv_get_cache_key(struct wined3d_shader_cache_key *key, const struct wined3d_shader *shader,
+        const struct shader_spirv_compile_arguments *args, const struct shader_spirv_resource_bindings *bindings,
+        const struct wined3d_stream_output_desc *so_desc)
+{
+    wined3d_shader_cache_key_init(key);
+    wined3d_shader_cache_key_update_shader(key, shader);
+    if (args)
+        wined3d_shader_cache_key_update(key, args, sizeof(*args));
+    wined3d_shader_cache_key_update(key, &bindings->binding_count, sizeof(bindings->binding_count));
+    wined3d_shader_cache_key_update(key, bindings->bindings, bindings->binding_count * sizeof(*bindings->bindings));
+    wined3d_shader_cache_key_update(key, &bindings->uav_counter_count, sizeof(bindings->uav_counter_count));
+    wined3d_shader_cache_key_update(key, bindings->uav_counters,
+            bindings->uav_counter_count * sizeof(*bindings->uav_counters));
+    wined3d_shader_cache_key_update_stream_output(key, so_desc);
+}
+
+static VkShaderModule shader_spirv_create_module(struct wined3d_device_vk *device_vk,
+        const void *code, SIZE_T code_size)
+{
+    const struct wined3d_vk_info *vk_info = &device_vk->vk_info;
+    VkShaderModuleCreateInfo shader_desc;
+    VkShaderModule module;
+    VkResult vr;
+
+    shader_desc.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    shader_desc.pNext = NULL;
+    shader_desc.flags = 0;
+    shader_desc.codeSize = code_size;
+    shader_desc.pCode = code;
+    if ((vr = VK_CALL(vkCreateShaderModule(device_vk->vk_device, &shader_desc, NULL, &module))) < 0)
+    {
+        WARN("Failed to create Vulkan shader module, vr %s.\n", wined3d_debug_vkresult(vr));
+        return VK_NULL_HANDLE;
+    }
+
+    return module;
+}
+
+/* This only depends on its arguments, and may be called from the compile
+ * worker threads. */
+static bool shader_spirv_translate(const struct wined3d_shader *shader,
+        const struct shader_spirv_compile_arguments *args, const struct shader_spirv_resource_bindings *bindings,
+        const struct wined3d_stream_output_desc *so_desc, struct vkd3d_shader_code *spirv)
 {
     struct wined3d_shader_spirv_compile_args compile_args;
     struct wined3d_shader_spirv_shader_interface iface;
     struct vkd3d_shader_compile_info info;
-    const struct wined3d_vk_info *vk_info;
     enum wined3d_shader_type shader_type;
-    VkShaderModuleCreateInfo shader_desc;
-    struct wined3d_device_vk *device_vk;
-    struct vkd3d_shader_code spirv;
-    VkShaderModule module;
     char *messages;
-    VkResult vr;
     int ret;
 
     shader_spirv_init_shader_interface_vk(&iface, shader, bindings, so_desc);
@@ -337,7 +392,7 @@ static VkShaderModule shader_spirv_compile(struct wined3d_context_vk *context_vk
     info.log_level = VKD3D_SHADER_LOG_WARNING;
     info.source_name = NULL;
 
-    ret = vkd3d_shader_compile(&info, &spirv, &messages);
+    ret = vkd3d_shader_compile(&info, spirv, &messages);
     if (messages && *messages && FIXME_ON(d3d_shader))
     {
         const char *ptr = messages;
@@ -355,29 +410,158 @@ static VkShaderModule shader_spirv_compile(struct wined3d_context_vk *context_vk
     if (ret < 0)
     {
         ERR("Failed to compile DXBC, ret %d.\n", ret);
-        return VK_NULL_HANDLE;
+        return false;
     }
 
-    device_vk = wined3d_device_vk(context_vk->c.device);
-    vk_info = &device_vk->vk_info;
+    return true;
+}
 
-    shader_desc.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-    shader_desc.pNext = NULL;
-    shader_desc.flags = 0;
-    shader_desc.codeSize = spirv.size;
-    shader_desc.pCode = spirv.code;
-    if ((vr = VK_CALL(vkCreateShaderModule(device_vk->vk_device, &shader_desc, NULL, &module))) < 0)
+static VkShaderModule shader_spirv_compile(struct shader_spirv_priv *priv, struct wined3d_context_vk *context_vk,
+        struct wined3d_shader *shader, const struct shader_spirv_compile_arguments *args,
+        const struct shader_spirv_resource_bindings *bindings, const struct wined3d_stream_output_desc *so_desc)
+{
+    struct wined3d_device_vk *device_vk = wined3d_device_vk(context_vk->c.device);
+    struct wined3d_shader_cache_key key;
+    struct vkd3d_shader_code spirv;
+    const void *cached_code;
+    SIZE_T cached_size;
+    VkShaderModule module;
+    void *data;
+
+    if (priv->cache)
     {
-        vkd3d_shader_free_shader_code(&spirv);
-        WARN("Failed to create Vulkan shader module, vr %s.\n", wined3d_debug_vkresult(vr));
-        return VK_NULL_HANDLE;
+        shader_spirv_get_cache_key(&key, shader, args, bindings, so_desc);
+        if ((cached_code = wined3d_shader_cache_get(priv->cache, &key, &cached_size)))
+        {
+            TRACE("Using cached SPIR-V for shader %p.\n", shader);
+            return shader_spirv_create_module(device_vk, cached_code, cached_size);
+        }
     }
 
+    if (!shader_spirv_translate(shader, args, bindings, so_desc, &spirv))
+        return VK_NULL_HANDLE;
+
+    if ((module = shader_spirv_create_module(device_vk, spirv.code, spirv.size)) && priv->cache
+            && (data = wined3d_shader_cache_put(priv->cache, &key, spirv.size)))
+        memcpy(data, spirv.code, spirv.size);
+
     vkd3d_shader_free_shader_code(&spirv);
 
     return module;
 }
 
+static void shader_spirv_run_compile_job(struct shader_spirv_compile_job *job)
+{
+    struct shader_spirv_priv *priv = job->priv;
+
+    if (shader_spirv_translate(job->shader, &job->args, &job->bindings, job->so_desc, &job->spirv))
+        job->vk_module = shader_spirv_create_module(job->device_vk, job->spirv.code, job->spirv.size);
+
+    EnterCriticalSection(&priv->job_cs);
+    job->done = true;
+    --priv->pending_job_count;
+    WakeAllConditionVariable(&priv->job_cv);
+    LeaveCriticalSection(&priv->job_cs);
+}
+
+static void CALLBACK shader_spirv_compile_job_cb(TP_CALLBACK_INSTANCE *instance, void *ctx)
+{
+    shader_spirv_run_compile_job(ctx);
+}
+
+static void shader_spirv_free_compile_job(struct shader_spirv_compile_job *job)
+{
+    if (job->spirv.code)
+        vkd3d_shader_free_shader_code(&job->spirv);
+    heap_free(job->bindings.bindings);
+    heap_free(job);
+}
+
+/* Translation of new graphics variants is queued to the thread pool, so
+ * that the stages of a pipeline are translated in parallel. The variant
+ * can't be used until shader_spirv_complete_variant() returns true. */
+static bool shader_spirv_queue_compile_job(struct shader_spirv_priv *priv, struct wined3d_context_vk *context_vk,
+        struct wined3d_shader *shader, struct shader_spirv_graphics_program_variant_vk *variant_vk,
+        const struct shader_spirv_resource_bindings *bindings)
+{
+    struct shader_spirv_compile_job *job;
+
+    if (!(job = heap_alloc_zero(sizeof(*job))))
+        return false;
+
+    job->priv = priv;
+    job->device_vk = wined3d_device_vk(context_vk->c.device);
+    job->shader = shader;
+    job->args = variant_vk->compile_args;
+    job->so_desc = variant_vk->so_desc;
+    if (bindings->binding_count)
+    {
+        if (!(job->bindings.bindings = heap_calloc(bindings->binding_count, sizeof(*bindings->bindings))))
+        {
+            heap_free(job);
+            return false;
+        }
+        memcpy(job->bindings.bindings, bindings->bindings, bindings->binding_count * sizeof(*bindings->bindings));
+    }
+    job->bindings.binding_count = bindings->binding_count;
+    memcpy(job->bindings.uav_counters, bindings->uav_counters,
+            bindings->uav_counter_count * sizeof(*bindings->uav_counters));
+    job->bindings.uav_counter_count = bindings->uav_counter_count;
+    if (priv->cache)
+        shader_spirv_get_cache_key(&job->key, shader, &job->args, bindings, job->so_desc);
+
+    variant_vk->job = job;
+
+    EnterCriticalSection(&priv->job_cs);
+    ++priv->pending_job_count;
+    LeaveCriticalSection(&priv->job_cs);
+
+    if (!TrySubmitThreadpoolCallback(shader_spirv_compile_job_cb, job, NULL))
+    {
+        WARN("Failed to submit compile job, compiling synchronously.\n");
+        shader_spirv_run_compile_job(job);
+    }
+
+    return true;
+}
+
+static bool shader_spirv_complete_variant(struct shader_spirv_priv *priv,
+        struct shader_spirv_graphics_program_variant_vk *variant_vk, bool wait)
+{
+    struct shader_spirv_compile_job *job;
+    void *data;
+
+    if (!(job = variant_vk->job))
+        return true;
+
+    EnterCriticalSection(&priv->job_cs);
+    if (!job->done && !wait)
+    {
+        LeaveCriticalSection(&priv->job_cs);
+        return false;
+    }
+    while (!job->done)
+        SleepConditionVariableCS(&priv->job_cv, &priv->job_cs, INFINITE);
+    LeaveCriticalSection(&priv->job_cs);
+
+    variant_vk->vk_module = job->vk_module;
+    if (job->vk_module && priv->cache
+            && (data = wined3d_shader_cache_put(priv->cache, &job->key, job->spirv.size)))
+        memcpy(data, job->spirv.code, job->spirv.size);
+    variant_vk->job = NULL;
+    shader_spirv_free_compile_job(job);
+
+    return true;
+}
+
+static void shader_spirv_wait_for_compile_jobs(struct shader_spirv_priv *priv)
+{
+    EnterCriticalSection(&priv->job_cs);
+    while (priv->pending_job_count)
+        SleepConditionVariableCS(&priv->job_cv, &priv->job_cs, INFINITE);
+    LeaveCriticalSection(&priv->job_cs);
+}
+
 static struct shader_spirv_graphics_program_variant_vk *shader_spirv_find_graphics_program_variant_vk(
         struct shader_spirv_priv *priv, struct wined3d_context_vk *context_vk, struct wined3d_shader *shader,
         const struct wined3d_state *state, const struct shader_spirv_resource_bindings *bindings)
@@ -387,8 +571,12 @@ static struct shader_spirv_graphics_program_variant_vk *shader_spirv_find_graphi
     size_t binding_base = bindings->binding_base[shader_type];
     const struct wined3d_stream_output_desc *so_desc = NULL;
     struct shader_spirv_graphics_program_vk *program_vk;
+    struct wined3d_device_vk *device_vk;
     struct shader_spirv_compile_arguments args;
+    struct wined3d_shader_cache_key key;
     size_t variant_count, i;
+    const void *code;
+    SIZE_T code_size;
 
     shader_spirv_compile_arguments_init(&args, &context_vk->c, shader, state, context_vk->sample_count);
     if (bindings->so_stage == shader_type)
@@ -412,8 +600,26 @@ static struct shader_spirv_graphics_program_variant_vk *shader_spirv_find_graphi
 
     variant_vk = &program_vk->variants[variant_count];
     variant_vk->compile_args = args;
+    variant_vk->so_desc = so_desc;
     variant_vk->binding_base = binding_base;
-    if (!(variant_vk->vk_module = shader_spirv_compile(context_vk, shader, &args, bindings, so_desc)))
+    variant_vk->vk_module = VK_NULL_HANDLE;
+    variant_vk->job = NULL;
+
+    if (priv->cache)
+    {
+        shader_spirv_get_cache_key(&key, shader, &args, bindings, so_desc);
+        if ((code = wined3d_shader_cache_get(priv->cache, &key, &code_size)))
+        {
+            TRACE("Using cached SPIR-V for shader %p.\n", shader);
+            device_vk = wined3d_device_vk(context_vk->c.device);
+            if (!(variant_vk->vk_module = shader_spirv_create_module(device_vk, code, code_size)))
+                return NULL;
+            ++program_vk->variant_count;
+            return variant_vk;
+        }
+    }
+
+    if (!shader_spirv_queue_compile_job(priv, context_vk, shader, variant_vk, bindings))
         return NULL;
     ++program_vk->variant_count;
 
@@ -437,7 +643,7 @@ static struct shader_spirv_compute_program_vk *shader_spirv_find_compute_program
     if (program->vk_module)
         return program;
 
-    if (!(program->vk_module = shader_spirv_compile(context_vk, shader, NULL, bindings, NULL)))
+    if (!(program->vk_module = shader_spirv_compile(priv, context_vk, shader, NULL, bindings, NULL)))
         return NULL;
 
     if (!(layout = wined3d_context_vk_get_pipeline_layout(context_vk,
@@ -819,8 +1025,10 @@ static void shader_spirv_precompile(void *shader_priv, struct wined3d_shader *sh
 static void shader_spirv_select(void *shader_priv, struct wined3d_context *context,
         const struct wined3d_state *state)
 {
+    struct shader_spirv_graphics_program_variant_vk *variants[WINED3D_SHADER_TYPE_GRAPHICS_COUNT] = {NULL};
     struct wined3d_context_vk *context_vk = wined3d_context_vk(context);
     struct shader_spirv_graphics_program_variant_vk *variant_vk;
+    bool wait = !wined3d_settings.async_shader_compile;
     struct shader_spirv_resource_bindings *bindings;
     size_t binding_base[WINED3D_SHADER_TYPE_COUNT];
     struct wined3d_pipeline_layout_vk *layout_vk;
@@ -831,6 +1039,7 @@ static void shader_spirv_select(void *shader_priv, struct wined3d_context *conte
     priv->vertex_pipe->vp_enable(context, !use_vs(state));
     priv->fragment_pipe->fp_enable(context, !use_ps(state));
 
+    context_vk->shaders_pending = 0;
     bindings = &priv->bindings;
     memcpy(binding_base, bindings->binding_base, sizeof(bindings->binding_base));
     if (!shader_spirv_resource_bindings_init(bindings, &context_vk->graphics.bindings,
@@ -858,7 +1067,24 @@ static void shader_spirv_select(void *shader_priv, struct wined3d_context *conte
             continue;
         }
 
-        if (!(variant_vk = shader_spirv_find_graphics_program_variant_vk(priv, context_vk, shader, state, bindings)))
+        if (!(variants[shader_type] = shader_spirv_find_graphics_program_variant_vk(priv,
+                context_vk, shader, state, bindings)))
+            goto fail;
+    }
+
+    /* With asynchronous shader compilation enabled, the draw is skipped
+     * until all stages are available, instead of waiting for them. */
+    for (shader_type = 0; shader_type < ARRAY_SIZE(variants); ++shader_type)
+    {
+        if (!(variant_vk = variants[shader_type]))
+            continue;
+
+        if (!shader_spirv_complete_variant(priv, variant_vk, wait))
+        {
+            context_vk->shaders_pending = 1;
+            continue;
+        }
+        if (!variant_vk->vk_module)
             goto fail;
         context_vk->graphics.vk_modules[shader_type] = variant_vk->vk_module;
     }
@@ -1012,10 +1238,15 @@ static void shader_spirv_destroy(struct wined3d_shader *shader)
         return;
     }
 
+    /* Pending jobs may reference this shader, or its stream output
+     * description. */
+    shader_spirv_wait_for_compile_jobs(device_vk->d.shader_priv);
+
     program_vk = shader->backend_data;
     for (i = 0; i < program_vk->variant_count; ++i)
     {
         variant_vk = &program_vk->variants[i];
+        shader_spirv_complete_variant(device_vk->d.shader_priv, variant_vk, true);
         shader_spirv_invalidate_contexts_graphics_program_variant(&device_vk->d, variant_vk);
         VK_CALL(vkDestroyShaderModule(device_vk->vk_device, variant_vk->vk_module, NULL));
     }
@@ -1025,6 +1256,37 @@ static void shader_spirv_destroy(struct wined3d_shader *shader)
     heap_free(program_vk);
 }
 
+static struct wined3d_shader_cache *shader_spirv_create_cache(const struct wined3d_device_vk *device_vk)
+{
+    const struct wined3d_adapter_vk *adapter_vk = wined3d_adapter_vk(device_vk->d.adapter);
+    const struct wined3d_driver_info *driver_info = &adapter_vk->a.driver_info;
+    const struct wined3d_d3d_info *d3d_info = &adapter_vk->a.d3d_info;
+    struct wined3d_shader_cache_key environment;
+    unsigned int i;
+
+    wined3d_shader_cache_key_init(&environment);
+    wined3d_shader_cache_key_update_string(&environment, PACKAGE_VERSION);
+    wined3d_shader_cache_key_update_string(&environment, vkd3d_shader_get_version(NULL, NULL));
+    wined3d_shader_cache_key_update(&environment, &driver_info->vendor, sizeof(driver_info->vendor));
+    wined3d_shader_cache_key_update(&environment, &driver_info->device, sizeof(driver_info->device));
+    wined3d_shader_cache_key_update(&environment, &d3d_info->limits, sizeof(d3d_info->limits));
+    /* The device features and extensions decide what the SPIR-V may use. */
+    wined3d_shader_cache_key_update(&environment, &device_vk->vk_info.api_version,
+            sizeof(device_vk->vk_info.api_version));
+    wined3d_shader_cache_key_update(&environment, &device_vk->enabled_features,
+            sizeof(device_vk->enabled_features));
+    wined3d_shader_cache_key_update(&environment, &device_vk->transform_feedback,
+            sizeof(device_vk->transform_feedback));
+    wined3d_shader_cache_key_update(&environment, &device_vk->geometry_streams,
+            sizeof(device_vk->geometry_streams));
+    wined3d_shader_cache_key_update(&environment, &adapter_vk->device_extension_count,
+            sizeof(adapter_vk->device_extension_count));
+    for (i = 0; i < adapter_vk->device_extension_count; ++i)
+        wined3d_shader_cache_key_update_string(&environment, adapter_vk->device_extensions[i]);
+
+    return wined3d_shader_cache_create("spirv", &environment);
+}
+
 static HRESULT shader_spirv_alloc(struct wined3d_device *device,
         const struct wined3d_vertex_pipe_ops *vertex_pipe, const struct wined3d_fragment_pipe_ops *fragment_pipe)
 {
@@ -1055,6 +1317,10 @@ static HRESULT shader_spirv_alloc(struct wined3d_device *device,
     fragment_pipe->get_caps(device->adapter, &fragment_caps);
     priv->ffp_proj_control = fragment_caps.wined3d_caps & WINED3D_FRAGMENT_CAP_PROJ_CONTROL;
     memset(&priv->bindings, 0, sizeof(priv->bindings));
+    priv->cache = shader_spirv_create_cache(wined3d_device_vk(device));
+    InitializeCriticalSection(&priv->job_cs);
+    InitializeConditionVariable(&priv->job_cv);
+    priv->pending_job_count = 0;
 
     device->vertex_priv = vertex_priv;
     device->fragment_priv = fragment_priv;
@@ -1067,6 +1333,9 @@ static void shader_spirv_free(struct wined3d_device *device, struct wined3d_cont
 {
     struct shader_spirv_priv *priv = device->shader_priv;
 
+    shader_spirv_wait_for_compile_jobs(priv);
+    DeleteCriticalSection(&priv->job_cs);
+    wined3d_shader_cache_destroy(priv->cache);
     shader_spirv_resource_bindings_cleanup(&priv->bindings);
     priv->fragment_pipe->free_private(device, context);
     priv->vertex_pipe->vp_free(device, context);
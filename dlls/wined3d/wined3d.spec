@@ -33,6 +33,13 @@
 @ cdecl wined3d_buffer_get_resource(ptr)
 @ cdecl wined3d_buffer_incref(ptr)
 
+@ cdecl wined3d_command_list_decref(ptr)
+@ cdecl wined3d_command_list_incref(ptr)
+
+@ cdecl wined3d_deferred_context_create(ptr ptr)
+@ cdecl wined3d_deferred_context_destroy(ptr)
+@ cdecl wined3d_deferred_context_record_command_list(ptr long ptr)
+
 @ cdecl wined3d_depth_stencil_state_create(ptr ptr ptr ptr ptr)
 @ cdecl wined3d_depth_stencil_state_decref(ptr)
 @ cdecl wined3d_depth_stencil_state_get_parent(ptr)
@@ -170,7 +177,28 @@
 @ cdecl wined3d_device_context_draw_indirect(ptr ptr long long)
 @ cdecl wined3d_device_context_dispatch(ptr long long long)
 @ cdecl wined3d_device_context_dispatch_indirect(ptr ptr long)
+@ cdecl wined3d_device_context_execute_command_list(ptr ptr long)
 @ cdecl wined3d_device_context_generate_mipmaps(ptr ptr)
+@ cdecl wined3d_device_context_get_blend_state(ptr ptr ptr)
+@ cdecl wined3d_device_context_get_constant_buffer(ptr long long)
+@ cdecl wined3d_device_context_get_depth_stencil_state(ptr ptr)
+@ cdecl wined3d_device_context_get_depth_stencil_view(ptr)
+@ cdecl wined3d_device_context_get_index_buffer(ptr ptr ptr)
+@ cdecl wined3d_device_context_get_predication(ptr ptr)
+@ cdecl wined3d_device_context_get_primitive_type(ptr ptr ptr)
+@ cdecl wined3d_device_context_get_rasterizer_state(ptr)
+@ cdecl wined3d_device_context_get_rendertarget_view(ptr long)
+@ cdecl wined3d_device_context_get_sampler(ptr long long)
+@ cdecl wined3d_device_context_get_scissor_rects(ptr ptr ptr)
+@ cdecl wined3d_device_context_get_shader(ptr long)
+@ cdecl wined3d_device_context_get_shader_resource_view(ptr long long)
+@ cdecl wined3d_device_context_get_stream_output(ptr long ptr)
+@ cdecl wined3d_device_context_get_stream_source(ptr long ptr ptr ptr)
+@ cdecl wined3d_device_context_get_unordered_access_view(ptr long long)
+@ cdecl wined3d_device_context_get_vertex_declaration(ptr)
+@ cdecl wined3d_device_context_get_viewports(ptr ptr ptr)
+@ cdecl wined3d_device_context_map(ptr ptr long ptr ptr long)
+@ cdecl wined3d_device_context_reset_state(ptr)
 @ cdecl wined3d_device_context_resolve_sub_resource(ptr ptr long ptr long long)
 @ cdecl wined3d_device_context_set_blend_state(ptr ptr ptr long)
 @ cdecl wined3d_device_context_set_constant_buffer(ptr long long ptr)
@@ -178,17 +206,21 @@
 @ cdecl wined3d_device_context_set_depth_stencil_view(ptr ptr)
 @ cdecl wined3d_device_context_set_index_buffer(ptr ptr long long)
 @ cdecl wined3d_device_context_set_predication(ptr ptr long)
+@ cdecl wined3d_device_context_set_primitive_type(ptr long long)
 @ cdecl wined3d_device_context_set_rasterizer_state(ptr ptr)
+@ cdecl wined3d_device_context_set_render_state(ptr long long)
 @ cdecl wined3d_device_context_set_rendertarget_view(ptr long ptr long)
 @ cdecl wined3d_device_context_set_sampler(ptr long long ptr)
 @ cdecl wined3d_device_context_set_scissor_rects(ptr long ptr)
 @ cdecl wined3d_device_context_set_shader(ptr long ptr)
 @ cdecl wined3d_device_context_set_shader_resource_view(ptr long long ptr)
+@ cdecl wined3d_device_context_set_state(ptr ptr)
 @ cdecl wined3d_device_context_set_stream_output(ptr long ptr long)
 @ cdecl wined3d_device_context_set_stream_source(ptr long ptr long long)
 @ cdecl wined3d_device_context_set_unordered_access_view(ptr long long ptr long)
 @ cdecl wined3d_device_context_set_vertex_declaration(ptr ptr)
 @ cdecl wined3d_device_context_set_viewports(ptr long ptr)
+@ cdecl wined3d_device_context_unmap(ptr ptr long)
 @ cdecl wined3d_device_context_update_sub_resource(ptr ptr long ptr ptr long long long)
 
 @ cdecl wined3d_output_find_closest_matching_mode(ptr ptr)
@@ -129,6 +129,8 @@ struct wined3d_settings wined3d_settings =
     ~0u,            /* No CS shader model limit by default. */
     WINED3D_RENDERER_AUTO,
     WINED3D_SHADER_BACKEND_AUTO,
+    NULL,           /* No persistent shader cache by default. */
+    FALSE,          /* Wait for shader compilation before drawing. */
 };
 
 struct wined3d * CDECL wined3d_create(DWORD flags)
@@ -398,6 +400,19 @@ static BOOL wined3d_dll_init(HINSTANCE hInstDLL)
                 wined3d_settings.renderer = WINED3D_RENDERER_NO3D;
             }
         }
+        if (!get_config_key_dword(hkey, appkey, "AsyncShaderCompile", &wined3d_settings.async_shader_compile))
+            ERR_(winediag)("Setting asynchronous shader compilation to %#x.\n",
+                    wined3d_settings.async_shader_compile);
+        if (!get_config_key(hkey, appkey, "ShaderCachePath", buffer, size) && *buffer)
+        {
+            size_t len = strlen(buffer) + 1;
+
+            if (!(wined3d_settings.shader_cache_path = heap_alloc(len)))
+                ERR("Failed to allocate shader cache path memory.\n");
+            else
+                memcpy(wined3d_settings.shader_cache_path, buffer, len);
+            TRACE("Using shader cache directory %s.\n", debugstr_a(wined3d_settings.shader_cache_path));
+        }
     }
 
     if (appkey) RegCloseKey( appkey );
@@ -439,6 +454,7 @@ static BOOL wined3d_dll_destroy(HINSTANCE hInstDLL)
     }
     heap_free(swapchain_state_table.hooks);
 
+    heap_free(wined3d_settings.shader_cache_path);
     heap_free(wined3d_settings.logo);
     UnregisterClassA(WINED3D_OPENGL_WINDOW_CLASS_NAME, hInstDLL);
 
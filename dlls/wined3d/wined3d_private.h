@@ -473,6 +473,8 @@ struct wined3d_settings
     unsigned int max_sm_cs;
     enum wined3d_renderer renderer;
     enum wined3d_shader_backend shader_backend;
+    char *shader_cache_path;
+    unsigned int async_shader_compile;
 };
 
 extern struct wined3d_settings wined3d_settings DECLSPEC_HIDDEN;
@@ -2190,7 +2192,8 @@ struct wined3d_context_gl
     uint32_t untracked_material_count : 2; /* Max value 2 */
     uint32_t needs_set : 1;
     uint32_t valid : 1;
-    uint32_t padding : 23;
+    uint32_t shaders_pending : 1;
+    uint32_t padding : 22;
 
     uint32_t default_attrib_value_set;
 
@@ -2526,7 +2529,8 @@ struct wined3d_context_vk
 
     uint32_t update_compute_pipeline : 1;
     uint32_t update_stream_output : 1;
-    uint32_t padding : 30;
+    uint32_t shaders_pending : 1;
+    uint32_t padding : 29;
 
     struct
     {
@@ -4000,6 +4004,9 @@ struct wined3d_device_vk
     uint32_t timestamp_bits;
 
     struct wined3d_vk_info vk_info;
+    VkPhysicalDeviceFeatures enabled_features;
+    VkBool32 transform_feedback;
+    VkBool32 geometry_streams;
 
     struct wined3d_null_resources_vk null_resources_vk;
     struct wined3d_null_views_vk null_views_vk;
@@ -4671,14 +4678,60 @@ enum wined3d_push_constants
 
 #define WINED3D_CS_QUERY_POLL_INTERVAL  10u
 #define WINED3D_CS_QUEUE_SIZE           0x100000u
+#define WINED3D_CS_QUEUE_MAX_CHUNKS     64u
 #define WINED3D_CS_SPIN_COUNT           10000000u
 
-struct wined3d_cs_queue
+/* Command packets are written to a list of chunks. The producer only writes
+ * "head" and links new chunks, the consumer only writes "tail" and retires
+ * chunks once it reaches the end of a chunk that has a successor. */
+struct wined3d_cs_queue_chunk
 {
+    struct wined3d_cs_queue_chunk *next;
+    size_t size;
     LONG head, tail;
-    BYTE data[WINED3D_CS_QUEUE_SIZE];
+    BYTE data[1];
+};
+
+struct wined3d_cs_queue
+{
+    struct wined3d_cs_queue_chunk *head_chunk, *tail_chunk;
+    struct wined3d_cs_queue_chunk *free_chunk;
+    LONG chunk_count;
+};
+
+struct wined3d_cs_stats
+{
+    ULONG64 bytes_queued;
+    ULONG64 stall_time, finish_time;
+    unsigned int stall_count, finish_count;
+    unsigned int chunk_allocations;
+    unsigned int upload_maps;
+    DWORD report_time;
+};
+
+/* Client memory backing DISCARD and NOOVERWRITE buffer maps. Each upload
+ * queued from it holds a reference, which the command stream releases once
+ * the upload has been executed. The data is write watched, so that maps
+ * without a range only upload the pages the application actually wrote. */
+struct wined3d_upload_memory
+{
+    LONG refcount;
+    unsigned int size;
+    BYTE *data;
+    BOOL write_watch;
+    ULONG_PTR page_count;
+    void *pages[1];
 };
 
+static inline void wined3d_upload_memory_decref(struct wined3d_upload_memory *memory)
+{
+    if (!InterlockedDecrement(&memory->refcount))
+    {
+        VirtualFree(memory->data, 0, MEM_RELEASE);
+        heap_free(memory);
+    }
+}
+
 struct wined3d_device_context_ops
 {
     void *(*require_space)(struct wined3d_device_context *context, size_t size, enum wined3d_cs_queue_id queue_id);
@@ -4686,6 +4739,16 @@ struct wined3d_device_context_ops
     void (*finish)(struct wined3d_device_context *context, enum wined3d_cs_queue_id queue_id);
     void (*push_constants)(struct wined3d_device_context *context, enum wined3d_push_constants p,
             unsigned int start_idx, unsigned int count, const void *constants);
+    void (*acquire_resource)(struct wined3d_device_context *context, struct wined3d_resource *resource);
+    void (*update_sub_resource)(struct wined3d_device_context *context, struct wined3d_resource *resource,
+            unsigned int sub_resource_idx, const struct wined3d_box *box, const void *data,
+            unsigned int row_pitch, unsigned int slice_pitch);
+    void (*acquire_command_list)(struct wined3d_device_context *context, struct wined3d_command_list *list);
+    HRESULT (*map)(struct wined3d_device_context *context, struct wined3d_resource *resource,
+            unsigned int sub_resource_idx, struct wined3d_map_desc *map_desc, const struct wined3d_box *box,
+            unsigned int flags);
+    HRESULT (*unmap)(struct wined3d_device_context *context, struct wined3d_resource *resource,
+            unsigned int sub_resource_idx);
 };
 
 struct wined3d_device_context
@@ -4714,6 +4777,8 @@ struct wined3d_cs
     HANDLE event;
     BOOL waiting_for_event;
     LONG pending_presents;
+
+    struct wined3d_cs_stats stats;
 };
 
 struct wined3d_cs *wined3d_cs_create(struct wined3d_device *device,
@@ -4732,7 +4797,6 @@ void wined3d_cs_emit_preload_resource(struct wined3d_cs *cs, struct wined3d_reso
 void wined3d_cs_emit_present(struct wined3d_cs *cs, struct wined3d_swapchain *swapchain, const RECT *src_rect,
         const RECT *dst_rect, HWND dst_window_override, unsigned int swap_interval, DWORD flags) DECLSPEC_HIDDEN;
 void wined3d_cs_emit_query_issue(struct wined3d_cs *cs, struct wined3d_query *query, DWORD flags) DECLSPEC_HIDDEN;
-void wined3d_cs_emit_reset_state(struct wined3d_cs *cs) DECLSPEC_HIDDEN;
 void wined3d_cs_emit_set_clip_plane(struct wined3d_cs *cs, UINT plane_idx,
         const struct wined3d_vec4 *plane) DECLSPEC_HIDDEN;
 void wined3d_cs_emit_set_color_key(struct wined3d_cs *cs, struct wined3d_texture *texture,
@@ -4741,8 +4805,6 @@ void wined3d_cs_emit_set_feature_level(struct wined3d_cs *cs, enum wined3d_featu
 void wined3d_cs_emit_set_light(struct wined3d_cs *cs, const struct wined3d_light_info *light) DECLSPEC_HIDDEN;
 void wined3d_cs_emit_set_light_enable(struct wined3d_cs *cs, unsigned int idx, BOOL enable) DECLSPEC_HIDDEN;
 void wined3d_cs_emit_set_material(struct wined3d_cs *cs, const struct wined3d_material *material) DECLSPEC_HIDDEN;
-void wined3d_cs_emit_set_render_state(struct wined3d_cs *cs,
-        enum wined3d_render_state state, DWORD value) DECLSPEC_HIDDEN;
 void wined3d_cs_emit_set_sampler_state(struct wined3d_cs *cs, UINT sampler_idx,
         enum wined3d_sampler_state state, DWORD value) DECLSPEC_HIDDEN;
 void wined3d_cs_emit_set_stream_source_freq(struct wined3d_cs *cs, UINT stream_idx,
@@ -4757,8 +4819,15 @@ void wined3d_cs_init_object(struct wined3d_cs *cs,
         void (*callback)(void *object), void *object) DECLSPEC_HIDDEN;
 HRESULT wined3d_cs_map(struct wined3d_cs *cs, struct wined3d_resource *resource, unsigned int sub_resource_idx,
         struct wined3d_map_desc *map_desc, const struct wined3d_box *box, unsigned int flags) DECLSPEC_HIDDEN;
+BOOL wined3d_cs_map_upload_memory(struct wined3d_cs *cs, struct wined3d_resource *resource,
+        unsigned int sub_resource_idx, struct wined3d_map_desc *map_desc,
+        const struct wined3d_box *box, unsigned int flags) DECLSPEC_HIDDEN;
 HRESULT wined3d_cs_unmap(struct wined3d_cs *cs, struct wined3d_resource *resource,
         unsigned int sub_resource_idx) DECLSPEC_HIDDEN;
+void wined3d_device_context_invalidate_upload_memory(struct wined3d_device_context *context,
+        struct wined3d_resource *resource) DECLSPEC_HIDDEN;
+BOOL wined3d_cs_unmap_upload_memory(struct wined3d_cs *cs, struct wined3d_resource *resource,
+        unsigned int sub_resource_idx) DECLSPEC_HIDDEN;
 
 static inline void wined3d_cs_finish(struct wined3d_cs *cs, enum wined3d_cs_queue_id queue_id)
 {
@@ -4785,8 +4854,11 @@ void wined3d_device_context_emit_draw(struct wined3d_device_context *context,
         enum wined3d_primitive_type primitive_type, unsigned int patch_vertex_count, int base_vertex_idx,
         unsigned int start_idx, unsigned int index_count, unsigned int start_instance, unsigned int instance_count,
         bool indexed) DECLSPEC_HIDDEN;
+void wined3d_device_context_emit_execute_command_list(struct wined3d_device_context *context,
+        struct wined3d_command_list *list) DECLSPEC_HIDDEN;
 void wined3d_device_context_emit_generate_mipmaps(struct wined3d_device_context *context,
         struct wined3d_shader_resource_view *view) DECLSPEC_HIDDEN;
+void wined3d_device_context_emit_reset_state(struct wined3d_device_context *context, bool invalidate) DECLSPEC_HIDDEN;
 void wined3d_device_context_emit_set_blend_state(struct wined3d_device_context *context,
         struct wined3d_blend_state *state, const struct wined3d_color *blend_factor,
         unsigned int sample_mask) DECLSPEC_HIDDEN;
@@ -4802,6 +4874,8 @@ void wined3d_device_context_emit_set_predication(struct wined3d_device_context *
         struct wined3d_query *predicate, BOOL value) DECLSPEC_HIDDEN;
 void wined3d_device_context_emit_set_rasterizer_state(struct wined3d_device_context *context,
         struct wined3d_rasterizer_state *rasterizer_state) DECLSPEC_HIDDEN;
+void wined3d_device_context_emit_set_render_state(struct wined3d_device_context *context,
+        enum wined3d_render_state state, DWORD value) DECLSPEC_HIDDEN;
 void wined3d_device_context_emit_set_rendertarget_view(struct wined3d_device_context *context, unsigned int view_idx,
         struct wined3d_rendertarget_view *view) DECLSPEC_HIDDEN;
 void wined3d_device_context_emit_set_sampler(struct wined3d_device_context *context, enum wined3d_shader_type type,
@@ -4860,6 +4934,10 @@ struct wined3d_buffer_ops
             unsigned int data_offset, unsigned int range_count, const struct wined3d_range *ranges);
 };
 
+#define WINED3D_BUFFER_HASDESC      0x01    /* A vertex description has been found. */
+#define WINED3D_BUFFER_USE_BO       0x02    /* Use a buffer object for this buffer. */
+#define WINED3D_BUFFER_PIN_SYSMEM   0x04    /* Keep a system memory copy for this buffer. */
+
 struct wined3d_buffer
 {
     struct wined3d_resource resource;
@@ -4880,6 +4958,13 @@ struct wined3d_buffer
     UINT stride;                                            /* 0 if no conversion */
     enum wined3d_buffer_conversion_type *conversion_map;    /* NULL if no conversion */
     UINT conversion_stride;                                 /* 0 if no shifted conversion */
+
+    /* Only accessed from the application thread. */
+    struct wined3d_upload_memory *upload_memory;
+    struct wined3d_upload_memory *upload_pool[3];
+    unsigned int upload_map_count;
+    unsigned int upload_start, upload_end;
+    BOOL upload_watched;
 };
 
 static inline struct wined3d_buffer *buffer_from_resource(struct wined3d_resource *resource)
@@ -5563,6 +5648,38 @@ void find_ds_compile_args(const struct wined3d_state *state, const struct wined3
 void find_gs_compile_args(const struct wined3d_state *state, const struct wined3d_shader *shader,
         struct gs_compile_args *args, const struct wined3d_context *context) DECLSPEC_HIDDEN;
 
+/* Persistent cache for translated shaders. The key covers everything the
+ * translation depends on; per-adapter state goes into the environment key
+ * passed to wined3d_shader_cache_create(). Entries also store the shader
+ * bytecode the key was computed from, which is compared on lookup so that a
+ * hash collision can't return the translation of a different shader. */
+struct wined3d_shader_cache_key
+{
+    uint64_t hash[2];
+    uint64_t size;
+    const void *byte_code;
+    SIZE_T byte_code_size;
+};
+
+struct wined3d_shader_cache;
+
+void wined3d_shader_cache_key_init(struct wined3d_shader_cache_key *key) DECLSPEC_HIDDEN;
+void wined3d_shader_cache_key_update(struct wined3d_shader_cache_key *key,
+        const void *data, size_t size) DECLSPEC_HIDDEN;
+void wined3d_shader_cache_key_update_string(struct wined3d_shader_cache_key *key, const char *str) DECLSPEC_HIDDEN;
+void wined3d_shader_cache_key_update_shader(struct wined3d_shader_cache_key *key,
+        const struct wined3d_shader *shader) DECLSPEC_HIDDEN;
+void wined3d_shader_cache_key_update_stream_output(struct wined3d_shader_cache_key *key,
+        const struct wined3d_stream_output_desc *so_desc) DECLSPEC_HIDDEN;
+
+struct wined3d_shader_cache *wined3d_shader_cache_create(const char *name,
+        const struct wined3d_shader_cache_key *environment) DECLSPEC_HIDDEN;
+void wined3d_shader_cache_destroy(struct wined3d_shader_cache *cache) DECLSPEC_HIDDEN;
+const void *wined3d_shader_cache_get(struct wined3d_shader_cache *cache,
+        const struct wined3d_shader_cache_key *key, SIZE_T *size) DECLSPEC_HIDDEN;
+void *wined3d_shader_cache_put(struct wined3d_shader_cache *cache,
+        const struct wined3d_shader_cache_key *key, SIZE_T size) DECLSPEC_HIDDEN;
+
 void string_buffer_clear(struct wined3d_string_buffer *buffer) DECLSPEC_HIDDEN;
 BOOL string_buffer_init(struct wined3d_string_buffer *buffer) DECLSPEC_HIDDEN;
 void string_buffer_free(struct wined3d_string_buffer *buffer) DECLSPEC_HIDDEN;
@@ -128,6 +128,12 @@
 #ifdef HAVE_SYS_POLL_H
 # include <sys/poll.h>
 #endif
+#ifdef HAVE_SYS_SENDFILE_H
+# include <sys/sendfile.h>
+#endif
+#ifdef HAVE_SYS_EPOLL_H
+# include <sys/epoll.h>
+#endif
 #ifdef HAVE_SYS_TIME_H
 # include <sys/time.h>
 #endif
@@ -142,6 +148,7 @@
 #include "winuser.h"
 #include "winerror.h"
 #include "winnls.h"
+#include "winreg.h"
 #include "winsock2.h"
 #include "mswsock.h"
 #include "ws2tcpip.h"
@@ -161,6 +168,8 @@
 #include "wine/exception.h"
 #include "wine/unicode.h"
 #include "wine/heap.h"
+#include "wine/list.h"
+#include "wine/rbtree.h"
 
 #if defined(linux) && !defined(IP_UNICAST_IF)
 #define IP_UNICAST_IF 50
@@ -335,6 +344,9 @@ static struct interface_filter generic_interface_filter = {
 #endif /* LINUX_BOUND_IF */
 
 extern ssize_t CDECL __wine_locked_recvmsg( int fd, struct msghdr *hdr, int flags );
+extern NTSTATUS CDECL __wine_add_fd_completion( HANDLE handle, ULONG_PTR value, NTSTATUS status,
+                                                SIZE_T information, BOOL async );
+extern void CDECL __wine_set_client_io_callback( ULONG (CDECL *func)( HANDLE, IO_STATUS_BLOCK *, BOOL, BOOL ) );
 
 /*
  * The actual definition of WSASendTo, wrapped in a different function name
@@ -568,11 +580,16 @@ static inline const char *debugstr_optval(const char *optval, int optlenval)
 #define SOCKET2HANDLE(s) ((HANDLE)(s))
 #define HANDLE2SOCKET(h) ((SOCKET)(h))
 
+static void poll_cache_socket_closed( SOCKET s );
+
 static BOOL socket_list_add(SOCKET socket)
 {
     unsigned int i, new_size;
     SOCKET *new_array;
 
+    /* the handle value may have belonged to a socket closed with CloseHandle() */
+    poll_cache_socket_closed(socket);
+
     EnterCriticalSection(&cs_socket_list);
     for (i = 0; i < socket_list_size; ++i)
     {
@@ -601,6 +618,8 @@ static void socket_list_remove(SOCKET socket)
 {
     unsigned int i;
 
+    poll_cache_socket_closed(socket);
+
     EnterCriticalSection(&cs_socket_list);
     for (i = 0; i < socket_list_size; ++i)
     {
@@ -623,6 +642,7 @@ struct ws2_async_io
 {
     async_callback_t *callback; /* must be the first field */
     struct ws2_async_io *next;
+    BOOL polled;                /* queued in the in-process reactor */
 };
 
 struct ws2_async_shutdown
@@ -670,16 +690,19 @@ struct ws2_accept_async
 
 struct ws2_transmitfile_async
 {
-    struct ws2_async_io   io;
-    char                  *buffer;
-    HANDLE                file;
-    DWORD                 file_read;
-    DWORD                 file_bytes;
-    DWORD                 bytes_per_send;
-    TRANSMIT_FILE_BUFFERS buffers;
-    DWORD                 flags;
-    LARGE_INTEGER         offset;
-    struct ws2_async      write;
+    struct ws2_async_io      io;
+    char                     *buffer;
+    TRANSMIT_PACKETS_ELEMENT *elements;
+    DWORD                    element_count;
+    DWORD                    element;        /* element currently being sent */
+    HANDLE                   file;           /* file of the current element, once started */
+    DWORD                    file_read;
+    DWORD                    file_bytes;
+    DWORD                    bytes_per_send;
+    DWORD                    flags;
+    BOOL                     use_sendfile;
+    LARGE_INTEGER            offset;
+    struct ws2_async         write;
 };
 
 static struct ws2_async_io *async_io_freelist;
@@ -708,12 +731,16 @@ static struct ws2_async_io *alloc_async_io( DWORD size, async_callback_t callbac
     }
 
     io = HeapAlloc( GetProcessHeap(), 0, size );
-    if (io) io->callback = callback;
+    if (io)
+    {
+        io->callback = callback;
+        io->polled = FALSE;
+    }
     return io;
 }
 
-static NTSTATUS register_async( int type, HANDLE handle, struct ws2_async_io *async, HANDLE event,
-                                PIO_APC_ROUTINE apc, void *apc_context, IO_STATUS_BLOCK *io )
+static NTSTATUS server_register_async( int type, HANDLE handle, struct ws2_async_io *async, HANDLE event,
+                                       PIO_APC_ROUTINE apc, void *apc_context, IO_STATUS_BLOCK *io )
 {
     NTSTATUS status;
 
@@ -733,6 +760,20 @@ static NTSTATUS register_async( int type, HANDLE handle, struct ws2_async_io *as
     return status;
 }
 
+#define REACTOR_SERVER_READ   0x01  /* reads are queued in the server */
+#define REACTOR_SERVER_WRITE  0x02  /* writes are queued in the server */
+
+static void ws2_reactor_to_server( SOCKET s, unsigned int flags );
+
+static NTSTATUS register_async( int type, HANDLE handle, struct ws2_async_io *async, HANDLE event,
+                                PIO_APC_ROUTINE apc, void *apc_context, IO_STATUS_BLOCK *io )
+{
+    /* the operations already queued in the reactor must complete first */
+    ws2_reactor_to_server( HANDLE2SOCKET(handle),
+                           type == ASYNC_TYPE_WRITE ? REACTOR_SERVER_WRITE : REACTOR_SERVER_READ );
+    return server_register_async( type, handle, async, event, apc, apc_context, io );
+}
+
 /****************************************************************/
 
 /* ----------------------------------- internal data */
@@ -751,6 +792,53 @@ typedef struct          /* WSAAsyncSelect() control struct */
 #define WS_MAX_UDP_DATAGRAM             1024
 static INT WINAPI WSA_DefaultBlockingHook( FARPROC x );
 
+/* Per-thread cache of the unix fds of polled sockets
+ *
+ * select() and WSAPoll() keep the fds of the sockets they poll, so that
+ * polling the same sockets again doesn't have to go through
+ * wine_server_handle_to_fd() and dup() each of them. closesocket() drops
+ * the socket from every thread's cache, so that the cached fds don't keep
+ * it open; if the thread is blocked polling it, the fd is closed once the
+ * call returns, as it would have been before.
+ *
+ * When a large set is passed to WSAPoll(), the sockets are also kept
+ * registered in a per-thread epoll set, so that only the changes from
+ * the previous call need to be passed to the kernel. */
+
+#define POLL_CACHE_BOUND   0x01
+#define POLL_CACHE_DGRAM   0x02
+#define POLL_CACHE_EPOLL   0x04
+#define POLL_CACHE_CLOSED  0x08
+
+#define POLL_EPOLL_THRESHOLD   128
+
+struct poll_cache_entry
+{
+    SOCKET       s;
+    int          fd;        /* -1 if the slot is free */
+    unsigned int flags;
+    DWORD        access;    /* access rights checked for the handle */
+    unsigned int seq;       /* last WSAPoll() call that used the entry */
+    ULONG        index;     /* index of the socket in that call */
+    int          events;    /* events registered with epoll */
+    unsigned int call;      /* last call that listed the socket */
+};
+
+struct poll_cache
+{
+    struct list  entry;
+    CRITICAL_SECTION cs;
+    struct poll_cache_entry *entries;
+    unsigned int size;      /* power of two */
+    unsigned int count;
+    BOOL         polling;   /* the thread is waiting on the cached fds */
+    BOOL         closed;    /* some entries are marked POLL_CACHE_CLOSED */
+    unsigned int seq;
+    unsigned int listed;    /* entries listed by the current call */
+    int          epoll_fd;
+    unsigned int registered;
+};
+
 /* hostent's, servent's and protent's are stored in one buffer per thread,
  * as documented on MSDN for the functions that return any of the buffers */
 struct per_thread_data
@@ -761,6 +849,7 @@ struct per_thread_data
     struct WS_protoent *pe_buffer;
     struct pollfd *fd_cache;
     unsigned int fd_count;
+    struct poll_cache poll_cache;
     int he_len;
     int se_len;
     int pe_len;
@@ -788,6 +877,7 @@ int WSAIOCTL_GetInterfaceCount(void);
 int WSAIOCTL_GetInterfaceName(int intNumber, char *intName);
 
 static void WS_AddCompletion( SOCKET sock, ULONG_PTR CompletionValue, NTSTATUS CompletionStatus, ULONG Information, BOOL force );
+static void poll_cache_free( struct poll_cache *cache );
 
 #define MAP_OPTION(opt) { WS_##opt, opt }
 
@@ -1506,6 +1596,7 @@ static void free_per_thread_data(void)
     HeapFree( GetProcessHeap(), 0, ptb->se_buffer );
     HeapFree( GetProcessHeap(), 0, ptb->pe_buffer );
     HeapFree( GetProcessHeap(), 0, ptb->fd_cache );
+    poll_cache_free( &ptb->poll_cache );
 
     HeapFree( GetProcessHeap(), 0, ptb );
     NtCurrentTeb()->WinSockData = NULL;
@@ -2454,14 +2545,14 @@ static NTSTATUS WS2_async_recv( void *user, IO_STATUS_BLOCK *iosb, NTSTATUS stat
         if (result >= 0)
         {
             status = STATUS_SUCCESS;
-            _enable_event( wsa->hSocket, FD_READ, 0, 0 );
+            if (!wsa->io.polled) _enable_event( wsa->hSocket, FD_READ, 0, 0 );
         }
         else
         {
             if (errno == EAGAIN)
             {
                 status = STATUS_PENDING;
-                _enable_event( wsa->hSocket, FD_READ, 0, 0 );
+                if (!wsa->io.polled) _enable_event( wsa->hSocket, FD_READ, 0, 0 );
             }
             else
             {
@@ -2815,10 +2906,77 @@ static NTSTATUS WS2_ReadFile(HANDLE hFile, PIO_STATUS_BLOCK io_status, char* buf
     return status;
 }
 
+/***********************************************************************
+ *     WS2_transmitfile_sendfile        (INTERNAL)
+ *
+ * Send the next part of the current file element straight from the page
+ * cache with sendfile(), without copying it through wsa->buffer.
+ * Returns STATUS_NOT_SUPPORTED if the file cannot be sent this way.
+ */
+static NTSTATUS WS2_transmitfile_sendfile( int fd, struct ws2_transmitfile_async *wsa )
+{
+#ifdef HAVE_SYS_SENDFILE_H
+    IO_STATUS_BLOCK *iosb = (IO_STATUS_BLOCK *)wsa->write.user_overlapped;
+    size_t count = 0x7ffff000; /* the most a single sendfile() call transfers */
+    off_t offset, *poffset = NULL;
+    unsigned int options;
+    NTSTATUS status;
+    int file_fd;
+    ssize_t ret;
+
+    status = wine_server_handle_to_fd( wsa->file, FILE_READ_DATA, &file_fd, &options );
+    if (status) return status;
+
+    if (wsa->file_bytes != 0)
+        count = min( count, wsa->file_bytes - wsa->file_read );
+    if (wsa->offset.QuadPart != FILE_USE_FILE_POINTER_POSITION)
+    {
+        offset = wsa->offset.QuadPart;
+        poffset = &offset;
+    }
+
+    do
+        ret = sendfile( fd, file_fd, poffset, count );
+    while (ret == -1 && errno == EINTR);
+    close( file_fd );
+
+    if (ret == -1)
+    {
+        if (errno == EAGAIN)
+            return STATUS_PENDING;
+        if (errno != EINVAL && errno != ENOSYS && errno != EOPNOTSUPP)
+            return wsaErrStatus();
+        /* not a regular file, fall back to read() and send() */
+        TRACE( "sendfile() failed, errno %d\n", errno );
+        wsa->use_sendfile = FALSE;
+        return STATUS_NOT_SUPPORTED;
+    }
+
+    if (!ret)
+    {
+        wsa->file = NULL;
+        return STATUS_END_OF_FILE;
+    }
+
+    if (iosb) iosb->Information += ret;
+    if (wsa->offset.QuadPart != FILE_USE_FILE_POINTER_POSITION)
+        wsa->offset.QuadPart += ret;
+    wsa->file_read += ret;
+    if (wsa->file_bytes != 0 && wsa->file_read >= wsa->file_bytes)
+        wsa->file = NULL;
+    return STATUS_PENDING;
+#else
+    wsa->use_sendfile = FALSE;
+    return STATUS_NOT_SUPPORTED;
+#endif
+}
+
 /***********************************************************************
  *     WS2_transmitfile_getbuffer       (INTERNAL)
  *
- * Pick the appropriate buffer for a TransmitFile send operation.
+ * Pick the appropriate buffer for a TransmitFile or TransmitPackets send
+ * operation. File data may also be sent directly, in which case no
+ * buffer is returned.
  */
 static NTSTATUS WS2_transmitfile_getbuffer( int fd, struct ws2_transmitfile_async *wsa )
 {
@@ -2826,24 +2984,45 @@ static NTSTATUS WS2_transmitfile_getbuffer( int fd, struct ws2_transmitfile_asyn
     if (wsa->write.first_iovec < wsa->write.n_iovecs)
         return STATUS_PENDING;
 
-    /* process the header (if applicable) */
-    if (wsa->buffers.Head)
-    {
-        wsa->write.first_iovec       = 0;
-        wsa->write.n_iovecs          = 1;
-        wsa->write.iovec[0].iov_base = wsa->buffers.Head;
-        wsa->write.iovec[0].iov_len  = wsa->buffers.HeadLength;
-        wsa->buffers.Head            = NULL;
-        return STATUS_PENDING;
-    }
-
-    /* process the main file */
-    if (wsa->file)
+    while (wsa->element < wsa->element_count)
     {
+        TRANSMIT_PACKETS_ELEMENT *element = &wsa->elements[wsa->element];
         DWORD bytes_per_send = wsa->bytes_per_send;
         IO_STATUS_BLOCK iosb;
         NTSTATUS status;
 
+        if (element->dwElFlags & TP_ELEMENT_MEMORY)
+        {
+            ++wsa->element;
+            if (!element->cLength)
+                continue;
+            wsa->write.first_iovec       = 0;
+            wsa->write.n_iovecs          = 1;
+            wsa->write.iovec[0].iov_base = element->u.pBuffer;
+            wsa->write.iovec[0].iov_len  = element->cLength;
+            return STATUS_PENDING;
+        }
+
+        if (!wsa->file)
+        {
+            /* start on a new file element */
+            wsa->file       = element->u.s.hFile;
+            wsa->file_read  = 0;
+            wsa->file_bytes = element->cLength;
+            wsa->offset     = element->u.s.nFileOffset;
+        }
+
+        if (wsa->use_sendfile)
+        {
+            status = WS2_transmitfile_sendfile( fd, wsa );
+            if (status == STATUS_END_OF_FILE || (status == STATUS_PENDING && !wsa->file))
+                ++wsa->element;
+            if (status == STATUS_END_OF_FILE)
+                continue; /* continue on to the next element */
+            if (status != STATUS_NOT_SUPPORTED)
+                return status;
+        }
+
         iosb.Information = 0;
         /* when the size of the transfer is limited ensure that we don't go past that limit */
         if (wsa->file_bytes != 0)
@@ -2852,35 +3031,30 @@ static NTSTATUS WS2_transmitfile_getbuffer( int fd, struct ws2_transmitfile_asyn
         if (wsa->offset.QuadPart != FILE_USE_FILE_POINTER_POSITION)
             wsa->offset.QuadPart += iosb.Information;
         if (status == STATUS_END_OF_FILE)
-            wsa->file = NULL; /* continue on to the footer */
-        else if (status != STATUS_SUCCESS)
-            return status;
-        else
         {
-            if (iosb.Information)
-            {
-                wsa->write.first_iovec       = 0;
-                wsa->write.n_iovecs          = 1;
-                wsa->write.iovec[0].iov_base = wsa->buffer;
-                wsa->write.iovec[0].iov_len  = iosb.Information;
-                wsa->file_read += iosb.Information;
-            }
+            /* continue on to the next element */
+            wsa->file = NULL;
+            ++wsa->element;
+            continue;
+        }
+        if (status != STATUS_SUCCESS)
+            return status;
 
-            if (wsa->file_bytes != 0 && wsa->file_read >= wsa->file_bytes)
-                wsa->file = NULL;
+        if (iosb.Information)
+        {
+            wsa->write.first_iovec       = 0;
+            wsa->write.n_iovecs          = 1;
+            wsa->write.iovec[0].iov_base = wsa->buffer;
+            wsa->write.iovec[0].iov_len  = iosb.Information;
+            wsa->file_read += iosb.Information;
+        }
 
-            return STATUS_PENDING;
+        if (wsa->file_bytes != 0 && wsa->file_read >= wsa->file_bytes)
+        {
+            wsa->file = NULL;
+            ++wsa->element;
         }
-    }
 
-    /* send the footer (if applicable) */
-    if (wsa->buffers.Tail)
-    {
-        wsa->write.first_iovec       = 0;
-        wsa->write.n_iovecs          = 1;
-        wsa->write.iovec[0].iov_base = wsa->buffers.Tail;
-        wsa->write.iovec[0].iov_len  = wsa->buffers.TailLength;
-        wsa->buffers.Tail            = NULL;
         return STATUS_PENDING;
     }
 
@@ -2897,7 +3071,7 @@ static NTSTATUS WS2_transmitfile_base( int fd, struct ws2_transmitfile_async *ws
     NTSTATUS status;
 
     status = WS2_transmitfile_getbuffer( fd, wsa );
-    if (status == STATUS_PENDING)
+    if (status == STATUS_PENDING && wsa->write.first_iovec < wsa->write.n_iovecs)
     {
         IO_STATUS_BLOCK *iosb = (IO_STATUS_BLOCK *)wsa->write.user_overlapped;
         int n;
@@ -2941,62 +3115,35 @@ static NTSTATUS WS2_async_transmitfile( void *user, IO_STATUS_BLOCK *iosb, NTSTA
 }
 
 /***********************************************************************
- *     TransmitFile
+ *     WS2_transmit_alloc               (INTERNAL)
+ *
+ * Allocate the async state for a TransmitFile or TransmitPackets
+ * operation, with room for element_count elements.
  */
-static BOOL WINAPI WS2_TransmitFile( SOCKET s, HANDLE h, DWORD file_bytes, DWORD bytes_per_send,
-                                     LPOVERLAPPED overlapped, LPTRANSMIT_FILE_BUFFERS buffers,
-                                     DWORD flags )
+static struct ws2_transmitfile_async *WS2_transmit_alloc( SOCKET s, DWORD element_count, DWORD bytes_per_send,
+                                                          LPOVERLAPPED overlapped, DWORD flags )
 {
-    union generic_unix_sockaddr uaddr;
-    socklen_t uaddrlen = sizeof(uaddr);
     struct ws2_transmitfile_async *wsa;
-    NTSTATUS status;
-    int fd;
-
-    TRACE("(%lx, %p, %d, %d, %p, %p, %d)\n", s, h, file_bytes, bytes_per_send, overlapped,
-            buffers, flags );
-
-    fd = get_sock_fd( s, FILE_WRITE_DATA, NULL );
-    if (fd == -1) return FALSE;
-
-    if (getpeername( fd, &uaddr.addr, &uaddrlen ) != 0)
-    {
-        release_sock_fd( s, fd );
-        WSASetLastError( WSAENOTCONN );
-        return FALSE;
-    }
-    if (flags)
-        FIXME("Flags are not currently supported (0x%x).\n", flags);
-
-    if (h && GetFileType( h ) != FILE_TYPE_DISK)
-    {
-        FIXME("Non-disk file handles are not currently supported.\n");
-        release_sock_fd( s, fd );
-        WSASetLastError( WSAEOPNOTSUPP );
-        return FALSE;
-    }
 
     /* set reasonable defaults when requested */
     if (!bytes_per_send)
         bytes_per_send = (1 << 16); /* Depends on OS version: PAGE_SIZE, 2*PAGE_SIZE, or 2^16 */
 
-    if (!(wsa = (struct ws2_transmitfile_async *)alloc_async_io( sizeof(*wsa) + bytes_per_send,
+    if (!(wsa = (struct ws2_transmitfile_async *)alloc_async_io( sizeof(*wsa) + bytes_per_send
+                                                                 + element_count * sizeof(*wsa->elements),
                                                                  WS2_async_transmitfile )))
-    {
-        release_sock_fd( s, fd );
-        WSASetLastError( WSAEFAULT );
-        return FALSE;
-    }
-    if (buffers)
-        wsa->buffers = *buffers;
-    else
-        memset(&wsa->buffers, 0x0, sizeof(wsa->buffers));
-    wsa->buffer                = (char *)(wsa + 1);
-    wsa->file                  = h;
+        return NULL;
+
+    wsa->elements              = (TRANSMIT_PACKETS_ELEMENT *)(wsa + 1);
+    wsa->element_count         = 0;
+    wsa->element               = 0;
+    wsa->buffer                = (char *)(wsa->elements + element_count);
+    wsa->file                  = NULL;
     wsa->file_read             = 0;
-    wsa->file_bytes            = file_bytes;
+    wsa->file_bytes            = 0;
     wsa->bytes_per_send        = bytes_per_send;
     wsa->flags                 = flags;
+    wsa->use_sendfile          = TRUE;
     wsa->offset.QuadPart       = FILE_USE_FILE_POINTER_POSITION;
     wsa->write.hSocket         = SOCKET2HANDLE(s);
     wsa->write.addr            = NULL;
@@ -3007,13 +3154,24 @@ static BOOL WINAPI WS2_TransmitFile( SOCKET s, HANDLE h, DWORD file_bytes, DWORD
     wsa->write.n_iovecs        = 0;
     wsa->write.first_iovec     = 0;
     wsa->write.user_overlapped = overlapped;
+    return wsa;
+}
+
+/***********************************************************************
+ *     WS2_transmit                     (INTERNAL)
+ *
+ * Start a TransmitFile or TransmitPackets operation. Takes ownership of
+ * wsa and of the socket fd.
+ */
+static BOOL WS2_transmit( SOCKET s, int fd, struct ws2_transmitfile_async *wsa, LPOVERLAPPED overlapped )
+{
+    NTSTATUS status;
+
     if (overlapped)
     {
         IO_STATUS_BLOCK *iosb = (IO_STATUS_BLOCK *)overlapped;
         int status;
 
-        wsa->offset.u.LowPart  = overlapped->u.s.Offset;
-        wsa->offset.u.HighPart = overlapped->u.s.OffsetHigh;
         iosb->u.Status = STATUS_PENDING;
         iosb->Information = 0;
         status = register_async( ASYNC_TYPE_WRITE, SOCKET2HANDLE(s), &wsa->io,
@@ -3043,6 +3201,152 @@ static BOOL WINAPI WS2_TransmitFile( SOCKET s, HANDLE h, DWORD file_bytes, DWORD
     return (status == STATUS_SUCCESS);
 }
 
+/***********************************************************************
+ *     TransmitFile
+ */
+static BOOL WINAPI WS2_TransmitFile( SOCKET s, HANDLE h, DWORD file_bytes, DWORD bytes_per_send,
+                                     LPOVERLAPPED overlapped, LPTRANSMIT_FILE_BUFFERS buffers,
+                                     DWORD flags )
+{
+    union generic_unix_sockaddr uaddr;
+    socklen_t uaddrlen = sizeof(uaddr);
+    struct ws2_transmitfile_async *wsa;
+    TRANSMIT_PACKETS_ELEMENT *element;
+    int fd;
+
+    TRACE("(%lx, %p, %d, %d, %p, %p, %d)\n", s, h, file_bytes, bytes_per_send, overlapped,
+            buffers, flags );
+
+    fd = get_sock_fd( s, FILE_WRITE_DATA, NULL );
+    if (fd == -1) return FALSE;
+
+    if (getpeername( fd, &uaddr.addr, &uaddrlen ) != 0)
+    {
+        release_sock_fd( s, fd );
+        WSASetLastError( WSAENOTCONN );
+        return FALSE;
+    }
+    if (flags)
+        FIXME("Flags are not currently supported (0x%x).\n", flags);
+
+    if (h && GetFileType( h ) != FILE_TYPE_DISK)
+    {
+        FIXME("Non-disk file handles are not currently supported.\n");
+        release_sock_fd( s, fd );
+        WSASetLastError( WSAEOPNOTSUPP );
+        return FALSE;
+    }
+
+    if (!(wsa = WS2_transmit_alloc( s, 3, bytes_per_send, overlapped, flags )))
+    {
+        release_sock_fd( s, fd );
+        WSASetLastError( WSAEFAULT );
+        return FALSE;
+    }
+
+    /* the header, the file and the footer are sent as consecutive elements */
+    if (buffers && buffers->Head)
+    {
+        element = &wsa->elements[wsa->element_count++];
+        element->dwElFlags = TP_ELEMENT_MEMORY;
+        element->cLength   = buffers->HeadLength;
+        element->u.pBuffer   = buffers->Head;
+    }
+    if (h)
+    {
+        element = &wsa->elements[wsa->element_count++];
+        element->dwElFlags   = TP_ELEMENT_FILE;
+        element->cLength     = file_bytes;
+        element->u.s.hFile       = h;
+        element->u.s.nFileOffset.QuadPart = FILE_USE_FILE_POINTER_POSITION;
+        if (overlapped)
+        {
+            element->u.s.nFileOffset.u.LowPart  = overlapped->u.s.Offset;
+            element->u.s.nFileOffset.u.HighPart = overlapped->u.s.OffsetHigh;
+        }
+    }
+    if (buffers && buffers->Tail)
+    {
+        element = &wsa->elements[wsa->element_count++];
+        element->dwElFlags = TP_ELEMENT_MEMORY;
+        element->cLength   = buffers->TailLength;
+        element->u.pBuffer   = buffers->Tail;
+    }
+
+    return WS2_transmit( s, fd, wsa, overlapped );
+}
+
+/***********************************************************************
+ *     TransmitPackets
+ */
+static BOOL WINAPI WS2_TransmitPackets( SOCKET s, LPTRANSMIT_PACKETS_ELEMENT elements, DWORD count,
+                                        DWORD send_size, LPOVERLAPPED overlapped, DWORD flags )
+{
+    union generic_unix_sockaddr uaddr;
+    socklen_t uaddrlen = sizeof(uaddr);
+    struct ws2_transmitfile_async *wsa;
+    DWORD i;
+    int fd;
+
+    TRACE("(%lx, %p, %u, %u, %p, %#x)\n", s, elements, count, send_size, overlapped, flags );
+
+    fd = get_sock_fd( s, FILE_WRITE_DATA, NULL );
+    if (fd == -1) return FALSE;
+
+    if (getpeername( fd, &uaddr.addr, &uaddrlen ) != 0)
+    {
+        release_sock_fd( s, fd );
+        WSASetLastError( WSAENOTCONN );
+        return FALSE;
+    }
+    if (flags)
+        FIXME("Flags are not currently supported (0x%x).\n", flags);
+
+    if (count && !elements)
+    {
+        release_sock_fd( s, fd );
+        WSASetLastError( WSAEINVAL );
+        return FALSE;
+    }
+
+    for (i = 0; i < count; ++i)
+    {
+        if (!(elements[i].dwElFlags & (TP_ELEMENT_MEMORY | TP_ELEMENT_FILE))
+                || (elements[i].dwElFlags & (TP_ELEMENT_MEMORY | TP_ELEMENT_FILE))
+                        == (TP_ELEMENT_MEMORY | TP_ELEMENT_FILE))
+        {
+            release_sock_fd( s, fd );
+            WSASetLastError( WSAEINVAL );
+            return FALSE;
+        }
+        if ((elements[i].dwElFlags & TP_ELEMENT_FILE) && GetFileType( elements[i].u.s.hFile ) != FILE_TYPE_DISK)
+        {
+            FIXME("Non-disk file handles are not currently supported.\n");
+            release_sock_fd( s, fd );
+            WSASetLastError( WSAEOPNOTSUPP );
+            return FALSE;
+        }
+    }
+
+    if (!(wsa = WS2_transmit_alloc( s, count, send_size, overlapped, flags )))
+    {
+        release_sock_fd( s, fd );
+        WSASetLastError( WSAEFAULT );
+        return FALSE;
+    }
+
+    memcpy( wsa->elements, elements, count * sizeof(*elements) );
+    wsa->element_count = count;
+    for (i = 0; i < count; ++i)
+    {
+        /* an offset of -1 means the current file position */
+        if ((wsa->elements[i].dwElFlags & TP_ELEMENT_FILE) && wsa->elements[i].u.s.nFileOffset.QuadPart == -1)
+            wsa->elements[i].u.s.nFileOffset.QuadPart = FILE_USE_FILE_POINTER_POSITION;
+    }
+
+    return WS2_transmit( s, fd, wsa, overlapped );
+}
+
 /***********************************************************************
  *     GetAcceptExSockaddrs
  */
@@ -4807,7 +5111,7 @@ INT WINAPI WSAIoctl(SOCKET s, DWORD code, LPVOID in_buff, DWORD in_size, LPVOID
             EXTENSION_FUNCTION(WSAID_ACCEPTEX, WS2_AcceptEx)
             EXTENSION_FUNCTION(WSAID_GETACCEPTEXSOCKADDRS, WS2_GetAcceptExSockaddrs)
             EXTENSION_FUNCTION(WSAID_TRANSMITFILE, WS2_TransmitFile)
-            /* EXTENSION_FUNCTION(WSAID_TRANSMITPACKETS, WS2_TransmitPackets) */
+            EXTENSION_FUNCTION(WSAID_TRANSMITPACKETS, WS2_TransmitPackets)
             EXTENSION_FUNCTION(WSAID_WSARECVMSG, WS2_WSARecvMsg)
             EXTENSION_FUNCTION(WSAID_WSASENDMSG, WSASendMsg)
         };
@@ -5075,30 +5379,286 @@ int WINAPI WS_recvfrom(SOCKET s, char *buf, INT len, int flags,
         return n;
 }
 
-/* allocate a poll array for the corresponding fd sets */
-static struct pollfd *fd_sets_to_poll( const WS_fd_set *readfds, const WS_fd_set *writefds,
-                                       const WS_fd_set *exceptfds, int *count_ptr )
+static struct list poll_caches = LIST_INIT( poll_caches );
+DECLARE_CRITICAL_SECTION(cs_poll_caches);
+
+static inline unsigned int poll_cache_hash( SOCKET s )
 {
-    unsigned int i, j = 0, count = 0;
-    struct pollfd *fds;
-    struct per_thread_data *ptb = get_per_thread_data();
+    /* handles are multiples of 4 */
+    return (unsigned int)(s >> 2) * 0x9e3779b1;
+}
 
-    if (readfds) count += readfds->fd_count;
-    if (writefds) count += writefds->fd_count;
-    if (exceptfds) count += exceptfds->fd_count;
-    *count_ptr = count;
-    if (!count)
+static struct poll_cache_entry *poll_cache_find( struct poll_cache *cache, SOCKET s )
+{
+    unsigned int i, mask = cache->size - 1;
+
+    if (!cache->count) return NULL;
+    for (i = poll_cache_hash( s ) & mask; cache->entries[i].fd != -1; i = (i + 1) & mask)
+        if (cache->entries[i].s == s) return &cache->entries[i];
+    return NULL;
+}
+
+static void poll_cache_close_entry( struct poll_cache *cache, struct poll_cache_entry *entry )
+{
+#ifdef HAVE_SYS_EPOLL_H
+    if (entry->flags & POLL_CACHE_EPOLL)
     {
-        SetLastError(WSAEINVAL);
-        return NULL;
+        epoll_ctl( cache->epoll_fd, EPOLL_CTL_DEL, entry->fd, NULL );
+        cache->registered--;
     }
+#endif
+    close( entry->fd );
+}
 
-    /* check if the cache can hold all descriptors, if not do the resizing */
-    if (ptb->fd_count < count)
+static void poll_cache_remove( struct poll_cache *cache, struct poll_cache_entry *entry )
+{
+    unsigned int i = entry - cache->entries, j, k, mask = cache->size - 1;
+
+    poll_cache_close_entry( cache, entry );
+    cache->count--;
+
+    /* shift back the following entries of the cluster */
+    for (j = (i + 1) & mask; cache->entries[j].fd != -1; j = (j + 1) & mask)
     {
-        if (!(fds = HeapAlloc(GetProcessHeap(), 0, count * sizeof(fds[0]))))
-        {
-            SetLastError( ERROR_NOT_ENOUGH_MEMORY );
+        k = poll_cache_hash( cache->entries[j].s ) & mask;
+        if (i <= j ? (i < k && k <= j) : (i < k || k <= j)) continue;
+        cache->entries[i] = cache->entries[j];
+        i = j;
+    }
+    cache->entries[i].fd = -1;
+}
+
+static void poll_cache_flush( struct poll_cache *cache )
+{
+    unsigned int i;
+
+    for (i = 0; i < cache->size; i++)
+    {
+        if (cache->entries[i].fd == -1) continue;
+        poll_cache_close_entry( cache, &cache->entries[i] );
+        cache->entries[i].fd = -1;
+    }
+    cache->count = 0;
+}
+
+static void poll_cache_free( struct poll_cache *cache )
+{
+    if (!cache->entries) return;
+
+    EnterCriticalSection( &cs_poll_caches );
+    list_remove( &cache->entry );
+    LeaveCriticalSection( &cs_poll_caches );
+
+    poll_cache_flush( cache );
+    if (cache->epoll_fd != -1) close( cache->epoll_fd );
+    HeapFree( GetProcessHeap(), 0, cache->entries );
+    DeleteCriticalSection( &cache->cs );
+}
+
+/* called when a socket is closed with closesocket(), since the cached fds
+ * keep the socket open, and when a socket handle is created, since the
+ * handle value may have been used by a socket closed with CloseHandle() */
+static void poll_cache_socket_closed( SOCKET s )
+{
+    struct poll_cache_entry *entry;
+    struct poll_cache *cache;
+
+    if (list_empty( &poll_caches )) return;
+
+    EnterCriticalSection( &cs_poll_caches );
+    LIST_FOR_EACH_ENTRY( cache, &poll_caches, struct poll_cache, entry )
+    {
+        EnterCriticalSection( &cache->cs );
+        if ((entry = poll_cache_find( cache, s )))
+        {
+            if (cache->polling)
+            {
+                entry->flags |= POLL_CACHE_CLOSED;
+                cache->closed = TRUE;
+            }
+            else poll_cache_remove( cache, entry );
+        }
+        LeaveCriticalSection( &cache->cs );
+    }
+    LeaveCriticalSection( &cs_poll_caches );
+}
+
+/* lock the thread's cache; returns NULL with the last error set on failure */
+static struct poll_cache *poll_cache_acquire(void)
+{
+    struct poll_cache *cache = &get_per_thread_data()->poll_cache;
+    unsigned int i;
+
+    if (!cache->entries)
+    {
+        cache->size = 64;
+        if (!(cache->entries = HeapAlloc( GetProcessHeap(), 0, cache->size * sizeof(*cache->entries) )))
+        {
+            SetLastError( WSAENOBUFS );
+            return NULL;
+        }
+        memset( cache->entries, 0xff, cache->size * sizeof(*cache->entries) );
+        cache->epoll_fd = -1;
+        InitializeCriticalSection( &cache->cs );
+
+        EnterCriticalSection( &cs_poll_caches );
+        list_add_tail( &poll_caches, &cache->entry );
+        LeaveCriticalSection( &cs_poll_caches );
+    }
+
+    EnterCriticalSection( &cache->cs );
+    cache->polling = FALSE;
+    if (cache->closed)
+    {
+        /* removing an entry may shift a following one to the same slot */
+        for (i = 0; i < cache->size;)
+        {
+            if (cache->entries[i].fd != -1 && (cache->entries[i].flags & POLL_CACHE_CLOSED))
+                poll_cache_remove( cache, &cache->entries[i] );
+            else
+                i++;
+        }
+        cache->closed = FALSE;
+    }
+    return cache;
+}
+
+/* start a new poll call on the locked cache, returns its sequence number */
+static unsigned int poll_cache_start( struct poll_cache *cache )
+{
+    cache->listed = 0;
+    return ++cache->seq;
+}
+
+/* close the fds of the sockets that the current call didn't list, so that
+ * rotating socket sets don't keep a growing number of fds open */
+static void poll_cache_evict( struct poll_cache *cache )
+{
+    unsigned int i;
+
+    if (cache->count == cache->listed) return;
+
+    /* removing an entry may shift a following one to the same slot */
+    for (i = 0; i < cache->size;)
+    {
+        if (cache->entries[i].fd != -1 && cache->entries[i].call != cache->seq)
+            poll_cache_remove( cache, &cache->entries[i] );
+        else
+            i++;
+    }
+}
+
+/* unlock the thread's cache, before waiting on the cached fds if wait is set */
+static void poll_cache_release( struct poll_cache *cache, BOOL wait )
+{
+    cache->polling = wait;
+    LeaveCriticalSection( &cache->cs );
+}
+
+static BOOL poll_cache_grow( struct poll_cache *cache )
+{
+    struct poll_cache_entry *entries, *old = cache->entries;
+    unsigned int i, j, size = cache->size * 2;
+
+    if (!(entries = HeapAlloc( GetProcessHeap(), 0, size * sizeof(*entries) ))) return FALSE;
+    memset( entries, 0xff, size * sizeof(*entries) );
+    for (i = 0; i < cache->size; i++)
+    {
+        if (old[i].fd == -1) continue;
+        for (j = poll_cache_hash( old[i].s ) & (size - 1); entries[j].fd != -1; j = (j + 1) & (size - 1))
+            ;
+        entries[j] = old[i];
+    }
+    cache->entries = entries;
+    cache->size = size;
+    HeapFree( GetProcessHeap(), 0, old );
+    return TRUE;
+}
+
+/* returns the cache entry of a socket whose handle grants the requested
+ * access, or NULL with the last error set */
+static struct poll_cache_entry *poll_cache_get( struct poll_cache *cache, SOCKET s, DWORD access )
+{
+    struct poll_cache_entry *entry;
+    unsigned int i, mask;
+    int fd;
+
+    if ((entry = poll_cache_find( cache, s )))
+    {
+        if ((entry->access & access) != access)
+        {
+            if ((fd = get_sock_fd( s, access, NULL )) == -1) return NULL;
+            release_sock_fd( s, fd );
+            entry->access |= access;
+        }
+        if (entry->call != cache->seq)
+        {
+            entry->call = cache->seq;
+            cache->listed++;
+        }
+        return entry;
+    }
+
+    if ((fd = get_sock_fd( s, access, NULL )) == -1) return NULL;
+    if ((cache->count + 1) * 2 > cache->size && !poll_cache_grow( cache ))
+    {
+        release_sock_fd( s, fd );
+        SetLastError( WSAENOBUFS );
+        return NULL;
+    }
+
+    mask = cache->size - 1;
+    for (i = poll_cache_hash( s ) & mask; cache->entries[i].fd != -1; i = (i + 1) & mask)
+        ;
+    entry = &cache->entries[i];
+    entry->s      = s;
+    entry->fd     = fd;
+    entry->flags  = _get_fd_type( fd ) == SOCK_DGRAM ? POLL_CACHE_DGRAM : 0;
+    entry->access = access;
+    entry->seq    = 0;
+    entry->index  = 0;
+    entry->events = 0;
+    entry->call   = cache->seq;
+    cache->count++;
+    cache->listed++;
+    return entry;
+}
+
+/* a socket can't be unbound, so only a positive answer is cached */
+static BOOL poll_cache_is_bound( struct poll_cache_entry *entry )
+{
+    if (entry->flags & POLL_CACHE_BOUND) return TRUE;
+    if (is_fd_bound( entry->fd, NULL, NULL ) != 1) return FALSE;
+    entry->flags |= POLL_CACHE_BOUND;
+    return TRUE;
+}
+
+/* allocate a poll array for the corresponding fd sets */
+static struct pollfd *fd_sets_to_poll( struct poll_cache *cache, const WS_fd_set *readfds,
+                                       const WS_fd_set *writefds, const WS_fd_set *exceptfds,
+                                       int *count_ptr )
+{
+    unsigned int i, j = 0, count = 0;
+    struct pollfd *fds;
+    struct per_thread_data *ptb = get_per_thread_data();
+    struct poll_cache_entry *entry;
+
+    if (readfds) count += readfds->fd_count;
+    if (writefds) count += writefds->fd_count;
+    if (exceptfds) count += exceptfds->fd_count;
+    *count_ptr = count;
+    if (!count)
+    {
+        SetLastError(WSAEINVAL);
+        return NULL;
+    }
+
+    /* check if the cache can hold all descriptors, if not do the resizing */
+    if (ptb->fd_count < count)
+    {
+        if (!(fds = HeapAlloc(GetProcessHeap(), 0, count * sizeof(fds[0]))))
+        {
+            SetLastError( ERROR_NOT_ENOUGH_MEMORY );
             return NULL;
         }
         HeapFree(GetProcessHeap(), 0, ptb->fd_cache);
@@ -5111,16 +5671,15 @@ static struct pollfd *fd_sets_to_poll( const WS_fd_set *readfds, const WS_fd_set
     if (readfds)
         for (i = 0; i < readfds->fd_count; i++, j++)
         {
-            fds[j].fd = get_sock_fd( readfds->fd_array[i], FILE_READ_DATA, NULL );
-            if (fds[j].fd == -1) goto failed;
+            if (!(entry = poll_cache_get( cache, readfds->fd_array[i], FILE_READ_DATA ))) return NULL;
             fds[j].revents = 0;
-            if (is_fd_bound(fds[j].fd, NULL, NULL) == 1)
+            if (poll_cache_is_bound( entry ))
             {
+                fds[j].fd = entry->fd;
                 fds[j].events = POLLIN;
             }
             else
             {
-                release_sock_fd( readfds->fd_array[i], fds[j].fd );
                 fds[j].fd = -1;
                 fds[j].events = 0;
             }
@@ -5128,17 +5687,15 @@ static struct pollfd *fd_sets_to_poll( const WS_fd_set *readfds, const WS_fd_set
     if (writefds)
         for (i = 0; i < writefds->fd_count; i++, j++)
         {
-            fds[j].fd = get_sock_fd( writefds->fd_array[i], FILE_WRITE_DATA, NULL );
-            if (fds[j].fd == -1) goto failed;
+            if (!(entry = poll_cache_get( cache, writefds->fd_array[i], FILE_WRITE_DATA ))) return NULL;
             fds[j].revents = 0;
-            if (is_fd_bound(fds[j].fd, NULL, NULL) == 1 ||
-                _get_fd_type(fds[j].fd) == SOCK_DGRAM)
+            if ((entry->flags & POLL_CACHE_DGRAM) || poll_cache_is_bound( entry ))
             {
+                fds[j].fd = entry->fd;
                 fds[j].events = POLLOUT;
             }
             else
             {
-                release_sock_fd( writefds->fd_array[i], fds[j].fd );
                 fds[j].fd = -1;
                 fds[j].events = 0;
             }
@@ -5146,14 +5703,14 @@ static struct pollfd *fd_sets_to_poll( const WS_fd_set *readfds, const WS_fd_set
     if (exceptfds)
         for (i = 0; i < exceptfds->fd_count; i++, j++)
         {
-            fds[j].fd = get_sock_fd( exceptfds->fd_array[i], 0, NULL );
-            if (fds[j].fd == -1) goto failed;
+            if (!(entry = poll_cache_get( cache, exceptfds->fd_array[i], 0 ))) return NULL;
             fds[j].revents = 0;
-            if (is_fd_bound(fds[j].fd, NULL, NULL) == 1)
+            if (poll_cache_is_bound( entry ))
             {
                 int oob_inlined = 0;
                 socklen_t olen = sizeof(oob_inlined);
 
+                fds[j].fd = entry->fd;
                 fds[j].events = POLLHUP;
 
                 /* Check if we need to test for urgent data or not */
@@ -5163,51 +5720,27 @@ static struct pollfd *fd_sets_to_poll( const WS_fd_set *readfds, const WS_fd_set
             }
             else
             {
-                release_sock_fd( exceptfds->fd_array[i], fds[j].fd );
                 fds[j].fd = -1;
                 fds[j].events = 0;
             }
         }
     return fds;
-
-failed:
-    count = j;
-    j = 0;
-    if (readfds)
-        for (i = 0; i < readfds->fd_count && j < count; i++, j++)
-            if (fds[j].fd != -1) release_sock_fd( readfds->fd_array[i], fds[j].fd );
-    if (writefds)
-        for (i = 0; i < writefds->fd_count && j < count; i++, j++)
-            if (fds[j].fd != -1) release_sock_fd( writefds->fd_array[i], fds[j].fd );
-    if (exceptfds)
-        for (i = 0; i < exceptfds->fd_count && j < count; i++, j++)
-            if (fds[j].fd != -1) release_sock_fd( exceptfds->fd_array[i], fds[j].fd );
-    return NULL;
 }
 
-/* release the file descriptor obtained in fd_sets_to_poll */
+/* ignore hangups of the sockets that were closed while polling */
 /* must be called with the original fd_set arrays, before calling get_poll_results */
-static void release_poll_fds( const WS_fd_set *readfds, const WS_fd_set *writefds,
-                              const WS_fd_set *exceptfds, struct pollfd *fds )
+static void check_closed_poll_fds( const WS_fd_set *readfds, const WS_fd_set *writefds,
+                                   const WS_fd_set *exceptfds, struct pollfd *fds )
 {
     unsigned int i, j = 0;
 
-    if (readfds)
-    {
-        for (i = 0; i < readfds->fd_count; i++, j++)
-            if (fds[j].fd != -1) release_sock_fd( readfds->fd_array[i], fds[j].fd );
-    }
-    if (writefds)
-    {
-        for (i = 0; i < writefds->fd_count; i++, j++)
-            if (fds[j].fd != -1) release_sock_fd( writefds->fd_array[i], fds[j].fd );
-    }
+    if (readfds) j += readfds->fd_count;
+    if (writefds) j += writefds->fd_count;
     if (exceptfds)
     {
         for (i = 0; i < exceptfds->fd_count; i++, j++)
         {
             if (fds[j].fd == -1) continue;
-            release_sock_fd( exceptfds->fd_array[i], fds[j].fd );
             if (fds[j].revents & POLLHUP)
             {
                 int fd = get_sock_fd( exceptfds->fd_array[i], 0, NULL );
@@ -5297,31 +5830,169 @@ int WINAPI WS_select(int nfds, WS_fd_set *ws_readfds,
                      WS_fd_set *ws_writefds, WS_fd_set *ws_exceptfds,
                      const struct WS_timeval* ws_timeout)
 {
+    struct poll_cache *cache;
     struct pollfd *pollfds;
     int count, ret, timeout = -1;
 
     TRACE("read %p, write %p, excp %p timeout %p\n",
           ws_readfds, ws_writefds, ws_exceptfds, ws_timeout);
 
-    if (!(pollfds = fd_sets_to_poll( ws_readfds, ws_writefds, ws_exceptfds, &count )))
+    if (!(cache = poll_cache_acquire()))
         return SOCKET_ERROR;
+    poll_cache_start( cache );
+    if (!(pollfds = fd_sets_to_poll( cache, ws_readfds, ws_writefds, ws_exceptfds, &count )))
+    {
+        poll_cache_release( cache, FALSE );
+        return SOCKET_ERROR;
+    }
+    poll_cache_evict( cache );
+    poll_cache_release( cache, TRUE );
 
     if (ws_timeout)
         timeout = (ws_timeout->tv_sec * 1000) + (ws_timeout->tv_usec + 999) / 1000;
 
     ret = do_poll(pollfds, count, timeout);
-    release_poll_fds( ws_readfds, ws_writefds, ws_exceptfds, pollfds );
+
+    /* close the fds of the sockets closed while polling */
+    cache = poll_cache_acquire();
+    poll_cache_release( cache, FALSE );
+    check_closed_poll_fds( ws_readfds, ws_writefds, ws_exceptfds, pollfds );
 
     if (ret == -1) SetLastError(wsaErrno());
     else ret = get_poll_results( ws_readfds, ws_writefds, ws_exceptfds, pollfds );
     return ret;
 }
 
+#ifdef HAVE_SYS_EPOLL_H
+
+static int do_epoll( int epoll_fd, struct epoll_event *events, int count, int timeout )
+{
+    struct timeval tv1, tv2;
+    int ret, torig = timeout;
+
+    if (timeout > 0) gettimeofday( &tv1, 0 );
+
+    while ((ret = epoll_wait( epoll_fd, events, count, timeout )) < 0)
+    {
+        if (errno != EINTR) break;
+        if (timeout < 0) continue;
+        if (timeout == 0) return 0;
+
+        gettimeofday( &tv2, 0 );
+
+        tv2.tv_sec  -= tv1.tv_sec;
+        tv2.tv_usec -= tv1.tv_usec;
+        if (tv2.tv_usec < 0)
+        {
+            tv2.tv_usec += 1000000;
+            tv2.tv_sec  -= 1;
+        }
+
+        timeout = torig - (tv2.tv_sec * 1000) - (tv2.tv_usec + 999) / 1000;
+        if (timeout <= 0) return 0;
+    }
+    return ret;
+}
+
+/* poll a large set with the thread's epoll set; returns -2 if the set can't be used */
+/* must be called with the cache locked */
+static int poll_with_epoll( struct poll_cache *cache, WSAPOLLFD *wfds, ULONG count, int timeout )
+{
+    struct poll_cache_entry *entry;
+    struct epoll_event *events, ev;
+    unsigned int seq;
+    int i, n, ret = 0;
+
+    if (cache->epoll_fd == -1)
+    {
+        if ((cache->epoll_fd = epoll_create( count )) == -1) return -2;
+        fcntl( cache->epoll_fd, F_SETFD, FD_CLOEXEC );
+    }
+
+    seq = poll_cache_start( cache );
+    for (i = 0; i < count; i++)
+    {
+        wfds[i].revents = 0;
+        if (!(entry = poll_cache_get( cache, wfds[i].fd, 0 )))
+        {
+            wfds[i].revents = WS_POLLNVAL;
+            continue;
+        }
+        /* the same socket is listed twice */
+        if (entry->seq == seq) return -2;
+        entry->seq   = seq;
+        entry->index = i;
+
+        /* the poll flags have the same values as the epoll ones */
+        ev.events = convert_poll_w2u( wfds[i].events );
+        ev.data.u64 = entry->s;
+        if (!(entry->flags & POLL_CACHE_EPOLL))
+        {
+            if (epoll_ctl( cache->epoll_fd, EPOLL_CTL_ADD, entry->fd, &ev ) == -1) return -2;
+            entry->flags |= POLL_CACHE_EPOLL;
+            entry->events = ev.events;
+            cache->registered++;
+        }
+        else if (entry->events != ev.events)
+        {
+            if (epoll_ctl( cache->epoll_fd, EPOLL_CTL_MOD, entry->fd, &ev ) == -1) return -2;
+            entry->events = ev.events;
+        }
+    }
+
+    /* this also stops watching the sockets that are no longer polled */
+    poll_cache_evict( cache );
+
+    if (!(events = HeapAlloc( GetProcessHeap(), 0, count * sizeof(*events) )))
+    {
+        SetLastError( WSAENOBUFS );
+        return SOCKET_ERROR;
+    }
+
+    poll_cache_release( cache, TRUE );
+    n = do_epoll( cache->epoll_fd, events, count, timeout );
+    if (n == -1)
+    {
+        SetLastError( wsaErrno() );
+        ret = SOCKET_ERROR;
+    }
+    poll_cache_acquire();
+
+    for (i = 0; i < n; i++)
+    {
+        SOCKET s = events[i].data.u64;
+
+        if (!(entry = poll_cache_find( cache, s ))) continue;
+        if (events[i].events & POLLHUP)
+        {
+            /* Check if the socket still exists */
+            int fd = get_sock_fd( s, 0, NULL );
+            if (fd != -1)
+            {
+                wfds[entry->index].revents = WS_POLLHUP;
+                release_sock_fd( s, fd );
+            }
+            else
+                wfds[entry->index].revents = WS_POLLNVAL;
+        }
+        else
+            wfds[entry->index].revents = convert_poll_u2w( events[i].events );
+        if (wfds[entry->index].revents) ret++;
+    }
+
+    HeapFree( GetProcessHeap(), 0, events );
+    return ret;
+}
+
+#endif  /* HAVE_SYS_EPOLL_H */
+
 /***********************************************************************
  *     WSAPoll
  */
 int WINAPI WSAPoll(WSAPOLLFD *wfds, ULONG count, int timeout)
 {
+    struct poll_cache_entry *entry;
+    struct poll_cache *cache;
     int i, ret;
     struct pollfd *ufds;
 
@@ -5336,26 +6007,46 @@ int WINAPI WSAPoll(WSAPOLLFD *wfds, ULONG count, int timeout)
         return SOCKET_ERROR;
     }
 
+    if (!(cache = poll_cache_acquire()))
+        return SOCKET_ERROR;
+
+#ifdef HAVE_SYS_EPOLL_H
+    if (count >= POLL_EPOLL_THRESHOLD &&
+        (ret = poll_with_epoll( cache, wfds, count, timeout )) != -2)
+    {
+        poll_cache_release( cache, FALSE );
+        return ret;
+    }
+#endif
+
     if (!(ufds = HeapAlloc(GetProcessHeap(), 0, count * sizeof(ufds[0]))))
     {
+        poll_cache_release( cache, FALSE );
         SetLastError(WSAENOBUFS);
         return SOCKET_ERROR;
     }
 
+    poll_cache_start( cache );
     for (i = 0; i < count; i++)
     {
-        ufds[i].fd = get_sock_fd(wfds[i].fd, 0, NULL);
+        entry = poll_cache_get( cache, wfds[i].fd, 0 );
+        ufds[i].fd = entry ? entry->fd : -1;
         ufds[i].events = convert_poll_w2u(wfds[i].events);
         ufds[i].revents = 0;
     }
+    poll_cache_evict( cache );
+    poll_cache_release( cache, TRUE );
 
     ret = do_poll(ufds, count, timeout);
 
+    /* close the fds of the sockets closed while polling */
+    cache = poll_cache_acquire();
+    poll_cache_release( cache, FALSE );
+
     for (i = 0; i < count; i++)
     {
         if (ufds[i].fd != -1)
         {
-            release_sock_fd(wfds[i].fd, ufds[i].fd);
             if (ufds[i].revents & POLLHUP)
             {
                 /* Check if the socket still exists */
@@ -5383,18 +6074,386 @@ int WINAPI WSAPoll(WSAPOLLFD *wfds, ULONG count, int timeout)
 static void WS_AddCompletion( SOCKET sock, ULONG_PTR CompletionValue, NTSTATUS CompletionStatus,
                               ULONG Information, BOOL async )
 {
-    SERVER_START_REQ( add_fd_completion )
+    __wine_add_fd_completion( SOCKET2HANDLE(sock), CompletionValue, CompletionStatus, Information, async );
+}
+
+/***********************************************************************
+ * In-process completion of overlapped socket I/O
+ *
+ * Pending overlapped operations are normally queued in the server, which
+ * polls the socket and wakes a thread of the process up to perform the
+ * I/O. When enabled through the "InProcessAsync" value of the
+ * HKCU\Software\Wine\WinSock key, operations that complete through an
+ * event or a completion port are instead queued here and performed by a
+ * reactor thread polling the sockets with epoll. Their completions are
+ * posted with __wine_add_fd_completion(), which doesn't need the server
+ * when the socket was associated with a port of this process.
+ *
+ * ntdll calls back into the reactor to cancel operations from
+ * NtCancelIoFile(Ex)() and when a socket handle is closed, which also
+ * drops the reactor state and the fd it keeps for the handle.
+ *
+ * Each direction of a socket is handled either by the reactor or by the
+ * server, so that operations complete in issue order. A direction moves
+ * to the server for good, along with the operations queued in the
+ * reactor, as soon as ws2_32 queues an async there, for instance for a
+ * completion routine or a shutdown. Sockets selected with WSAEventSelect()
+ * or WSAAsyncSelect() are left to the server, which needs to see their
+ * I/O to re-enable events. Asyncs queued in the server through
+ * NtReadFile() and NtWriteFile() are not coordinated with the reactor.
+ */
+
+#ifdef HAVE_SYS_EPOLL_H
+
+struct ws2_reactor_op
+{
+    struct list          entry;
+    struct ws2_async    *wsa;
+    IO_STATUS_BLOCK     *iosb;
+    HANDLE               event;
+    ULONG_PTR            cvalue;
+    DWORD                tid;
+};
+
+struct ws2_reactor_socket
+{
+    struct wine_rb_entry entry;
+    SOCKET               s;
+    int                  fd;     /* fd polled while operations are pending, or -1 */
+    unsigned int         flags;
+    struct list          ops[2]; /* pending reads and writes, in issue order */
+};
+
+static int reactor_socket_compare( const void *key, const struct wine_rb_entry *entry )
+{
+    const struct ws2_reactor_socket *sock = WINE_RB_ENTRY_VALUE( entry, const struct ws2_reactor_socket, entry );
+    SOCKET s = *(const SOCKET *)key;
+
+    return s < sock->s ? -1 : s > sock->s;
+}
+
+DECLARE_CRITICAL_SECTION(cs_reactor);
+static struct wine_rb_tree reactor_sockets = { reactor_socket_compare };
+static int reactor_epoll = -1;
+
+/* must be called with cs_reactor held */
+static struct ws2_reactor_socket *reactor_get_socket( SOCKET s, BOOL create )
+{
+    struct ws2_reactor_socket *sock;
+    struct wine_rb_entry *entry;
+
+    if ((entry = wine_rb_get( &reactor_sockets, &s )))
+        return WINE_RB_ENTRY_VALUE( entry, struct ws2_reactor_socket, entry );
+    if (!create || !(sock = HeapAlloc( GetProcessHeap(), 0, sizeof(*sock) ))) return NULL;
+    sock->s     = s;
+    sock->fd    = -1;
+    sock->flags = 0;
+    list_init( &sock->ops[0] );
+    list_init( &sock->ops[1] );
+    wine_rb_put( &reactor_sockets, &s, &sock->entry );
+    return sock;
+}
+
+/* must be called with cs_reactor held */
+static void reactor_update_socket( struct ws2_reactor_socket *sock )
+{
+    struct epoll_event event;
+
+    event.events = 0;
+    if (!list_empty( &sock->ops[0] )) event.events |= EPOLLIN | EPOLLPRI;
+    if (!list_empty( &sock->ops[1] )) event.events |= EPOLLOUT;
+
+    if (!event.events)
     {
-        req->handle      = wine_server_obj_handle( SOCKET2HANDLE(sock) );
-        req->cvalue      = CompletionValue;
-        req->status      = CompletionStatus;
-        req->information = Information;
-        req->async       = async;
-        wine_server_call( req );
+        if (sock->fd != -1)
+        {
+            epoll_ctl( reactor_epoll, EPOLL_CTL_DEL, sock->fd, &event );
+            close( sock->fd );
+            sock->fd = -1;
+        }
+        if (!sock->flags)
+        {
+            wine_rb_remove( &reactor_sockets, &sock->entry );
+            HeapFree( GetProcessHeap(), 0, sock );
+        }
+        return;
     }
-    SERVER_END_REQ;
+
+    event.data.u64 = sock->s;
+    epoll_ctl( reactor_epoll, EPOLL_CTL_MOD, sock->fd, &event );
+}
+
+/* must be called with cs_reactor held, which keeps the socket handle open */
+static void reactor_complete_op( SOCKET s, struct ws2_reactor_op *op )
+{
+    NTSTATUS status = op->iosb->u.Status;
+    ULONG_PTR information = op->iosb->Information;
+
+    list_remove( &op->entry );
+    if (op->cvalue) WS_AddCompletion( s, op->cvalue, status, information, TRUE );
+    if (op->event) SetEvent( op->event );
+    HeapFree( GetProcessHeap(), 0, op );
+}
+
+/* must be called with cs_reactor held */
+static void reactor_run_ops( SOCKET s, struct list *ops )
+{
+    struct ws2_reactor_op *op, *next;
+
+    LIST_FOR_EACH_ENTRY_SAFE( op, next, ops, struct ws2_reactor_op, entry )
+    {
+        /* the callback releases the async once it is done */
+        if (op->wsa->io.callback( op->wsa, op->iosb, STATUS_ALERTED ) == STATUS_PENDING)
+            break;
+        reactor_complete_op( s, op );
+    }
+}
+
+/* must be called with cs_reactor held */
+static void reactor_cancel_op( SOCKET s, struct ws2_reactor_op *op )
+{
+    op->wsa->io.callback( op->wsa, op->iosb, STATUS_CANCELLED );
+    reactor_complete_op( s, op );
+}
+
+/* must be called with cs_reactor held */
+static void reactor_move_to_server( struct ws2_reactor_socket *sock, unsigned int flags )
+{
+    struct ws2_reactor_op *op, *next;
+    NTSTATUS status;
+    int i;
+
+    for (i = 0; i < 2; i++)
+    {
+        if (!(flags & (REACTOR_SERVER_READ << i)) || (sock->flags & (REACTOR_SERVER_READ << i)))
+            continue;
+        LIST_FOR_EACH_ENTRY_SAFE( op, next, &sock->ops[i], struct ws2_reactor_op, entry )
+        {
+            op->wsa->io.polled = FALSE;
+            status = server_register_async( i ? ASYNC_TYPE_WRITE : ASYNC_TYPE_READ, SOCKET2HANDLE(sock->s),
+                                            &op->wsa->io, op->event, NULL, (void *)op->cvalue, op->iosb );
+            if (status == STATUS_PENDING)
+            {
+                list_remove( &op->entry );
+                HeapFree( GetProcessHeap(), 0, op );
+                continue;
+            }
+            op->wsa->io.callback( op->wsa, op->iosb, status );
+            reactor_complete_op( sock->s, op );
+        }
+    }
+    sock->flags |= flags;
 }
 
+static void reactor_process_socket( SOCKET s )
+{
+    struct ws2_reactor_socket *sock;
+
+    EnterCriticalSection( &cs_reactor );
+    /* the socket may have been closed since epoll_wait() returned */
+    if ((sock = reactor_get_socket( s, FALSE )) && sock->fd != -1)
+    {
+        reactor_run_ops( s, &sock->ops[0] );
+        reactor_run_ops( s, &sock->ops[1] );
+        reactor_update_socket( sock );
+    }
+    LeaveCriticalSection( &cs_reactor );
+}
+
+static DWORD WINAPI reactor_thread( void *arg )
+{
+    struct epoll_event events[64];
+    int i, count;
+
+    for (;;)
+    {
+        if ((count = epoll_wait( reactor_epoll, events, ARRAY_SIZE(events), -1 )) == -1)
+        {
+            if (errno == EINTR) continue;
+            ERR( "epoll_wait failed, errno %d\n", errno );
+            return 1;
+        }
+
+        for (i = 0; i < count; ++i)
+            reactor_process_socket( events[i].data.u64 );
+    }
+}
+
+/***********************************************************************
+ *     reactor_cancel_io                (INTERNAL)
+ *
+ * Cancel the operations queued in the reactor for a handle, either because
+ * of NtCancelIoFile(Ex)() or because the handle is being closed. Returns
+ * the number of cancelled operations.
+ */
+static ULONG CDECL reactor_cancel_io( HANDLE handle, IO_STATUS_BLOCK *iosb, BOOL only_thread, BOOL close )
+{
+    SOCKET s = HANDLE2SOCKET(handle);
+    struct ws2_reactor_socket *sock;
+    struct ws2_reactor_op *op, *next;
+    ULONG count = 0;
+    int i;
+
+    if (!reactor_sockets.root) return 0;
+
+    EnterCriticalSection( &cs_reactor );
+    if ((sock = reactor_get_socket( s, FALSE )))
+    {
+        for (i = 0; i < 2; i++)
+        {
+            LIST_FOR_EACH_ENTRY_SAFE( op, next, &sock->ops[i], struct ws2_reactor_op, entry )
+            {
+                if (iosb && op->iosb != iosb) continue;
+                if (only_thread && op->tid != GetCurrentThreadId()) continue;
+                reactor_cancel_op( s, op );
+                count++;
+            }
+        }
+        if (close) sock->flags = 0;
+        reactor_update_socket( sock );
+    }
+    LeaveCriticalSection( &cs_reactor );
+    return count;
+}
+
+static BOOL WINAPI reactor_init_once( INIT_ONCE *once, void *param, void **context )
+{
+    char buffer[4];
+    DWORD size = sizeof(buffer);
+    HANDLE thread;
+    HKEY key;
+    int fd;
+
+    if (RegOpenKeyExA( HKEY_CURRENT_USER, "Software\\Wine\\WinSock", 0, KEY_READ, &key ))
+        return TRUE;
+    if (RegQueryValueExA( key, "InProcessAsync", NULL, NULL, (BYTE *)buffer, &size )
+            || (buffer[0] != 'y' && buffer[0] != 'Y'))
+    {
+        RegCloseKey( key );
+        return TRUE;
+    }
+    RegCloseKey( key );
+
+    if ((fd = epoll_create( 64 )) == -1)
+    {
+        WARN( "epoll_create failed, errno %d\n", errno );
+        return TRUE;
+    }
+    fcntl( fd, F_SETFD, FD_CLOEXEC );
+    reactor_epoll = fd;
+
+    if (!(thread = CreateThread( NULL, 0, reactor_thread, NULL, 0, NULL )))
+    {
+        reactor_epoll = -1;
+        close( fd );
+        return TRUE;
+    }
+    CloseHandle( thread );
+
+    __wine_set_client_io_callback( reactor_cancel_io );
+    TRACE( "using in-process socket reactor\n" );
+    return TRUE;
+}
+
+static BOOL reactor_enabled(void)
+{
+    static INIT_ONCE init_once = INIT_ONCE_STATIC_INIT;
+
+    InitOnceExecuteOnce( &init_once, reactor_init_once, NULL, NULL );
+    return reactor_epoll != -1;
+}
+
+/***********************************************************************
+ *     ws2_reactor_queue                (INTERNAL)
+ *
+ * Queue a pending overlapped operation in the in-process reactor. On
+ * failure, the caller registers the async with the server instead.
+ */
+static BOOL ws2_reactor_queue( SOCKET s, struct ws2_async *wsa, IO_STATUS_BLOCK *iosb,
+                               HANDLE event, ULONG_PTR cvalue, BOOL write )
+{
+    struct ws2_reactor_socket *sock;
+    struct ws2_reactor_op *op;
+
+    if (!reactor_enabled()) return FALSE;
+
+    if (!(op = HeapAlloc( GetProcessHeap(), 0, sizeof(*op) ))) return FALSE;
+    op->wsa    = wsa;
+    op->iosb   = iosb;
+    op->event  = (HANDLE)((ULONG_PTR)event & ~1);
+    op->cvalue = cvalue;
+    op->tid    = GetCurrentThreadId();
+
+    EnterCriticalSection( &cs_reactor );
+    if (!(sock = reactor_get_socket( s, TRUE ))) goto failed;
+    if (sock->flags & (REACTOR_SERVER_READ << write)) goto failed;
+    if (sock->fd == -1)
+    {
+        struct epoll_event ev;
+
+        if (wine_server_handle_to_fd( SOCKET2HANDLE(s), 0, &sock->fd, NULL ))
+        {
+            sock->fd = -1;
+            goto failed;
+        }
+        ev.events = 0;
+        ev.data.u64 = s;
+        if (epoll_ctl( reactor_epoll, EPOLL_CTL_ADD, sock->fd, &ev ) == -1)
+        {
+            close( sock->fd );
+            sock->fd = -1;
+            goto failed;
+        }
+    }
+    if (op->event) ResetEvent( op->event );
+    wsa->io.polled = TRUE;
+    list_add_tail( &sock->ops[write ? 1 : 0], &op->entry );
+    reactor_update_socket( sock );
+    LeaveCriticalSection( &cs_reactor );
+    return TRUE;
+
+failed:
+    if (sock) reactor_update_socket( sock );
+    LeaveCriticalSection( &cs_reactor );
+    HeapFree( GetProcessHeap(), 0, op );
+    return FALSE;
+}
+
+/***********************************************************************
+ *     ws2_reactor_to_server            (INTERNAL)
+ *
+ * Move some directions of a socket to the server for good, along with the
+ * operations queued in the reactor for them.
+ */
+static void ws2_reactor_to_server( SOCKET s, unsigned int flags )
+{
+    struct ws2_reactor_socket *sock;
+
+    if (!reactor_enabled()) return;
+
+    EnterCriticalSection( &cs_reactor );
+    if ((sock = reactor_get_socket( s, TRUE )))
+    {
+        reactor_move_to_server( sock, flags );
+        reactor_update_socket( sock );
+    }
+    LeaveCriticalSection( &cs_reactor );
+}
+
+#else
+
+static BOOL ws2_reactor_queue( SOCKET s, struct ws2_async *wsa, IO_STATUS_BLOCK *iosb,
+                               HANDLE event, ULONG_PTR cvalue, BOOL write )
+{
+    return FALSE;
+}
+
+static void ws2_reactor_to_server( SOCKET s, unsigned int flags )
+{
+}
+
+#endif  /* HAVE_SYS_EPOLL_H */
+
 
 /***********************************************************************
  *		send			(WS2_32.19)
@@ -5513,16 +6572,21 @@ static int WS2_sendto( SOCKET s, LPWSABUF lpBuffers, DWORD dwBufferCount,
             iosb->u.Status = STATUS_PENDING;
             iosb->Information = n == -1 ? 0 : n;
 
-            if (wsa->completion_func)
-                err = register_async( ASYNC_TYPE_WRITE, wsa->hSocket, &wsa->io, NULL,
-                                      ws2_async_apc, wsa, iosb );
+            if (!wsa->completion_func && ws2_reactor_queue( s, wsa, iosb, lpOverlapped->hEvent, cvalue, TRUE ))
+                err = STATUS_PENDING;
             else
-                err = register_async( ASYNC_TYPE_WRITE, wsa->hSocket, &wsa->io, lpOverlapped->hEvent,
-                                      NULL, (void *)cvalue, iosb );
+            {
+                if (wsa->completion_func)
+                    err = register_async( ASYNC_TYPE_WRITE, wsa->hSocket, &wsa->io, NULL,
+                                          ws2_async_apc, wsa, iosb );
+                else
+                    err = register_async( ASYNC_TYPE_WRITE, wsa->hSocket, &wsa->io, lpOverlapped->hEvent,
+                                          NULL, (void *)cvalue, iosb );
 
-            /* Enable the event only after starting the async. The server will deliver it as soon as
-               the async is done. */
-            _enable_event(SOCKET2HANDLE(s), FD_WRITE, 0, 0);
+                /* Enable the event only after starting the async. The server will deliver it as soon as
+                   the async is done. */
+                _enable_event(SOCKET2HANDLE(s), FD_WRITE, 0, 0);
+            }
 
             if (err != STATUS_PENDING) HeapFree( GetProcessHeap(), 0, wsa );
             SetLastError(NtStatusToWSAError( err ));
@@ -7271,6 +8335,9 @@ int WINAPI WSAEventSelect(SOCKET s, WSAEVENT hEvent, LONG lEvent)
 
     TRACE("%04lx, hEvent %p, event %08x\n", s, hEvent, lEvent);
 
+    /* the server needs to see the I/O of the socket to re-enable events */
+    ws2_reactor_to_server( s, REACTOR_SERVER_READ | REACTOR_SERVER_WRITE );
+
     SERVER_START_REQ( set_socket_event )
     {
         req->handle = wine_server_obj_handle( SOCKET2HANDLE(s) );
@@ -7340,6 +8407,8 @@ INT WINAPI WSAAsyncSelect(SOCKET s, HWND hWnd, UINT uMsg, LONG lEvent)
 
     TRACE("%04lx, hWnd %p, uMsg %08x, event %08x\n", s, hWnd, uMsg, lEvent);
 
+    ws2_reactor_to_server( s, REACTOR_SERVER_READ | REACTOR_SERVER_WRITE );
+
     SERVER_START_REQ( set_socket_event )
     {
         req->handle = wine_server_obj_handle( SOCKET2HANDLE(s) );
@@ -7920,6 +8989,8 @@ static int WS2_recv_base( SOCKET s, LPWSABUF lpBuffers, DWORD dwBufferCount,
                 if (wsa->completion_func)
                     err = register_async( ASYNC_TYPE_READ, wsa->hSocket, &wsa->io, NULL,
                                           ws2_async_apc, wsa, iosb );
+                else if (ws2_reactor_queue( s, wsa, iosb, lpOverlapped->hEvent, cvalue, FALSE ))
+                    err = STATUS_PENDING;
                 else
                     err = register_async( ASYNC_TYPE_READ, wsa->hSocket, &wsa->io, lpOverlapped->hEvent,
                                           NULL, (void *)cvalue, iosb );
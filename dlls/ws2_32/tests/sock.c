@@ -3712,6 +3712,70 @@ todo_wine
     ok(FD_ISSET(fdWrite, &writefds), "fdWrite socket is not in the set\n");
     closesocket(fdWrite);
 }
+
+static void test_select_closehandle(void)
+{
+    struct timeval timeout = {1, 0}, zero = {0, 0};
+    SOCKET client, server, sock;
+    fd_set readfds, writefds;
+    WSAPOLLFD fds[1];
+    char buffer[4];
+    int ret;
+
+    tcp_socketpair(&client, &server);
+
+    FD_ZERO(&writefds);
+    FD_SET(client, &writefds);
+    ret = select(0, NULL, &writefds, NULL, &timeout);
+    ok(ret == 1, "expected 1, got %d\n", ret);
+
+    /* closing the handle closes the socket, even though select() has seen it */
+    ret = CloseHandle((HANDLE)client);
+    ok(ret, "CloseHandle failed: %u\n", GetLastError());
+    FD_ZERO(&readfds);
+    FD_SET(server, &readfds);
+    ret = select(0, &readfds, NULL, NULL, &timeout);
+    ok(ret == 1, "expected 1, got %d\n", ret);
+    ret = recv(server, buffer, sizeof(buffer), 0);
+    ok(!ret, "expected 0, got %d\n", ret);
+
+    /* the handle value may be reused for another socket */
+    sock = socket(AF_INET, SOCK_DGRAM, 0);
+    ok(sock != INVALID_SOCKET, "socket failed: %d\n", WSAGetLastError());
+    FD_ZERO(&readfds);
+    FD_SET(sock, &readfds);
+    ret = select(0, &readfds, NULL, NULL, &zero);
+    ok(ret == 0, "expected 0, got %d\n", ret);
+    FD_ZERO(&writefds);
+    FD_SET(sock, &writefds);
+    ret = select(0, NULL, &writefds, NULL, &timeout);
+    ok(ret == 1, "expected 1, got %d\n", ret);
+
+    closesocket(sock);
+    closesocket(server);
+
+    if (!pWSAPoll) return;
+
+    /* the same with WSAPoll(), for a set of sockets that changes between calls */
+    tcp_socketpair(&client, &server);
+    fds[0].fd = client;
+    fds[0].events = POLLWRNORM;
+    fds[0].revents = 0;
+    ret = pWSAPoll(fds, 1, 1000);
+    ok(ret == 1, "expected 1, got %d\n", ret);
+
+    ret = CloseHandle((HANDLE)client);
+    ok(ret, "CloseHandle failed: %u\n", GetLastError());
+    fds[0].fd = server;
+    fds[0].events = POLLRDNORM;
+    fds[0].revents = 0;
+    ret = pWSAPoll(fds, 1, 1000);
+    ok(ret == 1, "expected 1, got %d\n", ret);
+    ret = recv(server, buffer, sizeof(buffer), 0);
+    ok(!ret, "expected 0, got %d\n", ret);
+
+    closesocket(server);
+}
 #undef FD_SET_ALL
 #undef FD_ZERO_ALL
 
@@ -8172,6 +8236,397 @@ static void test_TransmitFile(void)
     closesocket(server);
 }
 
+static void test_TransmitPackets(void)
+{
+    GUID transmitPacketsGuid = WSAID_TRANSMITPACKETS;
+    LPFN_TRANSMITPACKETS pTransmitPackets = NULL;
+    TRANSMIT_PACKETS_ELEMENT elements[3];
+    char header_msg[] = "hello world";
+    char footer_msg[] = "goodbye!!!";
+    char system_ini_path[MAX_PATH];
+    char buf[256], file_buf[256];
+    DWORD num_bytes, total_sent;
+    SOCKET client, dest;
+    WSAOVERLAPPED ov;
+    HANDLE file;
+    int iret;
+    BOOL bret;
+
+    tcp_socketpair(&client, &dest);
+
+    iret = WSAIoctl(client, SIO_GET_EXTENSION_FUNCTION_POINTER, &transmitPacketsGuid, sizeof(transmitPacketsGuid),
+                    &pTransmitPackets, sizeof(pTransmitPackets), &num_bytes, NULL, NULL);
+    ok(!iret, "failed to get TransmitPackets, error %u\n", GetLastError());
+
+    GetSystemWindowsDirectoryA(system_ini_path, MAX_PATH );
+    strcat(system_ini_path, "\\system.ini");
+    file = CreateFileA(system_ini_path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_ALWAYS, 0x0, NULL);
+    ok(file != INVALID_HANDLE_VALUE, "failed to open file, error %u\n", GetLastError());
+
+    /* Test TransmitPackets with memory and file elements */
+    memset(elements, 0, sizeof(elements));
+    elements[0].dwElFlags = TP_ELEMENT_MEMORY;
+    elements[0].cLength = sizeof(header_msg);
+    elements[0].pBuffer = header_msg;
+    elements[1].dwElFlags = TP_ELEMENT_FILE;
+    elements[1].cLength = 0;
+    elements[1].hFile = file;
+    elements[1].nFileOffset.QuadPart = 0;
+    elements[2].dwElFlags = TP_ELEMENT_MEMORY | TP_ELEMENT_EOP;
+    elements[2].cLength = sizeof(footer_msg);
+    elements[2].pBuffer = footer_msg;
+    bret = pTransmitPackets(client, elements, 3, 0, NULL, 0);
+    ok(bret, "TransmitPackets failed, error %u.\n", WSAGetLastError());
+    iret = recv(dest, buf, sizeof(header_msg), 0);
+    ok(iret == sizeof(header_msg), "Got unexpected size %d.\n", iret);
+    ok(!memcmp(buf, header_msg, sizeof(header_msg)), "TransmitPackets header buffer did not match!\n");
+    compare_file(file, dest, 0);
+    iret = recv(dest, buf, sizeof(footer_msg), 0);
+    ok(iret == sizeof(footer_msg), "Got unexpected size %d.\n", iret);
+    ok(!memcmp(buf, footer_msg, sizeof(footer_msg)), "TransmitPackets footer buffer did not match!\n");
+
+    /* Test overlapped TransmitPackets with a partial file element */
+    memset(&ov, 0, sizeof(ov));
+    ov.hEvent = CreateEventW(NULL, FALSE, FALSE, NULL);
+    elements[0].dwElFlags = TP_ELEMENT_FILE;
+    elements[0].cLength = 20;
+    elements[0].hFile = file;
+    elements[0].nFileOffset.QuadPart = 10;
+    bret = pTransmitPackets(client, elements, 1, 0, &ov, 0);
+    ok(!bret, "TransmitPackets succeeded unexpectedly.\n");
+    ok(WSAGetLastError() == ERROR_IO_PENDING, "Got unexpected error %u.\n", WSAGetLastError());
+    iret = WaitForSingleObject(ov.hEvent, 2000);
+    ok(iret == WAIT_OBJECT_0, "Overlapped TransmitPackets failed.\n");
+    WSAGetOverlappedResult(client, &ov, &total_sent, FALSE, NULL);
+    ok(total_sent == 20, "Got unexpected size %u.\n", total_sent);
+    SetFilePointer(file, 10, NULL, FILE_BEGIN);
+    ReadFile(file, file_buf, 20, &num_bytes, NULL);
+    iret = recv(dest, buf, 20, 0);
+    ok(iret == 20, "Got unexpected size %d.\n", iret);
+    ok(!memcmp(buf, file_buf, 20), "TransmitPackets file data did not match!\n");
+
+    CloseHandle(ov.hEvent);
+    CloseHandle(file);
+    closesocket(client);
+    closesocket(dest);
+}
+
+static DWORD WINAPI transmit_benchmark_recv_thread(void *arg)
+{
+    SOCKET sock = (SOCKET)arg;
+    static char buf[1 << 16];
+    DWORD total = 0;
+    int ret;
+
+    while ((ret = recv(sock, buf, sizeof(buf), 0)) > 0)
+        total += ret;
+    return total;
+}
+
+/* Measures TransmitFile() throughput over loopback. Only run in
+ * interactive mode. */
+static void test_TransmitFile_benchmark(void)
+{
+    static const DWORD file_size = 64 * 1024 * 1024;
+    GUID transmitFileGuid = WSAID_TRANSMITFILE;
+    LPFN_TRANSMITFILE pTransmitFile = NULL;
+    LARGE_INTEGER frequency, start, end;
+    char path[MAX_PATH], *data;
+    DWORD num_bytes, received;
+    SOCKET client, dest;
+    HANDLE file, thread;
+    unsigned int i;
+    double time;
+    BOOL bret;
+    int iret;
+
+    GetTempPathA(MAX_PATH, path);
+    strcat(path, "transmitfile.bin");
+    file = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_ALWAYS,
+            FILE_FLAG_DELETE_ON_CLOSE, NULL);
+    ok(file != INVALID_HANDLE_VALUE, "failed to create file, error %u\n", GetLastError());
+
+    data = HeapAlloc(GetProcessHeap(), 0, 1 << 20);
+    for (i = 0; i < (1 << 20); ++i)
+        data[i] = i;
+    for (i = 0; i < file_size >> 20; ++i)
+        WriteFile(file, data, 1 << 20, &num_bytes, NULL);
+    HeapFree(GetProcessHeap(), 0, data);
+
+    tcp_socketpair(&client, &dest);
+    iret = WSAIoctl(client, SIO_GET_EXTENSION_FUNCTION_POINTER, &transmitFileGuid, sizeof(transmitFileGuid),
+                    &pTransmitFile, sizeof(pTransmitFile), &num_bytes, NULL, NULL);
+    ok(!iret, "failed to get TransmitFile, error %u\n", GetLastError());
+
+    thread = CreateThread(NULL, 0, transmit_benchmark_recv_thread, (void *)dest, 0, NULL);
+
+    QueryPerformanceFrequency(&frequency);
+    SetFilePointer(file, 0, NULL, FILE_BEGIN);
+    QueryPerformanceCounter(&start);
+    bret = pTransmitFile(client, file, 0, 0, NULL, NULL, 0);
+    ok(bret, "TransmitFile failed, error %u.\n", WSAGetLastError());
+    shutdown(client, SD_SEND);
+    WaitForSingleObject(thread, INFINITE);
+    QueryPerformanceCounter(&end);
+
+    GetExitCodeThread(thread, &received);
+    ok(received == file_size, "Got unexpected size %u.\n", received);
+    time = (double)(end.QuadPart - start.QuadPart) / frequency.QuadPart;
+    trace("TransmitFile: %u MiB in %.3f s, %.1f MiB/s.\n", file_size >> 20, time, (file_size >> 20) / time);
+
+    CloseHandle(thread);
+    CloseHandle(file);
+    closesocket(client);
+    closesocket(dest);
+}
+
+static DWORD WINAPI cancel_io_thread(void *arg)
+{
+    return CancelIo(arg);
+}
+
+static void test_overlapped_cancellation(void)
+{
+    OVERLAPPED overlapped, overlapped2, *ovl;
+    char buffer[16], buffer2[16];
+    WSABUF wsabuf, wsabuf2;
+    SOCKET client, server;
+    DWORD size, flags;
+    HANDLE port, thread;
+    ULONG_PTR key;
+    BOOL bret;
+    int iret;
+
+    tcp_socketpair_ovl(&client, &server);
+    wsabuf.buf = buffer;
+    wsabuf.len = sizeof(buffer);
+    wsabuf2.buf = buffer2;
+    wsabuf2.len = sizeof(buffer2);
+
+    /* CancelIo() only cancels the operations of the calling thread */
+    memset(&overlapped, 0, sizeof(overlapped));
+    overlapped.hEvent = CreateEventW(NULL, TRUE, FALSE, NULL);
+    flags = 0;
+    iret = WSARecv(server, &wsabuf, 1, NULL, &flags, &overlapped, NULL);
+    ok(iret == SOCKET_ERROR && WSAGetLastError() == WSA_IO_PENDING, "got %d, error %u\n", iret, WSAGetLastError());
+
+    thread = CreateThread(NULL, 0, cancel_io_thread, (HANDLE)server, 0, NULL);
+    WaitForSingleObject(thread, INFINITE);
+    CloseHandle(thread);
+    ok(WaitForSingleObject(overlapped.hEvent, 100) == WAIT_TIMEOUT, "recv completed\n");
+
+    bret = CancelIo((HANDLE)server);
+    ok(bret, "CancelIo failed, error %u\n", GetLastError());
+    ok(!WaitForSingleObject(overlapped.hEvent, 1000), "recv was not cancelled\n");
+    bret = WSAGetOverlappedResult(server, &overlapped, &size, FALSE, &flags);
+    ok(!bret && WSAGetLastError() == ERROR_OPERATION_ABORTED, "got %d, error %u\n", bret, WSAGetLastError());
+
+    /* CancelIoEx() only cancels the given operation */
+    ResetEvent(overlapped.hEvent);
+    memset(&overlapped2, 0, sizeof(overlapped2));
+    overlapped2.hEvent = CreateEventW(NULL, TRUE, FALSE, NULL);
+    flags = 0;
+    iret = WSARecv(server, &wsabuf, 1, NULL, &flags, &overlapped, NULL);
+    ok(iret == SOCKET_ERROR && WSAGetLastError() == WSA_IO_PENDING, "got %d, error %u\n", iret, WSAGetLastError());
+    flags = 0;
+    iret = WSARecv(server, &wsabuf2, 1, NULL, &flags, &overlapped2, NULL);
+    ok(iret == SOCKET_ERROR && WSAGetLastError() == WSA_IO_PENDING, "got %d, error %u\n", iret, WSAGetLastError());
+
+    bret = CancelIoEx((HANDLE)server, &overlapped2);
+    ok(bret, "CancelIoEx failed, error %u\n", GetLastError());
+    ok(!WaitForSingleObject(overlapped2.hEvent, 1000), "recv was not cancelled\n");
+    bret = WSAGetOverlappedResult(server, &overlapped2, &size, FALSE, &flags);
+    ok(!bret && WSAGetLastError() == ERROR_OPERATION_ABORTED, "got %d, error %u\n", bret, WSAGetLastError());
+    SetLastError(0xdeadbeef);
+    bret = CancelIoEx((HANDLE)server, &overlapped2);
+    ok(!bret && GetLastError() == ERROR_NOT_FOUND, "got %d, error %u\n", bret, GetLastError());
+
+    iret = send(client, "x", 1, 0);
+    ok(iret == 1, "send returned %d, error %u\n", iret, WSAGetLastError());
+    ok(!WaitForSingleObject(overlapped.hEvent, 1000), "recv did not complete\n");
+    bret = WSAGetOverlappedResult(server, &overlapped, &size, FALSE, &flags);
+    ok(bret && size == 1 && buffer[0] == 'x', "got %d, size %u, error %u\n", bret, size, WSAGetLastError());
+
+    CloseHandle(overlapped.hEvent);
+    CloseHandle(overlapped2.hEvent);
+
+    /* closing the handle cancels the pending operations and closes the connection */
+    port = CreateIoCompletionPort((HANDLE)server, NULL, 0x1234, 0);
+    ok(port != NULL, "failed to create completion port, error %u\n", GetLastError());
+    memset(&overlapped, 0, sizeof(overlapped));
+    flags = 0;
+    iret = WSARecv(server, &wsabuf, 1, NULL, &flags, &overlapped, NULL);
+    ok(iret == SOCKET_ERROR && WSAGetLastError() == WSA_IO_PENDING, "got %d, error %u\n", iret, WSAGetLastError());
+
+    bret = CloseHandle((HANDLE)server);
+    ok(bret, "CloseHandle failed, error %u\n", GetLastError());
+    ovl = NULL;
+    bret = GetQueuedCompletionStatus(port, &size, &key, &ovl, 1000);
+    ok(!bret, "recv succeeded\n");
+    ok(ovl == &overlapped, "got overlapped %p\n", ovl);
+    ok(key == 0x1234, "got key %#lx\n", key);
+
+    size = 1000;
+    setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, (char *)&size, sizeof(size));
+    iret = recv(client, buffer, sizeof(buffer), 0);
+    ok(!iret, "recv returned %d, error %u\n", iret, WSAGetLastError());
+
+    CloseHandle(port);
+    closesocket(client);
+}
+
+static DWORD WINAPI echo_benchmark_server_thread(void *arg)
+{
+    SOCKET s = (SOCKET)arg;
+    OVERLAPPED overlapped, *ovl;
+    DWORD size, flags;
+    ULONG_PTR key;
+    HANDLE port;
+    char buffer[256];
+    WSABUF wsabuf;
+    BOOL bret;
+    int iret;
+
+    port = CreateIoCompletionPort((HANDLE)s, NULL, 0x1234, 0);
+    ok(port != NULL, "failed to create completion port, error %u\n", GetLastError());
+
+    for (;;)
+    {
+        memset(&overlapped, 0, sizeof(overlapped));
+        wsabuf.buf = buffer;
+        wsabuf.len = sizeof(buffer);
+        flags = 0;
+        iret = WSARecv(s, &wsabuf, 1, NULL, &flags, &overlapped, NULL);
+        if (iret && WSAGetLastError() != WSA_IO_PENDING) break;
+        bret = GetQueuedCompletionStatus(port, &size, &key, &ovl, INFINITE);
+        if (!bret || !size) break;
+
+        memset(&overlapped, 0, sizeof(overlapped));
+        wsabuf.len = size;
+        iret = WSASend(s, &wsabuf, 1, NULL, 0, &overlapped, NULL);
+        if (iret && WSAGetLastError() != WSA_IO_PENDING) break;
+        bret = GetQueuedCompletionStatus(port, &size, &key, &ovl, INFINITE);
+        if (!bret) break;
+    }
+
+    CloseHandle(port);
+    return 0;
+}
+
+static int __cdecl compare_latency(const void *a, const void *b)
+{
+    LONGLONG x = *(const LONGLONG *)a, y = *(const LONGLONG *)b;
+    return x < y ? -1 : x > y;
+}
+
+static void test_echo_benchmark(void)
+{
+    static const unsigned int count = 20000;
+    LARGE_INTEGER frequency, start, end, t0, t1;
+    char request[64], reply[64];
+    SOCKET client, server;
+    LONGLONG *latency;
+    unsigned int i;
+    HANDLE thread;
+    double time;
+    int iret, received;
+
+    tcp_socketpair_ovl(&client, &server);
+    thread = CreateThread(NULL, 0, echo_benchmark_server_thread, (void *)server, 0, NULL);
+
+    latency = HeapAlloc(GetProcessHeap(), 0, count * sizeof(*latency));
+    memset(request, 'x', sizeof(request));
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&start);
+    for (i = 0; i < count; ++i)
+    {
+        QueryPerformanceCounter(&t0);
+        iret = send(client, request, sizeof(request), 0);
+        ok(iret == sizeof(request), "send returned %d, error %u\n", iret, WSAGetLastError());
+        for (received = 0; received < sizeof(reply); received += iret)
+        {
+            iret = recv(client, reply + received, sizeof(reply) - received, 0);
+            if (iret <= 0) break;
+        }
+        ok(received == sizeof(reply), "received %d bytes, error %u\n", received, WSAGetLastError());
+        QueryPerformanceCounter(&t1);
+        latency[i] = t1.QuadPart - t0.QuadPart;
+    }
+    QueryPerformanceCounter(&end);
+
+    shutdown(client, SD_SEND);
+    WaitForSingleObject(thread, INFINITE);
+    CloseHandle(thread);
+
+    qsort(latency, count, sizeof(*latency), compare_latency);
+    time = (double)(end.QuadPart - start.QuadPart) / frequency.QuadPart;
+    trace("echo: %u requests in %.3f s, %.0f req/s, p50 %.1f us, p99 %.1f us.\n", count, time, count / time,
+            latency[count / 2] * 1e6 / frequency.QuadPart, latency[count * 99 / 100] * 1e6 / frequency.QuadPart);
+
+    HeapFree(GetProcessHeap(), 0, latency);
+    closesocket(client);
+    closesocket(server);
+}
+
+static void test_WSAPoll_benchmark(void)
+{
+    static const unsigned int idle_count = 10000, active_count = 100, iterations = 1000;
+    LARGE_INTEGER frequency, start, end;
+    struct sockaddr_in addr;
+    unsigned int i, count;
+    WSAPOLLFD *fds;
+    SOCKET sender;
+    double time;
+    int ret, len;
+
+    if (!pWSAPoll)
+    {
+        win_skip("WSAPoll is not available\n");
+        return;
+    }
+
+    fds = HeapAlloc(GetProcessHeap(), 0, (idle_count + active_count) * sizeof(*fds));
+    sender = socket(AF_INET, SOCK_DGRAM, 0);
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+    for (count = 0; count < idle_count + active_count; ++count)
+    {
+        fds[count].fd = socket(AF_INET, SOCK_DGRAM, 0);
+        if (fds[count].fd == INVALID_SOCKET) break;
+        fds[count].events = POLLRDNORM;
+        addr.sin_port = 0;
+        bind(fds[count].fd, (struct sockaddr *)&addr, sizeof(addr));
+        if (count < idle_count) continue;
+
+        /* the active sockets are kept readable */
+        len = sizeof(addr);
+        getsockname(fds[count].fd, (struct sockaddr *)&addr, &len);
+        sendto(sender, "x", 1, 0, (struct sockaddr *)&addr, sizeof(addr));
+    }
+    if (count < idle_count + active_count)
+        trace("only created %u sockets\n", count);
+
+    ret = pWSAPoll(fds, count, 1000);
+    ok(ret == count - min(count, idle_count), "got %d\n", ret);
+
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&start);
+    for (i = 0; i < iterations; ++i)
+        pWSAPoll(fds, count, 0);
+    QueryPerformanceCounter(&end);
+
+    time = (double)(end.QuadPart - start.QuadPart) / frequency.QuadPart;
+    trace("WSAPoll: %u sockets, %u calls in %.3f s, %.1f us per call.\n",
+          count, iterations, time, time * 1e6 / iterations);
+
+    for (i = 0; i < count; ++i)
+        closesocket(fds[i].fd);
+    closesocket(sender);
+    HeapFree(GetProcessHeap(), 0, fds);
+}
+
 static void test_getpeername(void)
 {
     SOCKET sock;
@@ -10588,10 +11043,82 @@ static void test_wsaioctl(void)
     closesocket(s);
 }
 
+/* Run the overlapped I/O tests with the in-process reactor enabled. */
+static void test_reactor(void)
+{
+    PROCESS_INFORMATION info;
+    STARTUPINFOA startup;
+    char cmdline[MAX_PATH + 16], value[8], **argv;
+    DWORD size, type;
+    BOOL had_value;
+    HKEY key;
+    LONG ret;
+
+    if (strcmp(winetest_platform, "wine"))
+    {
+        skip("The in-process reactor is specific to Wine.\n");
+        return;
+    }
+
+    ret = RegCreateKeyExA(HKEY_CURRENT_USER, "Software\\Wine\\WinSock", 0, NULL, 0, KEY_ALL_ACCESS, NULL, &key, NULL);
+    ok(!ret, "failed to create key, error %u\n", ret);
+    size = sizeof(value);
+    had_value = !RegQueryValueExA(key, "InProcessAsync", NULL, &type, (BYTE *)value, &size);
+    ret = RegSetValueExA(key, "InProcessAsync", 0, REG_SZ, (const BYTE *)"Y", 2);
+    ok(!ret, "failed to set value, error %u\n", ret);
+
+    winetest_get_mainargs(&argv);
+    sprintf(cmdline, "\"%s\" sock reactor", argv[0]);
+    memset(&startup, 0, sizeof(startup));
+    startup.cb = sizeof(startup);
+    ret = CreateProcessA(NULL, cmdline, NULL, NULL, FALSE, 0, NULL, NULL, &startup, &info);
+    ok(ret, "failed to create process, error %u\n", GetLastError());
+    if (ret)
+    {
+        winetest_wait_child_process(info.hProcess);
+        CloseHandle(info.hProcess);
+        CloseHandle(info.hThread);
+    }
+
+    if (had_value) RegSetValueExA(key, "InProcessAsync", 0, type, (BYTE *)value, size);
+    else RegDeleteValueA(key, "InProcessAsync");
+    RegCloseKey(key);
+}
+
+static void test_reactor_child(void)
+{
+    Init();
+
+    test_WSASendMsg();
+    test_WSASendTo();
+    test_WSARecv();
+    test_write_watch();
+    test_iocp();
+    test_events(0);
+    test_events(1);
+    test_TransmitFile();
+    test_AcceptEx();
+    test_completion_port();
+    test_overlapped_cancellation();
+    test_send();
+
+    if (winetest_interactive)
+        test_echo_benchmark();
+
+    Exit();
+}
+
 START_TEST( sock )
 {
+    char **argv;
     int i;
 
+    if (winetest_get_mainargs(&argv) >= 3 && !strcmp(argv[2], "reactor"))
+    {
+        test_reactor_child();
+        return;
+    }
+
 /* Leave these tests at the beginning. They depend on WSAStartup not having been
  * called, which is done by Init() below. */
     test_WithoutWSAStartup();
@@ -10621,6 +11148,7 @@ START_TEST( sock )
     test_errors();
     test_listen();
     test_select();
+    test_select_closehandle();
     test_accept();
     test_getpeername();
     test_getsockname();
@@ -10644,6 +11172,7 @@ START_TEST( sock )
 
     test_ipv6only();
     test_TransmitFile();
+    test_TransmitPackets();
     test_GetAddrInfoW();
     test_GetAddrInfoExW();
     test_getaddrinfo();
@@ -10661,6 +11190,7 @@ START_TEST( sock )
     test_WSAAsyncGetServByPort();
     test_WSAAsyncGetServByName();
     test_completion_port();
+    test_overlapped_cancellation();
     test_address_list_query();
 
     test_WSCGetProviderInfo();
@@ -10671,5 +11201,14 @@ START_TEST( sock )
     test_synchronous_WSAIoctl();
     test_wsaioctl();
 
+    test_reactor();
+
+    if (winetest_interactive)
+    {
+        test_TransmitFile_benchmark();
+        test_echo_benchmark();
+        test_WSAPoll_benchmark();
+    }
+
     Exit();
 }
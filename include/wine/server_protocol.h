@@ -824,6 +824,29 @@ typedef struct
 } cursor_pos_t;
 
 
+struct window_shared_memory
+{
+    unsigned int   seq;
+    user_handle_t  handle;
+    user_handle_t  parent;
+    user_handle_t  owner;
+    thread_id_t    tid;
+    process_id_t   pid;
+    unsigned int   style;
+    unsigned int   ex_style;
+    unsigned int   dpi;
+    rectangle_t    window_rect;
+    rectangle_t    client_rect;
+};
+
+
+struct queue_shared_memory
+{
+    unsigned int wake_bits;
+    unsigned int changed_bits;
+};
+
+
 
 
 
@@ -2596,7 +2619,7 @@ struct get_msg_queue_reply
 {
     struct reply_header __header;
     obj_handle_t handle;
-    char __pad_12[4];
+    obj_handle_t shared;
 };
 
 
@@ -3156,6 +3179,20 @@ struct set_window_info_reply
 
 
 
+struct get_window_shared_memory_request
+{
+    struct request_header __header;
+    char __pad_12[4];
+};
+struct get_window_shared_memory_reply
+{
+    struct reply_header __header;
+    obj_handle_t   handle;
+    char __pad_12[4];
+};
+
+
+
 struct set_parent_request
 {
     struct request_header __header;
@@ -5526,6 +5563,7 @@ enum request
     REQ_set_window_owner,
     REQ_get_window_info,
     REQ_set_window_info,
+    REQ_get_window_shared_memory,
     REQ_set_parent,
     REQ_get_window_parents,
     REQ_get_window_children,
@@ -5806,6 +5844,7 @@ union generic_request
     struct set_window_owner_request set_window_owner_request;
     struct get_window_info_request get_window_info_request;
     struct set_window_info_request set_window_info_request;
+    struct get_window_shared_memory_request get_window_shared_memory_request;
     struct set_parent_request set_parent_request;
     struct get_window_parents_request get_window_parents_request;
     struct get_window_children_request get_window_children_request;
@@ -6084,6 +6123,7 @@ union generic_reply
     struct set_window_owner_reply set_window_owner_reply;
     struct get_window_info_reply get_window_info_reply;
     struct set_window_info_reply set_window_info_reply;
+    struct get_window_shared_memory_reply get_window_shared_memory_reply;
     struct set_parent_reply set_parent_reply;
     struct get_window_parents_reply get_window_parents_reply;
     struct get_window_children_reply get_window_children_reply;
@@ -6224,7 +6264,7 @@ union generic_reply
 
 /* ### protocol_version begin ### */
 
-#define SERVER_PROTOCOL_VERSION 690
+#define SERVER_PROTOCOL_VERSION 692
 
 /* ### protocol_version end ### */
 
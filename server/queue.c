@@ -28,6 +28,9 @@
 #ifdef HAVE_POLL_H
 # include <poll.h>
 #endif
+#ifdef HAVE_SYS_MMAN_H
+# include <sys/mman.h>
+#endif
 
 #include "ntstatus.h"
 #define WIN32_NO_STATUS
@@ -140,6 +143,8 @@ struct msg_queue
     struct thread_input   *input;           /* thread input descriptor */
     struct hook_table     *hooks;           /* hook table */
     timeout_t              last_get_msg;    /* time of last get message call */
+    struct object         *shared_mapping;  /* mapping of the memory shared with the client */
+    struct queue_shared_memory *shared;     /* state mirrored into the shared memory */
 };
 
 struct hotkey
@@ -305,6 +310,8 @@ static struct msg_queue *create_msg_queue( struct thread *thread, struct thread_
         queue->input           = (struct thread_input *)grab_object( input );
         queue->hooks           = NULL;
         queue->last_get_msg    = current_time;
+        queue->shared_mapping  = NULL;
+        queue->shared          = NULL;
         list_init( &queue->send_result );
         list_init( &queue->callback_result );
         list_init( &queue->pending_timers );
@@ -474,11 +481,20 @@ static inline int is_signaled( struct msg_queue *queue )
     return ((queue->wake_bits & queue->wake_mask) || (queue->changed_bits & queue->changed_mask));
 }
 
+/* mirror the queue bits into the memory shared with the client */
+static inline void update_shared_bits( struct msg_queue *queue )
+{
+    if (!queue->shared) return;
+    queue->shared->wake_bits    = queue->wake_bits;
+    queue->shared->changed_bits = queue->changed_bits;
+}
+
 /* set some queue bits */
 static inline void set_queue_bits( struct msg_queue *queue, unsigned int bits )
 {
     queue->wake_bits |= bits;
     queue->changed_bits |= bits;
+    update_shared_bits( queue );
     if (is_signaled( queue )) wake_up( &queue->obj, 0 );
 }
 
@@ -487,6 +503,7 @@ static inline void clear_queue_bits( struct msg_queue *queue, unsigned int bits
 {
     queue->wake_bits &= ~bits;
     queue->changed_bits &= ~bits;
+    update_shared_bits( queue );
 }
 
 /* check whether msg is a keyboard message */
@@ -1034,6 +1051,11 @@ static void msg_queue_destroy( struct object *obj )
     release_object( queue->input );
     if (queue->hooks) release_object( queue->hooks );
     if (queue->fd) release_object( queue->fd );
+    if (queue->shared_mapping)
+    {
+        munmap( queue->shared, sizeof(*queue->shared) );
+        release_object( queue->shared_mapping );
+    }
 }
 
 static void msg_queue_poll_event( struct fd *fd, int event )
@@ -2307,7 +2329,24 @@ DECL_HANDLER(get_msg_queue)
     struct msg_queue *queue = get_current_queue();
 
     reply->handle = 0;
-    if (queue) reply->handle = alloc_handle( current->process, queue, SYNCHRONIZE, 0 );
+    reply->shared = 0;
+    if (!queue) return;
+    reply->handle = alloc_handle( current->process, queue, SYNCHRONIZE, 0 );
+
+    if (!queue->shared_mapping)
+    {
+        void *ptr;
+
+        if (!(queue->shared_mapping = create_shared_mapping( sizeof(*queue->shared), &ptr )))
+        {
+            /* the client can still use the server requests */
+            clear_error();
+            return;
+        }
+        queue->shared = ptr;
+        update_shared_bits( queue );
+    }
+    reply->shared = alloc_handle( current->process, queue->shared_mapping, SECTION_MAP_READ | SECTION_QUERY, 0 );
 }
 
 
@@ -2366,6 +2405,7 @@ DECL_HANDLER(get_queue_status)
         reply->wake_bits    = queue->wake_bits;
         reply->changed_bits = queue->changed_bits;
         queue->changed_bits &= ~req->clear_bits;
+        update_shared_bits( queue );
     }
     else reply->wake_bits = reply->changed_bits = 0;
 }
@@ -2548,6 +2588,7 @@ DECL_HANDLER(get_message)
     }
     if (filter & QS_INPUT) queue->changed_bits &= ~QS_INPUT;
     if (filter & QS_PAINT) queue->changed_bits &= ~QS_PAINT;
+    update_shared_bits( queue );
 
     /* then check for posted messages */
     if ((filter & QS_POSTMESSAGE) &&
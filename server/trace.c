@@ -2579,6 +2579,7 @@ static void dump_get_msg_queue_request( const struct get_msg_queue_request *req
 static void dump_get_msg_queue_reply( const struct get_msg_queue_reply *req )
 {
     fprintf( stderr, " handle=%04x", req->handle );
+    fprintf( stderr, ", shared=%04x", req->shared );
 }
 
 static void dump_set_queue_fd_request( const struct set_queue_fd_request *req )
@@ -2944,6 +2945,15 @@ static void dump_set_window_info_reply( const struct set_window_info_reply *req
     fprintf( stderr, ", old_id=%08x", req->old_id );
 }
 
+static void dump_get_window_shared_memory_request( const struct get_window_shared_memory_request *req )
+{
+}
+
+static void dump_get_window_shared_memory_reply( const struct get_window_shared_memory_reply *req )
+{
+    fprintf( stderr, " handle=%04x", req->handle );
+}
+
 static void dump_set_parent_request( const struct set_parent_request *req )
 {
     fprintf( stderr, " handle=%08x", req->handle );
@@ -4591,6 +4601,7 @@ static const dump_func req_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_set_window_owner_request,
     (dump_func)dump_get_window_info_request,
     (dump_func)dump_set_window_info_request,
+    (dump_func)dump_get_window_shared_memory_request,
     (dump_func)dump_set_parent_request,
     (dump_func)dump_get_window_parents_request,
     (dump_func)dump_get_window_children_request,
@@ -4867,6 +4878,7 @@ static const dump_func reply_dumpers[REQ_NB_REQUESTS] = {
     (dump_func)dump_set_window_owner_reply,
     (dump_func)dump_get_window_info_reply,
     (dump_func)dump_set_window_info_reply,
+    (dump_func)dump_get_window_shared_memory_reply,
     (dump_func)dump_set_parent_reply,
     (dump_func)dump_get_window_parents_reply,
     (dump_func)dump_get_window_children_reply,
@@ -5143,6 +5155,7 @@ static const char * const req_names[REQ_NB_REQUESTS] = {
     "set_window_owner",
     "get_window_info",
     "set_window_info",
+    "get_window_shared_memory",
     "set_parent",
     "get_window_parents",
     "get_window_children",
@@ -33,6 +33,8 @@
 #include "winternl.h"
 
 #include "object.h"
+#include "file.h"
+#include "handle.h"
 #include "request.h"
 #include "thread.h"
 #include "process.h"
@@ -118,6 +120,10 @@ struct user_handle_array
 
 static const rectangle_t empty_rect;
 
+/* window state shared with the clients, indexed by user handle */
+static struct object *shared_windows_mapping;
+static struct window_shared_memory *shared_windows;
+
 /* global window pointers */
 static struct window *shell_window;
 static struct window *shell_listview;
@@ -144,6 +150,49 @@ static inline int is_desktop_window( const struct window *win )
     return !win->parent;  /* only desktop windows have no parent */
 }
 
+/* get the shared memory entry of a window */
+static inline struct window_shared_memory *get_shared_window( user_handle_t handle )
+{
+    return &shared_windows[((handle & 0xffff) - FIRST_USER_HANDLE) >> 1];
+}
+
+/* publish the window state in the memory shared with the clients */
+static void update_shared_window( struct window *win )
+{
+    struct window_shared_memory *shared;
+
+    if (!shared_windows) return;
+    shared = get_shared_window( win->handle );
+
+    /* readers retry while the sequence number is odd or has changed */
+    __atomic_store_n( &shared->seq, shared->seq + 1, __ATOMIC_SEQ_CST );
+    __atomic_thread_fence( __ATOMIC_RELEASE );
+    shared->handle      = win->handle;
+    shared->parent      = win->parent ? win->parent->handle : 0;
+    shared->owner       = win->parent ? win->owner : 0;
+    shared->tid         = win->thread ? get_thread_id( win->thread ) : 0;
+    shared->pid         = win->thread ? get_process_id( win->thread->process ) : 0;
+    shared->style       = win->style;
+    shared->ex_style    = win->ex_style;
+    shared->dpi         = win->dpi;
+    shared->window_rect = win->window_rect;
+    shared->client_rect = win->client_rect;
+    __atomic_store_n( &shared->seq, shared->seq + 1, __ATOMIC_SEQ_CST );
+}
+
+/* remove a destroyed window from the memory shared with the clients */
+static void remove_shared_window( struct window *win )
+{
+    struct window_shared_memory *shared;
+
+    if (!shared_windows) return;
+    shared = get_shared_window( win->handle );
+    __atomic_store_n( &shared->seq, shared->seq + 1, __ATOMIC_SEQ_CST );
+    __atomic_thread_fence( __ATOMIC_RELEASE );
+    shared->handle = 0;
+    __atomic_store_n( &shared->seq, shared->seq + 1, __ATOMIC_SEQ_CST );
+}
+
 /* get next window in Z-order list */
 static inline struct window *get_next_window( struct window *win )
 {
@@ -283,6 +332,7 @@ static int set_parent_window( struct window *win, struct window *parent )
         list_add_head( &win->parent->unlinked, &win->entry );
         win->is_linked = 0;
     }
+    update_shared_window( win );
     return 1;
 }
 
@@ -421,6 +471,7 @@ static void detach_window_thread( struct window *win )
     /* destroyed when the desktop ref count reaches zero */
     release_object( win->desktop );
     win->thread = NULL;
+    update_shared_window( win );
 }
 
 /* get the process owning the top window of a given desktop */
@@ -1716,8 +1767,10 @@ static void set_window_pos( struct window *win, struct window *previous,
             offset_rect( &child->visible_rect, new_size - old_size, 0 );
             offset_rect( &child->surface_rect, new_size - old_size, 0 );
             offset_rect( &child->client_rect, new_size - old_size, 0 );
+            update_shared_window( child );
         }
     }
+    update_shared_window( win );
 
     /* reset cursor clip rectangle when the desktop changes size */
     if (win == win->desktop->top_window) win->desktop->cursor.clip = *window_rect;
@@ -1901,6 +1954,7 @@ void destroy_window( struct window *win )
     if (win == taskman_window) taskman_window = NULL;
     free_hotkeys( win->desktop, win->handle );
     cleanup_clipboard_window( win->desktop, win->handle );
+    remove_shared_window( win );
     free_user_handle( win->handle );
     destroy_properties( win );
     list_remove( &win->entry );
@@ -1965,6 +2019,7 @@ DECL_HANDLER(create_window)
         win->dpi_awareness = req->awareness;
         win->dpi = req->dpi;
     }
+    update_shared_window( win );
 
     reply->handle    = win->handle;
     reply->parent    = win->parent ? win->parent->handle : 0;
@@ -1976,6 +2031,25 @@ DECL_HANDLER(create_window)
 }
 
 
+/* get the memory where the server publishes the window state */
+DECL_HANDLER(get_window_shared_memory)
+{
+    struct window *win;
+    user_handle_t handle = 0;
+    void *ptr;
+
+    if (!shared_windows_mapping)
+    {
+        mem_size_t size = ((LAST_USER_HANDLE - FIRST_USER_HANDLE + 1) >> 1) * sizeof(*shared_windows);
+
+        if (!(shared_windows_mapping = create_shared_mapping( size, &ptr ))) return;
+        shared_windows = ptr;
+        while ((win = next_user_handle( &handle, USER_WINDOW ))) update_shared_window( win );
+    }
+    reply->handle = alloc_handle( current->process, shared_windows_mapping, SECTION_MAP_READ | SECTION_QUERY, 0 );
+}
+
+
 /* set the parent of a window */
 DECL_HANDLER(set_parent)
 {
@@ -2027,6 +2101,7 @@ DECL_HANDLER(get_desktop_window)
         {
             detach_window_thread( desktop->top_window );
             desktop->top_window->style  = WS_POPUP | WS_VISIBLE | WS_CLIPSIBLINGS | WS_CLIPCHILDREN;
+            update_shared_window( desktop->top_window );
         }
     }
 
@@ -2039,6 +2114,7 @@ DECL_HANDLER(get_desktop_window)
         {
             detach_window_thread( desktop->msg_window );
             desktop->msg_window->style = WS_POPUP | WS_CLIPSIBLINGS | WS_CLIPCHILDREN;
+            update_shared_window( desktop->msg_window );
         }
     }
 
@@ -2074,6 +2150,7 @@ DECL_HANDLER(set_window_owner)
 
     reply->prev_owner = win->owner;
     reply->full_owner = win->owner = owner ? owner->handle : 0;
+    update_shared_window( win );
 }
 
 
@@ -2146,6 +2223,8 @@ DECL_HANDLER(set_window_info)
     if (req->flags & SET_WIN_EXTRA) memcpy( win->extra_bytes + req->extra_offset,
                                             &req->extra_value, req->extra_size );
 
+    if (req->flags & (SET_WIN_STYLE | SET_WIN_EXSTYLE)) update_shared_window( win );
+
     /* changing window style triggers a non-client paint */
     if (req->flags & SET_WIN_STYLE) win->paint_flags |= PAINT_NONCLIENT;
 }